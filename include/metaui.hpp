@@ -10,6 +10,30 @@
  * - Image loading (BMP, PNG*, JPEG*) with stb_image
  * - Flexible layout system (Box, Stack, Grid, Sidebar)
  * - Rich widget library (Text, Image, Button, Slider, etc.)
+ * - Virtualized DataGrid backed by a model interface
+ * - Sort/filter proxy models with incremental filtering on a thread pool
+ * - Virtualized TreeView with an O(log n) expanded-row index
+ * - Ring-buffered Console with ANSI colors and a monospace fast path
+ * - RichText paragraphs with styled spans and cached line layout
+ * - NumericLabel for live counters with per-digit quad updates
+ * - Start/middle/end ellipsis truncation for Text and Label
+ * - Color emoji (CBDT/sbix) in budgeted RGBA atlas pages
+ * - Optional cross-process glyph atlas in shared memory
+ * - Font lookup by family/bold/italic via fontconfig or a cached scan index
+ * - Embedded res:// resource bundles with optional font subsetting
+ * - MSDF icon atlas: any size and color from one texture, batched draws
+ * - SVG images rasterized off-thread per display size, LRU-cached
+ * - Canvas widget: vector paths with GPU-cached tessellation and AA
+ * - LineChart: ring-buffered series, min/max or LTTB decimation, instanced lines
+ * - Heatmap: float texture + colormap shader, dirty-row uploads, zoom/pan
+ * - VideoFrame: I420/NV12 from any thread, latest-frame mailbox, YUV shader
+ * - backdropBlur() frosted glass: dual Kawase at reduced resolution, cached
+ * - Nine-patch images; blurred shadows cached per (radius, blur) as nine-patches
+ * - separateSurface(): live widgets commit on their own Wayland subsurface
+ * - Reduced-resolution window/subsurfaces scaled by the compositor (wp_viewporter)
+ * - Input-to-photon latency histograms from wp_presentation feedback
+ * - Input recording and deterministic headless replay for repeatable benchmarks
+ * - MockCompositor (metaui/mockcompositor.hpp): in-process test compositor
  * - Easy styling with gradients, shadows, rounded corners
  * - Animation support with multiple easing curves
  * - Native Wayland integration with wlr-layer-shell
@@ -38,10 +62,15 @@
  */
 
 #include "metaui/core.hpp"
+#include "metaui/threadpool.hpp"
 #include "metaui/widget.hpp"
 #include "metaui/layouts.hpp"
 #include "metaui/renderer.hpp"
 #include "metaui/widgets.hpp"
+#include "metaui/models.hpp"
+#include "metaui/views.hpp"
+#include "metaui/metrics.hpp"
+#include "metaui/replay.hpp"
 #include "metaui/application.hpp"
 
 namespace MetaUI {
@@ -3,10 +3,18 @@
 #include "core.hpp"
 #include "widget.hpp"
 #include "renderer.hpp"
+#include "metrics.hpp"
+#include "replay.hpp"
 #include <wayland-client.h>
 #include <wayland-egl.h>
 #include <EGL/egl.h>
+#include <atomic>
 #include <chrono>
+#include <vector>
+#include <list>
+#include <cerrno>
+#include <poll.h>
+#include <time.h>
 #include <linux/input-event-codes.h>
 
 #define namespace namespace_workaround
@@ -14,6 +22,8 @@ extern "C" {
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 }
 #undef namespace
+#include "viewporter-client-protocol.h"
+#include "presentation-time-client-protocol.h"
 
 namespace MetaUI {
 
@@ -23,7 +33,7 @@ public:
         : title_(title), width_(width), height_(height) {
         initWayland();
         initEGL();
-        renderer_ = std::make_unique<Renderer>(width, height);
+        renderer_ = std::make_unique<Renderer>(width_, height_);
     }
     
     ~Application() {
@@ -36,34 +46,95 @@ public:
             root_->measure(Size(width_, height_));
             root_->layout(Rect(0, 0, width_, height_));
         }
+        attachSubsurfaces();
+        mainDirty_ = true;
     }
     
+    // The window redraws on input and configure events and on
+    // Widget::requestRedraw() from any thread, which every setter that
+    // changes what a widget draws calls. Widgets with
+    // separateSurface() redraw on their own frame callbacks, and only after
+    // input, their own requestRedraw() or while their renderer has pending
+    // work, so a wakeup that is only theirs leaves the window's last commit
+    // in place.
     void run() {
         running_ = true;
         auto lastFrame = std::chrono::steady_clock::now();
         
-        while (running_ && wl_display_dispatch(display_) != -1) {
+        while (running_ && dispatch()) {
             auto now = std::chrono::steady_clock::now();
             float dt = std::chrono::duration<float>(now - lastFrame).count();
             lastFrame = now;
             
             update(dt);
-            render();
-            eglSwapBuffers(eglDisplay_, eglSurface_);
+            if (mainDirty_) {
+                mainDirty_ = false;
+                syncSubsurfaces();
+                uint64_t renderStart = presentationTime();
+                eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+                render();
+                if (renderer_->hasPendingWork()) requestFrame();
+                requestPresentationFeedback(renderStart);
+                eglSwapBuffers(eglDisplay_, eglSurface_);
+            }
+            for (auto& sub : subsurfaces_) {
+                if (sub->frameDue && sub->dirty) renderSubsurface(*sub);
+            }
         }
     }
     
-    void quit() { running_ = false; }
+    // Callable from any thread; wakes run() so it returns promptly.
+    void quit() {
+        running_ = false;
+        RedrawSignal::shared().notify();
+    }
+    
     Renderer& renderer() { return *renderer_; }
     
+    // Renders the window at scale times its size and has the compositor
+    // stretch it to full size (wp_viewporter): less fill rate and buffer
+    // memory for softer pixels. No effect without wp_viewporter.
+    void setRenderScale(float scale) {
+        if (!viewporter_) return;
+        renderScale_ = std::clamp(scale, 0.1f, 1.0f);
+        if (!viewport_) viewport_ = wp_viewporter_get_viewport(viewporter_, surface_);
+        wp_viewport_set_destination(viewport_, width_, height_);
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+        renderer_->setPixelScale(renderScale_);
+        renderer_->setContentScale(renderScale_);
+        wl_egl_window_resize(eglWindow_, renderer_->pixelWidth(), renderer_->pixelHeight(), 0, 0);
+        mainDirty_ = true;
+    }
+    
+    // Latencies measured from wp_presentation feedback; stays empty when
+    // the compositor doesn't support it. Input timestamps are assumed to
+    // share the presentation clock's base (CLOCK_MONOTONIC in practice);
+    // events that don't are timed from when they were received.
+    const PresentationMetrics& presentationMetrics() const { return metrics_; }
+    void resetPresentationMetrics() { metrics_.clear(); }
+    
+    // Appends every input and resize event the window receives to the
+    // recording, timed from this call; nullptr stops. Replay it with
+    // InputReplay on a HeadlessApplication of the same size.
+    void recordInput(InputRecording* recording) {
+        recording_ = recording;
+        recordStart_ = std::chrono::steady_clock::now();
+    }
+
 private:
     std::string title_;
     int width_, height_;
-    bool running_ = false;
+    std::atomic<bool> running_{false};
     
     wl_display* display_ = nullptr;
     wl_registry* registry_ = nullptr;
     wl_compositor* compositor_ = nullptr;
+    wl_subcompositor* subcompositor_ = nullptr;
+    wp_viewporter* viewporter_ = nullptr;
+    wp_viewport* viewport_ = nullptr;
+    wp_presentation* presentation_ = nullptr;
+    clockid_t presentationClock_ = CLOCK_MONOTONIC;
+    float renderScale_ = 1.0f;
     wl_surface* surface_ = nullptr;
     wl_seat* seat_ = nullptr;
     wl_pointer* pointer_ = nullptr;
@@ -74,12 +145,50 @@ private:
     EGLDisplay eglDisplay_ = EGL_NO_DISPLAY;
     EGLContext eglContext_ = EGL_NO_CONTEXT;
     EGLSurface eglSurface_ = EGL_NO_SURFACE;
+    EGLConfig eglConfig_ = nullptr;
     wl_egl_window* eglWindow_ = nullptr;
     
+    // A widget drawn into its own desynchronized subsurface. It has its own
+    // renderer (same GL context) so its caches and frame pacing stay apart
+    // from the window's.
+    struct Subsurface {
+        WidgetPtr widget;
+        Rect bounds;
+        float scale = 1.0f;
+        wl_surface* surface = nullptr;
+        wl_subsurface* subsurface = nullptr;
+        wl_egl_window* window = nullptr;
+        wp_viewport* viewport = nullptr;
+        EGLSurface eglSurface = EGL_NO_SURFACE;
+        std::unique_ptr<Renderer> renderer;
+        wl_callback* frameCallback = nullptr;
+        bool frameDue = true;
+        bool dirty = true;   // render at the next frame callback
+    };
+    std::vector<std::unique_ptr<Subsurface>> subsurfaces_;
+    
     WidgetPtr root_;
     WidgetPtr focusedWidget_;
     std::unique_ptr<Renderer> renderer_;
     Point mousePos_;
+    wl_surface* pointerSurface_ = nullptr;
+    bool mainDirty_ = true;
+    
+    // A committed frame waiting for its presented/discarded event, with the
+    // input events (presentation clock, ns) it was the first to reflect.
+    struct PendingPresentation {
+        Application* app;
+        struct wp_presentation_feedback* feedback;
+        uint64_t renderStart;
+        std::vector<uint64_t> inputs;
+    };
+    std::list<PendingPresentation> presentations_;
+    std::vector<uint64_t> pendingInputs_;
+    uint64_t lastPresented_ = 0;
+    PresentationMetrics metrics_;
+    
+    InputRecording* recording_ = nullptr;
+    std::chrono::steady_clock::time_point recordStart_;
     
     void initWayland() {
         display_ = wl_display_connect(nullptr);
@@ -95,6 +204,21 @@ private:
                 if (strcmp(interface, wl_compositor_interface.name) == 0) {
                     app->compositor_ = static_cast<wl_compositor*>(
                         wl_registry_bind(registry, name, &wl_compositor_interface, 4));
+                } else if (strcmp(interface, wl_subcompositor_interface.name) == 0) {
+                    app->subcompositor_ = static_cast<wl_subcompositor*>(
+                        wl_registry_bind(registry, name, &wl_subcompositor_interface, 1));
+                } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+                    app->presentation_ = static_cast<wp_presentation*>(
+                        wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+                    static const wp_presentation_listener presentationListener = {
+                        .clock_id = [](void* data, wp_presentation*, uint32_t clock) {
+                            static_cast<Application*>(data)->presentationClock_ = (clockid_t)clock;
+                        }
+                    };
+                    wp_presentation_add_listener(app->presentation_, &presentationListener, app);
+                } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+                    app->viewporter_ = static_cast<wp_viewporter*>(
+                        wl_registry_bind(registry, name, &wp_viewporter_interface, 1));
                 } else if (strcmp(interface, wl_seat_interface.name) == 0) {
                     app->seat_ = static_cast<wl_seat*>(
                         wl_registry_bind(registry, name, &wl_seat_interface, 5));
@@ -126,7 +250,10 @@ private:
             static const zwlr_layer_surface_v1_listener layerListener = {
                 .configure = [](void* data, zwlr_layer_surface_v1* surface,
                                uint32_t serial, uint32_t w, uint32_t h) {
+                    auto* app = static_cast<Application*>(data);
                     zwlr_layer_surface_v1_ack_configure(surface, serial);
+                    if (w && h && ((int)w != app->width_ || (int)h != app->height_)) app->resize(w, h);
+                    app->mainDirty_ = true;
                 },
                 .closed = [](void* data, zwlr_layer_surface_v1* surface) {
                     static_cast<Application*>(data)->quit();
@@ -159,33 +286,45 @@ private:
     
     void setupPointer() {
         static const wl_pointer_listener pointerListener = {
-            .enter = [](void*, wl_pointer*, uint32_t, wl_surface*, wl_fixed_t, wl_fixed_t) {},
-            .leave = [](void*, wl_pointer*, uint32_t, wl_surface*) {},
+            .enter = [](void* data, wl_pointer*, uint32_t, wl_surface* surface, wl_fixed_t x, wl_fixed_t y) {
+                auto* app = static_cast<Application*>(data);
+                app->pointerSurface_ = surface;
+                app->mousePos_ = app->toWindow(surface, x, y);
+            },
+            .leave = [](void* data, wl_pointer*, uint32_t, wl_surface*) {
+                static_cast<Application*>(data)->pointerSurface_ = nullptr;
+            },
             .motion = [](void* data, wl_pointer*, uint32_t time, wl_fixed_t x, wl_fixed_t y) {
                 auto* app = static_cast<Application*>(data);
-                app->mousePos_ = Point(wl_fixed_to_double(x), wl_fixed_to_double(y));
-                MouseEvent event;
-                event.position = app->mousePos_;
-                if (app->root_) app->root_->handleMouseMove(event);
+                app->mousePos_ = app->toWindow(app->pointerSurface_, x, y);
+                InputRecord record;
+                record.type = InputRecord::Type::Motion;
+                record.x = app->mousePos_.x;
+                record.y = app->mousePos_.y;
+                app->handleInput(record, time);
             },
             .button = [](void* data, wl_pointer*, uint32_t, uint32_t time,
                         uint32_t button, uint32_t state) {
                 auto* app = static_cast<Application*>(data);
-                MouseEvent event;
-                event.position = app->mousePos_;
-                event.button = static_cast<MouseButton>(button - BTN_LEFT);
-                event.pressed = (state == WL_POINTER_BUTTON_STATE_PRESSED);
-                if (app->root_) app->root_->handleMouseButton(event);
+                InputRecord record;
+                record.type = InputRecord::Type::Button;
+                record.x = app->mousePos_.x;
+                record.y = app->mousePos_.y;
+                record.code = button - BTN_LEFT;
+                record.pressed = (state == WL_POINTER_BUTTON_STATE_PRESSED);
+                app->handleInput(record, time);
             },
-            .axis = [](void* data, wl_pointer*, uint32_t, uint32_t axis, wl_fixed_t value) {
+            .axis = [](void* data, wl_pointer*, uint32_t time, uint32_t axis, wl_fixed_t value) {
                 auto* app = static_cast<Application*>(data);
-                ScrollEvent event;
-                event.position = app->mousePos_;
+                InputRecord record;
+                record.type = InputRecord::Type::Scroll;
+                record.x = app->mousePos_.x;
+                record.y = app->mousePos_.y;
                 if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL)
-                    event.deltaY = wl_fixed_to_double(value);
+                    record.deltaY = wl_fixed_to_double(value);
                 else
-                    event.deltaX = wl_fixed_to_double(value);
-                if (app->root_) app->root_->handleScroll(event);
+                    record.deltaX = wl_fixed_to_double(value);
+                app->handleInput(record, time);
             },
             .frame = [](void*, wl_pointer*) {},
             .axis_source = [](void*, wl_pointer*, uint32_t) {},
@@ -203,10 +342,11 @@ private:
             .key = [](void* data, wl_keyboard*, uint32_t, uint32_t time,
                      uint32_t key, uint32_t state) {
                 auto* app = static_cast<Application*>(data);
-                KeyEvent event;
-                event.keycode = key;
-                event.pressed = (state == WL_KEYBOARD_KEY_STATE_PRESSED);
-                if (app->root_) app->root_->handleKeyEvent(event);
+                InputRecord record;
+                record.type = InputRecord::Type::Key;
+                record.code = key;
+                record.pressed = (state == WL_KEYBOARD_KEY_STATE_PRESSED);
+                app->handleInput(record, time);
             },
             .modifiers = [](void*, wl_keyboard*, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) {},
             .repeat_info = [](void*, wl_keyboard*, int32_t, int32_t) {}
@@ -222,6 +362,7 @@ private:
         EGLint configAttribs[] = {
             EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
             EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_STENCIL_SIZE, 8,   // path fills and strokes
             EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
             EGL_NONE
         };
@@ -230,6 +371,7 @@ private:
         EGLint numConfigs;
         if (!eglChooseConfig(eglDisplay_, configAttribs, &config, 1, &numConfigs))
             throw std::runtime_error("Failed to choose EGL config");
+        eglConfig_ = config;
         
         eglBindAPI(EGL_OPENGL_API);
         
@@ -244,6 +386,269 @@ private:
     
     void update(float dt) {}
     
+    // wl_display_dispatch() that also returns when RedrawSignal fires.
+    bool dispatch() {
+        while (wl_display_prepare_read(display_) != 0) {
+            if (wl_display_dispatch_pending(display_) == -1) return false;
+        }
+        wl_display_flush(display_);
+        
+        pollfd fds[2] = {
+            {wl_display_get_fd(display_), POLLIN, 0},
+            {RedrawSignal::shared().fd(), POLLIN, 0},
+        };
+        if (poll(fds, 2, -1) < 0) {
+            wl_display_cancel_read(display_);
+            return errno == EINTR;
+        }
+        if (fds[0].revents & POLLIN) {
+            if (wl_display_read_events(display_) == -1) return false;
+        } else {
+            wl_display_cancel_read(display_);
+            if (fds[0].revents & (POLLERR | POLLHUP)) return false;
+        }
+        if (fds[1].revents & POLLIN) takeRedrawRequests();
+        return wl_display_dispatch_pending(display_) != -1;
+    }
+    
+    void takeRedrawRequests() {
+        if (RedrawSignal::shared().take()) mainDirty_ = true;
+        for (auto& sub : subsurfaces_) {
+            if (sub->widget->takeRedrawRequest()) sub->dirty = true;
+        }
+    }
+    
+    // Wakes the dispatch loop at the next frame (committed by the swap) so
+    // background work such as SVG rasterization shows up without input.
+    void requestFrame() {
+        static const wl_callback_listener frameListener = {
+            .done = [](void* data, wl_callback* callback, uint32_t) {
+                static_cast<Application*>(data)->mainDirty_ = true;
+                wl_callback_destroy(callback);
+            }
+        };
+        wl_callback_add_listener(wl_surface_frame(surface_), &frameListener, this);
+    }
+    
+    uint64_t presentationTime() const {
+        timespec ts;
+        clock_gettime(presentationClock_, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+    
+    // Input events carry a 32-bit millisecond time. Rebuild the full
+    // timestamp against the presentation clock; one that lands implausibly
+    // far from now comes from another clock, so use the receive time.
+    void noteInput(uint32_t timeMs) {
+        // Any widget may react, including those in subsurfaces.
+        mainDirty_ = true;
+        for (auto& sub : subsurfaces_) sub->dirty = true;
+        if (!presentation_) return;
+        uint64_t now = presentationTime();
+        uint32_t age = (uint32_t)(now / 1000000) - timeMs;
+        pendingInputs_.push_back(age < 10000 ? now - (uint64_t)age * 1000000 : now);
+    }
+    
+    // Asked for before the swap so it covers the commit the swap makes.
+    void requestPresentationFeedback(uint64_t renderStart) {
+        if (!presentation_) return;
+        static const wp_presentation_feedback_listener feedbackListener = {
+            .sync_output = [](void*, struct wp_presentation_feedback*, wl_output*) {},
+            .presented = [](void* data, struct wp_presentation_feedback*, uint32_t secHi, uint32_t secLo,
+                            uint32_t nsec, uint32_t refresh, uint32_t, uint32_t, uint32_t) {
+                auto* pending = static_cast<PendingPresentation*>(data);
+                uint64_t shown = (((uint64_t)secHi << 32) | secLo) * 1000000000ull + nsec;
+                pending->app->recordPresentation(*pending, shown, refresh);
+            },
+            .discarded = [](void* data, struct wp_presentation_feedback*) {
+                auto* pending = static_cast<PendingPresentation*>(data);
+                pending->app->metrics_.discarded++;
+                pending->app->finishPresentation(*pending);
+            }
+        };
+        presentations_.push_back({this, wp_presentation_feedback(presentation_, surface_), renderStart,
+                                  std::move(pendingInputs_)});
+        pendingInputs_.clear();
+        PendingPresentation& pending = presentations_.back();
+        wp_presentation_feedback_add_listener(pending.feedback, &feedbackListener, &pending);
+    }
+    
+    void recordPresentation(PendingPresentation& pending, uint64_t shown, uint32_t refresh) {
+        auto ms = [](uint64_t later, uint64_t earlier) {
+            return later > earlier ? (later - earlier) / 1e6 : 0.0;
+        };
+        for (uint64_t input : pending.inputs) metrics_.inputToPresent.add(ms(shown, input));
+        metrics_.renderToPresent.add(ms(shown, pending.renderStart));
+        if (lastPresented_) metrics_.frameInterval.add(ms(shown, lastPresented_));
+        lastPresented_ = shown;
+        metrics_.presented++;
+        metrics_.refreshNs = refresh;
+        finishPresentation(pending);
+    }
+    
+    void finishPresentation(PendingPresentation& pending) {
+        wp_presentation_feedback_destroy(pending.feedback);
+        presentations_.remove_if([&](const PendingPresentation& p) { return &p == &pending; });
+    }
+    
+    // Every input event goes through here, so a recording holds exactly
+    // what the widgets were given.
+    void handleInput(InputRecord& record, uint32_t timeMs) {
+        noteInput(timeMs);
+        addRecord(record);
+        if (root_) dispatchInput(*root_, record);
+    }
+    
+    void addRecord(InputRecord& record) {
+        if (!recording_) return;
+        auto elapsed = std::chrono::steady_clock::now() - recordStart_;
+        record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        recording_->add(record);
+    }
+    
+    // Configure may arrive before EGL is up; the window is then created at
+    // the new size.
+    void resize(int width, int height) {
+        width_ = width;
+        height_ = height;
+        InputRecord record;
+        record.type = InputRecord::Type::Resize;
+        record.x = width;
+        record.y = height;
+        addRecord(record);
+        if (root_) {
+            root_->measure(Size(width_, height_));
+            root_->layout(Rect(0, 0, width_, height_));
+        }
+        if (!renderer_) return;
+        
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+        renderer_->setSize(width_, height_);
+        if (viewport_) wp_viewport_set_destination(viewport_, width_, height_);
+        wl_egl_window_resize(eglWindow_, renderer_->pixelWidth(), renderer_->pixelHeight(), 0, 0);
+        syncSubsurfaces();
+    }
+    
+    // Pointer coordinates arrive relative to the surface under the pointer.
+    Point toWindow(wl_surface* surface, wl_fixed_t x, wl_fixed_t y) const {
+        Point p(wl_fixed_to_double(x), wl_fixed_to_double(y));
+        for (auto& sub : subsurfaces_) {
+            if (sub->surface == surface) return Point(p.x + sub->bounds.x, p.y + sub->bounds.y);
+        }
+        return p;
+    }
+    
+    // Attaches again when the widgets asking for a surface, their bounds or
+    // their scale changed since the last attach.
+    void syncSubsurfaces() {
+        std::vector<WidgetPtr> wanted;
+        if (subcompositor_ && root_) collectSeparateSurfaces(*root_, wanted);
+        bool same = wanted.size() == subsurfaces_.size();
+        for (size_t i = 0; same && i < wanted.size(); ++i) {
+            const Subsurface& sub = *subsurfaces_[i];
+            Rect bounds = wanted[i]->surfaceBounds();
+            same = sub.widget == wanted[i] && sub.scale == surfaceScale(*wanted[i]) &&
+                   sub.bounds.x == bounds.x && sub.bounds.y == bounds.y &&
+                   sub.bounds.width == bounds.width && sub.bounds.height == bounds.height;
+        }
+        if (!same) attachSubsurfaces();
+    }
+    
+    float surfaceScale(const Widget& widget) const {
+        return viewporter_ ? std::clamp(widget.surfaceScale(), 0.1f, 1.0f) : 1.0f;
+    }
+    
+    // Gives every widget asking for separateSurface() a subsurface at its
+    // laid-out bounds, desynchronized so its commits show without one from
+    // the window. Later widgets in tree order stack above earlier ones.
+    void attachSubsurfaces() {
+        detachSubsurfaces();
+        if (!subcompositor_ || !root_) return;
+        
+        std::vector<WidgetPtr> wanted;
+        collectSeparateSurfaces(*root_, wanted);
+        for (auto& widget : wanted) {
+            auto sub = std::make_unique<Subsurface>();
+            sub->widget = widget;
+            sub->bounds = widget->surfaceBounds();
+            sub->scale = surfaceScale(*widget);
+            int w = (int)sub->bounds.width, h = (int)sub->bounds.height;
+            sub->surface = wl_compositor_create_surface(compositor_);
+            sub->subsurface = wl_subcompositor_get_subsurface(subcompositor_, sub->surface, surface_);
+            wl_subsurface_set_position(sub->subsurface, (int)sub->bounds.x, (int)sub->bounds.y);
+            wl_subsurface_set_desync(sub->subsurface);
+            
+            float scale = sub->scale;
+            int pw = std::max(1, (int)std::lround(w * scale));
+            int ph = std::max(1, (int)std::lround(h * scale));
+            if (pw != w || ph != h) {
+                sub->viewport = wp_viewporter_get_viewport(viewporter_, sub->surface);
+                wp_viewport_set_destination(sub->viewport, w, h);
+            }
+            sub->window = wl_egl_window_create(sub->surface, pw, ph);
+            sub->eglSurface = eglCreateWindowSurface(eglDisplay_, eglConfig_,
+                                                     (EGLNativeWindowType)sub->window, nullptr);
+            if (sub->eglSurface == EGL_NO_SURFACE) {
+                destroySubsurface(*sub);
+                continue;
+            }
+            
+            // Paced by our own frame callbacks, so the swap must not block
+            // on the surface's previous frame.
+            eglMakeCurrent(eglDisplay_, sub->eglSurface, sub->eglSurface, eglContext_);
+            eglSwapInterval(eglDisplay_, 0);
+            sub->renderer = std::make_unique<Renderer>(w, h);
+            sub->renderer->setOrigin((int)sub->bounds.x, (int)sub->bounds.y);
+            sub->renderer->setPixelScale(scale);
+            sub->renderer->setContentScale(scale);
+            widget->setSurfaceAttached(true);
+            subsurfaces_.push_back(std::move(sub));
+        }
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+    }
+    
+    void renderSubsurface(Subsurface& sub) {
+        static const wl_callback_listener frameListener = {
+            .done = [](void* data, wl_callback* callback, uint32_t) {
+                auto* sub = static_cast<Subsurface*>(data);
+                sub->frameDue = true;
+                sub->frameCallback = nullptr;
+                wl_callback_destroy(callback);
+            }
+        };
+        sub.frameDue = false;
+        eglMakeCurrent(eglDisplay_, sub.eglSurface, sub.eglSurface, eglContext_);
+        sub.renderer->beginFrame();
+        if (sub.widget->isVisible()) sub.widget->render(*sub.renderer);
+        sub.renderer->endFrame();
+        sub.dirty = sub.renderer->hasPendingWork();
+        sub.frameCallback = wl_surface_frame(sub.surface);
+        wl_callback_add_listener(sub.frameCallback, &frameListener, &sub);
+        eglSwapBuffers(eglDisplay_, sub.eglSurface);
+    }
+    
+    void destroySubsurface(Subsurface& sub) {
+        if (sub.widget) sub.widget->setSurfaceAttached(false);
+        if (sub.frameCallback) wl_callback_destroy(sub.frameCallback);
+        if (sub.renderer) {
+            eglMakeCurrent(eglDisplay_, sub.eglSurface, sub.eglSurface, eglContext_);
+            sub.renderer.reset();
+        }
+        if (sub.eglSurface != EGL_NO_SURFACE) {
+            eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+            eglDestroySurface(eglDisplay_, sub.eglSurface);
+        }
+        if (sub.window) wl_egl_window_destroy(sub.window);
+        if (sub.viewport) wp_viewport_destroy(sub.viewport);
+        if (sub.subsurface) wl_subsurface_destroy(sub.subsurface);
+        if (sub.surface) wl_surface_destroy(sub.surface);
+    }
+    
+    void detachSubsurfaces() {
+        for (auto& sub : subsurfaces_) destroySubsurface(*sub);
+        subsurfaces_.clear();
+    }
+    
     void render() {
         renderer_->beginFrame();
         if (root_) root_->render(*renderer_);
@@ -251,6 +656,9 @@ private:
     }
     
     void cleanup() {
+        detachSubsurfaces();
+        for (auto& pending : presentations_) wp_presentation_feedback_destroy(pending.feedback);
+        presentations_.clear();
         if (eglDisplay_ != EGL_NO_DISPLAY) {
             eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
             if (eglContext_ != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay_, eglContext_);
@@ -258,12 +666,16 @@ private:
             eglTerminate(eglDisplay_);
         }
         if (eglWindow_) wl_egl_window_destroy(eglWindow_);
+        if (viewport_) wp_viewport_destroy(viewport_);
         if (layerSurface_) zwlr_layer_surface_v1_destroy(layerSurface_);
         if (surface_) wl_surface_destroy(surface_);
         if (pointer_) wl_pointer_destroy(pointer_);
         if (keyboard_) wl_keyboard_destroy(keyboard_);
         if (seat_) wl_seat_destroy(seat_);
         if (layerShell_) zwlr_layer_shell_v1_destroy(layerShell_);
+        if (subcompositor_) wl_subcompositor_destroy(subcompositor_);
+        if (viewporter_) wp_viewporter_destroy(viewporter_);
+        if (presentation_) wp_presentation_destroy(presentation_);
         if (compositor_) wl_compositor_destroy(compositor_);
         if (registry_) wl_registry_destroy(registry_);
         if (display_) wl_display_disconnect(display_);
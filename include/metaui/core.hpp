@@ -223,6 +223,8 @@ struct TextStyle {
     
     enum class Align { Left, Center, Right } align = Align::Left;
     enum class VAlign { Top, Middle, Bottom } valign = VAlign::Top;
+    // Where an ellipsis replaces text that doesn't fit on one line.
+    enum class Truncate { None, Start, Middle, End } truncate = Truncate::None;
 };
 
 struct BoxStyle {
@@ -242,6 +244,8 @@ struct BoxStyle {
     Color gradientStart;
     Color gradientEnd;
     float gradientAngle = 0.0f;
+    
+    float backdropBlur = 0.0f;
 };
 
 // ============================================================================
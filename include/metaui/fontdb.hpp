@@ -0,0 +1,551 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef METAUI_HAVE_FONTCONFIG
+#include <fontconfig/fontconfig.h>
+#endif
+
+namespace MetaUI {
+
+// ============================================================================
+// Font Discovery
+// ============================================================================
+
+struct FontFace {
+    std::string path;
+    int index = 0;                  // face within a .ttc/.otc collection
+    std::string family;
+    int weight = 400;               // OS/2 usWeightClass
+    int width = 5;                  // OS/2 usWidthClass (5 = normal)
+    bool italic = false;
+    uint32_t unicodeRanges[4] = {}; // OS/2 ulUnicodeRange1..4
+    
+    bool coversRange(int bit) const {
+        return bit >= 0 && bit < 128 && (unicodeRanges[bit / 32] >> (bit % 32)) & 1;
+    }
+};
+
+// Knows every installed face and resolves (family, bold, italic) to one of
+// them with a single hash lookup. Faces come from fontconfig when built with
+// METAUI_HAVE_FONTCONFIG, otherwise from scanning the font directories;
+// the scan is cached in an index file and only directories whose mtime
+// changed are parsed again, reading just the name and OS/2 tables.
+class FontDatabase {
+public:
+    FontDatabase(std::vector<std::string> directories, std::string indexPath)
+        : directories_(std::move(directories)), indexPath_(std::move(indexPath)) {
+        rescan();
+    }
+    
+    static FontDatabase& shared() {
+        static FontDatabase db(defaultDirectories(), defaultIndexPath());
+        return db;
+    }
+    
+    // family may be a face family ("DejaVu Sans"), a generic name
+    // ("sans-serif", "serif", "monospace") or empty for the default sans.
+    // Unknown families resolve to the default; nullptr only when no fonts
+    // are installed at all.
+    const FontFace* resolve(const std::string& family, bool bold = false, bool italic = false) const {
+        if (const FontFace* face = find(family.empty() ? "sans-serif" : family, bold, italic)) return face;
+        if (const FontFace* face = find("sans-serif", bold, italic)) return face;
+        return faces_.empty() ? nullptr : &faces_.front();
+    }
+    
+    // Whether a font name is a file rather than a family: it contains a
+    // '/' or names an existing file relative to the working directory.
+    static bool isFilePath(const std::string& name) {
+        if (name.find('/') != std::string::npos) return true;
+        struct stat st;
+        return !name.empty() && stat(name.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+    }
+    
+    // Like resolve() but nullptr when the family isn't installed.
+    const FontFace* find(const std::string& family, bool bold = false, bool italic = false) const {
+        auto it = styles_.find(lower(family));
+        if (it == styles_.end()) return nullptr;
+        size_t index = it->second[(bold ? 1 : 0) | (italic ? 2 : 0)];
+        return index < faces_.size() ? &faces_[index] : nullptr;
+    }
+    
+    const std::vector<FontFace>& faces() const { return faces_; }
+    
+    // Font file contents, shared by every Font opened from the same file
+    // while any of them is alive.
+    std::shared_ptr<const std::vector<unsigned char>> fileData(const std::string& path) {
+        std::lock_guard<std::mutex> lock(filesMutex_);
+        auto it = files_.find(path);
+        if (it != files_.end()) {
+            if (auto data = it->second.lock()) return data;
+        }
+        
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return nullptr;
+        fseek(file, 0, SEEK_END);
+        size_t size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        auto data = std::make_shared<std::vector<unsigned char>>(size);
+        bool ok = fread(data->data(), 1, size, file) == size;
+        fclose(file);
+        if (!ok) return nullptr;
+        
+        files_[path] = data;
+        return data;
+    }
+    
+    void rescan() {
+        faces_.clear();
+#ifdef METAUI_HAVE_FONTCONFIG
+        scanFontconfig();
+#endif
+        if (faces_.empty()) scanDirectories();
+        buildStyles();
+    }
+    
+    static std::vector<std::string> defaultDirectories() {
+        std::vector<std::string> dirs;
+        if (const char* extra = getenv("METAUI_FONT_PATH")) {
+            std::string list = extra;
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t end = list.find(':', start);
+                if (end == std::string::npos) end = list.size();
+                if (end > start) dirs.push_back(list.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+        if (const char* home = getenv("HOME")) {
+            dirs.push_back(std::string(home) + "/.local/share/fonts");
+            dirs.push_back(std::string(home) + "/.fonts");
+        }
+        dirs.push_back("/usr/local/share/fonts");
+        dirs.push_back("/usr/share/fonts");
+        return dirs;
+    }
+    
+    static std::string defaultIndexPath() {
+        if (const char* cache = getenv("XDG_CACHE_HOME")) return std::string(cache) + "/metaui/fonts.idx";
+        if (const char* home = getenv("HOME")) return std::string(home) + "/.cache/metaui/fonts.idx";
+        return "";
+    }
+
+private:
+    static constexpr const char* INDEX_HEADER = "metaui-fonts 1";
+    
+    struct Directory {
+        long long mtime = 0;
+        std::vector<std::string> subdirs;
+        std::vector<FontFace> faces;  // paths relative to the directory
+    };
+    
+    std::vector<std::string> directories_;
+    std::string indexPath_;
+    std::vector<FontFace> faces_;
+    // lowercased family or alias -> face per (bold | italic << 1)
+    std::unordered_map<std::string, std::array<uint32_t, 4>> styles_;
+    std::unordered_map<std::string, std::weak_ptr<const std::vector<unsigned char>>> files_;
+    std::mutex filesMutex_;
+    
+    static std::string lower(std::string s) {
+        for (auto& c : s) c = (char)std::tolower((unsigned char)c);
+        return s;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Resolution table
+    // ------------------------------------------------------------------------
+    
+    void buildStyles() {
+        styles_.clear();
+        std::unordered_map<std::string, std::vector<uint32_t>> families;
+        for (uint32_t i = 0; i < faces_.size(); ++i) {
+            families[lower(faces_[i].family)].push_back(i);
+        }
+        
+        for (const auto& [name, members] : families) {
+            std::array<uint32_t, 4> best;
+            for (int style = 0; style < 4; ++style) {
+                int targetWeight = (style & 1) ? 700 : 400;
+                bool targetItalic = style & 2;
+                int bestScore = -1;
+                for (uint32_t i : members) {
+                    const FontFace& f = faces_[i];
+                    int score = std::abs(f.weight - targetWeight) +
+                                std::abs(f.width - 5) * 200 +
+                                (f.italic != targetItalic ? 1000 : 0);
+                    if (bestScore < 0 || score < bestScore) {
+                        bestScore = score;
+                        best[style] = i;
+                    }
+                }
+            }
+            styles_[name] = best;
+        }
+        
+        static const std::vector<std::pair<const char*, std::vector<const char*>>> generics = {
+            {"sans-serif", {"dejavu sans", "noto sans", "liberation sans", "cantarell",
+                            "roboto", "open sans", "arial", "helvetica"}},
+            {"serif", {"dejavu serif", "noto serif", "liberation serif", "times new roman"}},
+            {"monospace", {"dejavu sans mono", "noto sans mono", "liberation mono",
+                           "jetbrains mono", "source code pro", "courier new"}},
+        };
+        for (const auto& [alias, candidates] : generics) {
+            for (const char* candidate : candidates) {
+                auto it = styles_.find(candidate);
+                if (it != styles_.end()) {
+                    styles_[alias] = it->second;
+                    break;
+                }
+            }
+        }
+        if (!styles_.count("sans-serif") && !faces_.empty()) {
+            auto first = styles_.find(lower(faces_.front().family));
+            if (first != styles_.end()) styles_["sans-serif"] = first->second;
+        }
+        auto sans = styles_.find("sans-serif");
+        if (sans != styles_.end()) styles_["sans"] = sans->second;
+        auto mono = styles_.find("monospace");
+        if (mono != styles_.end()) styles_["mono"] = mono->second;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Directory scan with on-disk index
+    // ------------------------------------------------------------------------
+    
+    void scanDirectories() {
+        std::unordered_map<std::string, Directory> cached = readIndex();
+        std::unordered_map<std::string, Directory> current;
+        bool changed = false;
+        
+        std::vector<std::string> pending(directories_.rbegin(), directories_.rend());
+        while (!pending.empty()) {
+            std::string dir = pending.back();
+            pending.pop_back();
+            if (current.count(dir)) continue;
+            
+            struct stat st;
+            if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+            
+            auto it = cached.find(dir);
+            if (it != cached.end() && it->second.mtime == (long long)st.st_mtime) {
+                current[dir] = std::move(it->second);
+            } else {
+                current[dir] = scanDirectory(dir, (long long)st.st_mtime);
+                changed = true;
+            }
+            
+            const Directory& entry = current[dir];
+            for (auto sub = entry.subdirs.rbegin(); sub != entry.subdirs.rend(); ++sub) {
+                pending.push_back(dir + "/" + *sub);
+            }
+            for (const FontFace& face : entry.faces) {
+                faces_.push_back(face);
+                faces_.back().path = dir + "/" + face.path;
+            }
+        }
+        
+        if (changed || current.size() != cached.size()) writeIndex(current);
+    }
+    
+    static Directory scanDirectory(const std::string& dir, long long mtime) {
+        Directory entry;
+        entry.mtime = mtime;
+        DIR* d = opendir(dir.c_str());
+        if (!d) return entry;
+        
+        std::vector<std::string> files;
+        while (dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name == "." || name == "..") continue;
+            
+            struct stat st;
+            if (stat((dir + "/" + name).c_str(), &st) != 0) continue;
+            if (S_ISDIR(st.st_mode)) {
+                entry.subdirs.push_back(name);
+            } else if (isFontFile(name)) {
+                files.push_back(name);
+            }
+        }
+        closedir(d);
+        
+        std::sort(entry.subdirs.begin(), entry.subdirs.end());
+        std::sort(files.begin(), files.end());
+        for (const auto& name : files) {
+            readFaces(dir + "/" + name, name, entry.faces);
+        }
+        return entry;
+    }
+    
+    static bool isFontFile(const std::string& name) {
+        size_t dot = name.rfind('.');
+        if (dot == std::string::npos) return false;
+        std::string ext = lower(name.substr(dot + 1));
+        return ext == "ttf" || ext == "otf" || ext == "ttc" || ext == "otc";
+    }
+    
+    std::unordered_map<std::string, Directory> readIndex() const {
+        std::unordered_map<std::string, Directory> dirs;
+        FILE* file = indexPath_.empty() ? nullptr : fopen(indexPath_.c_str(), "r");
+        if (!file) return dirs;
+        
+        char buffer[4096];
+        Directory* dir = nullptr;
+        bool valid = fgets(buffer, sizeof(buffer), file) &&
+                     std::strncmp(buffer, INDEX_HEADER, std::strlen(INDEX_HEADER)) == 0;
+        while (valid && fgets(buffer, sizeof(buffer), file)) {
+            std::vector<std::string> fields;
+            std::string line(buffer);
+            if (!line.empty() && line.back() == '\n') line.pop_back();
+            size_t start = 0;
+            for (;;) {
+                size_t tab = line.find('\t', start);
+                fields.push_back(line.substr(start, tab - start));
+                if (tab == std::string::npos) break;
+                start = tab + 1;
+            }
+            
+            if (fields[0] == "D" && fields.size() == 3) {
+                dir = &dirs[fields[2]];
+                dir->mtime = std::atoll(fields[1].c_str());
+            } else if (fields[0] == "S" && fields.size() == 2 && dir) {
+                dir->subdirs.push_back(fields[1]);
+            } else if (fields[0] == "F" && fields.size() == 11 && dir) {
+                FontFace face;
+                face.path = fields[1];
+                face.index = std::atoi(fields[2].c_str());
+                face.weight = std::atoi(fields[3].c_str());
+                face.width = std::atoi(fields[4].c_str());
+                face.italic = fields[5] == "1";
+                for (int r = 0; r < 4; ++r) {
+                    face.unicodeRanges[r] = (uint32_t)std::strtoul(fields[6 + r].c_str(), nullptr, 16);
+                }
+                face.family = fields[10];
+                dir->faces.push_back(std::move(face));
+            } else {
+                valid = false;
+            }
+        }
+        fclose(file);
+        if (!valid) dirs.clear();
+        return dirs;
+    }
+    
+    void writeIndex(const std::unordered_map<std::string, Directory>& dirs) const {
+        if (indexPath_.empty()) return;
+        
+        // Create the cache directory chain, then write atomically.
+        for (size_t slash = indexPath_.find('/', 1); slash != std::string::npos;
+             slash = indexPath_.find('/', slash + 1)) {
+            mkdir(indexPath_.substr(0, slash).c_str(), 0755);
+        }
+        std::string temp = indexPath_ + ".tmp";
+        FILE* file = fopen(temp.c_str(), "w");
+        if (!file) return;
+        
+        fprintf(file, "%s\n", INDEX_HEADER);
+        for (const auto& [path, dir] : dirs) {
+            fprintf(file, "D\t%lld\t%s\n", dir.mtime, path.c_str());
+            for (const auto& sub : dir.subdirs) fprintf(file, "S\t%s\n", sub.c_str());
+            for (const auto& f : dir.faces) {
+                fprintf(file, "F\t%s\t%d\t%d\t%d\t%d\t%x\t%x\t%x\t%x\t%s\n",
+                        f.path.c_str(), f.index, f.weight, f.width, f.italic ? 1 : 0,
+                        f.unicodeRanges[0], f.unicodeRanges[1],
+                        f.unicodeRanges[2], f.unicodeRanges[3], f.family.c_str());
+            }
+        }
+        bool ok = fclose(file) == 0;
+        if (ok) rename(temp.c_str(), indexPath_.c_str());
+        else remove(temp.c_str());
+    }
+    
+    // ------------------------------------------------------------------------
+    // SFNT header parsing (name, OS/2 and head tables only)
+    // ------------------------------------------------------------------------
+    
+    static uint16_t be16(const unsigned char* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+    static uint32_t be32(const unsigned char* p) { return (uint32_t)be16(p) << 16 | be16(p + 2); }
+    
+    static bool readAt(FILE* file, long offset, size_t size, std::vector<unsigned char>& out) {
+        out.resize(size);
+        return fseek(file, offset, SEEK_SET) == 0 && fread(out.data(), 1, size, file) == size;
+    }
+    
+    static void readFaces(const std::string& fullPath, const std::string& name,
+                          std::vector<FontFace>& out) {
+        FILE* file = fopen(fullPath.c_str(), "rb");
+        if (!file) return;
+        
+        std::vector<unsigned char> header;
+        std::vector<uint32_t> offsets{0};
+        if (readAt(file, 0, 12, header) && be32(header.data()) == 0x74746366) {  // 'ttcf'
+            uint32_t count = std::min<uint32_t>(be32(header.data() + 8), 256);
+            std::vector<unsigned char> table;
+            offsets.clear();
+            if (readAt(file, 12, count * 4, table)) {
+                for (uint32_t i = 0; i < count; ++i) offsets.push_back(be32(table.data() + i * 4));
+            }
+        }
+        
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            FontFace face;
+            face.path = name;
+            face.index = (int)i;
+            if (readFace(file, offsets[i], face)) out.push_back(std::move(face));
+        }
+        fclose(file);
+    }
+    
+    static bool readFace(FILE* file, uint32_t offset, FontFace& face) {
+        std::vector<unsigned char> buf;
+        if (!readAt(file, offset, 12, buf)) return false;
+        uint16_t numTables = be16(buf.data() + 4);
+        if (!readAt(file, offset + 12, (size_t)numTables * 16, buf)) return false;
+        
+        uint32_t nameOff = 0, nameLen = 0, os2Off = 0, os2Len = 0, headOff = 0;
+        for (uint16_t t = 0; t < numTables; ++t) {
+            const unsigned char* r = buf.data() + t * 16;
+            uint32_t tag = be32(r);
+            if (tag == 0x6E616D65) { nameOff = be32(r + 8); nameLen = be32(r + 12); }  // name
+            if (tag == 0x4F532F32) { os2Off = be32(r + 8); os2Len = be32(r + 12); }    // OS/2
+            if (tag == 0x68656164) { headOff = be32(r + 8); }                          // head
+        }
+        if (!nameOff || nameLen > (1u << 20)) return false;
+        
+        std::vector<unsigned char> name;
+        if (!readAt(file, nameOff, nameLen, name) || !readFamily(name, face.family)) return false;
+        
+        std::vector<unsigned char> os2;
+        if (os2Off && os2Len >= 64 && readAt(file, os2Off, 64, os2)) {
+            face.weight = be16(os2.data() + 4);
+            face.width = be16(os2.data() + 6);
+            for (int r = 0; r < 4; ++r) face.unicodeRanges[r] = be32(os2.data() + 42 + r * 4);
+            uint16_t selection = be16(os2.data() + 62);
+            face.italic = selection & 0x201;  // ITALIC | OBLIQUE
+            if ((selection & 0x20) && face.weight < 600) face.weight = 700;
+        } else if (headOff && readAt(file, headOff + 44, 2, os2)) {
+            uint16_t macStyle = be16(os2.data());
+            face.weight = (macStyle & 1) ? 700 : 400;
+            face.italic = macStyle & 2;
+        }
+        if (face.weight <= 0 || face.weight > 1000) face.weight = 400;
+        if (face.width < 1 || face.width > 9) face.width = 5;
+        return true;
+    }
+    
+    // Typographic family (name ID 16) when present, else the legacy family
+    // (ID 1). Windows English names are preferred over Mac Roman ones.
+    static bool readFamily(const std::vector<unsigned char>& name, std::string& family) {
+        if (name.size() < 6) return false;
+        uint16_t count = be16(name.data() + 2);
+        uint16_t storage = be16(name.data() + 4);
+        
+        int bestScore = -1;
+        for (uint16_t i = 0; i < count; ++i) {
+            size_t r = 6 + (size_t)i * 12;
+            if (r + 12 > name.size()) break;
+            uint16_t platform = be16(&name[r]), language = be16(&name[r + 4]);
+            uint16_t id = be16(&name[r + 6]);
+            uint16_t length = be16(&name[r + 8]), offset = be16(&name[r + 10]);
+            if (id != 1 && id != 16) continue;
+            if ((size_t)storage + offset + length > name.size()) continue;
+            
+            bool windows = platform == 3 || platform == 0;
+            if (!windows && platform != 1) continue;
+            int score = (id == 16 ? 4 : 0) + (windows ? 2 : 0) +
+                        ((windows && language == 0x409) || (!windows && language == 0) ? 1 : 0);
+            if (score <= bestScore) continue;
+            
+            const unsigned char* s = name.data() + storage + offset;
+            std::string decoded;
+            if (windows) {
+                for (uint16_t k = 0; k + 1 < length; k += 2) appendUtf8(decoded, be16(s + k));
+            } else {
+                decoded.assign(reinterpret_cast<const char*>(s), length);
+            }
+            if (decoded.empty() || decoded.find('\t') != std::string::npos) continue;
+            family = decoded;
+            bestScore = score;
+        }
+        return bestScore >= 0;
+    }
+    
+    static void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | cp >> 6);
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xE0 | cp >> 12);
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+#ifdef METAUI_HAVE_FONTCONFIG
+    // ------------------------------------------------------------------------
+    // fontconfig (keeps its own cache, so no index file is written)
+    // ------------------------------------------------------------------------
+    
+    void scanFontconfig() {
+        FcConfig* config = FcInitLoadConfigAndFonts();
+        if (!config) return;
+        
+        FcPattern* pattern = FcPatternCreate();
+        FcObjectSet* objects = FcObjectSetBuild(FC_FILE, FC_INDEX, FC_FAMILY, FC_WEIGHT,
+                                                FC_SLANT, FC_WIDTH, nullptr);
+        FcFontSet* set = FcFontList(config, pattern, objects);
+        
+        for (int i = 0; set && i < set->nfont; ++i) {
+            FcPattern* p = set->fonts[i];
+            FcChar8* file = nullptr;
+            FcChar8* family = nullptr;
+            if (FcPatternGetString(p, FC_FILE, 0, &file) != FcResultMatch ||
+                FcPatternGetString(p, FC_FAMILY, 0, &family) != FcResultMatch ||
+                !isFontFile(reinterpret_cast<const char*>(file))) {
+                continue;
+            }
+            
+            FontFace face;
+            face.path = reinterpret_cast<const char*>(file);
+            face.family = reinterpret_cast<const char*>(family);
+            int index = 0, weight = FC_WEIGHT_REGULAR, slant = FC_SLANT_ROMAN, width = FC_WIDTH_NORMAL;
+            FcPatternGetInteger(p, FC_INDEX, 0, &index);
+            FcPatternGetInteger(p, FC_WEIGHT, 0, &weight);
+            FcPatternGetInteger(p, FC_SLANT, 0, &slant);
+            FcPatternGetInteger(p, FC_WIDTH, 0, &width);
+            face.index = index & 0xFFFF;  // high bits select variable instances
+            face.weight = FcWeightToOpenType(weight);
+            face.italic = slant != FC_SLANT_ROMAN;
+            // fontconfig widths are percentages; 100 is class 5.
+            static const int widths[] = {50, 62, 75, 87, 100, 112, 125, 150, 200};
+            face.width = 1;
+            for (int c = 1; c < 9; ++c) {
+                if (std::abs(widths[c] - width) < std::abs(widths[face.width - 1] - width)) face.width = c + 1;
+            }
+            faces_.push_back(std::move(face));
+        }
+        
+        if (set) FcFontSetDestroy(set);
+        FcObjectSetDestroy(objects);
+        FcPatternDestroy(pattern);
+        FcConfigDestroy(config);
+    }
+#endif
+};
+
+} // namespace MetaUI
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MetaUI {
+
+// ============================================================================
+// Shared Glyph Atlas
+// ============================================================================
+
+// A font atlas (bitmap plus glyph index) in a POSIX shared memory segment,
+// keyed by font file, size and atlas layout. Every MetaUI process of a user
+// that opens the same font maps the same segment, so each glyph is
+// rasterized once per seat and the atlas bitmap exists once in RAM.
+//
+// The index is an append-only open-addressing table. A writer claims a slot
+// with a CAS on its key, reserves atlas space with a CAS on the packed shelf
+// cursor, rasterizes into the region it now owns and publishes the glyph
+// with a release store. Nothing is ever removed, so readers take no locks.
+//
+// Segments are unlinked when their last user closes them, and retired
+// (unlinked while still mapped) once the bitmap or index fills up, so the
+// next process to open the font starts a fresh one. A segment from another
+// version, or one whose creator died before initializing it, is replaced.
+//
+// Users are tracked by pid, so processes that crash don't keep a segment
+// alive: one left with no live users is unlinked when the font is next
+// closed, or when the same user next creates any segment. Until then at
+// most one such segment per font and size stays in /dev/shm. A reused pid
+// can delay that until the new process exits.
+class SharedGlyphAtlas {
+public:
+    static constexpr uint32_t MAGIC = 0x4D554741;  // "MUGA"
+    static constexpr uint32_t VERSION = 3;
+    static constexpr uint32_t INDEX_SLOTS = 8192;
+    static constexpr uint32_t MAX_USERS = 64;      // more processes keep private atlases
+    
+    struct Glyph {
+        float u0, v0, u1, v1;
+        float x0, y0, x1, y1;
+        float advance;
+        int32_t width, height;
+    };
+    
+    // Maps (creating on first use) the segment for identity, which must
+    // change whenever the glyphs would: font file, its mtime, pixel size.
+    // Returns nullptr if shared memory isn't usable; callers then keep a
+    // private atlas.
+    static std::unique_ptr<SharedGlyphAtlas> open(const std::string& identity,
+                                                  int width, int height) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/%s%016llx",
+                      prefix().c_str(), (unsigned long long)hash(identity, width, height));
+        bool stale = false;
+        std::unique_ptr<SharedGlyphAtlas> atlas = open(name, width, height, stale);
+        if (!atlas && stale) {
+            shm_unlink(name);
+            atlas = open(name, width, height, stale);
+        }
+        return atlas;
+    }
+    
+    ~SharedGlyphAtlas() {
+        header_->users[user_].store(0, std::memory_order_release);
+        if (!hasLiveUsers(*header_)) retire();
+        munmap(header_, size_);
+    }
+    
+    SharedGlyphAtlas(const SharedGlyphAtlas&) = delete;
+    SharedGlyphAtlas& operator=(const SharedGlyphAtlas&) = delete;
+    
+    unsigned char* pixels() { return reinterpret_cast<unsigned char*>(header_ + 1); }
+    
+    // Returns true with out filled when the glyph is published (waiting
+    // briefly if another process is writing it). Otherwise owned is the slot
+    // the caller just claimed and must publish() or fail(), or -1 when the
+    // glyph can't be shared (table full, or its writer died mid-way).
+    bool find(uint32_t key, Glyph& out, int& owned) {
+        owned = -1;
+        uint32_t tag = key + 1;
+        uint32_t mask = INDEX_SLOTS - 1;
+        uint32_t i = (uint32_t)(mix(key) & mask);
+        
+        for (uint32_t probe = 0; probe < INDEX_SLOTS; ++probe, i = (i + 1) & mask) {
+            Slot& slot = header_->slots[i];
+            uint32_t current = slot.key.load(std::memory_order_acquire);
+            if (current == 0) {
+                if (slot.key.compare_exchange_strong(current, tag, std::memory_order_acq_rel)) {
+                    owned = (int)i;
+                    return false;
+                }
+                // Lost the race; current now holds the winner's key.
+            }
+            if (current != tag) continue;
+            
+            if (!waitFor([&] { return slot.state.load(std::memory_order_acquire) != WRITING; })) {
+                return false;
+            }
+            if (slot.state.load(std::memory_order_acquire) != READY) return false;
+            out = slot.glyph;
+            return true;
+        }
+        retire();
+        return false;
+    }
+    
+    void publish(int slot, const Glyph& glyph) {
+        header_->slots[slot].glyph = glyph;
+        header_->slots[slot].state.store(READY, std::memory_order_release);
+    }
+    
+    void fail(int slot) {
+        header_->slots[slot].state.store(FAILED, std::memory_order_release);
+    }
+    
+    // Shelf allocation shared by all processes; the region is the caller's.
+    bool reserve(int w, int h, int& x, int& y) {
+        uint64_t current = header_->cursor.load(std::memory_order_relaxed);
+        for (;;) {
+            uint32_t cx = cursorX(current), cy = cursorY(current), row = cursorRow(current);
+            if (cx + w + 1 >= header_->width) {
+                cx = 1;
+                cy += row + 1;
+                row = 0;
+            }
+            if (cy + h + 1 >= header_->height) {
+                retire();
+                return false;
+            }
+            
+            uint64_t next = packCursor(cx + w + 1, cy, std::max<uint32_t>(row, (uint32_t)h));
+            if (header_->cursor.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+                x = (int)cx;
+                y = (int)cy;
+                return true;
+            }
+        }
+    }
+
+private:
+    enum : uint32_t { WRITING = 0, READY = 1, FAILED = 2 };
+    
+    struct Slot {
+        std::atomic<uint32_t> key;    // glyph key + 1; 0 = empty
+        std::atomic<uint32_t> state;
+        Glyph glyph;
+    };
+    
+    struct Header {
+        std::atomic<uint32_t> magic;
+        uint32_t version;
+        uint32_t width, height;
+        std::atomic<int32_t> users[MAX_USERS];  // pids with the segment open; 0 = free
+        std::atomic<uint32_t> unlinked;  // the name no longer refers to this segment
+        std::atomic<uint64_t> cursor;  // x:21 | y:21 | rowHeight:21
+        Slot slots[INDEX_SLOTS];
+    };
+    
+    static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+                  "shared atlas needs address-free atomics");
+    
+    Header* header_;
+    size_t size_;
+    std::string name_;
+    int user_;
+    
+    SharedGlyphAtlas(void* memory, size_t size, const char* name, int user)
+        : header_(static_cast<Header*>(memory)), size_(size), name_(name), user_(user) {}
+    
+    // stale is set when a segment exists under name but can't be used.
+    static std::unique_ptr<SharedGlyphAtlas> open(const char* name, int width, int height, bool& stale) {
+        stale = false;
+        size_t size = sizeof(Header) + (size_t)width * height;
+        
+        bool creator = true;
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            creator = false;
+            fd = shm_open(name, O_RDWR, 0600);
+        }
+        if (fd < 0) return nullptr;
+        
+        if (creator) {
+            if (ftruncate(fd, (off_t)size) != 0) {
+                close(fd);
+                shm_unlink(name);
+                return nullptr;
+            }
+        } else if (!waitFor([&] {
+                       struct stat st;
+                       return fstat(fd, &st) == 0 && (size_t)st.st_size >= size;
+                   })) {
+            close(fd);
+            stale = true;
+            return nullptr;
+        }
+        
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) return nullptr;
+        
+        Header* header = static_cast<Header*>(memory);
+        int user = 0;
+        if (creator) {
+            // ftruncate zero-fills, so every slot already reads as empty.
+            header->version = VERSION;
+            header->width = (uint32_t)width;
+            header->height = (uint32_t)height;
+            header->cursor.store(packCursor(1, 1, 0), std::memory_order_relaxed);
+            header->users[0].store((int32_t)getpid(), std::memory_order_relaxed);
+            header->magic.store(MAGIC, std::memory_order_release);
+            sweepOrphans(name);
+        } else if (!waitFor([&] { return header->magic.load(std::memory_order_acquire) == MAGIC; }) ||
+                   header->version != VERSION ||
+                   header->width != (uint32_t)width || header->height != (uint32_t)height) {
+            munmap(memory, size);
+            stale = true;
+            return nullptr;
+        } else if ((user = claimUser(*header)) < 0) {
+            munmap(memory, size);
+            return nullptr;
+        }
+        return std::unique_ptr<SharedGlyphAtlas>(new SharedGlyphAtlas(memory, size, name, user));
+    }
+    
+    static std::string prefix() {
+        return "metaui-glyphs-" + std::to_string((unsigned)getuid()) + "-";
+    }
+    
+    static bool alive(int32_t pid) {
+        return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+    }
+    
+    // Frees the slots of processes that exited without closing.
+    static bool hasLiveUsers(Header& header) {
+        bool live = false;
+        for (auto& user : header.users) {
+            int32_t pid = user.load(std::memory_order_acquire);
+            if (pid == 0) continue;
+            if (alive(pid)) live = true;
+            else user.compare_exchange_strong(pid, 0, std::memory_order_acq_rel);
+        }
+        return live;
+    }
+    
+    static int claimUser(Header& header) {
+        int32_t self = (int32_t)getpid();
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            for (uint32_t i = 0; i < MAX_USERS; ++i) {
+                int32_t expected = 0;
+                if (header.users[i].compare_exchange_strong(expected, self, std::memory_order_acq_rel)) {
+                    return (int)i;
+                }
+            }
+            hasLiveUsers(header);
+        }
+        return -1;
+    }
+    
+    // Unlinks this user's segments whose users all died without closing
+    // them. Segments of other versions or still being created are left.
+    static void sweepOrphans(const char* keep) {
+        DIR* dir = opendir("/dev/shm");
+        if (!dir) return;
+        std::string ours = prefix();
+        while (dirent* entry = readdir(dir)) {
+            std::string name = std::string("/") + entry->d_name;
+            if (name.compare(1, ours.size(), ours) != 0 || name == keep) continue;
+            int fd = shm_open(name.c_str(), O_RDWR, 0600);
+            if (fd < 0) continue;
+            struct stat st;
+            void* memory = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Header)) {
+                memory = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (memory == MAP_FAILED) continue;
+            Header* header = static_cast<Header*>(memory);
+            if (header->magic.load(std::memory_order_acquire) == MAGIC && header->version == VERSION &&
+                !hasLiveUsers(*header) && header->unlinked.exchange(1, std::memory_order_acq_rel) == 0) {
+                shm_unlink(name.c_str());
+            }
+            munmap(memory, sizeof(Header));
+        }
+        closedir(dir);
+    }
+    
+    // Unlinks the name once per segment, so a retired segment can't take a
+    // newer one with the same name down with it. Mappings stay valid.
+    void retire() {
+        if (header_->unlinked.exchange(1, std::memory_order_acq_rel) == 0) shm_unlink(name_.c_str());
+    }
+    
+    static uint64_t packCursor(uint32_t x, uint32_t y, uint32_t row) {
+        return (uint64_t)x << 42 | (uint64_t)y << 21 | row;
+    }
+    static uint32_t cursorX(uint64_t c) { return (uint32_t)(c >> 42) & 0x1FFFFF; }
+    static uint32_t cursorY(uint64_t c) { return (uint32_t)(c >> 21) & 0x1FFFFF; }
+    static uint32_t cursorRow(uint64_t c) { return (uint32_t)c & 0x1FFFFF; }
+    
+    static uint64_t mix(uint64_t v) {
+        v ^= v >> 33;
+        v *= 0xff51afd7ed558ccdULL;
+        v ^= v >> 33;
+        return v;
+    }
+    
+    static uint64_t hash(const std::string& identity, int width, int height) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        auto feed = [&](const void* data, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                h ^= static_cast<const unsigned char*>(data)[i];
+                h *= 0x100000001b3ULL;
+            }
+        };
+        uint32_t layout[3] = {VERSION, (uint32_t)width, (uint32_t)height};
+        feed(identity.data(), identity.size());
+        feed(layout, sizeof(layout));
+        return h;
+    }
+    
+    // Spins, then yields, for up to ~250ms: long enough for any live writer,
+    // short enough that a crashed one only costs a fallback glyph.
+    template<typename Pred>
+    static bool waitFor(Pred ready) {
+        for (int i = 0; i < 64; ++i) {
+            if (ready()) return true;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(250);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (ready()) return true;
+            std::this_thread::yield();
+        }
+        return ready();
+    }
+};
+
+} // namespace MetaUI
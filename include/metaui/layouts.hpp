@@ -13,10 +13,10 @@ class Box : public Container {
 public:
     explicit Box(Direction dir = Direction::Horizontal) : direction_(dir) {}
     
-    Box& direction(Direction dir) { direction_ = dir; return *this; }
-    Box& spacing(float s) { spacing_ = s; return *this; }
-    Box& align(Alignment a) { alignment_ = a; return *this; }
-    Box& crossAlign(Alignment a) { crossAlignment_ = a; return *this; }
+    Box& direction(Direction dir) { direction_ = dir; requestRedraw(); return *this; }
+    Box& spacing(float s) { spacing_ = s; requestRedraw(); return *this; }
+    Box& align(Alignment a) { alignment_ = a; requestRedraw(); return *this; }
+    Box& crossAlign(Alignment a) { crossAlignment_ = a; requestRedraw(); return *this; }
     
     Size measureContent(Size available) override {
         if (children_.empty()) return Size(0, 0);
@@ -122,6 +122,7 @@ public:
     Stack& align(Alignment h, Alignment v) {
         horizontalAlign_ = h;
         verticalAlign_ = v;
+        requestRedraw();
         return *this;
     }
     
@@ -163,9 +164,9 @@ private:
 
 class Grid : public Container {
 public:
-    Grid& columns(int cols) { columns_ = cols; return *this; }
-    Grid& spacing(float s) { spacing_ = s; return *this; }
-    Grid& cellSize(Size s) { cellSize_ = s; return *this; }
+    Grid& columns(int cols) { columns_ = cols; requestRedraw(); return *this; }
+    Grid& spacing(float s) { spacing_ = s; requestRedraw(); return *this; }
+    Grid& cellSize(Size s) { cellSize_ = s; requestRedraw(); return *this; }
     
     Size measureContent(Size available) override {
         if (children_.empty() || columns_ <= 0) return Size(0, 0);
@@ -211,7 +212,7 @@ private:
 
 class ScrollView : public Container {
 public:
-    ScrollView& scrollDirection(Direction dir) { scrollDir_ = dir; return *this; }
+    ScrollView& scrollDirection(Direction dir) { scrollDir_ = dir; requestRedraw(); return *this; }
     
     Size measureContent(Size available) override {
         if (children_.empty()) return Size(0, 0);
@@ -267,8 +268,8 @@ public:
     Sidebar(Position pos = Position::Left, float size = 200)
         : position_(pos), sidebarSize_(size) {}
     
-    Sidebar& position(Position pos) { position_ = pos; return *this; }
-    Sidebar& sidebarSize(float size) { sidebarSize_ = size; return *this; }
+    Sidebar& position(Position pos) { position_ = pos; requestRedraw(); return *this; }
+    Sidebar& sidebarSize(float size) { sidebarSize_ = size; requestRedraw(); return *this; }
     
     void layoutChildren() override {
         if (children_.size() < 2) return;
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace MetaUI {
+
+// ============================================================================
+// Latency Histogram
+// ============================================================================
+
+// Millisecond samples in fixed 0.25 ms buckets up to 250 ms; slower samples
+// count in the last bucket. Min, max and mean are exact, percentiles are
+// bucket upper bounds.
+class LatencyHistogram {
+public:
+    static constexpr double BUCKET_MS = 0.25;
+    static constexpr size_t BUCKET_COUNT = 1000;
+    
+    LatencyHistogram() : buckets_(BUCKET_COUNT, 0) {}
+    
+    void add(double ms) {
+        ms = std::max(0.0, ms);
+        size_t bucket = std::min(BUCKET_COUNT - 1, (size_t)(ms / BUCKET_MS));
+        buckets_[bucket]++;
+        count_++;
+        sum_ += ms;
+        min_ = std::min(min_, ms);
+        max_ = std::max(max_, ms);
+    }
+    
+    void clear() {
+        std::fill(buckets_.begin(), buckets_.end(), 0);
+        count_ = 0;
+        sum_ = 0;
+        min_ = std::numeric_limits<double>::max();
+        max_ = 0;
+    }
+    
+    size_t count() const { return count_; }
+    double min() const { return count_ ? min_ : 0; }
+    double max() const { return max_; }
+    double mean() const { return count_ ? sum_ / count_ : 0; }
+    
+    // p in [0, 1], e.g. 0.99 for the 99th percentile.
+    double percentile(double p) const {
+        if (count_ == 0) return 0;
+        size_t rank = (size_t)std::ceil(std::clamp(p, 0.0, 1.0) * count_);
+        size_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets_[i];
+            if (seen >= std::max<size_t>(rank, 1)) return std::min(max_, (i + 1) * BUCKET_MS);
+        }
+        return max_;
+    }
+    
+    const std::vector<uint32_t>& buckets() const { return buckets_; }
+
+private:
+    std::vector<uint32_t> buckets_;
+    size_t count_ = 0;
+    double sum_ = 0;
+    double min_ = std::numeric_limits<double>::max();
+    double max_ = 0;
+};
+
+// ============================================================================
+// Presentation Metrics
+// ============================================================================
+
+// Filled from wp_presentation feedback on the window surface (see
+// Application::presentationMetrics).
+struct PresentationMetrics {
+    // Input event timestamp to the frame that handled it being shown.
+    LatencyHistogram inputToPresent;
+    // Start of the frame's render to it being shown.
+    LatencyHistogram renderToPresent;
+    // Between consecutive presented frames.
+    LatencyHistogram frameInterval;
+    
+    uint64_t presented = 0;
+    uint64_t discarded = 0;
+    uint32_t refreshNs = 0;     // output refresh period, 0 if unknown
+    
+    void clear() {
+        inputToPresent.clear();
+        renderToPresent.clear();
+        frameInterval.clear();
+        presented = discarded = 0;
+    }
+};
+
+} // namespace MetaUI
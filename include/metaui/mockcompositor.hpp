@@ -0,0 +1,751 @@
+#pragma once
+
+#include <wayland-server.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+#include "xdg-shell-server-protocol.h"
+#define namespace namespace_workaround
+extern "C" {
+#include "wlr-layer-shell-unstable-v1-server-protocol.h"
+}
+#undef namespace
+
+namespace MetaUI {
+
+// ============================================================================
+// Mock Compositor
+// ============================================================================
+
+// A committed shm buffer, copied out before the buffer is released.
+struct MockFrame {
+    uint32_t surface = 0;       // wl_surface object id
+    int width = 0, height = 0;  // 0 for non-shm buffers
+    uint32_t format = 0;        // WL_SHM_FORMAT_*
+    std::vector<uint8_t> pixels;    // packed rows; empty unless collectPixels()
+    uint64_t time = 0;          // commit time, CLOCK_MONOTONIC ns
+};
+
+// In-process compositor for integration tests and benchmarks without a
+// desktop. It serves one client over a socketpair from its own thread and
+// exports WAYLAND_SOCKET, so the next wl_display_connect(nullptr) in the
+// process (e.g. Application's constructor) connects to it:
+//
+//   MockCompositor compositor;
+//   Application app("Test", 400, 300);
+//   compositor.pointerMotion(10, 10);
+//   compositor.waitForFrames(1, std::chrono::seconds(1));
+//   compositor.closeSurface();     // app.run() returns
+//
+// Offers wl_compositor, wl_shm, wl_seat, zwlr_layer_shell_v1 and
+// xdg_wm_base. With no GPU buffer protocol EGL falls back to Mesa's
+// software path and commits shm buffers, which are what gets collected.
+// Destroy the client before the compositor.
+class MockCompositor {
+public:
+    explicit MockCompositor(int outputWidth = 1920, int outputHeight = 1080)
+        : outputWidth_(outputWidth), outputHeight_(outputHeight) {
+        display_ = wl_display_create();
+        if (!display_) throw std::runtime_error("Failed to create Wayland display");
+        loop_ = wl_display_get_event_loop(display_);
+        wl_display_init_shm(display_);
+        createGlobals();
+        
+        taskFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        tickFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        if (taskFd_ < 0 || tickFd_ < 0) throw std::runtime_error("Failed to create compositor timers");
+        wl_event_loop_add_fd(loop_, taskFd_, WL_EVENT_READABLE, runTasks, this);
+        wl_event_loop_add_fd(loop_, tickFd_, WL_EVENT_READABLE, onTick, this);
+        setRefreshInterval(std::chrono::nanoseconds(16666667));
+        
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+            throw std::runtime_error("Failed to create client socket");
+        if (!wl_client_create(display_, fds[0])) {
+            close(fds[0]);
+            close(fds[1]);
+            throw std::runtime_error("Failed to create Wayland client");
+        }
+        clientFd_ = fds[1];
+        setenv("WAYLAND_SOCKET", std::to_string(clientFd_).c_str(), 1);
+        
+        running_ = true;
+        thread_ = std::thread([this] {
+            while (running_) {
+                wl_event_loop_dispatch(loop_, -1);
+                wl_display_flush_clients(display_);
+            }
+        });
+    }
+    
+    ~MockCompositor() {
+        post([this] { running_ = false; });
+        if (thread_.joinable()) thread_.join();
+        
+        // Never connected: take the socket back.
+        const char* socket = getenv("WAYLAND_SOCKET");
+        if (socket && std::atoi(socket) == clientFd_) {
+            unsetenv("WAYLAND_SOCKET");
+            close(clientFd_);
+        }
+        wl_display_destroy_clients(display_);
+        wl_display_destroy(display_);
+        close(taskFd_);
+        close(tickFd_);
+    }
+    
+    MockCompositor(const MockCompositor&) = delete;
+    MockCompositor& operator=(const MockCompositor&) = delete;
+    
+    // Frame callbacks are answered on this period, like an output's vblank.
+    void setRefreshInterval(std::chrono::nanoseconds interval) {
+        long long ns = std::max<long long>(1, interval.count());
+        itimerspec spec = {};
+        spec.it_interval.tv_sec = ns / 1000000000;
+        spec.it_interval.tv_nsec = ns % 1000000000;
+        spec.it_value = spec.it_interval;
+        timerfd_settime(tickFd_, 0, &spec, nullptr);
+    }
+    
+    // Keep the pixels of committed buffers; off, frames carry only their
+    // size and time, which is all a pacing benchmark needs.
+    void collectPixels(bool collect) { collectPixels_ = collect; }
+    
+    // Input goes to the most recently configured surface, in its local
+    // coordinates, entering it first if needed. Callable from any thread;
+    // events are sent from the compositor thread.
+    void pointerMotion(float x, float y) {
+        post([this, x, y] {
+            pointerX_ = x;
+            pointerY_ = y;
+            if (!focusPointer()) return;
+            uint32_t time = timeMs();
+            forEachFocused(pointers_, [&](wl_resource* pointer) {
+                wl_pointer_send_motion(pointer, time, wl_fixed_from_double(x), wl_fixed_from_double(y));
+                sendPointerFrame(pointer);
+            });
+        });
+    }
+    
+    void pointerButton(uint32_t button, bool pressed) {
+        post([this, button, pressed] {
+            if (!focusPointer()) return;
+            uint32_t serial = wl_display_next_serial(display_);
+            uint32_t time = timeMs();
+            uint32_t state = pressed ? WL_POINTER_BUTTON_STATE_PRESSED : WL_POINTER_BUTTON_STATE_RELEASED;
+            forEachFocused(pointers_, [&](wl_resource* pointer) {
+                wl_pointer_send_button(pointer, serial, time, button, state);
+                sendPointerFrame(pointer);
+            });
+        });
+    }
+    
+    void pointerAxis(bool vertical, float value) {
+        post([this, vertical, value] {
+            if (!focusPointer()) return;
+            uint32_t time = timeMs();
+            uint32_t axis = vertical ? WL_POINTER_AXIS_VERTICAL_SCROLL : WL_POINTER_AXIS_HORIZONTAL_SCROLL;
+            forEachFocused(pointers_, [&](wl_resource* pointer) {
+                wl_pointer_send_axis(pointer, time, axis, wl_fixed_from_double(value));
+                sendPointerFrame(pointer);
+            });
+        });
+    }
+    
+    void key(uint32_t keycode, bool pressed) {
+        post([this, keycode, pressed] {
+            if (!focusKeyboard()) return;
+            uint32_t serial = wl_display_next_serial(display_);
+            uint32_t time = timeMs();
+            uint32_t state = pressed ? WL_KEYBOARD_KEY_STATE_PRESSED : WL_KEYBOARD_KEY_STATE_RELEASED;
+            forEachFocused(keyboards_, [&](wl_resource* keyboard) {
+                wl_keyboard_send_key(keyboard, serial, time, keycode, state);
+            });
+        });
+    }
+    
+    // Sends the most recently configured surface a new size, as an output
+    // change or an interactive resize would; 0 lets the client pick.
+    void configureSurface(int width, int height) {
+        post([this, width, height] {
+            if (focus_) sendConfigure(*focus_, (uint32_t)std::max(0, width), (uint32_t)std::max(0, height));
+        });
+    }
+    
+    // Asks the most recently configured surface to go away: closed for a
+    // layer surface, close for a toplevel.
+    void closeSurface() {
+        post([this] {
+            if (!focus_) return;
+            if (focus_->role == Role::Layer) zwlr_layer_surface_v1_send_closed(focus_->roleResource);
+            else if (focus_->role == Role::Toplevel) xdg_toplevel_send_close(focus_->toplevel);
+        });
+    }
+    
+    // Frames committed so far, including ones already taken.
+    size_t frameCount() const {
+        std::lock_guard<std::mutex> lock(framesMutex_);
+        return committed_;
+    }
+    
+    bool waitForFrames(size_t count, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(framesMutex_);
+        return framesCv_.wait_for(lock, timeout, [&] { return committed_ >= count; });
+    }
+    
+    std::vector<MockFrame> takeFrames() {
+        std::lock_guard<std::mutex> lock(framesMutex_);
+        std::vector<MockFrame> frames;
+        frames.swap(frames_);
+        return frames;
+    }
+    
+    uint64_t frameCallbacksDone() const { return callbacksDone_; }
+
+private:
+    enum class Role { None, Layer, Toplevel };
+    
+    struct Surface;
+    // Clears a pending attach when the client destroys the buffer first.
+    // The listener is the first member so the notify callback can cast back.
+    struct BufferRef {
+        wl_listener destroyed;
+        Surface* surface;
+    };
+    
+    struct Surface {
+        MockCompositor* compositor = nullptr;
+        wl_resource* resource = nullptr;
+        wl_resource* buffer = nullptr;
+        BufferRef bufferRef = {};
+        std::vector<wl_resource*> pendingCallbacks;
+        Role role = Role::None;
+        wl_resource* roleResource = nullptr;    // layer surface or xdg_surface
+        wl_resource* toplevel = nullptr;
+        bool configured = false;
+        uint32_t width = 0, height = 0;         // requested layer-surface size
+    };
+    
+    int outputWidth_, outputHeight_;
+    wl_display* display_ = nullptr;
+    wl_event_loop* loop_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int clientFd_ = -1;
+    
+    int taskFd_ = -1;
+    std::mutex tasksMutex_;
+    std::deque<std::function<void()>> tasks_;
+    
+    int tickFd_ = -1;
+    std::vector<wl_resource*> frameCallbacks_;
+    std::atomic<uint64_t> callbacksDone_{0};
+    
+    // Compositor-thread state
+    std::vector<Surface*> surfaces_;
+    std::vector<wl_resource*> pointers_;
+    std::vector<wl_resource*> keyboards_;
+    Surface* focus_ = nullptr;
+    Surface* pointerFocus_ = nullptr;
+    Surface* keyboardFocus_ = nullptr;
+    float pointerX_ = 0, pointerY_ = 0;
+    
+    std::atomic<bool> collectPixels_{false};
+    mutable std::mutex framesMutex_;
+    std::condition_variable framesCv_;
+    std::vector<MockFrame> frames_;
+    size_t committed_ = 0;
+    
+    static uint64_t timeNs() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+    
+    static uint32_t timeMs() { return (uint32_t)(timeNs() / 1000000); }
+    
+    static MockCompositor* self(wl_resource* resource) {
+        return static_cast<MockCompositor*>(wl_resource_get_user_data(resource));
+    }
+    
+    static Surface* surfaceFrom(wl_resource* resource) {
+        return static_cast<Surface*>(wl_resource_get_user_data(resource));
+    }
+    
+    static void destroyResource(wl_client*, wl_resource* resource) { wl_resource_destroy(resource); }
+    
+    static wl_resource* createResource(wl_client* client, const wl_interface* interface, int version,
+                                       uint32_t id, const void* impl, void* data,
+                                       wl_resource_destroy_func_t destroy = nullptr) {
+        wl_resource* resource = wl_resource_create(client, interface, version, id);
+        if (!resource) {
+            wl_client_post_no_memory(client);
+            return nullptr;
+        }
+        wl_resource_set_implementation(resource, impl, data, destroy);
+        return resource;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Cross-thread tasks and frame ticks
+    // ------------------------------------------------------------------------
+    
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex_);
+            tasks_.push_back(std::move(task));
+        }
+        uint64_t one = 1;
+        ssize_t written = write(taskFd_, &one, sizeof(one));
+        (void)written;
+    }
+    
+    static int runTasks(int fd, uint32_t, void* data) {
+        auto* compositor = static_cast<MockCompositor*>(data);
+        uint64_t count;
+        ssize_t got = read(fd, &count, sizeof(count));
+        (void)got;
+        std::deque<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(compositor->tasksMutex_);
+            tasks.swap(compositor->tasks_);
+        }
+        for (auto& task : tasks) task();
+        return 0;
+    }
+    
+    static int onTick(int fd, uint32_t, void* data) {
+        auto* compositor = static_cast<MockCompositor*>(data);
+        uint64_t expirations;
+        ssize_t got = read(fd, &expirations, sizeof(expirations));
+        (void)got;
+        std::vector<wl_resource*> callbacks;
+        callbacks.swap(compositor->frameCallbacks_);
+        uint32_t time = timeMs();
+        for (wl_resource* callback : callbacks) {
+            wl_callback_send_done(callback, time);
+            wl_resource_destroy(callback);
+        }
+        compositor->callbacksDone_ += callbacks.size();
+        return 0;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Globals
+    // ------------------------------------------------------------------------
+    
+    void createGlobals() {
+        wl_global_create(display_, &wl_compositor_interface, 4, this,
+            [](wl_client* client, void* data, uint32_t version, uint32_t id) {
+                static const struct wl_compositor_interface impl = {
+                    .create_surface = [](wl_client* client, wl_resource* resource, uint32_t id) {
+                        self(resource)->createSurface(client, wl_resource_get_version(resource), id);
+                    },
+                    .create_region = [](wl_client* client, wl_resource*, uint32_t id) {
+                        static const struct wl_region_interface regionImpl = {
+                            .destroy = destroyResource,
+                            .add = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {},
+                            .subtract = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {}
+                        };
+                        createResource(client, &wl_region_interface, 1, id, &regionImpl, nullptr);
+                    }
+                };
+                createResource(client, &wl_compositor_interface, version, id, &impl, data);
+            });
+        
+        wl_global_create(display_, &wl_seat_interface, 5, this,
+            [](wl_client* client, void* data, uint32_t version, uint32_t id) {
+                static const struct wl_seat_interface impl = {
+                    .get_pointer = [](wl_client* client, wl_resource* resource, uint32_t id) {
+                        self(resource)->createPointer(client, wl_resource_get_version(resource), id);
+                    },
+                    .get_keyboard = [](wl_client* client, wl_resource* resource, uint32_t id) {
+                        self(resource)->createKeyboard(client, wl_resource_get_version(resource), id);
+                    },
+                    .get_touch = [](wl_client* client, wl_resource* resource, uint32_t id) {
+                        static const struct wl_touch_interface touchImpl = { .release = destroyResource };
+                        createResource(client, &wl_touch_interface, wl_resource_get_version(resource), id,
+                                       &touchImpl, nullptr);
+                    },
+                    .release = destroyResource
+                };
+                wl_resource* seat = createResource(client, &wl_seat_interface, version, id, &impl, data);
+                if (!seat) return;
+                wl_seat_send_capabilities(seat, WL_SEAT_CAPABILITY_POINTER | WL_SEAT_CAPABILITY_KEYBOARD);
+                if (version >= WL_SEAT_NAME_SINCE_VERSION) wl_seat_send_name(seat, "mock");
+            });
+        
+        wl_global_create(display_, &zwlr_layer_shell_v1_interface, 1, this,
+            [](wl_client* client, void* data, uint32_t version, uint32_t id) {
+                static const struct zwlr_layer_shell_v1_interface impl = {
+                    .get_layer_surface = [](wl_client* client, wl_resource* resource, uint32_t id,
+                                            wl_resource* surface, wl_resource*, uint32_t, const char*) {
+                        self(resource)->createLayerSurface(client, wl_resource_get_version(resource), id,
+                                                           surfaceFrom(surface));
+                    },
+#ifdef ZWLR_LAYER_SHELL_V1_DESTROY_SINCE_VERSION
+                    .destroy = destroyResource
+#endif
+                };
+                createResource(client, &zwlr_layer_shell_v1_interface, version, id, &impl, data);
+            });
+        
+        wl_global_create(display_, &xdg_wm_base_interface, 1, this,
+            [](wl_client* client, void* data, uint32_t version, uint32_t id) {
+                static const struct xdg_wm_base_interface impl = {
+                    .destroy = destroyResource,
+                    .create_positioner = [](wl_client* client, wl_resource*, uint32_t) {
+                        wl_client_post_implementation_error(client, "popups are not supported");
+                    },
+                    .get_xdg_surface = [](wl_client* client, wl_resource* resource, uint32_t id,
+                                          wl_resource* surface) {
+                        self(resource)->createXdgSurface(client, wl_resource_get_version(resource), id,
+                                                         surfaceFrom(surface));
+                    },
+                    .pong = [](wl_client*, wl_resource*, uint32_t) {}
+                };
+                createResource(client, &xdg_wm_base_interface, version, id, &impl, data);
+            });
+    }
+    
+    // ------------------------------------------------------------------------
+    // Surfaces
+    // ------------------------------------------------------------------------
+    
+    void createSurface(wl_client* client, int version, uint32_t id) {
+        static const struct wl_surface_interface impl = {
+            .destroy = destroyResource,
+            .attach = [](wl_client*, wl_resource* resource, wl_resource* buffer, int32_t, int32_t) {
+                Surface* surface = surfaceFrom(resource);
+                surface->compositor->attach(*surface, buffer);
+            },
+            .damage = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {},
+            .frame = [](wl_client* client, wl_resource* resource, uint32_t id) {
+                Surface* surface = surfaceFrom(resource);
+                wl_resource* callback = createResource(client, &wl_callback_interface, 1, id, nullptr,
+                                                       surface->compositor, forgetCallback);
+                if (callback) surface->pendingCallbacks.push_back(callback);
+            },
+            .set_opaque_region = [](wl_client*, wl_resource*, wl_resource*) {},
+            .set_input_region = [](wl_client*, wl_resource*, wl_resource*) {},
+            .commit = [](wl_client*, wl_resource* resource) {
+                Surface* surface = surfaceFrom(resource);
+                surface->compositor->commit(*surface);
+            },
+            .set_buffer_transform = [](wl_client*, wl_resource*, int32_t) {},
+            .set_buffer_scale = [](wl_client*, wl_resource*, int32_t) {},
+            .damage_buffer = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {},
+#ifdef WL_SURFACE_OFFSET_SINCE_VERSION
+            .offset = [](wl_client*, wl_resource*, int32_t, int32_t) {}
+#endif
+        };
+        
+        auto* surface = new Surface();
+        surface->compositor = this;
+        surface->resource = createResource(client, &wl_surface_interface, version, id, &impl, surface,
+            [](wl_resource* resource) {
+                Surface* surface = surfaceFrom(resource);
+                surface->compositor->destroySurface(surface);
+            });
+        if (!surface->resource) {
+            delete surface;
+            return;
+        }
+        surfaces_.push_back(surface);
+    }
+    
+    void destroySurface(Surface* surface) {
+        if (surface->buffer) wl_list_remove(&surface->bufferRef.destroyed.link);
+        std::vector<wl_resource*> callbacks;
+        callbacks.swap(surface->pendingCallbacks);
+        for (wl_resource* callback : callbacks) wl_resource_destroy(callback);
+        if (surface->roleResource) wl_resource_set_user_data(surface->roleResource, nullptr);
+        if (surface->toplevel) wl_resource_set_user_data(surface->toplevel, nullptr);
+        if (focus_ == surface) focus_ = nullptr;
+        if (pointerFocus_ == surface) pointerFocus_ = nullptr;
+        if (keyboardFocus_ == surface) keyboardFocus_ = nullptr;
+        surfaces_.erase(std::remove(surfaces_.begin(), surfaces_.end(), surface), surfaces_.end());
+        delete surface;
+    }
+    
+    static void forgetCallback(wl_resource* callback) {
+        auto* compositor = self(callback);
+        auto& done = compositor->frameCallbacks_;
+        done.erase(std::remove(done.begin(), done.end(), callback), done.end());
+        for (Surface* surface : compositor->surfaces_) {
+            auto& pending = surface->pendingCallbacks;
+            pending.erase(std::remove(pending.begin(), pending.end(), callback), pending.end());
+        }
+    }
+    
+    void attach(Surface& surface, wl_resource* buffer) {
+        if (surface.buffer) wl_list_remove(&surface.bufferRef.destroyed.link);
+        surface.buffer = buffer;
+        if (!buffer) return;
+        surface.bufferRef.surface = &surface;
+        surface.bufferRef.destroyed.notify = [](wl_listener* listener, void*) {
+            auto* ref = reinterpret_cast<BufferRef*>(listener);
+            wl_list_remove(&listener->link);
+            ref->surface->buffer = nullptr;
+        };
+        wl_resource_add_destroy_listener(buffer, &surface.bufferRef.destroyed);
+    }
+    
+    void commit(Surface& surface) {
+        frameCallbacks_.insert(frameCallbacks_.end(), surface.pendingCallbacks.begin(),
+                               surface.pendingCallbacks.end());
+        surface.pendingCallbacks.clear();
+        
+        if (surface.buffer) {
+            wl_resource* buffer = surface.buffer;
+            wl_list_remove(&surface.bufferRef.destroyed.link);
+            surface.buffer = nullptr;
+            capture(surface, buffer);
+            wl_buffer_send_release(buffer);
+        }
+        if (surface.role != Role::None && !surface.configured) configure(surface);
+    }
+    
+    void capture(Surface& surface, wl_resource* buffer) {
+        MockFrame frame;
+        frame.surface = wl_resource_get_id(surface.resource);
+        frame.time = timeNs();
+        if (wl_shm_buffer* shm = wl_shm_buffer_get(buffer)) {
+            frame.width = wl_shm_buffer_get_width(shm);
+            frame.height = wl_shm_buffer_get_height(shm);
+            frame.format = wl_shm_buffer_get_format(shm);
+            if (collectPixels_) {
+                size_t row = (size_t)frame.width * 4;     // ARGB8888/XRGB8888 only
+                size_t stride = wl_shm_buffer_get_stride(shm);
+                frame.pixels.resize(row * frame.height);
+                wl_shm_buffer_begin_access(shm);
+                auto* data = static_cast<const uint8_t*>(wl_shm_buffer_get_data(shm));
+                for (int y = 0; y < frame.height; ++y) {
+                    std::memcpy(frame.pixels.data() + y * row, data + y * stride, row);
+                }
+                wl_shm_buffer_end_access(shm);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(framesMutex_);
+            frames_.push_back(std::move(frame));
+            committed_++;
+        }
+        framesCv_.notify_all();
+    }
+    
+    // First commit with a role: layer surfaces get their requested size
+    // (the output's when 0), toplevels 0x0 so the client picks.
+    void configure(Surface& surface) {
+        if (surface.role == Role::Layer) {
+            sendConfigure(surface, surface.width ? surface.width : (uint32_t)outputWidth_,
+                          surface.height ? surface.height : (uint32_t)outputHeight_);
+        } else {
+            sendConfigure(surface, 0, 0);
+        }
+        surface.configured = true;
+        focus_ = &surface;
+    }
+    
+    void sendConfigure(Surface& surface, uint32_t width, uint32_t height) {
+        uint32_t serial = wl_display_next_serial(display_);
+        if (surface.role == Role::Layer) {
+            zwlr_layer_surface_v1_send_configure(surface.roleResource, serial, width, height);
+        } else if (surface.role == Role::Toplevel) {
+            wl_array states;
+            wl_array_init(&states);
+            xdg_toplevel_send_configure(surface.toplevel, (int32_t)width, (int32_t)height, &states);
+            wl_array_release(&states);
+            xdg_surface_send_configure(surface.roleResource, serial);
+        }
+    }
+    
+    // ------------------------------------------------------------------------
+    // Shell roles
+    // ------------------------------------------------------------------------
+    
+    static void clearRole(wl_resource* resource) {
+        if (Surface* surface = surfaceFrom(resource)) {
+            surface->role = Role::None;
+            surface->roleResource = nullptr;
+            surface->configured = false;
+        }
+    }
+    
+    void createLayerSurface(wl_client* client, int version, uint32_t id, Surface* surface) {
+        static const struct zwlr_layer_surface_v1_interface impl = {
+            .set_size = [](wl_client*, wl_resource* resource, uint32_t width, uint32_t height) {
+                if (Surface* surface = surfaceFrom(resource)) {
+                    surface->width = width;
+                    surface->height = height;
+                }
+            },
+            .set_anchor = [](wl_client*, wl_resource*, uint32_t) {},
+            .set_exclusive_zone = [](wl_client*, wl_resource*, int32_t) {},
+            .set_margin = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {},
+            .set_keyboard_interactivity = [](wl_client*, wl_resource*, uint32_t) {},
+            .get_popup = [](wl_client*, wl_resource*, wl_resource*) {},
+            .ack_configure = [](wl_client*, wl_resource*, uint32_t) {},
+            .destroy = destroyResource,
+            .set_layer = [](wl_client*, wl_resource*, uint32_t) {},
+#ifdef ZWLR_LAYER_SURFACE_V1_SET_EXCLUSIVE_EDGE_SINCE_VERSION
+            .set_exclusive_edge = [](wl_client*, wl_resource*, uint32_t) {}
+#endif
+        };
+        wl_resource* resource = createResource(client, &zwlr_layer_surface_v1_interface, version, id,
+                                               &impl, surface, clearRole);
+        if (!resource) return;
+        surface->role = Role::Layer;
+        surface->roleResource = resource;
+    }
+    
+    void createXdgSurface(wl_client* client, int version, uint32_t id, Surface* surface) {
+        static const struct xdg_surface_interface impl = {
+            .destroy = destroyResource,
+            .get_toplevel = [](wl_client* client, wl_resource* resource, uint32_t id) {
+                static const struct xdg_toplevel_interface toplevelImpl = {
+                    .destroy = destroyResource,
+                    .set_parent = [](wl_client*, wl_resource*, wl_resource*) {},
+                    .set_title = [](wl_client*, wl_resource*, const char*) {},
+                    .set_app_id = [](wl_client*, wl_resource*, const char*) {},
+                    .show_window_menu = [](wl_client*, wl_resource*, wl_resource*, uint32_t, int32_t, int32_t) {},
+                    .move = [](wl_client*, wl_resource*, wl_resource*, uint32_t) {},
+                    .resize = [](wl_client*, wl_resource*, wl_resource*, uint32_t, uint32_t) {},
+                    .set_max_size = [](wl_client*, wl_resource*, int32_t, int32_t) {},
+                    .set_min_size = [](wl_client*, wl_resource*, int32_t, int32_t) {},
+                    .set_maximized = [](wl_client*, wl_resource*) {},
+                    .unset_maximized = [](wl_client*, wl_resource*) {},
+                    .set_fullscreen = [](wl_client*, wl_resource*, wl_resource*) {},
+                    .unset_fullscreen = [](wl_client*, wl_resource*) {},
+                    .set_minimized = [](wl_client*, wl_resource*) {}
+                };
+                Surface* surface = surfaceFrom(resource);
+                if (!surface) return;
+                surface->toplevel = createResource(client, &xdg_toplevel_interface,
+                                                   wl_resource_get_version(resource), id,
+                                                   &toplevelImpl, surface,
+                    [](wl_resource* resource) {
+                        if (Surface* surface = surfaceFrom(resource)) {
+                            surface->toplevel = nullptr;
+                            surface->role = Role::None;
+                        }
+                    });
+                if (surface->toplevel) surface->role = Role::Toplevel;
+            },
+            .get_popup = [](wl_client* client, wl_resource*, uint32_t, wl_resource*, wl_resource*) {
+                wl_client_post_implementation_error(client, "popups are not supported");
+            },
+            .set_window_geometry = [](wl_client*, wl_resource*, int32_t, int32_t, int32_t, int32_t) {},
+            .ack_configure = [](wl_client*, wl_resource*, uint32_t) {}
+        };
+        wl_resource* resource = createResource(client, &xdg_surface_interface, version, id,
+                                               &impl, surface, clearRole);
+        if (resource) surface->roleResource = resource;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Seat
+    // ------------------------------------------------------------------------
+    
+    static void forgetInput(wl_resource* resource) {
+        auto* compositor = self(resource);
+        for (auto* list : {&compositor->pointers_, &compositor->keyboards_}) {
+            list->erase(std::remove(list->begin(), list->end(), resource), list->end());
+        }
+    }
+    
+    void createPointer(wl_client* client, int version, uint32_t id) {
+        static const struct wl_pointer_interface impl = {
+            .set_cursor = [](wl_client*, wl_resource*, uint32_t, wl_resource*, int32_t, int32_t) {},
+            .release = destroyResource
+        };
+        wl_resource* pointer = createResource(client, &wl_pointer_interface, version, id, &impl, this,
+                                              forgetInput);
+        if (pointer) pointers_.push_back(pointer);
+    }
+    
+    void createKeyboard(wl_client* client, int version, uint32_t id) {
+        static const struct wl_keyboard_interface impl = { .release = destroyResource };
+        wl_resource* keyboard = createResource(client, &wl_keyboard_interface, version, id, &impl, this,
+                                               forgetInput);
+        if (!keyboard) return;
+        keyboards_.push_back(keyboard);
+        
+        int fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            wl_keyboard_send_keymap(keyboard, WL_KEYBOARD_KEYMAP_FORMAT_NO_KEYMAP, fd, 0);
+            close(fd);
+        }
+        if (version >= WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) wl_keyboard_send_repeat_info(keyboard, 0, 0);
+    }
+    
+    template<typename Fn>
+    void forEachFocused(const std::vector<wl_resource*>& resources, Surface* focus, Fn fn) {
+        if (!focus) return;
+        wl_client* client = wl_resource_get_client(focus->resource);
+        for (wl_resource* resource : resources) {
+            if (wl_resource_get_client(resource) == client) fn(resource);
+        }
+    }
+    
+    template<typename Fn>
+    void forEachFocused(const std::vector<wl_resource*>& resources, Fn fn) {
+        forEachFocused(resources, focus_, fn);
+    }
+    
+    static void sendPointerFrame(wl_resource* pointer) {
+        if (wl_resource_get_version(pointer) >= WL_POINTER_FRAME_SINCE_VERSION) wl_pointer_send_frame(pointer);
+    }
+    
+    bool focusPointer() {
+        if (!focus_) return false;
+        if (pointerFocus_ == focus_) return true;
+        uint32_t serial = wl_display_next_serial(display_);
+        forEachFocused(pointers_, pointerFocus_, [&](wl_resource* pointer) {
+            wl_pointer_send_leave(pointer, serial, pointerFocus_->resource);
+            sendPointerFrame(pointer);
+        });
+        pointerFocus_ = focus_;
+        forEachFocused(pointers_, [&](wl_resource* pointer) {
+            wl_pointer_send_enter(pointer, serial, focus_->resource,
+                                  wl_fixed_from_double(pointerX_), wl_fixed_from_double(pointerY_));
+            sendPointerFrame(pointer);
+        });
+        return true;
+    }
+    
+    bool focusKeyboard() {
+        if (!focus_) return false;
+        if (keyboardFocus_ == focus_) return true;
+        uint32_t serial = wl_display_next_serial(display_);
+        forEachFocused(keyboards_, keyboardFocus_, [&](wl_resource* keyboard) {
+            wl_keyboard_send_leave(keyboard, serial, keyboardFocus_->resource);
+        });
+        keyboardFocus_ = focus_;
+        wl_array keys;
+        wl_array_init(&keys);
+        forEachFocused(keyboards_, [&](wl_resource* keyboard) {
+            wl_keyboard_send_enter(keyboard, serial, focus_->resource, &keys);
+        });
+        wl_array_release(&keys);
+        return true;
+    }
+};
+
+} // namespace MetaUI
@@ -0,0 +1,606 @@
+#pragma once
+
+#include "core.hpp"
+#include "threadpool.hpp"
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace MetaUI {
+
+// ============================================================================
+// Model Change Notifications
+// ============================================================================
+
+// A batch of changes is applied in order: each range refers to row indices
+// after the preceding changes in the same batch have been applied.
+struct ModelChange {
+    enum class Kind { Reset, RowsInserted, RowsRemoved, DataChanged };
+    
+    Kind kind = Kind::Reset;
+    size_t first = 0;
+    size_t count = 0;
+};
+
+using ModelListener = std::function<void(const std::vector<ModelChange>&)>;
+
+// ============================================================================
+// DataGrid Model
+// ============================================================================
+
+// Table data source for DataGrid. The grid only asks for cells it is about to
+// draw, so implementations can be backed by databases, files or generators
+// without materializing every row.
+class DataGridModel {
+public:
+    virtual ~DataGridModel() = default;
+    
+    virtual size_t rowCount() const = 0;
+    virtual size_t columnCount() const = 0;
+    virtual std::string cellText(size_t row, size_t column) const = 0;
+    
+    virtual std::string headerText(size_t /*column*/) const { return std::string(); }
+    
+    // Preferred width in pixels, or 0 to use the grid's default.
+    virtual float columnWidth(size_t /*column*/) const { return 0; }
+    
+    size_t addListener(ModelListener listener) {
+        listeners_.emplace_back(++nextListenerId_, std::move(listener));
+        return nextListenerId_;
+    }
+    
+    void removeListener(size_t id) {
+        listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+            [id](const auto& entry) { return entry.first == id; }), listeners_.end());
+    }
+
+protected:
+    void notify(const std::vector<ModelChange>& changes) {
+        if (changes.empty()) return;
+        for (auto& entry : listeners_) entry.second(changes);
+    }
+    
+    void notifyReset() { notify({ModelChange{}}); }
+
+private:
+    std::vector<std::pair<size_t, ModelListener>> listeners_;
+    size_t nextListenerId_ = 0;
+};
+
+// ============================================================================
+// Text Search
+// ============================================================================
+
+inline char foldAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : c;
+}
+
+inline std::string toLowerAscii(std::string_view text) {
+    std::string result(text);
+    for (char& c : result) c = foldAscii(c);
+    return result;
+}
+
+#if defined(__SSE2__)
+inline __m128i foldAscii(__m128i v) {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+// ASCII case-insensitive substring test; `needle` must already be lowercased
+// with toLowerAscii(). Bytes >= 0x80 (UTF-8 sequences) compare exactly.
+// With SSE2, 16 candidate positions are tested at once by matching the
+// needle's first and last bytes before verifying.
+inline bool containsIgnoreCase(std::string_view haystack, std::string_view needle) {
+    size_t n = needle.size();
+    if (n == 0) return true;
+    if (haystack.size() < n) return false;
+    
+    const char* h = haystack.data();
+    size_t last = haystack.size() - n;
+    auto matchesAt = [&](size_t pos) {
+        for (size_t k = 0; k < n; ++k) {
+            if (foldAscii(h[pos + k]) != needle[k]) return false;
+        }
+        return true;
+    };
+    
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i lastByte = _mm_set1_epi8(needle[n - 1]);
+    for (; i + 16 <= last + 1; i += 16) {
+        __m128i a = foldAscii(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i)));
+        __m128i b = foldAscii(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + n - 1)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, lastByte)));
+        while (mask) {
+            if (matchesAt(i + __builtin_ctz(mask))) return true;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i <= last; ++i) {
+        if (matchesAt(i)) return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// Sort / Filter Proxy Model
+// ============================================================================
+
+// Presents a sorted and filtered view of another DataGridModel. The filter
+// and sort columns are read from the source once and cached, so per-keystroke
+// work never touches the source. Extending the query only re-tests rows that
+// matched before; every update notifies listeners with the minimal set of
+// inserted/removed ranges so virtualized views keep their cached rows.
+class SortFilterModel : public DataGridModel {
+public:
+    explicit SortFilterModel(std::shared_ptr<DataGridModel> source,
+                             ThreadPool& pool = ThreadPool::shared())
+        : source_(std::move(source)), pool_(pool) {
+        if (source_) {
+            listenerId_ = source_->addListener([this](const std::vector<ModelChange>&) {
+                rebuild();
+            });
+        }
+        rebuild();
+    }
+    
+    ~SortFilterModel() override {
+        if (source_) source_->removeListener(listenerId_);
+    }
+    
+    SortFilterModel(const SortFilterModel&) = delete;
+    SortFilterModel& operator=(const SortFilterModel&) = delete;
+    
+    SortFilterModel& filterColumn(size_t column) {
+        if (column == filterColumn_) return *this;
+        filterColumn_ = column;
+        filterKeys_.clear();
+        std::string query = std::move(query_);
+        query_.clear();
+        applyFilter(query, true);
+        return *this;
+    }
+    
+    SortFilterModel& filter(const std::string& query) {
+        applyFilter(toLowerAscii(query), false);
+        return *this;
+    }
+    
+    SortFilterModel& sort(size_t column, bool ascending = true) {
+        sorted_ = true;
+        sortColumn_ = column;
+        ascending_ = ascending;
+        resort();
+        return *this;
+    }
+    
+    SortFilterModel& clearSort() {
+        sorted_ = false;
+        resort();
+        return *this;
+    }
+    
+    const std::string& filterQuery() const { return query_; }
+    size_t sourceRow(size_t row) const { return rows_[row]; }
+    const std::shared_ptr<DataGridModel>& source() const { return source_; }
+    
+    size_t rowCount() const override { return rows_.size(); }
+    size_t columnCount() const override { return source_ ? source_->columnCount() : 0; }
+    
+    std::string cellText(size_t row, size_t column) const override {
+        return source_->cellText(rows_[row], column);
+    }
+    
+    std::string headerText(size_t column) const override {
+        return source_->headerText(column);
+    }
+    
+    float columnWidth(size_t column) const override {
+        return source_->columnWidth(column);
+    }
+
+private:
+    // Above this many ranges a diff is less useful than a reset.
+    static constexpr size_t MAX_DIFF_RANGES = 1024;
+    static constexpr size_t MIN_CHUNK = 16384;
+    
+    std::shared_ptr<DataGridModel> source_;
+    ThreadPool& pool_;
+    size_t listenerId_ = 0;
+    
+    size_t filterColumn_ = 0;
+    std::string query_;
+    bool sorted_ = false;
+    size_t sortColumn_ = 0;
+    bool ascending_ = true;
+    
+    // One column's text packed into a single buffer, so scans stream through
+    // memory instead of chasing a heap pointer per row.
+    struct PackedColumn {
+        std::string data;
+        std::vector<size_t> offsets;
+        
+        size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+        std::string_view operator[](size_t i) const {
+            return std::string_view(data.data() + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        void clear() { data.clear(); offsets.clear(); }
+    };
+    
+    PackedColumn filterKeys_;
+    std::vector<uint32_t> order_;  // source rows in sort order
+    std::vector<uint32_t> rank_;   // source row -> position in order_
+    std::vector<uint32_t> rows_;   // rows passing the filter, in sort order
+    
+    size_t sourceRows() const { return source_ ? source_->rowCount() : 0; }
+    
+    PackedColumn extractColumn(size_t column) const {
+        PackedColumn keys;
+        size_t rows = sourceRows();
+        keys.offsets.reserve(rows + 1);
+        keys.offsets.push_back(0);
+        bool valid = column < columnCount();
+        for (size_t r = 0; r < rows; ++r) {
+            if (valid) keys.data += source_->cellText(r, column);
+            keys.offsets.push_back(keys.data.size());
+        }
+        return keys;
+    }
+    
+    const PackedColumn& filterKeys() {
+        if (filterKeys_.size() != sourceRows() || filterKeys_.offsets.empty()) {
+            filterKeys_ = extractColumn(filterColumn_);
+        }
+        return filterKeys_;
+    }
+    
+    void rebuild() {
+        filterKeys_.clear();
+        order_.resize(sourceRows());
+        std::iota(order_.begin(), order_.end(), 0u);
+        if (sorted_) sortOrder();
+        updateRanks();
+        rows_ = query_.empty() ? order_ : matching(order_, query_);
+        notifyReset();
+    }
+    
+    void resort() {
+        // The visible set is unchanged; only its sequence is.
+        std::vector<uint8_t> visible(order_.size(), 0);
+        for (uint32_t r : rows_) visible[r] = 1;
+        
+        std::iota(order_.begin(), order_.end(), 0u);
+        if (sorted_) sortOrder();
+        updateRanks();
+        
+        rows_.clear();
+        for (uint32_t r : order_) {
+            if (visible[r]) rows_.push_back(r);
+        }
+        notifyReset();
+    }
+    
+    void updateRanks() {
+        rank_.resize(order_.size());
+        for (size_t i = 0; i < order_.size(); ++i) rank_[order_[i]] = (uint32_t)i;
+    }
+    
+    // Stable parallel merge sort: chunks are sorted on the pool, then merged
+    // pairwise with each merge level also spread across the pool.
+    void sortOrder() {
+        PackedColumn sortKeys;
+        if (sortColumn_ == filterColumn_) filterKeys();
+        else sortKeys = extractColumn(sortColumn_);
+        const PackedColumn& keys = sortColumn_ == filterColumn_ ? filterKeys_ : sortKeys;
+        
+        bool ascending = ascending_;
+        auto less = [&keys, ascending](uint32_t a, uint32_t b) {
+            return ascending ? keys[a] < keys[b] : keys[b] < keys[a];
+        };
+        
+        size_t n = order_.size();
+        size_t chunks = std::max<size_t>(1, std::min(pool_.size(), n / MIN_CHUNK));
+        size_t step = (n + chunks - 1) / std::max<size_t>(1, chunks);
+        std::vector<size_t> bounds;
+        for (size_t b = 0; b < n; b += step) bounds.push_back(b);
+        bounds.push_back(n);
+        
+        pool_.parallelFor(bounds.size() - 1, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                std::stable_sort(order_.begin() + bounds[c], order_.begin() + bounds[c + 1], less);
+            }
+        });
+        
+        for (size_t width = 1; width < bounds.size() - 1; width *= 2) {
+            size_t merges = (bounds.size() - 1 + 2 * width - 1) / (2 * width);
+            pool_.parallelFor(merges, 1, [&](size_t begin, size_t end) {
+                for (size_t m = begin; m < end; ++m) {
+                    size_t lo = m * 2 * width;
+                    size_t mid = std::min(lo + width, bounds.size() - 1);
+                    size_t hi = std::min(lo + 2 * width, bounds.size() - 1);
+                    if (mid >= hi) continue;
+                    std::inplace_merge(order_.begin() + bounds[lo], order_.begin() + bounds[mid],
+                                       order_.begin() + bounds[hi], less);
+                }
+            });
+        }
+    }
+    
+    std::vector<uint32_t> matching(const std::vector<uint32_t>& candidates,
+                                   const std::string& query) {
+        const auto& keys = filterKeys();
+        std::vector<uint8_t> hit(candidates.size());
+        pool_.parallelFor(candidates.size(), MIN_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                hit[i] = containsIgnoreCase(keys[candidates[i]], query);
+            }
+        });
+        
+        std::vector<uint32_t> result;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (hit[i]) result.push_back(candidates[i]);
+        }
+        return result;
+    }
+    
+    void applyFilter(const std::string& query, bool force) {
+        if (!force && query == query_) return;
+        
+        std::vector<uint32_t> next;
+        if (query.empty()) {
+            next = order_;
+        } else if (!force && !query_.empty() && query.find(query_) != std::string::npos) {
+            // Anything matching the longer query matched the shorter one.
+            next = matching(rows_, query);
+        } else {
+            next = matching(order_, query);
+        }
+        query_ = query;
+        
+        std::vector<ModelChange> changes = diff(rows_, next);
+        rows_.swap(next);
+        notify(changes);
+    }
+    
+    // Both sequences are subsequences of order_, so a single merge walk by
+    // rank yields the inserted and removed ranges.
+    std::vector<ModelChange> diff(const std::vector<uint32_t>& before,
+                                  const std::vector<uint32_t>& after) const {
+        std::vector<ModelChange> changes;
+        size_t i = 0, j = 0, pos = 0;
+        
+        auto extend = [&](ModelChange::Kind kind) {
+            if (!changes.empty() && changes.back().kind == kind &&
+                changes.back().first + (kind == ModelChange::Kind::RowsInserted
+                                        ? changes.back().count : 0) == pos) {
+                changes.back().count++;
+            } else {
+                changes.push_back(ModelChange{kind, pos, 1});
+            }
+        };
+        
+        while (i < before.size() || j < after.size()) {
+            if (changes.size() > MAX_DIFF_RANGES) return {ModelChange{}};
+            
+            if (i < before.size() && j < after.size() && before[i] == after[j]) {
+                i++; j++; pos++;
+            } else if (j == after.size() ||
+                       (i < before.size() && rank_[before[i]] < rank_[after[j]])) {
+                extend(ModelChange::Kind::RowsRemoved);
+                i++;
+            } else {
+                extend(ModelChange::Kind::RowsInserted);
+                j++; pos++;
+            }
+        }
+        return changes;
+    }
+};
+
+// ============================================================================
+// Tree Model
+// ============================================================================
+
+// Hierarchical data source for TreeView. Nodes are opaque ids chosen by the
+// model; children are only requested when their parent is first expanded, so
+// large or lazily-loaded hierarchies (e.g. file systems) stay cheap.
+class TreeModel {
+public:
+    using NodeId = uint64_t;
+    
+    virtual ~TreeModel() = default;
+    
+    // The root itself is not displayed; its children are the top-level rows.
+    virtual NodeId root() const { return 0; }
+    virtual size_t childCount(NodeId node) const = 0;
+    virtual NodeId child(NodeId node, size_t index) const = 0;
+    virtual std::string text(NodeId node) const = 0;
+    virtual bool hasChildren(NodeId node) const { return childCount(node) > 0; }
+};
+
+// ============================================================================
+// Tree Row Index
+// ============================================================================
+
+// Flattened index of the visible (expanded) rows of a TreeModel. Every
+// materialized node keeps a Fenwick tree over its children's visible row
+// counts, so expand/collapse and row <-> node lookups cost
+// O(depth * log(children)) instead of rebuilding a flat list.
+class TreeRowIndex {
+public:
+    using Slot = uint32_t;
+    static constexpr Slot NONE = ~0u;
+    
+    struct Node {
+        TreeModel::NodeId id = 0;
+        Slot parent = NONE;
+        uint32_t indexInParent = 0;
+        uint32_t depth = 0;
+        bool expanded = false;
+        bool loaded = false;
+        int8_t hasChildren = -1;  // -1 until asked
+        int64_t childRows = 0;    // visible rows below this node if expanded
+        std::vector<Slot> children;
+        std::vector<int64_t> fenwick;  // 1-based, over children's row counts
+    };
+    
+    void reset(std::shared_ptr<TreeModel> model) {
+        model_ = std::move(model);
+        nodes_.clear();
+        if (!model_) return;
+        
+        Node root;
+        root.id = model_->root();
+        root.depth = 0;
+        nodes_.push_back(std::move(root));
+        expand(0);
+    }
+    
+    const std::shared_ptr<TreeModel>& model() const { return model_; }
+    const Node& node(Slot slot) const { return nodes_[slot]; }
+    Slot rootSlot() const { return 0; }
+    
+    size_t rowCount() const { return nodes_.empty() ? 0 : (size_t)nodes_[0].childRows; }
+    
+    bool hasChildren(Slot slot) {
+        Node& n = nodes_[slot];
+        if (n.hasChildren < 0) n.hasChildren = model_->hasChildren(n.id) ? 1 : 0;
+        return n.hasChildren > 0;
+    }
+    
+    void expand(Slot slot) {
+        if (nodes_[slot].expanded) return;
+        if (!nodes_[slot].loaded) load(slot);
+        nodes_[slot].expanded = true;
+        propagate(slot, nodes_[slot].childRows);
+    }
+    
+    void collapse(Slot slot) {
+        if (!nodes_[slot].expanded || slot == rootSlot()) return;
+        nodes_[slot].expanded = false;
+        propagate(slot, -nodes_[slot].childRows);
+    }
+    
+    void toggle(Slot slot) {
+        if (nodes_[slot].expanded) collapse(slot);
+        else expand(slot);
+    }
+    
+    // Node displayed at a visible row.
+    Slot slotAt(size_t row) const {
+        if (row >= rowCount()) return NONE;
+        Slot slot = rootSlot();
+        int64_t remaining = (int64_t)row;
+        for (;;) {
+            const Node& n = nodes_[slot];
+            size_t index = findChild(n.fenwick, remaining);
+            Slot child = n.children[index];
+            if (remaining == 0) return child;
+            remaining -= 1;
+            slot = child;
+        }
+    }
+    
+    // Visible row of a node, or -1 if an ancestor is collapsed.
+    int64_t rowOf(Slot slot) const {
+        int64_t row = 0;
+        for (Slot s = slot; s != rootSlot(); ) {
+            const Node& n = nodes_[s];
+            const Node& p = nodes_[n.parent];
+            if (!p.expanded) return -1;
+            row += prefix(p.fenwick, n.indexInParent);
+            if (n.parent != rootSlot()) row += 1;
+            s = n.parent;
+        }
+        return row;
+    }
+    
+    // Next visible row in display order, or NONE at the end.
+    Slot next(Slot slot) const {
+        const Node& n = nodes_[slot];
+        if (n.expanded && !n.children.empty()) return n.children[0];
+        for (Slot s = slot; s != rootSlot(); s = nodes_[s].parent) {
+            const Node& p = nodes_[nodes_[s].parent];
+            uint32_t sibling = nodes_[s].indexInParent + 1;
+            if (sibling < p.children.size()) return p.children[sibling];
+        }
+        return NONE;
+    }
+
+private:
+    std::shared_ptr<TreeModel> model_;
+    std::vector<Node> nodes_;
+    
+    void load(Slot slot) {
+        size_t count = model_->childCount(nodes_[slot].id);
+        std::vector<Slot> children(count);
+        for (size_t i = 0; i < count; ++i) {
+            Node child;
+            child.id = model_->child(nodes_[slot].id, i);
+            child.parent = slot;
+            child.indexInParent = (uint32_t)i;
+            child.depth = nodes_[slot].depth + 1;
+            children[i] = (Slot)nodes_.size();
+            nodes_.push_back(std::move(child));
+        }
+        
+        // Every child starts collapsed (one row): fenwick[i] = lowbit(i).
+        Node& n = nodes_[slot];
+        n.children = std::move(children);
+        n.fenwick.assign(count + 1, 0);
+        for (size_t i = 1; i <= count; ++i) n.fenwick[i] = (int64_t)(i & (~i + 1));
+        n.childRows = (int64_t)count;
+        n.hasChildren = count > 0 ? 1 : 0;
+        n.loaded = true;
+    }
+    
+    // A node's row count changed by delta: update ancestors until one is
+    // collapsed (its own count doesn't depend on its children then).
+    void propagate(Slot slot, int64_t delta) {
+        if (delta == 0) return;
+        for (Slot s = slot; s != rootSlot(); ) {
+            Node& p = nodes_[nodes_[s].parent];
+            for (size_t i = nodes_[s].indexInParent + 1; i < p.fenwick.size(); i += i & (~i + 1)) {
+                p.fenwick[i] += delta;
+            }
+            p.childRows += delta;
+            if (!p.expanded) return;
+            s = nodes_[s].parent;
+        }
+    }
+    
+    static int64_t prefix(const std::vector<int64_t>& fenwick, size_t count) {
+        int64_t sum = 0;
+        for (size_t i = count; i > 0; i -= i & (~i + 1)) sum += fenwick[i];
+        return sum;
+    }
+    
+    // Finds the child whose rows contain `row`, leaving the offset into that
+    // child's rows in `row`.
+    static size_t findChild(const std::vector<int64_t>& fenwick, int64_t& row) {
+        size_t n = fenwick.size() - 1;
+        size_t pos = 0;
+        size_t step = 1;
+        while (step * 2 <= n) step *= 2;
+        for (; step > 0; step /= 2) {
+            if (pos + step <= n && fenwick[pos + step] <= row) {
+                pos += step;
+                row -= fenwick[pos];
+            }
+        }
+        return pos;
+    }
+};
+
+} // namespace MetaUI
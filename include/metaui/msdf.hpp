@@ -0,0 +1,338 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace MetaUI {
+
+// ============================================================================
+// Multi-channel Signed Distance Fields
+// ============================================================================
+
+// Vector outline made of line, quadratic and cubic segments, in y-down
+// coordinates. Built with moveTo/lineTo/quadTo/cubicTo; contours close
+// implicitly.
+struct MsdfShape {
+    struct Vec {
+        float x = 0, y = 0;
+    };
+    
+    struct Edge {
+        enum Type : uint8_t { Line, Quad, Cubic } type = Line;
+        Vec p[4];
+        uint8_t color = 7;          // channel mask: 1 = R, 2 = G, 4 = B
+        float t0 = 0, t1 = 1;       // parameter range, for split edges
+        
+        Vec point(float t) const {
+            float s = 1 - t;
+            switch (type) {
+            case Line:
+                return {p[0].x * s + p[1].x * t, p[0].y * s + p[1].y * t};
+            case Quad:
+                return {s * s * p[0].x + 2 * s * t * p[1].x + t * t * p[2].x,
+                        s * s * p[0].y + 2 * s * t * p[1].y + t * t * p[2].y};
+            default:
+                return {s * s * s * p[0].x + 3 * s * s * t * p[1].x + 3 * s * t * t * p[2].x + t * t * t * p[3].x,
+                        s * s * s * p[0].y + 3 * s * s * t * p[1].y + 3 * s * t * t * p[2].y + t * t * t * p[3].y};
+            }
+        }
+        
+        Vec direction(float t) const {
+            float s = 1 - t;
+            Vec d;
+            switch (type) {
+            case Line:
+                d = {p[1].x - p[0].x, p[1].y - p[0].y};
+                break;
+            case Quad:
+                d = {2 * s * (p[1].x - p[0].x) + 2 * t * (p[2].x - p[1].x),
+                     2 * s * (p[1].y - p[0].y) + 2 * t * (p[2].y - p[1].y)};
+                if (d.x == 0 && d.y == 0) d = {p[2].x - p[0].x, p[2].y - p[0].y};
+                break;
+            default:
+                d = {3 * s * s * (p[1].x - p[0].x) + 6 * s * t * (p[2].x - p[1].x) + 3 * t * t * (p[3].x - p[2].x),
+                     3 * s * s * (p[1].y - p[0].y) + 6 * s * t * (p[2].y - p[1].y) + 3 * t * t * (p[3].y - p[2].y)};
+                if (d.x == 0 && d.y == 0) d = {p[3].x - p[0].x, p[3].y - p[0].y};
+                break;
+            }
+            return d;
+        }
+    };
+    
+    struct Contour {
+        std::vector<Edge> edges;
+    };
+    
+    std::vector<Contour> contours;
+    
+    void moveTo(float x, float y) {
+        contours.emplace_back();
+        pen_ = {x, y};
+        start_ = pen_;
+    }
+    void lineTo(float x, float y) { add(Edge::Line, {pen_, {x, y}}); }
+    void quadTo(float cx, float cy, float x, float y) { add(Edge::Quad, {pen_, {cx, cy}, {x, y}}); }
+    void cubicTo(float c1x, float c1y, float c2x, float c2y, float x, float y) {
+        add(Edge::Cubic, {pen_, {c1x, c1y}, {c2x, c2y}, {x, y}});
+    }
+    void close() {
+        if (pen_.x != start_.x || pen_.y != start_.y) lineTo(start_.x, start_.y);
+    }
+    
+    bool empty() const {
+        for (const auto& c : contours) if (!c.edges.empty()) return false;
+        return true;
+    }
+
+private:
+    Vec pen_, start_;
+    
+    void add(Edge::Type type, std::initializer_list<Vec> points) {
+        if (contours.empty()) moveTo(pen_.x, pen_.y);
+        Edge edge;
+        edge.type = type;
+        std::copy(points.begin(), points.end(), edge.p);
+        if (type == Edge::Line && edge.p[0].x == edge.p[1].x && edge.p[0].y == edge.p[1].y) return;
+        contours.back().edges.push_back(edge);
+        pen_ = *(points.end() - 1);
+    }
+};
+
+// Renders an MsdfShape into an RGB8 distance field after Chlumsky's
+// msdfgen: edges are colored so every corner sits between two channels,
+// each channel stores the signed pseudo-distance to its nearest edge, and
+// the median of the three reconstructs sharp corners at any scale. Curves
+// are flattened for the distance queries, and texels whose median has the
+// wrong sign or that lie beyond the range fall back to the true distance.
+class MsdfGenerator {
+public:
+    // Maps shape point s to pixel s * scale + (tx, ty). range is the
+    // distance in pixels that spans the full 0..255 value range.
+    static void generate(MsdfShape shape, unsigned char* rgb, int width, int height, int stride,
+                         float scale, float tx, float ty, float range) {
+        for (auto& contour : shape.contours) colorEdges(contour);
+        
+        std::vector<Segment> segments;
+        float orientation = 1;
+        float largestArea = 0;
+        for (const auto& contour : shape.contours) {
+            size_t first = segments.size();
+            for (const auto& edge : contour.edges) flatten(edge, scale, tx, ty, segments);
+            float area = 0;
+            for (size_t i = first; i < segments.size(); ++i) {
+                area += segments[i].a.x * segments[i].b.y - segments[i].b.x * segments[i].a.y;
+            }
+            if (std::fabs(area) > largestArea) {
+                largestArea = std::fabs(area);
+                orientation = area > 0 ? 1.0f : -1.0f;
+            }
+        }
+        
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                Vec p{x + 0.5f, y + 0.5f};
+                float channels[3];
+                float trueDistance = 1e30f;
+                evaluate(segments, p, orientation, channels, trueDistance);
+                
+                bool inside = winding(segments, p) != 0;
+                float median = std::max(std::min(channels[0], channels[1]),
+                                        std::min(std::max(channels[0], channels[1]), channels[2]));
+                // Outside the encoded range the channels saturate in
+                // different directions, which bilinear filtering turns
+                // into stray specks; those texels only need the true field.
+                if ((median > 0) != inside || trueDistance >= range * 0.5f) {
+                    float fallback = inside ? trueDistance : -trueDistance;
+                    channels[0] = channels[1] = channels[2] = fallback;
+                }
+                
+                unsigned char* out = rgb + y * stride + x * 3;
+                for (int c = 0; c < 3; ++c) {
+                    float v = 0.5f + channels[c] / range;
+                    out[c] = (unsigned char)std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f);
+                }
+            }
+        }
+    }
+
+private:
+    using Vec = MsdfShape::Vec;
+    using Edge = MsdfShape::Edge;
+    
+    enum : uint8_t { BLACK = 0, RED = 1, GREEN = 2, YELLOW = 3, BLUE = 4, MAGENTA = 5, CYAN = 6, WHITE = 7 };
+    
+    struct Segment {
+        Vec a, b;
+        uint8_t color;
+        bool extendStart, extendEnd;  // only at the original edge's endpoints
+    };
+    
+    static float cross(Vec a, Vec b) { return a.x * b.y - a.y * b.x; }
+    static float dot(Vec a, Vec b) { return a.x * b.x + a.y * b.y; }
+    static Vec normalize(Vec v) {
+        float len = std::sqrt(dot(v, v));
+        return len > 0 ? Vec{v.x / len, v.y / len} : Vec{0, 1};
+    }
+    
+    static bool isCorner(Vec a, Vec b) {
+        a = normalize(a);
+        b = normalize(b);
+        return dot(a, b) <= 0 || std::fabs(cross(a, b)) > 0.14112f;  // sin(3 rad)
+    }
+    
+    static void switchColor(uint8_t& color, uint8_t banned = BLACK) {
+        uint8_t combined = color & banned;
+        if (combined == RED || combined == GREEN || combined == BLUE) {
+            color = combined ^ WHITE;
+        } else if (color == BLACK || color == WHITE) {
+            color = CYAN;
+        } else {
+            int shifted = color << 1;
+            color = (uint8_t)((shifted | shifted >> 3) & WHITE);
+        }
+    }
+    
+    static void colorEdges(MsdfShape::Contour& contour) {
+        auto& edges = contour.edges;
+        size_t m = edges.size();
+        if (m == 0) return;
+        
+        std::vector<size_t> corners;
+        for (size_t i = 0; i < m; ++i) {
+            const Edge& prev = edges[(i + m - 1) % m];
+            if (isCorner(prev.direction(1), edges[i].direction(0))) corners.push_back(i);
+        }
+        
+        if (corners.empty()) {
+            for (auto& e : edges) e.color = WHITE;
+        } else if (corners.size() == 1) {
+            // Teardrop: spread three colors around the single corner,
+            // splitting edges when there are too few to carry them.
+            const uint8_t colors[3] = {MAGENTA, WHITE, YELLOW};
+            std::rotate(edges.begin(), edges.begin() + corners[0], edges.end());
+            if (m >= 3) {
+                for (size_t i = 0; i < m; ++i) {
+                    int third = (int)(3 + 2.875f * i / (m - 1) - 1.4375f + 0.5f) - 3;
+                    edges[i].color = colors[1 + third];
+                }
+            } else {
+                std::vector<Edge> parts;
+                for (const auto& e : edges) {
+                    for (int k = 0; k < 3; ++k) {
+                        Edge part = e;
+                        part.t0 = e.t0 + (e.t1 - e.t0) * k / 3.0f;
+                        part.t1 = e.t0 + (e.t1 - e.t0) * (k + 1) / 3.0f;
+                        parts.push_back(part);
+                    }
+                }
+                for (size_t i = 0; i < parts.size(); ++i) {
+                    parts[i].color = colors[m == 1 ? i : i / 2];
+                }
+                edges = std::move(parts);
+            }
+        } else {
+            uint8_t color = WHITE;
+            switchColor(color);
+            uint8_t initial = color;
+            size_t spline = 0;
+            for (size_t i = 0; i < m; ++i) {
+                size_t index = (corners[0] + i) % m;
+                if (spline + 1 < corners.size() && corners[spline + 1] == index) {
+                    ++spline;
+                    switchColor(color, spline == corners.size() - 1 ? initial : (uint8_t)BLACK);
+                }
+                edges[index].color = color;
+            }
+        }
+    }
+    
+    static void flatten(const Edge& edge, float scale, float tx, float ty, std::vector<Segment>& out) {
+        auto toPixel = [&](Vec v) { return Vec{v.x * scale + tx, v.y * scale + ty}; };
+        int steps = 1;
+        if (edge.type != Edge::Line) {
+            float length = 0;
+            int n = edge.type == Edge::Quad ? 2 : 3;
+            for (int i = 0; i < n; ++i) {
+                length += std::hypot(edge.p[i + 1].x - edge.p[i].x, edge.p[i + 1].y - edge.p[i].y);
+            }
+            length *= (edge.t1 - edge.t0) * scale;
+            steps = std::clamp((int)std::ceil(length / 2), 2, 24);
+        }
+        
+        Vec prev = toPixel(edge.point(edge.t0));
+        for (int i = 1; i <= steps; ++i) {
+            Vec next = toPixel(edge.point(edge.t0 + (edge.t1 - edge.t0) * i / steps));
+            if (next.x != prev.x || next.y != prev.y) {
+                out.push_back({prev, next, edge.color, i == 1, i == steps});
+            }
+            prev = next;
+        }
+    }
+    
+    static void evaluate(const std::vector<Segment>& segments, Vec p, float orientation,
+                         float channels[3], float& trueDistance) {
+        struct Best {
+            float distance = 1e30f;
+            float orthogonality = 0;
+            const Segment* segment = nullptr;
+            float t = 0;
+        } best[3];
+        
+        for (const auto& s : segments) {
+            Vec ab{s.b.x - s.a.x, s.b.y - s.a.y};
+            Vec ap{p.x - s.a.x, p.y - s.a.y};
+            float t = dot(ap, ab) / dot(ab, ab);
+            float tc = std::clamp(t, 0.0f, 1.0f);
+            Vec q{p.x - (s.a.x + ab.x * tc), p.y - (s.a.y + ab.y * tc)};
+            float distance = std::sqrt(dot(q, q));
+            float orthogonality = (t > 0 && t < 1) ? 1.0f : std::fabs(cross(normalize(ab), normalize(q)));
+            trueDistance = std::min(trueDistance, distance);
+            
+            for (int c = 0; c < 3; ++c) {
+                if (!(s.color & (1 << c))) continue;
+                Best& b = best[c];
+                if (distance < b.distance - 1e-4f ||
+                    (distance < b.distance + 1e-4f && orthogonality > b.orthogonality)) {
+                    b = {distance, orthogonality, &s, t};
+                }
+            }
+        }
+        
+        for (int c = 0; c < 3; ++c) {
+            const Best& b = best[c];
+            if (!b.segment) {
+                channels[c] = -1e30f;
+                continue;
+            }
+            const Segment& s = *b.segment;
+            Vec ab{s.b.x - s.a.x, s.b.y - s.a.y};
+            Vec ap{p.x - s.a.x, p.y - s.a.y};
+            float side = cross(ab, ap) * orientation >= 0 ? 1.0f : -1.0f;
+            float distance = b.distance;
+            // Beyond an endpoint, measure to the edge's extension so the
+            // channels stay straight through corners.
+            if ((b.t < 0 && s.extendStart) || (b.t > 1 && s.extendEnd)) {
+                float pseudo = std::fabs(cross(normalize(ab), ap));
+                if (pseudo <= distance) distance = pseudo;
+            }
+            channels[c] = side * distance;
+        }
+    }
+    
+    static int winding(const std::vector<Segment>& segments, Vec p) {
+        int w = 0;
+        for (const auto& s : segments) {
+            if (s.a.y <= p.y) {
+                if (s.b.y > p.y && cross({s.b.x - s.a.x, s.b.y - s.a.y}, {p.x - s.a.x, p.y - s.a.y}) > 0) ++w;
+            } else if (s.b.y <= p.y && cross({s.b.x - s.a.x, s.b.y - s.a.y}, {p.x - s.a.x, p.y - s.a.y}) < 0) {
+                --w;
+            }
+        }
+        return w;
+    }
+};
+
+} // namespace MetaUI
@@ -0,0 +1,421 @@
+#pragma once
+
+#include "core.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace MetaUI {
+
+// ============================================================================
+// 2D Transforms
+// ============================================================================
+
+// Affine transform mapping (x, y) to (a x + c y + e, b x + d y + f).
+struct Transform2D {
+    float a = 1, b = 0, c = 0, d = 1, e = 0, f = 0;
+    
+    static Transform2D translation(float x, float y) { return {1, 0, 0, 1, x, y}; }
+    static Transform2D scaling(float sx, float sy) { return {sx, 0, 0, sy, 0, 0}; }
+    static Transform2D rotation(float radians) {
+        float cs = std::cos(radians), sn = std::sin(radians);
+        return {cs, sn, -sn, cs, 0, 0};
+    }
+    
+    // Applies other first, then this.
+    Transform2D operator*(const Transform2D& o) const {
+        return {a * o.a + c * o.b, b * o.a + d * o.b,
+                a * o.c + c * o.d, b * o.c + d * o.d,
+                a * o.e + c * o.f + e, b * o.e + d * o.f + f};
+    }
+    
+    Point apply(const Point& p) const { return Point(a * p.x + c * p.y + e, b * p.x + d * p.y + f); }
+    
+    // Average linear scale, used to size anti-aliasing fringes and
+    // flattening tolerance in device pixels.
+    float scale() const { return std::sqrt(std::fabs(a * d - b * c)); }
+    
+    // Column-major 4x4 for glMultMatrixf.
+    void toMatrix(float m[16]) const {
+        const float values[16] = {a, b, 0, 0, c, d, 0, 0, 0, 0, 1, 0, e, f, 0, 1};
+        std::copy(values, values + 16, m);
+    }
+};
+
+// ============================================================================
+// Vector Paths
+// ============================================================================
+
+enum class FillRule { NonZero, EvenOdd };
+enum class LineCap { Butt, Round, Square };
+
+// Joins are always round.
+struct StrokeStyle {
+    float width = 1.0f;
+    LineCap cap = LineCap::Butt;
+    
+    bool operator==(const StrokeStyle& o) const { return width == o.width && cap == o.cap; }
+};
+
+// Retained path geometry. The renderer caches tessellated vertex buffers
+// per path (keyed by id()) and rebuilds them only when version() changes or
+// the drawn scale moves far enough to affect curve flattening, so keep the
+// path object alive across frames and transform it at draw time instead of
+// rebuilding it.
+class VectorPath {
+public:
+    VectorPath() : id_(nextId()) {}
+    VectorPath(const VectorPath& other) : contours_(other.contours_), id_(nextId()) {}
+    VectorPath& operator=(const VectorPath& other) {
+        contours_ = other.contours_;
+        version_++;
+        return *this;
+    }
+    
+    VectorPath& moveTo(float x, float y) {
+        contours_.push_back(Contour{{Segment{Segment::Move, {Point(x, y)}}}, false});
+        pen_ = start_ = Point(x, y);
+        version_++;
+        return *this;
+    }
+    
+    VectorPath& lineTo(float x, float y) {
+        if (contours_.empty() || contours_.back().closed) return moveTo(x, y);
+        append(Segment{Segment::Line, {Point(x, y)}});
+        return *this;
+    }
+    
+    VectorPath& quadTo(float cx, float cy, float x, float y) {
+        if (contours_.empty() || contours_.back().closed) moveTo(pen_.x, pen_.y);
+        append(Segment{Segment::Quad, {Point(cx, cy), Point(x, y)}});
+        return *this;
+    }
+    
+    VectorPath& bezierTo(float c1x, float c1y, float c2x, float c2y, float x, float y) {
+        if (contours_.empty() || contours_.back().closed) moveTo(pen_.x, pen_.y);
+        append(Segment{Segment::Cubic, {Point(c1x, c1y), Point(c2x, c2y), Point(x, y)}});
+        return *this;
+    }
+    
+    // Circular arc as in HTML canvas: connects from the current point with a
+    // line, angles in radians, clockwise on screen unless counterClockwise.
+    VectorPath& arc(float cx, float cy, float r, float startAngle, float endAngle,
+                    bool counterClockwise = false) {
+        float sweep = endAngle - startAngle;
+        const float full = 2.0f * (float)M_PI;
+        if (!counterClockwise && sweep < 0) sweep = std::fmod(sweep, full) + full;
+        if (counterClockwise && sweep > 0) sweep = std::fmod(sweep, full) - full;
+        sweep = std::clamp(sweep, -full, full);
+        
+        float sx = cx + r * std::cos(startAngle), sy = cy + r * std::sin(startAngle);
+        if (contours_.empty() || contours_.back().closed) moveTo(sx, sy);
+        else lineTo(sx, sy);
+        
+        int segments = std::max(1, (int)std::ceil(std::fabs(sweep) / ((float)M_PI / 2) - 1e-4f));
+        float step = sweep / segments;
+        float k = 4.0f / 3.0f * std::tan(step / 4) * r;
+        float angle = startAngle;
+        for (int i = 0; i < segments; ++i) {
+            float a0 = angle, a1 = angle + step;
+            float c0 = std::cos(a0), s0 = std::sin(a0), c1 = std::cos(a1), s1 = std::sin(a1);
+            bezierTo(cx + r * c0 - k * s0, cy + r * s0 + k * c0,
+                     cx + r * c1 + k * s1, cy + r * s1 - k * c1,
+                     cx + r * c1, cy + r * s1);
+            angle = a1;
+        }
+        return *this;
+    }
+    
+    VectorPath& close() {
+        if (!contours_.empty() && !contours_.back().closed) {
+            contours_.back().closed = true;
+            pen_ = start_;
+            version_++;
+        }
+        return *this;
+    }
+    
+    VectorPath& rect(float x, float y, float w, float h) {
+        return moveTo(x, y).lineTo(x + w, y).lineTo(x + w, y + h).lineTo(x, y + h).close();
+    }
+    
+    VectorPath& roundedRect(float x, float y, float w, float h, float r) {
+        r = std::min({r, w / 2, h / 2});
+        if (r <= 0) return rect(x, y, w, h);
+        const float pi = (float)M_PI;
+        moveTo(x + r, y);
+        arc(x + w - r, y + r, r, -pi / 2, 0);
+        arc(x + w - r, y + h - r, r, 0, pi / 2);
+        arc(x + r, y + h - r, r, pi / 2, pi);
+        arc(x + r, y + r, r, pi, 3 * pi / 2);
+        return close();
+    }
+    
+    VectorPath& circle(float cx, float cy, float r) {
+        moveTo(cx + r, cy);
+        arc(cx, cy, r, 0, 2 * (float)M_PI);
+        return close();
+    }
+    
+    VectorPath& clear() {
+        contours_.clear();
+        version_++;
+        return *this;
+    }
+    
+    bool empty() const { return contours_.empty(); }
+    uint64_t id() const { return id_; }
+    uint64_t version() const { return version_; }
+    
+    // Polylines in path units with at most `tolerance` deviation from the
+    // curves. Closed contours do not repeat their first point.
+    struct Polyline {
+        std::vector<Point> points;
+        bool closed = false;
+    };
+    
+    std::vector<Polyline> flatten(float tolerance) const {
+        std::vector<Polyline> result;
+        for (const Contour& contour : contours_) {
+            Polyline line;
+            line.closed = contour.closed;
+            Point pen;
+            for (const Segment& s : contour.segments) {
+                switch (s.type) {
+                case Segment::Move:
+                case Segment::Line:
+                    line.points.push_back(s.p[0]);
+                    break;
+                case Segment::Quad:
+                    flattenCubic(pen, Point(pen.x + (s.p[0].x - pen.x) * 2 / 3, pen.y + (s.p[0].y - pen.y) * 2 / 3),
+                                 Point(s.p[1].x + (s.p[0].x - s.p[1].x) * 2 / 3, s.p[1].y + (s.p[0].y - s.p[1].y) * 2 / 3),
+                                 s.p[1], tolerance, line.points);
+                    break;
+                case Segment::Cubic:
+                    flattenCubic(pen, s.p[0], s.p[1], s.p[2], tolerance, line.points);
+                    break;
+                }
+                pen = line.points.back();
+            }
+            // Drop repeated points, including a closing point equal to the start.
+            auto& pts = line.points;
+            pts.erase(std::unique(pts.begin(), pts.end(), [](const Point& a, const Point& b) {
+                return std::fabs(a.x - b.x) < 1e-5f && std::fabs(a.y - b.y) < 1e-5f;
+            }), pts.end());
+            if (line.closed && pts.size() > 1 &&
+                std::fabs(pts.front().x - pts.back().x) < 1e-5f && std::fabs(pts.front().y - pts.back().y) < 1e-5f) {
+                pts.pop_back();
+            }
+            if (!pts.empty()) result.push_back(std::move(line));
+        }
+        return result;
+    }
+
+private:
+    struct Segment {
+        enum Type { Move, Line, Quad, Cubic } type;
+        Point p[3];
+    };
+    struct Contour {
+        std::vector<Segment> segments;
+        bool closed = false;
+    };
+    
+    std::vector<Contour> contours_;
+    Point pen_, start_;
+    uint64_t id_;
+    uint64_t version_ = 0;
+    
+    static uint64_t nextId() {
+        static std::atomic<uint64_t> counter{1};
+        return counter++;
+    }
+    
+    void append(const Segment& segment) {
+        contours_.back().segments.push_back(segment);
+        pen_ = segment.type == Segment::Line ? segment.p[0] :
+               segment.type == Segment::Quad ? segment.p[1] : segment.p[2];
+        version_++;
+    }
+    
+    static void flattenCubic(Point p0, Point p1, Point p2, Point p3, float tolerance, std::vector<Point>& out) {
+        // Segment count from the second-difference bound on the curve.
+        float ddx = std::max(std::fabs(p0.x - 2 * p1.x + p2.x), std::fabs(p1.x - 2 * p2.x + p3.x));
+        float ddy = std::max(std::fabs(p0.y - 2 * p1.y + p2.y), std::fabs(p1.y - 2 * p2.y + p3.y));
+        float dd = std::sqrt(ddx * ddx + ddy * ddy);
+        int steps = std::clamp((int)std::ceil(std::sqrt(dd * 0.75f / std::max(tolerance, 1e-4f))), 1, 256);
+        for (int i = 1; i <= steps; ++i) {
+            float t = (float)i / steps, s = 1 - t;
+            out.push_back(Point(s * s * s * p0.x + 3 * s * s * t * p1.x + 3 * s * t * t * p2.x + t * t * t * p3.x,
+                                s * s * s * p0.y + 3 * s * s * t * p1.y + 3 * s * t * t * p2.y + t * t * t * p3.y));
+        }
+    }
+};
+
+// ============================================================================
+// Path Tessellation
+// ============================================================================
+
+// Triangle lists of (x, y, coverage) in path units. Fills are drawn
+// stencil-then-cover: fan triangles set the winding in the stencil buffer,
+// fringe triangles straddle the outline for anti-aliasing, and a bounding
+// quad covers whatever the stencil marked. Strokes are one strip per
+// segment plus round joins and caps, each with a half-pixel fringe.
+struct PathTessellation {
+    std::vector<float> vertices;
+    size_t fanCount = 0, fringeCount = 0, coverCount = 0;   // in vertices, in that order
+    
+    size_t vertexCount() const { return vertices.size() / 3; }
+    
+    static PathTessellation fill(const VectorPath& path, float scale) {
+        PathTessellation t;
+        float px = 1.0f / std::max(scale, 1e-4f);   // one device pixel in path units
+        auto lines = path.flatten(0.25f * px);
+        
+        float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+        for (const auto& line : lines) {
+            if (line.points.size() < 3) continue;
+            const Point& p0 = line.points[0];
+            for (size_t i = 1; i + 1 < line.points.size(); ++i) {
+                t.push(p0, 1);
+                t.push(line.points[i], 1);
+                t.push(line.points[i + 1], 1);
+            }
+            for (const Point& p : line.points) {
+                minX = std::min(minX, p.x);
+                minY = std::min(minY, p.y);
+                maxX = std::max(maxX, p.x);
+                maxY = std::max(maxY, p.y);
+            }
+        }
+        t.fanCount = t.vertexCount();
+        if (t.fanCount == 0) return t;
+        
+        // Coverage 0.5 on the outline falling to 0 half a pixel to either
+        // side; only the outside half survives the stencil test.
+        float half = 0.5f * px;
+        for (const auto& line : lines) {
+            const auto& pts = line.points;
+            size_t n = pts.size();
+            if (n < 3) continue;
+            std::vector<Point> offsets(n);
+            for (size_t i = 0; i < n; ++i) offsets[i] = miterOffset(pts[(i + n - 1) % n], pts[i], pts[(i + 1) % n], half);
+            for (size_t i = 0; i < n; ++i) {
+                size_t j = (i + 1) % n;
+                for (float side : {1.0f, -1.0f}) {
+                    Point oi(pts[i].x + offsets[i].x * side, pts[i].y + offsets[i].y * side);
+                    Point oj(pts[j].x + offsets[j].x * side, pts[j].y + offsets[j].y * side);
+                    t.quad(pts[i], 0.5f, pts[j], 0.5f, oj, 0, oi, 0);
+                }
+            }
+        }
+        t.fringeCount = t.vertexCount() - t.fanCount;
+        
+        minX -= px;
+        minY -= px;
+        maxX += px;
+        maxY += px;
+        t.quad(Point(minX, minY), 1, Point(maxX, minY), 1, Point(maxX, maxY), 1, Point(minX, maxY), 1);
+        t.coverCount = 6;
+        return t;
+    }
+    
+    static PathTessellation stroke(const VectorPath& path, const StrokeStyle& style, float scale) {
+        PathTessellation t;
+        float px = 1.0f / std::max(scale, 1e-4f);
+        auto lines = path.flatten(0.25f * px);
+        
+        // Hairlines keep a one pixel footprint and fade instead of thinning.
+        float alpha = std::min(1.0f, style.width / px);
+        float hw = std::max(style.width, px) / 2;
+        float inner = std::max(0.0f, hw - 0.5f * px), outer = hw + 0.5f * px;
+        
+        int discSteps = std::clamp((int)std::ceil(2 * (float)M_PI / std::acos(std::max(-1.0f, 1 - 0.25f * px / outer))), 8, 64);
+        auto disc = [&](const Point& c) {
+            for (int i = 0; i < discSteps; ++i) {
+                float a0 = 2 * (float)M_PI * i / discSteps, a1 = 2 * (float)M_PI * (i + 1) / discSteps;
+                Point d0(std::cos(a0), std::sin(a0)), d1(std::cos(a1), std::sin(a1));
+                Point i0(c.x + d0.x * inner, c.y + d0.y * inner), i1(c.x + d1.x * inner, c.y + d1.y * inner);
+                if (inner > 0) {
+                    t.push(c, alpha);
+                    t.push(i0, alpha);
+                    t.push(i1, alpha);
+                }
+                t.quad(i0, alpha, i1, alpha, Point(c.x + d1.x * outer, c.y + d1.y * outer), 0,
+                       Point(c.x + d0.x * outer, c.y + d0.y * outer), 0);
+            }
+        };
+        
+        for (const auto& line : lines) {
+            std::vector<Point> pts = line.points;
+            if (line.closed && pts.size() > 2) pts.push_back(pts.front());
+            size_t n = pts.size();
+            if (n < 2) {
+                if (n == 1 && style.cap == LineCap::Round) disc(pts[0]);
+                continue;
+            }
+            
+            for (size_t i = 0; i + 1 < n; ++i) {
+                Point a = pts[i], b = pts[i + 1];
+                float dx = b.x - a.x, dy = b.y - a.y;
+                float len = std::sqrt(dx * dx + dy * dy);
+                if (len == 0) continue;
+                dx /= len;
+                dy /= len;
+                if (!line.closed && style.cap == LineCap::Square) {
+                    if (i == 0) a = Point(a.x - dx * hw, a.y - dy * hw);
+                    if (i + 2 == n) b = Point(b.x + dx * hw, b.y + dy * hw);
+                }
+                Point nrm(-dy, dx);
+                auto at = [](const Point& p, const Point& d, float s) { return Point(p.x + d.x * s, p.y + d.y * s); };
+                if (inner > 0) t.quad(at(a, nrm, inner), alpha, at(b, nrm, inner), alpha, at(b, nrm, -inner), alpha, at(a, nrm, -inner), alpha);
+                t.quad(at(a, nrm, inner), alpha, at(b, nrm, inner), alpha, at(b, nrm, outer), 0, at(a, nrm, outer), 0);
+                t.quad(at(a, nrm, -inner), alpha, at(b, nrm, -inner), alpha, at(b, nrm, -outer), 0, at(a, nrm, -outer), 0);
+            }
+            
+            // A closed contour repeats its start, which needs only one join.
+            for (size_t i = 0; i < n; ++i) {
+                bool end = i == 0 || i + 1 == n;
+                if (line.closed && i + 1 == n && n > 2) continue;
+                if (!end || line.closed || style.cap == LineCap::Round) disc(pts[i]);
+            }
+        }
+        return t;
+    }
+
+private:
+    void push(const Point& p, float coverage) {
+        vertices.push_back(p.x);
+        vertices.push_back(p.y);
+        vertices.push_back(coverage);
+    }
+    
+    void quad(const Point& p0, float c0, const Point& p1, float c1, const Point& p2, float c2, const Point& p3, float c3) {
+        push(p0, c0);
+        push(p1, c1);
+        push(p2, c2);
+        push(p0, c0);
+        push(p2, c2);
+        push(p3, c3);
+    }
+    
+    // Offset along the averaged edge normals, lengthened at corners (up to
+    // 4x) so the fringe keeps its width.
+    static Point miterOffset(const Point& prev, const Point& p, const Point& next, float distance) {
+        auto normal = [](const Point& a, const Point& b) {
+            float dx = b.x - a.x, dy = b.y - a.y;
+            float len = std::sqrt(dx * dx + dy * dy);
+            return len > 0 ? Point(-dy / len, dx / len) : Point(0, 0);
+        };
+        Point n0 = normal(prev, p), n1 = normal(p, next);
+        Point dm((n0.x + n1.x) / 2, (n0.y + n1.y) / 2);
+        float d2 = dm.x * dm.x + dm.y * dm.y;
+        float s = d2 > 1e-6f ? std::min(1.0f / d2, 4.0f) : 1.0f;
+        if (d2 <= 1e-6f) dm = n1;
+        return Point(dm.x * s * distance, dm.y * s * distance);
+    }
+};
+
+} // namespace MetaUI
@@ -15,11 +15,28 @@
 
 #include "core.hpp"
 #include "widget.hpp"
+#include "glyphcache.hpp"
+#include "fontdb.hpp"
+#include "resources.hpp"
+#include "msdf.hpp"
+#include "svg.hpp"
+#include "path.hpp"
+#include "threadpool.hpp"
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
 #include <GL/gl.h>
+#include <GL/glext.h>
+#include <sys/stat.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <cstring>
 #include <algorithm>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <cstddef>
 
 
 
@@ -49,7 +66,9 @@ public:
         
         GLenum format = (channels == 4) ? GL_RGBA : 
                         (channels == 3) ? GL_RGB : 
+                        (channels == 2) ? GL_LUMINANCE_ALPHA :
                         (channels == 1) ? GL_ALPHA : GL_RGBA;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, 
                      format, GL_UNSIGNED_BYTE, data);
@@ -65,7 +84,7 @@ public:
     
     // Move only
     Texture(Texture&& other) noexcept 
-        : id_(other.id_), width_(other.width_), height_(other.height_) {
+        : id_(other.id_), width_(other.width_), height_(other.height_), version_(other.version_) {
         other.id_ = 0;
     }
     
@@ -75,6 +94,7 @@ public:
             id_ = other.id_;
             width_ = other.width_;
             height_ = other.height_;
+            version_ = other.version_;
             other.id_ = 0;
         }
         return *this;
@@ -83,61 +103,719 @@ public:
     Texture(const Texture&) = delete;
     Texture& operator=(const Texture&) = delete;
     
+    // Single-channel 32-bit float texture (GL_R32F) for data that a shader
+    // maps to colors. Contents start undefined; fill with update().
+    static Texture floatTexture(int width, int height) {
+        Texture texture;
+        texture.width_ = width;
+        texture.height_ = height;
+        glGenTextures(1, &texture.id_);
+        glBindTexture(GL_TEXTURE_2D, texture.id_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+    
+    // Replaces a sub-rectangle; format/type describe the tightly packed data.
+    void update(int x, int y, int width, int height, GLenum format, GLenum type, const void* data) {
+        glBindTexture(GL_TEXTURE_2D, id_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, data);
+        version_ = nextVersion();
+    }
+    
+    void setFilter(GLenum filter) {
+        glBindTexture(GL_TEXTURE_2D, id_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    }
+    
     GLuint id() const { return id_; }
     int width() const { return width_; }
     int height() const { return height_; }
     bool valid() const { return id_ != 0; }
     
+    // Changes with every update(); never shared between two textures.
+    uint64_t contentVersion() const { return version_; }
+
 private:
     GLuint id_ = 0;
     int width_ = 0, height_ = 0;
+    uint64_t version_ = nextVersion();
+    
+    static uint64_t nextVersion() {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
 };
 
 // ============================================================================
-// Font Management
+// Shader Programs
 // ============================================================================
 
-class Font {
+// GLSL 1.20 program for the compatibility profile: shaders read the
+// fixed-function inputs (gl_Vertex, gl_Color, gl_MultiTexCoord0), so
+// immediate-mode drawing works unchanged while the program is bound.
+class ShaderProgram {
 public:
-    Font(const std::string& path, float size) : size_(size) {
-        FILE* file = fopen(path.c_str(), "rb");
-        if (!file) {
-            // Try fallback fonts
-            const char* fallbacks[] = {
-                "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
-                "/usr/share/fonts/TTF/DejaVuSans.ttf",
-                "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
-                "/usr/share/fonts/noto/NotoSans-Regular.ttf",
-                nullptr
-            };
-            for (int i = 0; fallbacks[i]; i++) {
-                file = fopen(fallbacks[i], "rb");
-                if (file) break;
+    ShaderProgram() = default;
+    
+    ShaderProgram(const char* vertexSource, const char* fragmentSource) {
+        GLuint vs = compile(GL_VERTEX_SHADER, vertexSource);
+        GLuint fs = compile(GL_FRAGMENT_SHADER, fragmentSource);
+        if (vs && fs) {
+            id_ = glCreateProgram();
+            glAttachShader(id_, vs);
+            glAttachShader(id_, fs);
+            glLinkProgram(id_);
+            GLint linked = 0;
+            glGetProgramiv(id_, GL_LINK_STATUS, &linked);
+            if (!linked) {
+                glDeleteProgram(id_);
+                id_ = 0;
             }
         }
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+    }
+    
+    ~ShaderProgram() {
+        if (id_) glDeleteProgram(id_);
+    }
+    
+    ShaderProgram(ShaderProgram&& other) noexcept : id_(other.id_) { other.id_ = 0; }
+    
+    ShaderProgram& operator=(ShaderProgram&& other) noexcept {
+        if (this != &other) {
+            if (id_) glDeleteProgram(id_);
+            id_ = other.id_;
+            other.id_ = 0;
+        }
+        return *this;
+    }
+    
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+    
+    GLuint id() const { return id_; }
+    bool valid() const { return id_ != 0; }
+    GLint uniform(const char* name) const { return glGetUniformLocation(id_, name); }
+
+private:
+    GLuint id_ = 0;
+    
+    static GLuint compile(GLenum type, const char* source) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        GLint compiled = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+};
+
+// ============================================================================
+// Vertex Buffers
+// ============================================================================
+
+// Static float vertex data in a GL buffer object.
+class VertexBuffer {
+public:
+    VertexBuffer() = default;
+    
+    ~VertexBuffer() {
+        if (id_) glDeleteBuffers(1, &id_);
+    }
+    
+    VertexBuffer(VertexBuffer&& other) noexcept : id_(other.id_) { other.id_ = 0; }
+    
+    VertexBuffer& operator=(VertexBuffer&& other) noexcept {
+        if (this != &other) {
+            if (id_) glDeleteBuffers(1, &id_);
+            id_ = other.id_;
+            other.id_ = 0;
+        }
+        return *this;
+    }
+    
+    VertexBuffer(const VertexBuffer&) = delete;
+    VertexBuffer& operator=(const VertexBuffer&) = delete;
+    
+    void upload(const std::vector<float>& data) {
+        upload(data.data(), data.size() * sizeof(float), GL_STATIC_DRAW);
+    }
+    
+    // GL_STREAM_DRAW for data replaced every frame.
+    void upload(const void* data, size_t bytes, GLenum usage) {
+        if (!id_) glGenBuffers(1, &id_);
+        glBindBuffer(GL_ARRAY_BUFFER, id_);
+        glBufferData(GL_ARRAY_BUFFER, bytes, data, usage);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    
+    GLuint id() const { return id_; }
+    bool valid() const { return id_ != 0; }
+    
+private:
+    GLuint id_ = 0;
+};
+
+// ============================================================================
+// Render Targets
+// ============================================================================
+
+// RGBA8 texture with a framebuffer object attached, for offscreen passes.
+// Invalid when the driver reports the framebuffer incomplete.
+class RenderTarget {
+public:
+    RenderTarget() = default;
+    
+    RenderTarget(int width, int height) : texture_(width, height, nullptr, 4) {
+        GLint previous = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+        glGenFramebuffers(1, &fbo_);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_.id(), 0);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+        if (!complete) {
+            glDeleteFramebuffers(1, &fbo_);
+            fbo_ = 0;
+        }
+    }
+    
+    ~RenderTarget() {
+        if (fbo_) glDeleteFramebuffers(1, &fbo_);
+    }
+    
+    RenderTarget(RenderTarget&& other) noexcept : texture_(std::move(other.texture_)), fbo_(other.fbo_) {
+        other.fbo_ = 0;
+    }
+    
+    RenderTarget& operator=(RenderTarget&& other) noexcept {
+        if (this != &other) {
+            if (fbo_) glDeleteFramebuffers(1, &fbo_);
+            texture_ = std::move(other.texture_);
+            fbo_ = other.fbo_;
+            other.fbo_ = 0;
+        }
+        return *this;
+    }
+    
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+    
+    // Binds the framebuffer and sets the viewport to cover it.
+    void bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glViewport(0, 0, texture_.width(), texture_.height());
+    }
+    
+    const Texture& texture() const { return texture_; }
+    int width() const { return texture_.width(); }
+    int height() const { return texture_.height(); }
+    bool valid() const { return fbo_ != 0; }
+
+private:
+    Texture texture_;
+    GLuint fbo_ = 0;
+};
+
+// ============================================================================
+// Color Glyphs
+// ============================================================================
+
+// Bitmap color glyphs from an emoji font: CBDT/CBLC (Noto Color Emoji) or
+// sbix (Apple). Only the tables needed to find a glyph's PNG are read, so
+// fonts without outlines load fine; PNGs are decoded with stb_image.
+class ColorGlyphSource {
+public:
+    // A decoded glyph scaled to a pixel size. Bearings are from the pen
+    // position on the baseline to the bitmap's top-left, y up.
+    struct Bitmap {
+        std::vector<unsigned char> rgba;
+        int width = 0, height = 0;
+        float bearingX = 0, bearingY = 0;
+    };
+    
+    explicit ColorGlyphSource(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "rb");
         if (!file) return;
-        
         fseek(file, 0, SEEK_END);
-        size_t fileSize = ftell(file);
+        size_t size = ftell(file);
         fseek(file, 0, SEEK_SET);
-        
-        fontData_.resize(fileSize);
-        fread(fontData_.data(), 1, fileSize, file);
+        data_.resize(size);
+        if (fread(data_.data(), 1, size, file) != size) data_.clear();
         fclose(file);
+        parseTables();
+    }
+    
+    bool valid() const { return cmap_ != 0 && ((cblc_ && cbdt_) || (sbix_ && hmtx_)); }
+    
+    bool hasGlyph(int codepoint) const {
+        return valid() && glyphIndex(codepoint) != 0;
+    }
+    
+    // Advance as a fraction of the em.
+    float advance(int codepoint) const {
+        Location loc;
+        if (!locate(glyphIndex(codepoint), 0, loc)) return 0;
+        return loc.advance;
+    }
+    
+    // Decodes the glyph from the strike best suited to emPixels and box
+    // filters it down to that size.
+    bool decode(int codepoint, float emPixels, Bitmap& out) const {
+        Location loc;
+        if (!locate(glyphIndex(codepoint), emPixels, loc) || loc.pngLength == 0) return false;
         
-        if (!stbtt_InitFont(&font_, fontData_.data(), 0)) {
-            fontData_.clear();
-            return;
+        int w, h, channels;
+        unsigned char* pixels = stbi_load_from_memory(
+            data_.data() + loc.png, (int)loc.pngLength, &w, &h, &channels, 4);
+        if (!pixels) return false;
+        
+        float scale = emPixels / loc.ppem;
+        out.width = std::max(1, (int)std::lround(w * scale));
+        out.height = std::max(1, (int)std::lround(h * scale));
+        out.bearingX = loc.bearingX * emPixels;
+        out.bearingY = (loc.bearingTop ? loc.bearingY : loc.bearingY + (float)h / loc.ppem) * emPixels;
+        out.rgba.assign((size_t)out.width * out.height * 4, 0);
+        
+        // Alpha-weighted box filter so transparent edges don't darken.
+        for (int y = 0; y < out.height; ++y) {
+            int sy0 = y * h / out.height;
+            int sy1 = std::max(sy0 + 1, (y + 1) * h / out.height);
+            for (int x = 0; x < out.width; ++x) {
+                int sx0 = x * w / out.width;
+                int sx1 = std::max(sx0 + 1, (x + 1) * w / out.width);
+                float r = 0, g = 0, b = 0, a = 0;
+                for (int sy = sy0; sy < sy1; ++sy) {
+                    const unsigned char* p = pixels + ((size_t)sy * w + sx0) * 4;
+                    for (int sx = sx0; sx < sx1; ++sx, p += 4) {
+                        float pa = p[3];
+                        r += p[0] * pa;
+                        g += p[1] * pa;
+                        b += p[2] * pa;
+                        a += pa;
+                    }
+                }
+                unsigned char* o = &out.rgba[((size_t)y * out.width + x) * 4];
+                if (a > 0) {
+                    o[0] = (unsigned char)(r / a + 0.5f);
+                    o[1] = (unsigned char)(g / a + 0.5f);
+                    o[2] = (unsigned char)(b / a + 0.5f);
+                    o[3] = (unsigned char)(a / ((sx1 - sx0) * (sy1 - sy0)) + 0.5f);
+                }
+            }
+        }
+        stbi_image_free(pixels);
+        return true;
+    }
+    
+private:
+    std::vector<unsigned char> data_;
+    size_t cmap_ = 0, cmapSub_ = 0;
+    int cmapFormat_ = 0;
+    size_t cblc_ = 0, cbdt_ = 0, sbix_ = 0;
+    size_t head_ = 0, hhea_ = 0, hmtx_ = 0, maxp_ = 0;
+    
+    // Where a glyph's PNG lives and its metrics as fractions of the em. For
+    // sbix the bearing is to the bitmap's bottom-left (bearingTop = false).
+    struct Location {
+        size_t png = 0, pngLength = 0;
+        float ppem = 0;
+        float bearingX = 0, bearingY = 0, advance = 0;
+        bool bearingTop = true;
+    };
+    
+    uint8_t u8(size_t o) const { return o < data_.size() ? data_[o] : 0; }
+    uint16_t u16(size_t o) const { return (uint16_t)(u8(o) << 8 | u8(o + 1)); }
+    uint32_t u32(size_t o) const { return (uint32_t)u16(o) << 16 | u16(o + 2); }
+    int8_t s8(size_t o) const { return (int8_t)u8(o); }
+    int16_t s16(size_t o) const { return (int16_t)u16(o); }
+    
+    void parseTables() {
+        if (data_.size() < 12) return;
+        uint16_t numTables = u16(4);
+        for (uint16_t i = 0; i < numTables; ++i) {
+            size_t record = 12 + (size_t)i * 16;
+            uint32_t tag = u32(record);
+            size_t offset = u32(record + 8);
+            if (offset >= data_.size()) continue;
+            switch (tag) {
+                case 0x636D6170: cmap_ = offset; break;  // cmap
+                case 0x43424C43: cblc_ = offset; break;  // CBLC
+                case 0x43424454: cbdt_ = offset; break;  // CBDT
+                case 0x73626978: sbix_ = offset; break;  // sbix
+                case 0x68656164: head_ = offset; break;  // head
+                case 0x68686561: hhea_ = offset; break;  // hhea
+                case 0x686D7478: hmtx_ = offset; break;  // hmtx
+                case 0x6D617870: maxp_ = offset; break;  // maxp
+            }
         }
+        if (!cmap_) return;
         
-        scale_ = stbtt_ScaleForPixelHeight(&font_, size);
-        stbtt_GetFontVMetrics(&font_, &ascent_, &descent_, &lineGap_);
-        ascent_ = (int)(ascent_ * scale_);
-        descent_ = (int)(descent_ * scale_);
-        lineGap_ = (int)(lineGap_ * scale_);
+        // Prefer a full-Unicode format 12 subtable, fall back to BMP format 4.
+        uint16_t count = u16(cmap_ + 2);
+        for (uint16_t i = 0; i < count; ++i) {
+            size_t record = cmap_ + 4 + (size_t)i * 8;
+            uint16_t platform = u16(record), encoding = u16(record + 2);
+            size_t sub = cmap_ + u32(record + 4);
+            uint16_t format = u16(sub);
+            bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+            if (!unicode) continue;
+            if (format == 12 || (format == 4 && cmapFormat_ != 12)) {
+                cmapFormat_ = format;
+                cmapSub_ = sub;
+            }
+        }
+        if (!cmapFormat_) cmap_ = 0;
+    }
+    
+    uint32_t glyphIndex(int codepoint) const {
+        uint32_t cp = (uint32_t)codepoint;
+        if (cmapFormat_ == 12) {
+            uint32_t lo = 0, hi = u32(cmapSub_ + 12);
+            while (lo < hi) {
+                uint32_t mid = (lo + hi) / 2;
+                size_t group = cmapSub_ + 16 + (size_t)mid * 12;
+                if (cp < u32(group)) hi = mid;
+                else if (cp > u32(group + 4)) lo = mid + 1;
+                else return u32(group + 8) + (cp - u32(group));
+            }
+            return 0;
+        }
+        if (cmapFormat_ == 4 && cp <= 0xFFFF) {
+            size_t segX2 = u16(cmapSub_ + 6);
+            size_t ends = cmapSub_ + 14;
+            size_t starts = ends + segX2 + 2;
+            size_t deltas = starts + segX2;
+            size_t ranges = deltas + segX2;
+            for (size_t s = 0; s < segX2; s += 2) {
+                if (cp > u16(ends + s)) continue;
+                if (cp < u16(starts + s)) return 0;
+                uint16_t rangeOffset = u16(ranges + s);
+                if (rangeOffset == 0) return (cp + u16(deltas + s)) & 0xFFFF;
+                uint16_t glyph = u16(ranges + s + rangeOffset + (cp - u16(starts + s)) * 2);
+                return glyph ? (glyph + u16(deltas + s)) & 0xFFFF : 0;
+            }
+        }
+        return 0;
+    }
+    
+    // emPixels == 0 picks the largest strike (used for metrics only).
+    bool locate(uint32_t glyph, float emPixels, Location& loc) const {
+        if (glyph == 0) return false;
+        if (cblc_ && cbdt_) return locateCbdt(glyph, emPixels, loc);
+        if (sbix_) return locateSbix(glyph, emPixels, loc);
+        return false;
+    }
+    
+    // Smallest strike at least emPixels, else the largest one.
+    template<typename PpemAt>
+    static int pickStrike(uint32_t count, float emPixels, PpemAt ppemAt) {
+        int best = -1, largest = -1;
+        for (uint32_t i = 0; i < count; ++i) {
+            int ppem = ppemAt(i);
+            if (ppem <= 0) continue;
+            if (largest < 0 || ppem > ppemAt(largest)) largest = (int)i;
+            if (emPixels > 0 && ppem >= emPixels && (best < 0 || ppem < ppemAt(best))) best = (int)i;
+        }
+        return best >= 0 ? best : largest;
+    }
+    
+    bool locateCbdt(uint32_t glyph, float emPixels, Location& loc) const {
+        uint32_t numSizes = u32(cblc_ + 4);
+        auto strikeAt = [&](uint32_t i) { return cblc_ + 8 + (size_t)i * 48; };
+        auto covers = [&](uint32_t i) {
+            size_t st = strikeAt(i);
+            return glyph >= u16(st + 40) && glyph <= u16(st + 42);
+        };
+        int strike = pickStrike(numSizes, emPixels, [&](uint32_t i) {
+            return covers(i) ? (int)u8(strikeAt(i) + 45) : 0;
+        });
+        if (strike < 0) return false;
         
-        createAtlas();
-        valid_ = true;
+        size_t st = strikeAt((uint32_t)strike);
+        size_t array = cblc_ + u32(st);
+        uint32_t subtables = u32(st + 8);
+        loc.ppem = u8(st + 45);
+        
+        for (uint32_t i = 0; i < subtables; ++i) {
+            size_t entry = array + (size_t)i * 8;
+            uint16_t first = u16(entry), last = u16(entry + 2);
+            if (glyph < first || glyph > last) continue;
+            
+            size_t sub = array + u32(entry + 4);
+            uint16_t indexFormat = u16(sub);
+            uint16_t imageFormat = u16(sub + 2);
+            size_t imageData = cbdt_ + u32(sub + 4);
+            size_t offset = 0;
+            size_t bigMetrics = 0;
+            uint32_t index = glyph - first;
+            
+            switch (indexFormat) {
+                case 1: offset = imageData + u32(sub + 8 + (size_t)index * 4); break;
+                case 3: offset = imageData + u16(sub + 8 + (size_t)index * 2); break;
+                case 2:
+                    offset = imageData + (size_t)u32(sub + 8) * index;
+                    bigMetrics = sub + 12;
+                    break;
+                case 4: {
+                    uint32_t n = u32(sub + 8);
+                    for (uint32_t k = 0; k < n; ++k) {
+                        if (u16(sub + 12 + (size_t)k * 4) == glyph) {
+                            offset = imageData + u16(sub + 14 + (size_t)k * 4);
+                            break;
+                        }
+                    }
+                    break;
+                }
+                case 5: {
+                    uint32_t n = u32(sub + 20);
+                    for (uint32_t k = 0; k < n; ++k) {
+                        if (u16(sub + 24 + (size_t)k * 2) == glyph) {
+                            offset = imageData + (size_t)u32(sub + 8) * k;
+                            break;
+                        }
+                    }
+                    bigMetrics = sub + 12;
+                    break;
+                }
+                default: return false;
+            }
+            if (!offset) return false;
+            return readCbdtGlyph(offset, imageFormat, bigMetrics, loc);
+        }
+        return false;
+    }
+    
+    bool readCbdtGlyph(size_t at, uint16_t imageFormat, size_t indexMetrics, Location& loc) const {
+        size_t metrics;
+        size_t lengthAt;
+        switch (imageFormat) {
+            case 17: metrics = at; lengthAt = at + 5; break;
+            case 18: metrics = at; lengthAt = at + 8; break;
+            case 19:
+                if (!indexMetrics) return false;
+                metrics = indexMetrics;
+                lengthAt = at;
+                break;
+            default: return false;
+        }
+        // small and big metrics share the first five fields.
+        loc.bearingX = s8(metrics + 2) / loc.ppem;
+        loc.bearingY = s8(metrics + 3) / loc.ppem;
+        loc.advance = u8(metrics + 4) / loc.ppem;
+        loc.bearingTop = true;
+        loc.pngLength = u32(lengthAt);
+        loc.png = lengthAt + 4;
+        return loc.png + loc.pngLength <= data_.size();
+    }
+    
+    bool locateSbix(uint32_t glyph, float emPixels, Location& loc) const {
+        uint16_t numGlyphs = maxp_ ? u16(maxp_ + 4) : 0;
+        uint16_t unitsPerEm = head_ ? u16(head_ + 18) : 0;
+        if (glyph >= numGlyphs || unitsPerEm == 0 || !hhea_) return false;
+        
+        uint32_t numStrikes = u32(sbix_ + 4);
+        auto strikeAt = [&](uint32_t i) { return sbix_ + u32(sbix_ + 8 + (size_t)i * 4); };
+        int strike = pickStrike(numStrikes, emPixels, [&](uint32_t i) { return (int)u16(strikeAt(i)); });
+        if (strike < 0) return false;
+        
+        uint16_t numHMetrics = u16(hhea_ + 34);
+        if (numHMetrics == 0) return false;
+        loc.advance = (float)u16(hmtx_ + 4 * (size_t)std::min<uint32_t>(glyph, numHMetrics - 1)) / unitsPerEm;
+        
+        size_t st = strikeAt((uint32_t)strike);
+        loc.ppem = u16(st);
+        for (int hops = 0; hops < 2; ++hops) {
+            size_t begin = st + u32(st + 4 + (size_t)glyph * 4);
+            size_t end = st + u32(st + 8 + (size_t)glyph * 4);
+            if (end <= begin + 8) return false;
+            uint32_t type = u32(begin + 4);
+            if (type == 0x64757065) {  // 'dupe': data is another glyph id
+                glyph = u16(begin + 8);
+                if (glyph >= numGlyphs) return false;
+                continue;
+            }
+            if (type != 0x706E6720) return false;  // 'png '
+            loc.bearingX = s16(begin) / loc.ppem;
+            loc.bearingY = s16(begin + 2) / loc.ppem;
+            loc.bearingTop = false;
+            loc.png = begin + 8;
+            loc.pngLength = end - begin - 8;
+            return end <= data_.size();
+        }
+        return false;
+    }
+};
+
+// RGBA atlas pages for color glyphs, shared by every font of a renderer.
+// Glyphs are rasterized once per (codepoint, size). When the page budget is
+// used up, the least recently drawn page is cleared and reused; pages drawn
+// in the current frame are never evicted.
+class ColorGlyphCache {
+public:
+    static constexpr int PAGE_SIZE = 512;
+    
+    // Atlas location and quad offsets from the pen position on the baseline.
+    struct Entry {
+        int page = -1;
+        float u0, v0, u1, v1;
+        float x0, y0, x1, y1;
+    };
+    
+    explicit ColorGlyphCache(std::unique_ptr<ColorGlyphSource> source, size_t maxPages = 4)
+        : source_(std::move(source)), maxPages_(std::max<size_t>(1, maxPages)) {}
+    
+    bool hasGlyph(int codepoint) const { return source_->hasGlyph(codepoint); }
+    float advance(int codepoint, float emPixels) const {
+        return source_->advance(codepoint) * emPixels;
+    }
+    
+    void beginFrame() { frame_++; }
+    
+    // Rasterizes on a miss, which uploads to a page texture: call outside
+    // glBegin/glEnd. Returns nullptr when the glyph can't be drawn.
+    const Entry* get(int codepoint, float emPixels) {
+        uint64_t key = (uint64_t)codepoint << 16 | (uint16_t)std::lround(emPixels * 4);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            if (it->second.page < 0) return nullptr;
+            pages_[it->second.page].lastUse = frame_;
+            return &it->second;
+        }
+        
+        ColorGlyphSource::Bitmap bitmap;
+        if (!source_->decode(codepoint, emPixels, bitmap) ||
+            bitmap.width > PAGE_SIZE - 2 || bitmap.height > PAGE_SIZE - 2) {
+            entries_[key] = Entry{};
+            return nullptr;
+        }
+        
+        int x, y;
+        int page = allocate(bitmap.width, bitmap.height, x, y);
+        if (page < 0) return nullptr;
+        
+        glBindTexture(GL_TEXTURE_2D, pages_[page].texture.id());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, bitmap.width, bitmap.height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, bitmap.rgba.data());
+        
+        Entry& entry = entries_[key];
+        entry.page = page;
+        entry.u0 = (float)x / PAGE_SIZE;
+        entry.v0 = (float)y / PAGE_SIZE;
+        entry.u1 = (float)(x + bitmap.width) / PAGE_SIZE;
+        entry.v1 = (float)(y + bitmap.height) / PAGE_SIZE;
+        entry.x0 = std::round(bitmap.bearingX);
+        entry.y0 = -std::round(bitmap.bearingY);
+        entry.x1 = entry.x0 + bitmap.width;
+        entry.y1 = entry.y0 + bitmap.height;
+        pages_[page].keys.push_back(key);
+        pages_[page].lastUse = frame_;
+        return &entry;
+    }
+    
+    GLuint pageTexture(int page) const { return pages_[page].texture.id(); }
+    size_t pageCount() const { return pages_.size(); }
+
+private:
+    struct Page {
+        Texture texture;
+        int x = 1, y = 1, rowHeight = 0;
+        uint64_t lastUse = 0;
+        std::vector<uint64_t> keys;
+    };
+    
+    std::unique_ptr<ColorGlyphSource> source_;
+    size_t maxPages_;
+    std::vector<Page> pages_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    uint64_t frame_ = 0;
+    
+    static bool pack(Page& page, int w, int h, int& x, int& y) {
+        if (page.x + w + 1 >= PAGE_SIZE) {
+            page.x = 1;
+            page.y += page.rowHeight + 1;
+            page.rowHeight = 0;
+        }
+        if (page.y + h + 1 >= PAGE_SIZE) return false;
+        x = page.x;
+        y = page.y;
+        page.x += w + 1;
+        page.rowHeight = std::max(page.rowHeight, h);
+        return true;
+    }
+    
+    int allocate(int w, int h, int& x, int& y) {
+        for (size_t i = 0; i < pages_.size(); ++i) {
+            if (pack(pages_[i], w, h, x, y)) return (int)i;
+        }
+        
+        std::vector<unsigned char> blank((size_t)PAGE_SIZE * PAGE_SIZE * 4, 0);
+        if (pages_.size() < maxPages_) {
+            pages_.emplace_back();
+            pages_.back().texture = Texture(PAGE_SIZE, PAGE_SIZE, blank.data(), 4);
+            return pack(pages_.back(), w, h, x, y) ? (int)pages_.size() - 1 : -1;
+        }
+        
+        int victim = -1;
+        for (size_t i = 0; i < pages_.size(); ++i) {
+            if (pages_[i].lastUse < frame_ &&
+                (victim < 0 || pages_[i].lastUse < pages_[victim].lastUse)) {
+                victim = (int)i;
+            }
+        }
+        if (victim < 0) return -1;
+        
+        Page& page = pages_[victim];
+        for (uint64_t key : page.keys) entries_.erase(key);
+        page.keys.clear();
+        page.x = page.y = 1;
+        page.rowHeight = 0;
+        glBindTexture(GL_TEXTURE_2D, page.texture.id());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PAGE_SIZE, PAGE_SIZE,
+                        GL_RGBA, GL_UNSIGNED_BYTE, blank.data());
+        return pack(page, w, h, x, y) ? victim : -1;
+    }
+};
+
+// ============================================================================
+// Font Management
+// ============================================================================
+
+struct GlyphRun;
+
+class Font {
+public:
+    // path may also be a family or generic name ("serif", "monospace"),
+    // resolved through FontDatabase when no such file exists, or a
+    // "res://" resource. Fonts that can't be opened fall back to the
+    // default sans face. With shareAtlas the atlas lives in a
+    // SharedGlyphAtlas segment shared with other processes using the same
+    // font file and size.
+    Font(const std::string& path, float size, bool shareAtlas = false) : size_(size) {
+        FontDatabase& db = FontDatabase::shared();
+        const FontFace* face = FontDatabase::isFilePath(path) ? nullptr : db.resolve(path);
+        if (face) {
+            open(face->path, face->index, shareAtlas);
+        } else if (!open(path, 0, shareAtlas) && (face = db.resolve(""))) {
+            open(face->path, face->index, shareAtlas);
+        }
+    }
+    
+    Font(const FontFace& face, float size, bool shareAtlas = false) : size_(size) {
+        open(face.path, face.index, shareAtlas);
     }
     
     struct GlyphInfo {
@@ -145,31 +823,80 @@ public:
         float x0, y0, x1, y1;
         float advance;
         int width, height;
+        bool color = false;  // drawn from the renderer's ColorGlyphCache
     };
     
-    const GlyphInfo* getGlyph(int codepoint) {
-        auto it = glyphs_.find(codepoint);
+    // Horizontal subpixel offsets each glyph can be rasterized at. Pen
+    // positions are quantized to 1/SUBPIXEL_BINS px so glyph spacing stays
+    // even and text doesn't shimmer while moving by fractional amounts.
+    static constexpr int SUBPIXEL_BINS = 4;
+    
+    const GlyphInfo* getGlyph(int codepoint, int bin = 0) {
+        auto it = glyphs_.find(glyphKey(codepoint, bin));
         if (it != glyphs_.end()) return &it->second;
         
         // Try to add glyph dynamically
-        if (codepoint >= 32 && codepoint < 0x10000) {
-            addGlyph(codepoint);
-            it = glyphs_.find(codepoint);
+        if (codepoint >= 32 && codepoint <= 0x10FFFF) {
+            if (isColorGlyph(codepoint)) {
+                GlyphInfo info{};
+                info.advance = colorGlyphs_->advance(codepoint, emPixels_);
+                info.color = true;
+                glyphs_[glyphKey(codepoint, bin)] = info;
+            } else if (isEmojiControl(codepoint)) {
+                glyphs_[glyphKey(codepoint, bin)] = GlyphInfo{};
+            } else {
+                addGlyph(codepoint, bin);
+            }
+            it = glyphs_.find(glyphKey(codepoint, bin));
             if (it != glyphs_.end()) return &it->second;
         }
         
         // Return space glyph as fallback
-        it = glyphs_.find(' ');
+        it = glyphs_.find(glyphKey(' ', 0));
         return it != glyphs_.end() ? &it->second : nullptr;
     }
     
-    GLuint atlasTexture() const { return atlasTexture_; }
+    // Glyph variant for a fractional pen position. originX receives the
+    // whole-pixel x its quad offsets are relative to.
+    const GlyphInfo* getGlyphAt(int codepoint, float penX, float& originX) {
+        int bin;
+        snapSubpixel(penX, originX, bin);
+        return getGlyph(codepoint, bin);
+    }
+    
+    static void snapSubpixel(float x, float& origin, int& bin) {
+        origin = std::floor(x);
+        bin = (int)((x - origin) * SUBPIXEL_BINS + 0.5f);
+        if (bin == SUBPIXEL_BINS) {
+            bin = 0;
+            origin += 1;
+        }
+    }
+    
+    // Glyphs added after the initial bake are uploaded lazily; call this
+    // outside of glBegin/glEnd so new rows reach the texture first.
+    GLuint atlasTexture() {
+        if (atlasDirtyMax_ > atlasDirtyMin_) flushAtlas();
+        return atlasTexture_;
+    }
     bool valid() const { return valid_; }
+    bool hasGlyph(int codepoint) const { return stbtt_FindGlyphIndex(&font_, codepoint) != 0; }
     float size() const { return size_; }
+    float emSize() const { return emPixels_; }
+    
+    // Color glyphs are looked up for emoji and for anything this font lacks.
+    // Glyphs already rasterized before the cache is set keep their outline.
+    void setColorGlyphs(ColorGlyphCache* cache) { colorGlyphs_ = cache; }
+    ColorGlyphCache* colorGlyphs() const { return colorGlyphs_; }
     int ascent() const { return ascent_; }
     int descent() const { return descent_; }
     int lineHeight() const { return ascent_ - descent_ + lineGap_; }
     
+    // Lays a string out into atlas quads relative to its top-left corner.
+    // The run is reused (not reallocated) when laid out again. penX is the
+    // fractional pixel the pen starts at, for runs drawn at a known position.
+    void layoutRun(const std::string& text, GlyphRun& run, float penX = 0);
+    
     Size measureText(const std::string& text) {
         float width = 0;
         float maxWidth = 0;
@@ -227,90 +954,206 @@ public:
     
 private:
     stbtt_fontinfo font_;
-    std::vector<unsigned char> fontData_;
+    std::shared_ptr<const std::vector<unsigned char>> fontData_;  // shared across sizes
     float size_;
     float scale_;
+    float emPixels_ = 0;
+    ColorGlyphCache* colorGlyphs_ = nullptr;
     int ascent_, descent_, lineGap_;
-    std::unordered_map<int, GlyphInfo> glyphs_;
+    std::unordered_map<uint32_t, GlyphInfo> glyphs_;
     GLuint atlasTexture_ = 0;
     bool valid_ = false;
     
     static constexpr int ATLAS_WIDTH = 1024;
     static constexpr int ATLAS_HEIGHT = 1024;
-    std::vector<unsigned char> atlasData_;
+    std::vector<unsigned char> atlasData_;       // private atlas storage
+    std::unique_ptr<SharedGlyphAtlas> shared_;
+    unsigned char* atlas_ = nullptr;              // atlasData_ or the shared pixels
     int atlasX_ = 0, atlasY_ = 0, atlasRowHeight_ = 0;
+    int atlasDirtyMin_ = 0, atlasDirtyMax_ = 0;
+    
+    bool isColorGlyph(int codepoint) const {
+        return colorGlyphs_ && (codepoint >= 0x1F000 || !hasGlyph(codepoint)) &&
+               colorGlyphs_->hasGlyph(codepoint);
+    }
+    
+    // Joiners and presentation selectors inside emoji sequences.
+    static bool isEmojiControl(int codepoint) {
+        return codepoint == 0x200D || codepoint == 0xFE0E || codepoint == 0xFE0F;
+    }
+    
+    static uint32_t glyphKey(int codepoint, int bin) {
+        return ((uint32_t)codepoint << 2) | (uint32_t)bin;
+    }
+    
+    bool open(const std::string& path, int faceIndex, bool shareAtlas) {
+        const unsigned char* bytes = nullptr;
+        if (Resources::isResourcePath(path)) {
+            // Embedded fonts are used in place; bundles are never unloaded.
+            bytes = Resources::find(path).data;
+        } else if ((fontData_ = FontDatabase::shared().fileData(path))) {
+            bytes = fontData_->data();
+        }
+        if (!bytes) return false;
+        
+        int offset = stbtt_GetFontOffsetForIndex(bytes, faceIndex);
+        if (offset < 0 || !stbtt_InitFont(&font_, bytes, offset)) {
+            fontData_.reset();
+            return false;
+        }
+        
+        scale_ = stbtt_ScaleForPixelHeight(&font_, size_);
+        emPixels_ = scale_ / stbtt_ScaleForMappingEmToPixels(&font_, 1.0f);
+        stbtt_GetFontVMetrics(&font_, &ascent_, &descent_, &lineGap_);
+        ascent_ = (int)(ascent_ * scale_);
+        descent_ = (int)(descent_ * scale_);
+        lineGap_ = (int)(lineGap_ * scale_);
+        
+        // Embedded fonts have no file identity, so their atlas stays private.
+        if (shareAtlas && fontData_) {
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0) {
+                std::string identity = path + "#" + std::to_string(faceIndex) + ":" +
+                    std::to_string((long long)st.st_size) + ":" +
+                    std::to_string((long long)st.st_mtime) + ":" + std::to_string(size_);
+                shared_ = SharedGlyphAtlas::open(identity, ATLAS_WIDTH, ATLAS_HEIGHT);
+            }
+        }
+        
+        createAtlas();
+        valid_ = true;
+        return true;
+    }
     
     void createAtlas() {
-        atlasData_.resize(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+        if (shared_) {
+            atlas_ = shared_->pixels();
+        } else {
+            atlasData_.resize(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+            atlas_ = atlasData_.data();
+        }
         atlasX_ = 1;
         atlasY_ = 1;
         atlasRowHeight_ = 0;
         
-        // Pre-bake ASCII
+        // Pre-bake ASCII at the whole-pixel offset; other offsets are
+        // rasterized the first time text lands on them.
         for (int c = 32; c < 128; ++c) {
-            addGlyph(c);
+            addGlyph(c, 0);
         }
         
         uploadAtlas();
     }
     
-    void addGlyph(int codepoint) {
+    bool rasterizeGlyph(int codepoint, int bin, GlyphInfo& info) {
         int width, height, xoff, yoff;
-      unsigned char* bitmap = stbtt_GetCodepointBitmap(
-    &font_, scale_, scale_, codepoint, &width, &height, &xoff, &yoff);        
+        float shiftX = (float)bin / SUBPIXEL_BINS;
+        unsigned char* bitmap = stbtt_GetCodepointBitmapSubpixel(
+            &font_, scale_, scale_, shiftX, 0.0f, codepoint, &width, &height, &xoff, &yoff);
+        
+        int advance;
+        stbtt_GetCodepointHMetrics(&font_, codepoint, &advance, nullptr);
+        info.advance = advance * scale_;
+        
         if (!bitmap) {
-            // Create empty glyph
-            GlyphInfo info{};
-            int advance;
-            stbtt_GetCodepointHMetrics(&font_, codepoint, &advance, nullptr);
-            info.advance = advance * scale_;
-            glyphs_[codepoint] = info;
-            return;
+            // Empty glyph (e.g. space)
+            return true;
         }
         
-        // Check if we need new row
-        if (atlasX_ + width + 1 >= ATLAS_WIDTH) {
-            atlasX_ = 1;
-            atlasY_ += atlasRowHeight_ + 1;
-            atlasRowHeight_ = 0;
-        }
-        
-        // Check if atlas is full
-        if (atlasY_ + height + 1 >= ATLAS_HEIGHT) {
-            stbtt_FreeBitmap(bitmap, nullptr);
-            return;
+        int x, y;
+        if (!allocateAtlas(width, height, x, y)) {
+            stbtt_FreeBitmap(bitmap, nullptr);
+            return false;
         }
         
         // Copy to atlas
         for (int row = 0; row < height; ++row) {
-            for (int col = 0; col < width; ++col) {
-                atlasData_[(atlasY_ + row) * ATLAS_WIDTH + (atlasX_ + col)] = 
-                    bitmap[row * width + col];
-            }
+            memcpy(atlas_ + (y + row) * ATLAS_WIDTH + x, bitmap + row * width, width);
         }
         
-        int advance;
-        stbtt_GetCodepointHMetrics(&font_, codepoint, &advance, nullptr);
-        
-        GlyphInfo info;
-        info.u0 = (float)atlasX_ / ATLAS_WIDTH;
-        info.v0 = (float)atlasY_ / ATLAS_HEIGHT;
-        info.u1 = (float)(atlasX_ + width) / ATLAS_WIDTH;
-        info.v1 = (float)(atlasY_ + height) / ATLAS_HEIGHT;
+        info.u0 = (float)x / ATLAS_WIDTH;
+        info.v0 = (float)y / ATLAS_HEIGHT;
+        info.u1 = (float)(x + width) / ATLAS_WIDTH;
+        info.v1 = (float)(y + height) / ATLAS_HEIGHT;
         info.x0 = xoff;
         info.y0 = yoff;
         info.x1 = xoff + width;
         info.y1 = yoff + height;
-        info.advance = advance * scale_;
         info.width = width;
         info.height = height;
         
-        glyphs_[codepoint] = info;
+        markAtlasDirty(y, height);
+        stbtt_FreeBitmap(bitmap, nullptr);
+        return true;
+    }
+    
+    bool allocateAtlas(int width, int height, int& x, int& y) {
+        if (shared_) return shared_->reserve(width, height, x, y);
         
+        // Check if we need new row
+        if (atlasX_ + width + 1 >= ATLAS_WIDTH) {
+            atlasX_ = 1;
+            atlasY_ += atlasRowHeight_ + 1;
+            atlasRowHeight_ = 0;
+        }
+        
+        // Check if atlas is full
+        if (atlasY_ + height + 1 >= ATLAS_HEIGHT) return false;
+        
+        x = atlasX_;
+        y = atlasY_;
         atlasX_ += width + 1;
         atlasRowHeight_ = std::max(atlasRowHeight_, height + 1);
+        return true;
+    }
+    
+    void markAtlasDirty(int y, int height) {
+        if (atlasDirtyMax_ <= atlasDirtyMin_) {
+            atlasDirtyMin_ = y;
+            atlasDirtyMax_ = y + height;
+        } else {
+            atlasDirtyMin_ = std::min(atlasDirtyMin_, y);
+            atlasDirtyMax_ = std::max(atlasDirtyMax_, y + height);
+        }
+    }
+    
+    void addGlyph(int codepoint, int bin = 0) {
+        uint32_t key = glyphKey(codepoint, bin);
+        int slot = -1;
+        if (shared_) {
+            SharedGlyphAtlas::Glyph shared;
+            if (shared_->find(key, shared, slot)) {
+                // Rasterized by this or another process; only the upload is ours.
+                GlyphInfo info{};
+                info.u0 = shared.u0; info.v0 = shared.v0;
+                info.u1 = shared.u1; info.v1 = shared.v1;
+                info.x0 = shared.x0; info.y0 = shared.y0;
+                info.x1 = shared.x1; info.y1 = shared.y1;
+                info.advance = shared.advance;
+                info.width = shared.width;
+                info.height = shared.height;
+                glyphs_[key] = info;
+                markAtlasDirty((int)std::lround(info.v0 * ATLAS_HEIGHT), info.height);
+                return;
+            }
+            // With no slot (index full, or a writer died mid-way) the glyph
+            // still gets space of its own in the segment, just unindexed.
+        }
         
-        stbtt_FreeBitmap(bitmap, nullptr);
+        // Cached even when it didn't fit (blank, with its advance), so a full
+        // atlas isn't retried, and a dead writer waited on, every lookup.
+        GlyphInfo info{};
+        bool ok = rasterizeGlyph(codepoint, bin, info);
+        glyphs_[key] = info;
+        if (slot >= 0) {
+            if (ok) {
+                shared_->publish(slot, {info.u0, info.v0, info.u1, info.v1,
+                                        info.x0, info.y0, info.x1, info.y1,
+                                        info.advance, info.width, info.height});
+            } else {
+                shared_->fail(slot);
+            }
+        }
     }
     
     void uploadAtlas() {
@@ -321,9 +1164,543 @@ private:
         glGenTextures(1, &atlasTexture_);
         glBindTexture(GL_TEXTURE_2D, atlasTexture_);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
-                     GL_ALPHA, GL_UNSIGNED_BYTE, atlasData_.data());
+                     GL_ALPHA, GL_UNSIGNED_BYTE, atlas_);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        atlasDirtyMin_ = atlasDirtyMax_ = 0;
+    }
+    
+    void flushAtlas() {
+        glBindTexture(GL_TEXTURE_2D, atlasTexture_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, atlasDirtyMin_,
+                        ATLAS_WIDTH, atlasDirtyMax_ - atlasDirtyMin_,
+                        GL_ALPHA, GL_UNSIGNED_BYTE,
+                        atlas_ + atlasDirtyMin_ * ATLAS_WIDTH);
+        atlasDirtyMin_ = atlasDirtyMax_ = 0;
+    }
+};
+
+// ============================================================================
+// Glyph Runs
+// ============================================================================
+
+// A string laid out once into positioned atlas quads so it can be drawn every
+// frame without UTF-8 decoding or glyph lookups. Quads are relative to the
+// run's top-left corner.
+struct GlyphRun {
+    struct Quad {
+        float x0, y0, x1, y1;
+        float u0, v0, u1, v1;
+    };
+    
+    // Color switches inside the run, starting at a given quad; quads before
+    // the first change use the color passed when drawing.
+    struct ColorChange {
+        uint32_t quad;
+        Color color;
+    };
+    
+    // Color (emoji) glyph at a pen position on the baseline; drawn from the
+    // renderer's RGBA pages after the alpha quads.
+    struct ColorGlyph {
+        float x, y;
+        uint32_t codepoint;
+    };
+    
+    std::vector<Quad> quads;
+    std::vector<ColorChange> colors;
+    std::vector<ColorGlyph> colorGlyphs;
+    Font* font = nullptr;
+    float width = 0;
+    float height = 0;
+    float pen = 0;  // fractional pen the run was laid out from
+    
+    void clear() {
+        quads.clear();
+        colors.clear();
+        colorGlyphs.clear();
+        font = nullptr;
+        width = height = pen = 0;
+    }
+    bool empty() const { return quads.empty(); }
+};
+
+inline void Font::layoutRun(const std::string& text, GlyphRun& run, float penX) {
+    run.quads.clear();
+    run.colors.clear();
+    run.colorGlyphs.clear();
+    run.font = this;
+    run.width = 0;
+    run.height = text.empty() ? 0 : (float)lineHeight();
+    run.pen = penX;
+    
+    float x = penX;
+    float y = (float)ascent_;
+    
+    for (size_t i = 0; i < text.size(); ) {
+        if (text[i] == '\n') {
+            run.width = std::max(run.width, x - penX);
+            x = penX;
+            y += lineHeight();
+            run.height += lineHeight();
+            i++;
+            continue;
+        }
+        
+        int codepoint = decodeUTF8(text, i);
+        float originX;
+        auto* glyph = getGlyphAt(codepoint, x, originX);
+        if (!glyph) continue;
+        
+        if (glyph->color) {
+            run.colorGlyphs.push_back({originX, y, (uint32_t)codepoint});
+        } else if (glyph->width > 0) {
+            run.quads.push_back({
+                originX + glyph->x0, y + glyph->y0, originX + glyph->x1, y + glyph->y1,
+                glyph->u0, glyph->v0, glyph->u1, glyph->v1
+            });
+        }
+        x += glyph->advance;
+    }
+    run.width = std::max(run.width, x - penX);
+}
+
+// ============================================================================
+// Elided Text
+// ============================================================================
+
+// Fits one line of text into a width by replacing its start, middle or end
+// with an ellipsis. Advances are summed once per string into a prefix array,
+// the cut points are found by binary search, and the resulting run is kept
+// until the width, mode or fraction of the draw position changes.
+class ElidedText {
+public:
+    // Keeps the pen of the last layout: for measuring before the draw
+    // position is known, without undoing the run laid out for it.
+    const GlyphRun& layout(Font* font, const std::string& text, float maxWidth,
+                           TextStyle::Truncate mode) {
+        return layout(font, text, maxWidth, mode, run_.pen);
+    }
+    
+    // x is where the run will be drawn; only its fraction matters.
+    const GlyphRun& layout(Font* font, const std::string& text, float maxWidth,
+                           TextStyle::Truncate mode, float x) {
+        if (font != font_ || text != text_) {
+            font_ = font;
+            text_ = text;
+            measure();
+            width_ = -1;
+        }
+        float pen = x - std::floor(x);
+        if (maxWidth == width_ && mode == mode_ && pen == run_.pen) return run_;
+        width_ = maxWidth;
+        mode_ = mode;
+        
+        size_t n = offsets_.size() - 1;
+        float total = prefix_[n];
+        if (mode == TextStyle::Truncate::None || total <= maxWidth) {
+            font->layoutRun(text_, run_, pen);
+            return run_;
+        }
+        
+        const char* ellipsis = font->hasGlyph(0x2026) ? "\u2026" : "...";
+        float available = std::max(0.0f, maxWidth - font->measureText(ellipsis).width);
+        
+        // Longest prefix / shortest suffix within a budget.
+        auto prefixFits = [&](float budget) {
+            return (size_t)(std::upper_bound(prefix_.begin(), prefix_.end(), budget) - prefix_.begin()) - 1;
+        };
+        auto suffixStart = [&](float budget) {
+            return (size_t)(std::lower_bound(prefix_.begin(), prefix_.end(), total - budget) - prefix_.begin());
+        };
+        
+        elided_.clear();
+        switch (mode) {
+            case TextStyle::Truncate::End: {
+                size_t k = prefixFits(available);
+                elided_.append(text_, 0, offsets_[k]).append(ellipsis);
+                break;
+            }
+            case TextStyle::Truncate::Start: {
+                size_t j = suffixStart(available);
+                elided_.append(ellipsis).append(text_, offsets_[j], std::string::npos);
+                break;
+            }
+            default: {
+                size_t k = prefixFits(available / 2);
+                size_t j = std::max(k, suffixStart(available - prefix_[k]));
+                elided_.append(text_, 0, offsets_[k]).append(ellipsis)
+                       .append(text_, offsets_[j], std::string::npos);
+                break;
+            }
+        }
+        font->layoutRun(elided_, run_, pen);
+        return run_;
+    }
+
+private:
+    Font* font_ = nullptr;
+    std::string text_;
+    std::vector<float> prefix_;      // advance of the first i code points
+    std::vector<uint32_t> offsets_;  // byte offset of code point i
+    float width_ = -1;
+    TextStyle::Truncate mode_ = TextStyle::Truncate::None;
+    std::string elided_;
+    GlyphRun run_;
+    
+    void measure() {
+        prefix_.assign(1, 0.0f);
+        offsets_.assign(1, 0);
+        for (size_t i = 0; i < text_.size(); ) {
+            auto* glyph = font_->getGlyph(Font::decodeUTF8(text_, i));
+            prefix_.push_back(prefix_.back() + (glyph ? glyph->advance : 0));
+            offsets_.push_back((uint32_t)std::min(i, text_.size()));
+        }
+    }
+};
+
+// ============================================================================
+// Numeric Runs
+// ============================================================================
+
+// A short ASCII string (counter, clock, percentage) kept as one quad per
+// character, so an update rewrites only the characters that changed. Digits
+// share one whole-pixel advance and every pen position is a whole pixel:
+// changing a digit never moves its neighbours, and all glyphs come from a
+// table of the pre-baked zero-offset variants.
+class NumericRun {
+public:
+    static constexpr size_t MAX_CHARS = 32;
+    
+    void setFont(Font* font) {
+        if (font == run_.font) return;
+        run_.clear();
+        length_ = 0;
+        if (!font || !font->valid()) return;
+        
+        run_.font = font;
+        run_.height = (float)font->lineHeight();
+        float digit = 0;
+        for (int c = 0; c < 128; ++c) {
+            glyphs_[c] = c >= 32 ? font->getGlyph(c) : nullptr;
+            if (c >= '0' && c <= '9' && glyphs_[c]) digit = std::max(digit, glyphs_[c]->advance);
+        }
+        digitAdvance_ = std::ceil(digit);
+    }
+    
+    // Returns false when nothing changed.
+    bool setText(const char* text, size_t length) {
+        Font* font = run_.font;
+        if (!font) return false;
+        length = std::min(length, MAX_CHARS);
+        
+        size_t first = 0;
+        while (first < length && first < length_ && text[first] == text_[first]) first++;
+        if (first == length && length == length_) return false;
+        
+        run_.quads.resize(length);
+        float ascent = (float)font->ascent();
+        float pen = pens_[first];
+        for (size_t i = first; i < length; ++i) {
+            char c = (unsigned char)text[i] < 128 ? text[i] : '?';
+            if (i < length_ && c == text_[i] && pen == pens_[i]) {
+                pen = pens_[i + 1];
+                continue;
+            }
+            
+            const Font::GlyphInfo* g = glyphs_[(unsigned char)c];
+            bool digit = c >= '0' && c <= '9';
+            float advance = g ? (digit ? digitAdvance_ : std::round(g->advance)) : 0;
+            float x = pen + (digit && g ? std::floor((digitAdvance_ - g->advance) / 2) : 0);
+            
+            GlyphRun::Quad& q = run_.quads[i];
+            if (g && g->width > 0) {
+                q = {x + g->x0, ascent + g->y0, x + g->x1, ascent + g->y1,
+                     g->u0, g->v0, g->u1, g->v1};
+            } else {
+                q = {x, 0, x, 0, 0, 0, 0, 0};
+            }
+            
+            text_[i] = c;
+            pens_[i] = pen;
+            pen += advance;
+            pens_[i + 1] = pen;
+        }
+        
+        length_ = length;
+        run_.width = pens_[length];
+        return true;
+    }
+    bool setText(const char* text) { return setText(text, std::strlen(text)); }
+    
+    const GlyphRun& run() const { return run_; }
+    Font* font() const { return run_.font; }
+    float width() const { return run_.width; }
+    float height() const { return run_.height; }
+
+private:
+    GlyphRun run_;
+    const Font::GlyphInfo* glyphs_[128] = {};
+    float digitAdvance_ = 0;
+    char text_[MAX_CHARS] = {};
+    float pens_[MAX_CHARS + 1] = {};
+    size_t length_ = 0;
+};
+
+// ============================================================================
+// Icon Atlas
+// ============================================================================
+
+// Icons as multi-channel signed distance fields sharing one RGB texture, so
+// a single CELL_SIZE rendering serves every size and color and all icons
+// batch under one texture bind. Icons come from icon fonts, looked up by
+// glyph name (post table), "uniXXXX" or the character itself, or from
+// shapes added directly; each is generated on first use.
+class IconAtlas {
+public:
+    static constexpr int ATLAS_SIZE = 1024;
+    static constexpr int CELL_SIZE = 40;            // 25 x 25 = 625 icons
+    static constexpr float PADDING = 4.0f;          // cell pixels around the em box
+    static constexpr float DISTANCE_RANGE = 6.0f;   // cell pixels spanning 0..255
+    
+    // inset is the padding as a fraction of the em box: the quad drawn for
+    // an icon in rect extends rect by inset * size on every side.
+    struct Entry {
+        float u0, v0, u1, v1;
+        float inset;
+    };
+    
+    IconAtlas() = default;
+    IconAtlas(const IconAtlas&) = delete;
+    IconAtlas& operator=(const IconAtlas&) = delete;
+    
+    // Icon font file or "res://" resource. Later fonts are searched first.
+    bool addFont(const std::string& path) {
+        auto font = std::make_unique<IconFont>();
+        const unsigned char* bytes = nullptr;
+        size_t size = 0;
+        if (Resources::isResourcePath(path)) {
+            ResourceData res = Resources::find(path);
+            bytes = res.data;
+            size = res.size;
+        } else if ((font->data = FontDatabase::shared().fileData(path))) {
+            bytes = font->data->data();
+            size = font->data->size();
+        }
+        if (!bytes || size < 12 || !stbtt_InitFont(&font->info, bytes, stbtt_GetFontOffsetForIndex(bytes, 0))) {
+            return false;
+        }
+        
+        int ascent, descent, lineGap;
+        stbtt_GetFontVMetrics(&font->info, &ascent, &descent, &lineGap);
+        font->ascent = (float)ascent;
+        font->descent = (float)descent;
+        readGlyphNames(*font, size);
+        fonts_.insert(fonts_.begin(), std::move(font));
+        missing_.clear();
+        return true;
+    }
+    
+    // shape is in a viewBox x viewBox square (y down), as for SVG icons.
+    // Replacing a shape invalidates pointers find() returned for its name.
+    void addShape(const std::string& name, MsdfShape shape, float viewBox) {
+        shapes_[name] = {std::move(shape), viewBox};
+        entries_.erase(name);
+        missing_.erase(name);
+    }
+    
+    bool empty() const { return fonts_.empty() && shapes_.empty(); }
+    size_t size() const { return entries_.size(); }
+    
+    // nullptr if no font or shape provides the icon or the atlas is full.
+    const Entry* find(const std::string& name) {
+        auto it = entries_.find(name);
+        if (it != entries_.end()) return &it->second;
+        if (missing_.count(name)) return nullptr;
+        
+        int cellsPerRow = ATLAS_SIZE / CELL_SIZE;
+        if (nextCell_ >= cellsPerRow * cellsPerRow || !generate(name, nextCell_)) {
+            missing_.insert(name);
+            return nullptr;
+        }
+        
+        int cx = (nextCell_ % cellsPerRow) * CELL_SIZE;
+        int cy = (nextCell_ / cellsPerRow) * CELL_SIZE;
+        ++nextCell_;
+        Entry entry;
+        entry.u0 = (float)cx / ATLAS_SIZE;
+        entry.v0 = (float)cy / ATLAS_SIZE;
+        entry.u1 = (float)(cx + CELL_SIZE) / ATLAS_SIZE;
+        entry.v1 = (float)(cy + CELL_SIZE) / ATLAS_SIZE;
+        entry.inset = PADDING / (CELL_SIZE - 2 * PADDING);
+        return &entries_.emplace(name, entry).first->second;
+    }
+    
+    // Uploads cells generated since the last call.
+    GLuint texture() {
+        if (!texture_.id()) {
+            texture_ = Texture(ATLAS_SIZE, ATLAS_SIZE, nullptr, 3);
+        }
+        if (dirtyMax_ > dirtyMin_) {
+            glBindTexture(GL_TEXTURE_2D, texture_.id());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyMin_, ATLAS_SIZE, dirtyMax_ - dirtyMin_,
+                            GL_RGB, GL_UNSIGNED_BYTE, &pixels_[(size_t)dirtyMin_ * ATLAS_SIZE * 3]);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            dirtyMin_ = dirtyMax_ = 0;
+        }
+        return texture_.id();
+    }
+
+private:
+    struct IconFont {
+        std::shared_ptr<const std::vector<unsigned char>> data;  // null for resources
+        stbtt_fontinfo info;
+        float ascent = 0, descent = 0;
+        std::unordered_map<std::string, int> glyphNames;
+    };
+    
+    struct Shape {
+        MsdfShape shape;
+        float viewBox;
+    };
+    
+    std::vector<std::unique_ptr<IconFont>> fonts_;
+    std::unordered_map<std::string, Shape> shapes_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_set<std::string> missing_;
+    std::vector<unsigned char> pixels_;
+    Texture texture_;
+    int nextCell_ = 0;
+    int dirtyMin_ = 0, dirtyMax_ = 0;
+    
+    bool generate(const std::string& name, int cell) {
+        MsdfShape shape;
+        float scale, tx, ty;
+        float inner = CELL_SIZE - 2 * PADDING;
+        
+        auto custom = shapes_.find(name);
+        if (custom != shapes_.end()) {
+            shape = custom->second.shape;
+            scale = inner / custom->second.viewBox;
+            tx = ty = PADDING;
+        } else {
+            const IconFont* font = nullptr;
+            int glyph = 0;
+            for (const auto& f : fonts_) {
+                if ((glyph = glyphFor(*f, name))) {
+                    font = f.get();
+                    break;
+                }
+            }
+            if (!font || !glyphShape(*font, glyph, shape)) return false;
+            
+            int advance, bearing;
+            stbtt_GetGlyphHMetrics(&font->info, glyph, &advance, &bearing);
+            scale = inner / (font->ascent - font->descent);
+            tx = PADDING + (inner - advance * scale) / 2;
+            ty = PADDING + font->ascent * scale;
+        }
+        if (shape.empty()) return false;
+        
+        if (pixels_.empty()) pixels_.assign((size_t)ATLAS_SIZE * ATLAS_SIZE * 3, 0);
+        int cellsPerRow = ATLAS_SIZE / CELL_SIZE;
+        int cx = (cell % cellsPerRow) * CELL_SIZE;
+        int cy = (cell / cellsPerRow) * CELL_SIZE;
+        MsdfGenerator::generate(std::move(shape), &pixels_[((size_t)cy * ATLAS_SIZE + cx) * 3],
+                                CELL_SIZE, CELL_SIZE, ATLAS_SIZE * 3, scale, tx, ty, DISTANCE_RANGE);
+        
+        if (dirtyMax_ == dirtyMin_) {
+            dirtyMin_ = cy;
+            dirtyMax_ = cy + CELL_SIZE;
+        } else {
+            dirtyMin_ = std::min(dirtyMin_, cy);
+            dirtyMax_ = std::max(dirtyMax_, cy + CELL_SIZE);
+        }
+        return true;
+    }
+    
+    static int glyphFor(const IconFont& font, const std::string& name) {
+        auto it = font.glyphNames.find(name);
+        if (it != font.glyphNames.end()) return it->second;
+        
+        int codepoint = 0;
+        if (name.size() > 3 && name.compare(0, 3, "uni") == 0) {
+            codepoint = (int)std::strtol(name.c_str() + 3, nullptr, 16);
+        } else if (!name.empty()) {
+            size_t i = 0;
+            codepoint = Font::decodeUTF8(name, i);
+            if (i != name.size()) codepoint = 0;
+        }
+        return codepoint ? stbtt_FindGlyphIndex(&font.info, codepoint) : 0;
+    }
+    
+    // Font units are y up; MsdfShape is y down.
+    static bool glyphShape(const IconFont& font, int glyph, MsdfShape& shape) {
+        stbtt_vertex* vertices = nullptr;
+        int count = stbtt_GetGlyphShape(&font.info, glyph, &vertices);
+        for (int i = 0; i < count; ++i) {
+            const stbtt_vertex& v = vertices[i];
+            switch (v.type) {
+            case STBTT_vmove:
+                if (i > 0) shape.close();
+                shape.moveTo(v.x, -v.y);
+                break;
+            case STBTT_vline:
+                shape.lineTo(v.x, -v.y);
+                break;
+            case STBTT_vcurve:
+                shape.quadTo(v.cx, -v.cy, v.x, -v.y);
+                break;
+            case STBTT_vcubic:
+                shape.cubicTo(v.cx, -v.cy, v.cx1, -v.cy1, v.x, -v.y);
+                break;
+            }
+        }
+        if (count > 0) shape.close();
+        stbtt_FreeShape(&font.info, vertices);
+        return count > 0;
+    }
+    
+    // Glyph names from a version 2.0 post table (Material Icons, Font
+    // Awesome and most icon fonts name their glyphs after the icon). size
+    // is the font data's length; tables reaching past it are ignored.
+    static void readGlyphNames(IconFont& font, size_t size) {
+        const unsigned char* data = font.info.data;
+        auto u16 = [&](size_t o) { return (uint32_t)(data[o] << 8 | data[o + 1]); };
+        auto u32 = [&](size_t o) { return u16(o) << 16 | u16(o + 2); };
+        
+        size_t start = (size_t)font.info.fontstart;
+        if (start > size || size - start < 12) return;
+        uint32_t numTables = u16(start + 4);
+        if ((size - start - 12) / 16 < numTables) return;
+        size_t post = 0, postLength = 0;
+        for (uint32_t t = 0; t < numTables; ++t) {
+            size_t record = start + 12 + (size_t)t * 16;
+            if (std::memcmp(data + record, "post", 4) == 0) {
+                post = u32(record + 8);
+                postLength = u32(record + 12);
+            }
+        }
+        if (!post || postLength < 34 || post > size || size - post < postLength) return;
+        if (u32(post) != 0x00020000) return;
+        
+        uint32_t numGlyphs = u16(post + 32);
+        size_t names = post + 34 + (size_t)numGlyphs * 2;
+        size_t end = post + postLength;
+        if (names > end) return;
+        
+        std::vector<std::string> custom;
+        for (size_t p = names; p < end && p + 1 + data[p] <= end; p += 1 + data[p]) {
+            custom.emplace_back(reinterpret_cast<const char*>(data + p + 1), data[p]);
+        }
+        for (uint32_t g = 0; g < numGlyphs; ++g) {
+            uint32_t index = u16(post + 34 + g * 2);
+            if (index >= 258 && index - 258 < custom.size()) {
+                font.glyphNames.emplace(custom[index - 258], (int)g);
+            }
+        }
     }
 };
 
@@ -333,7 +1710,13 @@ private:
 
 class ImageLoader {
 public:
+    // Also accepts "res://" paths from a registered resource bundle.
     static Texture loadFromFile(const std::string& path) {
+        if (Resources::isResourcePath(path)) {
+            ResourceData res = Resources::find(path);
+            return res ? loadFromMemory(res.data, res.size) : Texture();
+        }
+        
         FILE* file = fopen(path.c_str(), "rb");
         if (!file) return Texture();
         
@@ -364,6 +1747,16 @@ public:
 // OpenGL Renderer
 // ============================================================================
 
+// One instance of Renderer::drawLineSegments; the layout is uploaded as is.
+struct LineSegment {
+    float x0, y0, x1, y1;
+    Color color;
+    float width;
+};
+static_assert(sizeof(LineSegment) == 9 * sizeof(float), "LineSegment must be tightly packed");
+
+enum class YuvMatrix { Bt601, Bt709 };
+
 class Renderer {
 public:
     Renderer(int width, int height) : width_(width), height_(height) {
@@ -375,27 +1768,78 @@ public:
     void setSize(int width, int height) {
         width_ = width;
         height_ = height;
-        glViewport(0, 0, width, height);
+        glViewport(0, 0, pixelWidth(), pixelHeight());
+    }
+    
+    // Framebuffer pixels per unit; below 1 when the target is rendered at
+    // reduced resolution and scaled up by the compositor (wp_viewporter).
+    void setPixelScale(float scale) {
+        pixelScale_ = std::max(0.1f, scale);
+        glViewport(0, 0, pixelWidth(), pixelHeight());
+    }
+    
+    float pixelScale() const { return pixelScale_; }
+    int pixelWidth() const { return std::max(1, (int)std::lround(width_ * pixelScale_)); }
+    int pixelHeight() const { return std::max(1, (int)std::lround(height_ * pixelScale_)); }
+    
+    // Window position of the target's top-left corner, for rendering a
+    // part of the window into its own surface: widgets keep drawing in
+    // window coordinates.
+    void setOrigin(int x, int y) {
+        originX_ = x;
+        originY_ = y;
     }
     
     void beginFrame() {
+        // Subsurface renderers share the window's GL context, so state that
+        // depends on the target is set again every frame.
+        glViewport(0, 0, pixelWidth(), pixelHeight());
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        clipStack_.clear();
+        glDisable(GL_SCISSOR_TEST);
+        
         glMatrixMode(GL_PROJECTION);
         glLoadIdentity();
-        glOrtho(0, width_, height_, 0, -1, 1);
+        glOrtho(originX_, originX_ + width_, originY_ + height_, originY_, -1, 1);
         
         glMatrixMode(GL_MODELVIEW);
         glLoadIdentity();
         
+        // Path fills and strokes expect a zero stencil; its contents are
+        // undefined after a swap.
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glClearStencil(0);
+        glStencilMask(0xFF);
+        glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        
+        if (colorGlyphs_) colorGlyphs_->beginFrame();
+        frame_++;
+        if (svgPending_ > 0) collectSvgRasters();
+        if (frame_ % PATH_CACHE_FRAMES == 0) trimPathCache();
+        if (frame_ % SHADOW_CACHE_FRAMES == 0) trimShadows();
+        
+        trackDraws_ = backdropDrawn_;
+        backdropDrawn_ = false;
+        drawSignature_ = 0xcbf29ce484222325ULL;
+        noteDraw(width_);
+        noteDraw(height_);
+        noteDraw(originX_);
+        noteDraw(originY_);
+        noteDraw(pixelScale_);
+        if (!backdrops_.empty()) trimBackdrops();
     }
     
     void endFrame() {
+        flushIcons();
         glFlush();
     }
     
     // Draw primitives
     void drawRect(const Rect& rect, const Color& color) {
+        flushIcons();
+        noteDraw(rect);
+        noteDraw(color);
         glDisable(GL_TEXTURE_2D);
         glColor4f(color.r, color.g, color.b, color.a);
         glBegin(GL_QUADS);
@@ -407,6 +1851,7 @@ public:
     }
     
     void drawRoundedRect(const Rect& rect, const BorderRadius& radius, const Color& color) {
+        noteDraw(radius);
         glDisable(GL_TEXTURE_2D);
         glColor4f(color.r, color.g, color.b, color.a);
         
@@ -433,6 +1878,11 @@ public:
     
     void drawBorder(const Rect& rect, const BorderRadius& radius, 
                    const Color& color, float width) {
+        flushIcons();
+        noteDraw(rect);
+        noteDraw(radius);
+        noteDraw(color);
+        noteDraw(width);
         glDisable(GL_TEXTURE_2D);
         glLineWidth(width);
         glColor4f(color.r, color.g, color.b, color.a);
@@ -483,6 +1933,11 @@ public:
     }
     
     void drawGradient(const Rect& rect, const Color& start, const Color& end, float angle) {
+        flushIcons();
+        noteDraw(rect);
+        noteDraw(start);
+        noteDraw(end);
+        noteDraw(angle);
         glDisable(GL_TEXTURE_2D);
         glBegin(GL_QUADS);
         glColor4f(start.r, start.g, start.b, start.a);
@@ -498,47 +1953,99 @@ public:
                  const Color& color, const TextStyle& style = TextStyle()) {
         if (!font || !font->valid()) return;
         
+        // Lay out from the exact fractional position; drawGlyphRun then
+        // lands the run on the whole pixel below it.
+        font->layoutRun(text, scratchRun_, pos.x - std::floor(pos.x));
+        drawGlyphRun(scratchRun_, pos, color);
+    }
+    
+    // Draws a pre-laid-out run. Glyphs that would cross maxWidth (when > 0)
+    // are dropped, which is how cells clip without a scissor change. The
+    // run is placed on the whole pixel nearest pos minus the pen it was laid
+    // out from, so a run laid out at pos's fraction (drawText, ElidedText)
+    // keeps its subpixel position. Runs laid out at pen 0, like table cells
+    // that scroll under a fixed cache, snap to whole pixels.
+    void drawGlyphRun(const GlyphRun& run, const Point& pos, const Color& color,
+                      float maxWidth = 0) {
+        Font* font = run.font;
+        if (!font || !font->valid() || (run.quads.empty() && run.colorGlyphs.empty())) return;
+        
+        flushIcons();
+        noteGlyphRun(run, pos, color, maxWidth);
         glEnable(GL_TEXTURE_2D);
         glBindTexture(GL_TEXTURE_2D, font->atlasTexture());
         glColor4f(color.r, color.g, color.b, color.a);
         
-        float x = pos.x;
-        float y = pos.y + font->ascent();
-        float startX = x;
-        
         glBegin(GL_QUADS);
-        for (size_t i = 0; i < text.size(); ) {
-            if (text[i] == '\n') {
-                x = startX;
-                y += font->lineHeight();
-                i++;
-                continue;
-            }
-            
-            int codepoint = Font::decodeUTF8(text, i);
-            auto* glyph = font->getGlyph(codepoint);
-            if (!glyph) continue;
-            
-            float x0 = x + glyph->x0;
-            float y0 = y + glyph->y0;
-            float x1 = x + glyph->x1;
-            float y1 = y + glyph->y1;
-            
-            glTexCoord2f(glyph->u0, glyph->v0); glVertex2f(x0, y0);
-            glTexCoord2f(glyph->u1, glyph->v0); glVertex2f(x1, y0);
-            glTexCoord2f(glyph->u1, glyph->v1); glVertex2f(x1, y1);
-            glTexCoord2f(glyph->u0, glyph->v1); glVertex2f(x0, y1);
-            
-            x += glyph->advance;
-        }
+        emitGlyphQuads(run, pos, maxWidth);
         glEnd();
         
+        queueColorGlyphs(run, pos, color.a, maxWidth);
+        drawColorGlyphs(font);
+        glDisable(GL_TEXTURE_2D);
+    }
+    
+    // Batched form: every run emitted between begin/end must come from the
+    // same font and already be laid out, since the atlas can't be updated
+    // while the batch is open.
+    void beginGlyphBatch(Font* font) {
+        if (!font || !font->valid()) return;
+        flushIcons();
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, font->atlasTexture());
+        glBegin(GL_QUADS);
+        batchFont_ = font;
+    }
+    
+    void batchGlyphRun(const GlyphRun& run, const Point& pos, const Color& color,
+                       float maxWidth = 0) {
+        if (!batchFont_ || run.font != batchFont_) return;
+        noteGlyphRun(run, pos, color, maxWidth);
+        glColor4f(color.r, color.g, color.b, color.a);
+        emitGlyphQuads(run, pos, maxWidth);
+        queueColorGlyphs(run, pos, color.a, maxWidth);
+    }
+    
+    void endGlyphBatch() {
+        if (!batchFont_) return;
+        glEnd();
+        drawColorGlyphs(batchFont_);
         glDisable(GL_TEXTURE_2D);
+        batchFont_ = nullptr;
+    }
+    
+    // Scissor clipping in widget coordinates; nested clips intersect.
+    void pushClip(const Rect& rect) {
+        flushIcons();
+        Rect clip = rect;
+        if (!clipStack_.empty()) {
+            const Rect& top = clipStack_.back();
+            float x0 = std::max(clip.x, top.x);
+            float y0 = std::max(clip.y, top.y);
+            float x1 = std::min(clip.x + clip.width, top.x + top.width);
+            float y1 = std::min(clip.y + clip.height, top.y + top.height);
+            clip = Rect(x0, y0, std::max(0.0f, x1 - x0), std::max(0.0f, y1 - y0));
+        }
+        clipStack_.push_back(clip);
+        noteDraw(clip);
+        applyClip();
+    }
+    
+    void popClip() {
+        if (clipStack_.empty()) return;
+        flushIcons();
+        clipStack_.pop_back();
+        noteDraw(clipStack_.size());
+        applyClip();
     }
     
     void drawImage(const Texture& texture, const Rect& rect, float opacity = 1.0f) {
         if (!texture.valid()) return;
         
+        flushIcons();
+        noteDraw(texture.contentVersion());
+        noteDraw(rect);
+        noteDraw(opacity);
         glEnable(GL_TEXTURE_2D);
         glBindTexture(GL_TEXTURE_2D, texture.id());
         glColor4f(1.0f, 1.0f, 1.0f, opacity);
@@ -579,22 +2086,155 @@ public:
         drawImage(texture, destRect, opacity);
     }
     
+    // Stretches texture over rect but keeps its borders: insets are in
+    // texture pixels and drawn at scale times that size (shrunk when rect
+    // can't fit both sides). Corners keep their size, edges stretch along
+    // one axis and the center along both; all nine quads go in one batch.
+    void drawNinePatch(const Texture& texture, const Rect& rect, const Padding& insets,
+                       const Color& tint = Color(1, 1, 1, 1), float scale = 1.0f) {
+        if (!texture.valid() || rect.width <= 0 || rect.height <= 0) return;
+        flushIcons();
+        noteDraw(texture.contentVersion());
+        noteDraw(rect);
+        noteDraw(insets);
+        noteDraw(tint);
+        noteDraw(scale);
+        
+        float left = insets.left * scale, right = insets.right * scale;
+        float top = insets.top * scale, bottom = insets.bottom * scale;
+        if (left + right > rect.width) {
+            float fit = rect.width / (left + right);
+            left *= fit;
+            right *= fit;
+        }
+        if (top + bottom > rect.height) {
+            float fit = rect.height / (top + bottom);
+            top *= fit;
+            bottom *= fit;
+        }
+        float tw = (float)texture.width(), th = (float)texture.height();
+        const float xs[4] = {rect.x, rect.x + left, rect.x + rect.width - right, rect.x + rect.width};
+        const float ys[4] = {rect.y, rect.y + top, rect.y + rect.height - bottom, rect.y + rect.height};
+        // Stretched spans stop half a texel short of the borders so linear
+        // filtering doesn't smear border texels across them.
+        const float u0[3] = {0, (insets.left + 0.5f) / tw, 1 - insets.right / tw};
+        const float u1[3] = {insets.left / tw, 1 - (insets.right + 0.5f) / tw, 1};
+        const float v0[3] = {0, (insets.top + 0.5f) / th, 1 - insets.bottom / th};
+        const float v1[3] = {insets.top / th, 1 - (insets.bottom + 0.5f) / th, 1};
+        
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture.id());
+        glColor4f(tint.r, tint.g, tint.b, tint.a);
+        glBegin(GL_QUADS);
+        for (int row = 0; row < 3; ++row) {
+            if (ys[row + 1] <= ys[row]) continue;
+            for (int col = 0; col < 3; ++col) {
+                if (xs[col + 1] <= xs[col]) continue;
+                glTexCoord2f(u0[col], v0[row]); glVertex2f(xs[col], ys[row]);
+                glTexCoord2f(u1[col], v0[row]); glVertex2f(xs[col + 1], ys[row]);
+                glTexCoord2f(u1[col], v1[row]); glVertex2f(xs[col + 1], ys[row + 1]);
+                glTexCoord2f(u0[col], v1[row]); glVertex2f(xs[col], ys[row + 1]);
+            }
+        }
+        glEnd();
+        glDisable(GL_TEXTURE_2D);
+    }
+    
+    // Soft shadow of a rounded box; blur is the CSS box-shadow blur radius
+    // (a Gaussian with sigma blur / 2). The blurred shape is generated once
+    // per (radius, blur) pair as a small nine-patch shared by every shadow
+    // with that pair.
+    void drawShadow(const Rect& rect, float radius, const Color& color, float blur) {
+        if (rect.width <= 0 || rect.height <= 0) return;
+        radius = std::min({radius, rect.width / 2, rect.height / 2});
+        if (blur < 0.5f) {
+            drawRoundedRect(rect, BorderRadius(radius), color);
+            return;
+        }
+        int r = std::max(0, (int)std::lround(radius));
+        int b = std::clamp((int)std::lround(blur), 1, MAX_SHADOW_BLUR);
+        const Texture& texture = shadowTexture(r, b);
+        drawNinePatch(texture, Rect(rect.x - b, rect.y - b, rect.width + 2 * b, rect.height + 2 * b),
+                      Padding((float)(r + 2 * b)), color);
+    }
+    
+    // Queues an MSDF icon. Consecutive icons are drawn as one batch, flushed
+    // by the next other draw call or clip change. Returns false when no icon
+    // font or shape provides name.
+    bool drawIcon(const std::string& name, const Rect& rect, const Color& color) {
+        if (!iconFontProbed_) {
+            iconFontProbed_ = true;
+            if (icons_.empty()) {
+                const char* families[] = {
+                    "Material Icons", "Material Symbols Outlined", "Material Symbols Rounded",
+                    "Font Awesome 6 Free", "Font Awesome 5 Free", nullptr
+                };
+                for (int i = 0; families[i]; i++) {
+                    if (const FontFace* face = FontDatabase::shared().find(families[i])) {
+                        icons_.addFont(face->path);
+                        break;
+                    }
+                }
+            }
+        }
+        
+        const IconAtlas::Entry* entry = icons_.find(name);
+        if (!entry) return false;
+        noteDraw(name.data(), name.size());
+        noteDraw(rect);
+        noteDraw(color);
+        iconQueue_.push_back({*entry, rect, color});
+        return true;
+    }
+    
+    IconAtlas& icons() { return icons_; }
+    bool loadIconFont(const std::string& path) { return icons_.addFont(path); }
+    
+    // path may be a font file or a family name (see Font).
     Font* loadFont(const std::string& path, float size) {
         std::string key = path + ":" + std::to_string((int)size);
         auto it = fonts_.find(key);
         if (it != fonts_.end()) {
             return it->second.get();
         }
-        
-        auto font = std::make_unique<Font>(path, size);
-        if (!font->valid()) {
-            // Try loading default font
-            font = std::make_unique<Font>("", size);
+        return cacheFont(key, std::make_unique<Font>(path, size, shareGlyphAtlases_));
+    }
+    
+    // Resolves fontFamily, bold and italic to an installed face.
+    Font* loadFont(const TextStyle& style) {
+        if (style.fontFamily.find('/') != std::string::npos) {
+            return loadFont(style.fontFamily, style.fontSize);
+        }
+        std::string key = style.fontFamily + (style.bold ? ":b" : ":") + (style.italic ? "i:" : ":") +
+                          std::to_string((int)style.fontSize);
+        auto it = fonts_.find(key);
+        if (it != fonts_.end()) {
+            return it->second.get();
         }
         
-        Font* ptr = font.get();
-        fonts_[key] = std::move(font);
-        return ptr;
+        // A relative file name, checked once per style thanks to the key.
+        if (FontDatabase::isFilePath(style.fontFamily)) {
+            return cacheFont(key, std::make_unique<Font>(style.fontFamily, style.fontSize, shareGlyphAtlases_));
+        }
+        const FontFace* face = FontDatabase::shared().resolve(style.fontFamily, style.bold, style.italic);
+        if (!face) return loadFont(style.fontFamily, style.fontSize);
+        return cacheFont(key, std::make_unique<Font>(*face, style.fontSize, shareGlyphAtlases_));
+    }
+    
+    // Opt-in: fonts loaded afterwards keep their atlas in shared memory so
+    // other MetaUI processes using the same font and size reuse the glyphs.
+    void setShareGlyphAtlases(bool share) { shareGlyphAtlases_ = share; }
+    
+    // Sets the bitmap color font used for emoji. maxPages bounds the RGBA
+    // atlas (PAGE_SIZE^2 * 4 bytes per page). Without a call, a system Noto
+    // Color Emoji is used when one is found.
+    bool loadColorFont(const std::string& path, size_t maxPages = 4) {
+        auto source = std::make_unique<ColorGlyphSource>(path);
+        if (!source->valid()) return false;
+        colorGlyphs_ = std::make_unique<ColorGlyphCache>(std::move(source), maxPages);
+        colorFontProbed_ = true;
+        for (auto& entry : fonts_) entry.second->setColorGlyphs(colorGlyphs_.get());
+        return true;
     }
     
     Texture* loadImage(const std::string& path) {
@@ -615,10 +2255,1099 @@ public:
         textures_.erase(path);
     }
     
+    // Logical to physical pixel ratio for resolution-dependent assets.
+    void setContentScale(float scale) { contentScale_ = std::max(0.25f, scale); }
+    float contentScale() const { return contentScale_; }
+    
+    // SVGs are parsed once per path and rasterized on the shared thread
+    // pool at exactly width x height logical pixels times the content scale
+    // (the viewBox is stretched; pass a size with the image's aspect ratio
+    // to preserve it). Until that raster is ready the closest size already
+    // cached for the path is returned, or nullptr for the first one. A new
+    // size cancels unfinished ones that weren't asked for this frame, so a
+    // resize doesn't queue a raster for every size it passes through.
+    // Rasters are cached per (path, pixel size) within the SVG cache budget,
+    // evicting the least recently drawn; textures returned in the current
+    // frame are never evicted, so call this every frame rather than keeping
+    // the pointer.
+    Texture* loadSvg(const std::string& path, float width, float height) {
+        SvgDocument* doc = svgDocument(path);
+        if (!doc || !doc->image) return nullptr;
+        
+        int pw = std::clamp((int)std::lround(width * contentScale_), 1, MAX_SVG_PIXELS);
+        int ph = std::clamp((int)std::lround(height * contentScale_), 1, MAX_SVG_PIXELS);
+        auto distance = [pw, ph](const SvgRaster& r) {
+            return std::abs(r.width - pw) + std::abs(r.height - ph);
+        };
+        SvgRaster* exact = nullptr;
+        SvgRaster* closest = nullptr;
+        for (auto& raster : doc->rasters) {
+            if (raster->width == pw && raster->height == ph) {
+                exact = raster.get();
+            } else if (raster->texture.valid() && (!closest || distance(*raster) < distance(*closest))) {
+                closest = raster.get();
+            }
+        }
+        
+        if (!exact) {
+            cancelStaleSvgRasters(*doc);
+            auto raster = std::make_unique<SvgRaster>();
+            raster->width = pw;
+            raster->height = ph;
+            raster->cancelled = std::make_shared<std::atomic<bool>>(false);
+            raster->pending = ThreadPool::shared().submit(
+                [image = doc->image, pw, ph, cancelled = raster->cancelled] {
+                    if (*cancelled) return std::vector<unsigned char>();
+                    return image->rasterize(pw, ph, false);
+                });
+            exact = raster.get();
+            doc->rasters.push_back(std::move(raster));
+            svgPending_++;
+        } else if (exact->pending.valid()) {
+            collectSvgRaster(*exact);
+        }
+        
+        exact->lastUse = frame_;
+        SvgRaster* best = exact->texture.valid() ? exact : closest;
+        if (!best) return nullptr;
+        best->lastUse = frame_;
+        return &best->texture;
+    }
+    
+    // Intrinsic size in logical pixels; empty when the file can't be parsed.
+    Size svgSize(const std::string& path) {
+        SvgDocument* doc = svgDocument(path);
+        if (!doc || !doc->image) return Size();
+        return Size(doc->image->width(), doc->image->height());
+    }
+    
+    void setSvgCacheBudget(size_t bytes) {
+        svgBudget_ = bytes;
+        trimSvgCache();
+    }
+    
+    // Fills a path in transform space (widget coordinates are device
+    // pixels). Tessellation is cached per path and reused while the path's
+    // version is unchanged; the transform is applied on the GPU.
+    void fillPath(const VectorPath& path, const Transform2D& transform, const Color& color,
+                  FillRule rule = FillRule::NonZero) {
+        if (path.empty() || !bindPathShader()) return;
+        notePath(path, transform, color);
+        noteDraw(rule);
+        float scale = transform.scale() * pixelScale_;
+        CachedPath& cached = pathCache_[path.id()];
+        cached.lastUse = frame_;
+        if (!cached.fill.valid() || cached.fillVersion != path.version() || !sameScale(cached.fillScale, scale)) {
+            PathTessellation t = PathTessellation::fill(path, scale);
+            cached.fill.upload(t.vertices);
+            cached.fillVersion = path.version();
+            cached.fillScale = scale;
+            cached.fanCount = t.fanCount;
+            cached.fringeCount = t.fringeCount;
+            cached.coverCount = t.coverCount;
+        }
+        if (cached.fanCount == 0) {
+            unbindPathShader();
+            return;
+        }
+        
+        beginPathDraw(cached.fill, transform, color);
+        if (!hasStencil()) {
+            // Only exact for convex paths, but draws something.
+            glDrawArrays(GL_TRIANGLES, 0, (GLsizei)cached.fanCount);
+        } else {
+            GLuint mask = rule == FillRule::EvenOdd ? 0x01 : 0xFF;
+            glEnable(GL_STENCIL_TEST);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glStencilMask(mask);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            if (rule == FillRule::EvenOdd) {
+                glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            } else {
+                glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+                glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+            }
+            glDrawArrays(GL_TRIANGLES, 0, (GLsizei)cached.fanCount);
+            
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glStencilFunc(GL_EQUAL, 0, mask);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            glDrawArrays(GL_TRIANGLES, (GLint)cached.fanCount, (GLsizei)cached.fringeCount);
+            
+            glStencilMask(0xFF);
+            glStencilFunc(GL_NOTEQUAL, 0, mask);
+            glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
+            glDrawArrays(GL_TRIANGLES, (GLint)(cached.fanCount + cached.fringeCount), (GLsizei)cached.coverCount);
+            glDisable(GL_STENCIL_TEST);
+        }
+        endPathDraw();
+    }
+    
+    void strokePath(const VectorPath& path, const Transform2D& transform, const Color& color,
+                    const StrokeStyle& style = StrokeStyle()) {
+        if (path.empty() || style.width <= 0 || !bindPathShader()) return;
+        notePath(path, transform, color);
+        noteDraw(style.width);
+        noteDraw(style.cap);
+        float scale = transform.scale() * pixelScale_;
+        CachedPath& cached = pathCache_[path.id()];
+        cached.lastUse = frame_;
+        if (!cached.stroke.valid() || cached.strokeVersion != path.version() ||
+            !(cached.strokeStyle == style) || !sameScale(cached.strokeScale, scale)) {
+            PathTessellation t = PathTessellation::stroke(path, style, scale);
+            cached.stroke.upload(t.vertices);
+            cached.strokeVersion = path.version();
+            cached.strokeStyle = style;
+            cached.strokeScale = scale;
+            cached.strokeCount = t.vertexCount();
+        }
+        if (cached.strokeCount == 0) {
+            unbindPathShader();
+            return;
+        }
+        
+        beginPathDraw(cached.stroke, transform, color);
+        GLsizei count = (GLsizei)cached.strokeCount;
+        if (!hasStencil()) {
+            glDrawArrays(GL_TRIANGLES, 0, count);
+        } else {
+            // Solid core first, then the fringe, both marking the stencil so
+            // each pixel blends at most once where segments and joins
+            // overlap; a fringe pixel covered twice keeps the first coverage
+            // drawn. Then reset the stencil.
+            glEnable(GL_STENCIL_TEST);
+            glStencilMask(0xFF);
+            glStencilFunc(GL_EQUAL, 0, 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+            glUniform1f(pathShader_.uniform("threshold"), 1.0f - 0.5f / 255.0f);
+            glDrawArrays(GL_TRIANGLES, 0, count);
+            
+            glUniform1f(pathShader_.uniform("threshold"), 0.0f);
+            glDrawArrays(GL_TRIANGLES, 0, count);
+            
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
+            glDrawArrays(GL_TRIANGLES, 0, count);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glDisable(GL_STENCIL_TEST);
+        }
+        endPathDraw();
+    }
+    
+    // Anti-aliased, round-capped segments in a single instanced draw, for
+    // polylines with thousands of points that change every frame (charts).
+    void drawLineSegments(const LineSegment* segments, size_t count) {
+        if (count == 0 || !bindLineShader()) return;
+        
+        noteDraw(segments, count * sizeof(LineSegment));
+        lineInstances_.upload(segments, count * sizeof(LineSegment), GL_STREAM_DRAW);
+        glDisable(GL_TEXTURE_2D);
+        
+        // Unit quad in gl_Vertex: x runs along the segment, y across it.
+        glBindBuffer(GL_ARRAY_BUFFER, lineCorners_.id());
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, nullptr);
+        
+        glBindBuffer(GL_ARRAY_BUFFER, lineInstances_.id());
+        const GLsizei stride = sizeof(LineSegment);
+        const GLint locations[3] = {lineSegmentAttr_, lineColorAttr_, lineWidthAttr_};
+        const GLint sizes[3] = {4, 4, 1};
+        const size_t offsets[3] = {0, offsetof(LineSegment, color), offsetof(LineSegment, width)};
+        for (int i = 0; i < 3; ++i) {
+            glEnableVertexAttribArray(locations[i]);
+            glVertexAttribPointer(locations[i], sizes[i], GL_FLOAT, GL_FALSE, stride,
+                                  reinterpret_cast<const void*>(offsets[i]));
+            glVertexAttribDivisor(locations[i], 1);
+        }
+        
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+        
+        for (int i = 0; i < 3; ++i) {
+            glVertexAttribDivisor(locations[i], 0);
+            glDisableVertexAttribArray(locations[i]);
+        }
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glUseProgram(0);
+    }
+    
+    // Draws a single-channel float texture through a colormap (an N x 1
+    // RGBA texture): value v takes the color at (v - min) / (max - min),
+    // NaN is transparent. uv selects the part of the data shown, so zoom
+    // and pan never touch the data.
+    void drawColormapped(const Texture& values, const Texture& colormap, const Rect& rect,
+                         const Rect& uv, float min, float max, float opacity = 1.0f) {
+        if (!values.valid() || !colormap.valid()) return;
+        flushIcons();
+        noteDraw(values.contentVersion());
+        noteDraw(colormap.contentVersion());
+        noteDraw(rect);
+        noteDraw(uv);
+        noteDraw(min);
+        noteDraw(max);
+        noteDraw(opacity);
+        if (!colormapShader_.valid()) {
+            colormapShader_ = ShaderProgram(
+                "#version 120\n"
+                "void main() {\n"
+                "    gl_Position = ftransform();\n"
+                "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+                "    gl_FrontColor = gl_Color;\n"
+                "}\n",
+                "#version 120\n"
+                "uniform sampler2D values;\n"
+                "uniform sampler2D colormap;\n"
+                "uniform vec2 range;\n"
+                "uniform float lutSize;\n"
+                "void main() {\n"
+                "    float v = texture2D(values, gl_TexCoord[0].st).r;\n"
+                "    if (v != v) discard;\n"
+                "    float t = clamp((v - range.x) * range.y, 0.0, 1.0);\n"
+                "    vec4 color = texture2D(colormap, vec2((t * (lutSize - 1.0) + 0.5) / lutSize, 0.5));\n"
+                "    gl_FragColor = vec4(color.rgb, color.a * gl_Color.a);\n"
+                "}\n");
+            if (!colormapShader_.valid()) return;
+        }
+        
+        glUseProgram(colormapShader_.id());
+        glUniform1i(colormapShader_.uniform("values"), 0);
+        glUniform1i(colormapShader_.uniform("colormap"), 1);
+        glUniform2f(colormapShader_.uniform("range"), min, max > min ? 1.0f / (max - min) : 0.0f);
+        glUniform1f(colormapShader_.uniform("lutSize"), (float)colormap.width());
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, colormap.id());
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, values.id());
+        glEnable(GL_TEXTURE_2D);
+        glColor4f(1.0f, 1.0f, 1.0f, opacity);
+        
+        glBegin(GL_QUADS);
+        glTexCoord2f(uv.x, uv.y);
+        glVertex2f(rect.x, rect.y);
+        glTexCoord2f(uv.x + uv.width, uv.y);
+        glVertex2f(rect.x + rect.width, rect.y);
+        glTexCoord2f(uv.x + uv.width, uv.y + uv.height);
+        glVertex2f(rect.x + rect.width, rect.y + rect.height);
+        glTexCoord2f(uv.x, uv.y + uv.height);
+        glVertex2f(rect.x, rect.y + rect.height);
+        glEnd();
+        
+        glDisable(GL_TEXTURE_2D);
+        glUseProgram(0);
+    }
+    
+    // Draws planar YUV: y, u and v are single-channel textures (the chroma
+    // planes at half size), or with v == nullptr u holds interleaved NV12
+    // chroma as luminance/alpha. Conversion to RGB happens in the shader.
+    void drawYuv(const Texture& y, const Texture& u, const Texture* v, const Rect& rect,
+                 YuvMatrix matrix = YuvMatrix::Bt601, bool fullRange = false, float opacity = 1.0f) {
+        if (!y.valid() || !u.valid() || (v && !v->valid())) return;
+        flushIcons();
+        noteDraw(y.contentVersion());
+        noteDraw(u.contentVersion());
+        noteDraw(v ? v->contentVersion() : 0);
+        noteDraw(rect);
+        noteDraw(matrix);
+        noteDraw(fullRange);
+        noteDraw(opacity);
+        if (!yuvShader_.valid()) {
+            yuvShader_ = ShaderProgram(
+                "#version 120\n"
+                "void main() {\n"
+                "    gl_Position = ftransform();\n"
+                "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+                "    gl_FrontColor = gl_Color;\n"
+                "}\n",
+                "#version 120\n"
+                "uniform sampler2D planeY;\n"
+                "uniform sampler2D planeU;\n"
+                "uniform sampler2D planeV;\n"
+                "uniform bool interleaved;\n"
+                "uniform vec3 offset;\n"
+                "uniform mat3 matrix;\n"
+                "void main() {\n"
+                "    vec2 uv = gl_TexCoord[0].st;\n"
+                "    vec4 chroma = texture2D(planeU, uv);\n"
+                "    vec3 yuv = vec3(texture2D(planeY, uv).a,\n"
+                "                    interleaved ? chroma.r : chroma.a,\n"
+                "                    interleaved ? chroma.a : texture2D(planeV, uv).a);\n"
+                "    gl_FragColor = vec4(clamp(matrix * (yuv - offset), 0.0, 1.0), gl_Color.a);\n"
+                "}\n");
+            if (!yuvShader_.valid()) return;
+        }
+        
+        // Columns: contribution of Y, U and V to (R, G, B).
+        bool bt709 = matrix == YuvMatrix::Bt709;
+        float rv = bt709 ? 1.5748f : 1.402f;
+        float gu = bt709 ? 0.1873f : 0.3441f;
+        float gv = bt709 ? 0.4681f : 0.7141f;
+        float bu = bt709 ? 1.8556f : 1.772f;
+        float ky = fullRange ? 1.0f : 255.0f / 219.0f;
+        float kc = fullRange ? 1.0f : 255.0f / 224.0f;
+        const float m[9] = {ky, ky, ky, 0, -gu * kc, bu * kc, rv * kc, -gv * kc, 0};
+        
+        glUseProgram(yuvShader_.id());
+        glUniform1i(yuvShader_.uniform("planeY"), 0);
+        glUniform1i(yuvShader_.uniform("planeU"), 1);
+        glUniform1i(yuvShader_.uniform("planeV"), 2);
+        glUniform1i(yuvShader_.uniform("interleaved"), v ? 0 : 1);
+        glUniform3f(yuvShader_.uniform("offset"), fullRange ? 0.0f : 16.0f / 255.0f, 128.0f / 255.0f, 128.0f / 255.0f);
+        glUniformMatrix3fv(yuvShader_.uniform("matrix"), 1, GL_FALSE, m);
+        if (v) {
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, v->id());
+        }
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, u.id());
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, y.id());
+        glEnable(GL_TEXTURE_2D);
+        glColor4f(1.0f, 1.0f, 1.0f, opacity);
+        
+        glBegin(GL_QUADS);
+        glTexCoord2f(0, 0);
+        glVertex2f(rect.x, rect.y);
+        glTexCoord2f(1, 0);
+        glVertex2f(rect.x + rect.width, rect.y);
+        glTexCoord2f(1, 1);
+        glVertex2f(rect.x + rect.width, rect.y + rect.height);
+        glTexCoord2f(0, 1);
+        glVertex2f(rect.x, rect.y + rect.height);
+        glEnd();
+        
+        glDisable(GL_TEXTURE_2D);
+        glUseProgram(0);
+    }
+    
+    // Frosted glass: blurs what has been drawn so far around rect with a
+    // dual Kawase chain (downsampling from half resolution, then back up)
+    // and composites it inside the rounded box. The blur is reused while
+    // everything drawn before it matches the previous frame.
+    void drawBackdropBlur(const Rect& rect, const BorderRadius& radius, float blurRadius) {
+        if (rect.width < 1 || rect.height < 1 || blurRadius <= 0 || !backdropShadersReady()) return;
+        flushIcons();
+        
+        // Each level halves the resolution and doubles the kernel's reach,
+        // so the spread is roughly offset * 2^(passes + 1).
+        float pixelRadius = blurRadius * pixelScale_;
+        int passes = std::clamp((int)std::log2(std::max(pixelRadius, 2.0f)) - 1, 1, BACKDROP_MAX_PASSES);
+        float offset = std::max(1.0f, pixelRadius / (float)(2 << passes));
+        
+        int pad = (int)std::ceil(blurRadius);
+        int x0 = std::max(originX_, (int)std::floor(rect.x) - pad);
+        int y0 = std::max(originY_, (int)std::floor(rect.y) - pad);
+        int x1 = std::min(originX_ + width_, (int)std::ceil(rect.x + rect.width) + pad);
+        int y1 = std::min(originY_ + height_, (int)std::ceil(rect.y + rect.height) + pad);
+        if (x1 - x0 < 2 || y1 - y0 < 2) return;
+        
+        uint64_t key = (uint64_t)(x0 & 0xffff) << 48 | (uint64_t)(y0 & 0xffff) << 32 |
+                       (uint64_t)(x1 & 0xffff) << 16 | (uint64_t)(y1 & 0xffff);
+        Backdrop& backdrop = backdrops_[key];
+        backdrop.lastUse = frame_;
+        backdropDrawn_ = true;
+        if (!backdrop.valid || !trackDraws_ || backdrop.signature != drawSignature_ ||
+            backdrop.blurRadius != blurRadius) {
+            int px0 = (int)std::lround((x0 - originX_) * pixelScale_);
+            int py0 = (int)std::lround((y0 - originY_) * pixelScale_);
+            int px1 = std::min(pixelWidth(), (int)std::lround((x1 - originX_) * pixelScale_));
+            int py1 = std::min(pixelHeight(), (int)std::lround((y1 - originY_) * pixelScale_));
+            backdrop.valid = px1 - px0 >= 2 && py1 - py0 >= 2 &&
+                             blurBackdrop(backdrop, px0, py0, px1 - px0, py1 - py0, passes, offset) && trackDraws_;
+            backdrop.signature = drawSignature_;
+            backdrop.blurRadius = blurRadius;
+            if (backdrop.levels.empty()) return;
+        }
+        noteDraw(rect);
+        noteDraw(radius);
+        noteDraw(blurRadius);
+        
+        float w = (float)(x1 - x0), h = (float)(y1 - y0);
+        float limit = std::min(rect.width, rect.height) / 2;
+        glUseProgram(backdropShader_.id());
+        glUniform1i(backdropShader_.uniform("source"), 0);
+        glUniform2f(backdropShader_.uniform("halfPixel"), 0.5f / backdrop.levels[0].width(),
+                    0.5f / backdrop.levels[0].height());
+        glUniform1f(backdropShader_.uniform("offset"), offset);
+        glUniform2f(backdropShader_.uniform("size"), rect.width, rect.height);
+        glUniform4f(backdropShader_.uniform("radii"),
+                    std::min(radius.topLeft, limit), std::min(radius.topRight, limit),
+                    std::min(radius.bottomRight, limit), std::min(radius.bottomLeft, limit));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, backdrop.levels[1].texture().id());
+        
+        // The capture is bottom-up like the framebuffer it came from.
+        float u0 = (rect.x - x0) / w, u1 = (rect.x + rect.width - x0) / w;
+        float vTop = (y1 - rect.y) / h, vBottom = (y1 - rect.y - rect.height) / h;
+        glBegin(GL_QUADS);
+        glMultiTexCoord2f(GL_TEXTURE1, 0, 0);
+        glTexCoord2f(u0, vTop); glVertex2f(rect.x, rect.y);
+        glMultiTexCoord2f(GL_TEXTURE1, rect.width, 0);
+        glTexCoord2f(u1, vTop); glVertex2f(rect.x + rect.width, rect.y);
+        glMultiTexCoord2f(GL_TEXTURE1, rect.width, rect.height);
+        glTexCoord2f(u1, vBottom); glVertex2f(rect.x + rect.width, rect.y + rect.height);
+        glMultiTexCoord2f(GL_TEXTURE1, 0, rect.height);
+        glTexCoord2f(u0, vBottom); glVertex2f(rect.x, rect.y + rect.height);
+        glEnd();
+        glUseProgram(0);
+    }
+    
+    // True while background work will change what the next frame draws.
+    bool hasPendingWork() const { return svgPending_ > 0; }
+
 private:
+    Font* cacheFont(const std::string& key, std::unique_ptr<Font> font) {
+        if (!colorFontProbed_) {
+            colorFontProbed_ = true;
+            if (const FontFace* emoji = FontDatabase::shared().find("Noto Color Emoji")) {
+                loadColorFont(emoji->path);
+            }
+        }
+        font->setColorGlyphs(colorGlyphs_.get());
+        
+        Font* ptr = font.get();
+        fonts_[key] = std::move(font);
+        return ptr;
+    }
+    
     int width_, height_;
+    int originX_ = 0, originY_ = 0;
+    float pixelScale_ = 1.0f;
     std::unordered_map<std::string, std::unique_ptr<Font>> fonts_;
     std::unordered_map<std::string, std::unique_ptr<Texture>> textures_;
+    std::vector<Rect> clipStack_;
+    GlyphRun scratchRun_;
+    Font* batchFont_ = nullptr;
+    std::unique_ptr<ColorGlyphCache> colorGlyphs_;
+    bool colorFontProbed_ = false;
+    bool shareGlyphAtlases_ = false;
+    
+    struct QueuedColorGlyph {
+        float x, y, clipRight, alpha;
+        uint32_t codepoint;
+    };
+    std::vector<QueuedColorGlyph> colorQueue_;
+    
+    // The entry is copied: addShape() may replace it before the flush.
+    struct QueuedIcon {
+        IconAtlas::Entry entry;
+        Rect rect;
+        Color color;
+    };
+    IconAtlas icons_;
+    std::vector<QueuedIcon> iconQueue_;
+    ShaderProgram iconShader_;
+    bool iconFontProbed_ = false;
+    
+    // Path buffers not drawn for this many frames are released.
+    static constexpr uint64_t PATH_CACHE_FRAMES = 120;
+    
+    struct CachedPath {
+        VertexBuffer fill, stroke;
+        uint64_t fillVersion = 0, strokeVersion = 0;
+        float fillScale = 0, strokeScale = 0;
+        StrokeStyle strokeStyle;
+        size_t fanCount = 0, fringeCount = 0, coverCount = 0, strokeCount = 0;
+        uint64_t lastUse = 0;
+    };
+    std::unordered_map<uint64_t, CachedPath> pathCache_;
+    ShaderProgram pathShader_;
+    int stencilBits_ = -1;
+    uint64_t frame_ = 0;
+    
+    // Fingerprint of the draw calls issued so far this frame. It is only
+    // kept while backdrop blurs are on screen (from the frame after the
+    // first one), and a backdrop whose fingerprint matches the previous
+    // frame's still shows the same pixels.
+    bool trackDraws_ = false;
+    bool backdropDrawn_ = false;
+    uint64_t drawSignature_ = 0;
+    
+    void noteDraw(const void* data, size_t bytes) {
+        if (!trackDraws_) return;
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        uint64_t h = drawSignature_;
+        for (; bytes >= 8; bytes -= 8, p += 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+            h ^= h >> 32;
+        }
+        for (; bytes > 0; --bytes, ++p) h = (h ^ *p) * 0x100000001b3ULL;
+        drawSignature_ = h;
+    }
+    
+    template <typename T>
+    void noteDraw(const T& value) { noteDraw(&value, sizeof(T)); }
+    
+    void noteGlyphRun(const GlyphRun& run, const Point& pos, const Color& color, float maxWidth) {
+        if (!trackDraws_) return;
+        noteDraw(run.quads.data(), run.quads.size() * sizeof(GlyphRun::Quad));
+        noteDraw(run.colors.data(), run.colors.size() * sizeof(GlyphRun::ColorChange));
+        noteDraw(run.colorGlyphs.data(), run.colorGlyphs.size() * sizeof(GlyphRun::ColorGlyph));
+        noteDraw(pos);
+        noteDraw(color);
+        noteDraw(maxWidth);
+    }
+    
+    void notePath(const VectorPath& path, const Transform2D& transform, const Color& color) {
+        noteDraw(path.id());
+        noteDraw(path.version());
+        noteDraw(transform);
+        noteDraw(color);
+    }
+    
+    // Shadow nine-patches not drawn for this many frames are released.
+    static constexpr uint64_t SHADOW_CACHE_FRAMES = 120;
+    static constexpr int MAX_SHADOW_BLUR = 64;
+    
+    struct CachedShadow {
+        Texture texture;
+        uint64_t lastUse = 0;
+    };
+    std::unordered_map<uint64_t, CachedShadow> shadows_;
+    
+    // Alpha nine-patch: a rounded square of radius r with b pixels of
+    // falloff outside it, blurred. Insets are r + 2b on every side (margin,
+    // falloff reaching inward, corner) around a one-pixel stretchable core.
+    const Texture& shadowTexture(int r, int b) {
+        CachedShadow& cached = shadows_[(uint64_t)r << 32 | (uint32_t)b];
+        cached.lastUse = frame_;
+        if (cached.texture.valid()) return cached.texture;
+        
+        int inset = r + 2 * b;
+        int size = 2 * inset + 1;
+        std::vector<float> coverage((size_t)size * size), temp(coverage.size());
+        float half = (size - 2 * b) * 0.5f;
+        float center = size * 0.5f;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                float qx = std::abs(x + 0.5f - center) - half + r;
+                float qy = std::abs(y + 0.5f - center) - half + r;
+                float outside = std::hypot(std::max(qx, 0.0f), std::max(qy, 0.0f));
+                float dist = std::min(std::max(qx, qy), 0.0f) + outside - r;
+                coverage[(size_t)y * size + x] = std::clamp(0.5f - dist, 0.0f, 1.0f);
+            }
+        }
+        
+        float sigma = b * 0.5f;
+        std::vector<float> kernel(2 * b + 1);
+        float total = 0;
+        for (int i = -b; i <= b; ++i) total += kernel[i + b] = std::exp(-(i * i) / (2 * sigma * sigma));
+        for (float& k : kernel) k /= total;
+        auto blurPass = [&](const std::vector<float>& src, std::vector<float>& dst, bool horizontal) {
+            for (int y = 0; y < size; ++y) {
+                for (int x = 0; x < size; ++x) {
+                    float sum = 0;
+                    for (int i = -b; i <= b; ++i) {
+                        int sx = horizontal ? x + i : x, sy = horizontal ? y : y + i;
+                        if (sx >= 0 && sx < size && sy >= 0 && sy < size) {
+                            sum += src[(size_t)sy * size + sx] * kernel[i + b];
+                        }
+                    }
+                    dst[(size_t)y * size + x] = sum;
+                }
+            }
+        };
+        blurPass(coverage, temp, true);
+        blurPass(temp, coverage, false);
+        
+        std::vector<unsigned char> alpha(coverage.size());
+        for (size_t i = 0; i < alpha.size(); ++i) alpha[i] = (unsigned char)std::lround(coverage[i] * 255);
+        cached.texture = Texture(size, size, alpha.data(), 1);
+        return cached.texture;
+    }
+    
+    void trimShadows() {
+        for (auto it = shadows_.begin(); it != shadows_.end();) {
+            if (it->second.lastUse + SHADOW_CACHE_FRAMES < frame_) it = shadows_.erase(it);
+            else ++it;
+        }
+    }
+    
+    static constexpr int BACKDROP_MAX_PASSES = 6;
+    
+    // levels[0] holds the capture at full resolution, levels[i] is 1/2^i
+    // of it; after the upsample passes levels[1] holds the blurred result.
+    struct Backdrop {
+        std::vector<RenderTarget> levels;
+        uint64_t signature = 0;
+        float blurRadius = 0;
+        uint64_t lastUse = 0;
+        bool valid = false;
+    };
+    std::unordered_map<uint64_t, Backdrop> backdrops_;
+    ShaderProgram kawaseDownShader_, kawaseUpShader_, backdropShader_;
+    
+    bool backdropShadersReady() {
+        if (backdropShader_.valid()) return kawaseDownShader_.valid() && kawaseUpShader_.valid();
+        static const char* passVertex =
+            "#version 120\n"
+            "void main() {\n"
+            "    gl_Position = gl_Vertex;\n"
+            "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+            "}\n";
+        static const char* upsample =
+            "#version 120\n"
+            "uniform sampler2D source;\n"
+            "uniform vec2 halfPixel;\n"
+            "uniform float offset;\n"
+            "vec4 upsample(vec2 uv) {\n"
+            "    vec2 d = halfPixel * offset;\n"
+            "    vec4 sum = texture2D(source, uv + vec2(-d.x * 2.0, 0.0));\n"
+            "    sum += texture2D(source, uv + vec2(-d.x, d.y)) * 2.0;\n"
+            "    sum += texture2D(source, uv + vec2(0.0, d.y * 2.0));\n"
+            "    sum += texture2D(source, uv + vec2(d.x, d.y)) * 2.0;\n"
+            "    sum += texture2D(source, uv + vec2(d.x * 2.0, 0.0));\n"
+            "    sum += texture2D(source, uv + vec2(d.x, -d.y)) * 2.0;\n"
+            "    sum += texture2D(source, uv + vec2(0.0, -d.y * 2.0));\n"
+            "    sum += texture2D(source, uv + vec2(-d.x, -d.y)) * 2.0;\n"
+            "    return sum / 12.0;\n"
+            "}\n";
+        kawaseDownShader_ = ShaderProgram(passVertex,
+            "#version 120\n"
+            "uniform sampler2D source;\n"
+            "uniform vec2 halfPixel;\n"
+            "uniform float offset;\n"
+            "void main() {\n"
+            "    vec2 uv = gl_TexCoord[0].xy;\n"
+            "    vec2 d = halfPixel * offset;\n"
+            "    vec4 sum = texture2D(source, uv) * 4.0;\n"
+            "    sum += texture2D(source, uv - d);\n"
+            "    sum += texture2D(source, uv + d);\n"
+            "    sum += texture2D(source, uv + vec2(d.x, -d.y));\n"
+            "    sum += texture2D(source, uv - vec2(d.x, -d.y));\n"
+            "    gl_FragColor = sum / 8.0;\n"
+            "}\n");
+        kawaseUpShader_ = ShaderProgram(passVertex, (std::string(upsample) +
+            "void main() {\n"
+            "    gl_FragColor = upsample(gl_TexCoord[0].xy);\n"
+            "}\n").c_str());
+        // The last upsample happens while compositing, masked by the
+        // rounded box (gl_TexCoord[1] is the position inside it).
+        backdropShader_ = ShaderProgram(
+            "#version 120\n"
+            "void main() {\n"
+            "    gl_Position = ftransform();\n"
+            "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+            "    gl_TexCoord[1] = gl_MultiTexCoord1;\n"
+            "}\n",
+            (std::string(upsample) +
+            "uniform vec2 size;\n"
+            "uniform vec4 radii;\n"
+            "void main() {\n"
+            "    vec2 c = gl_TexCoord[1].xy - size * 0.5;\n"
+            "    float r = c.x < 0.0 ? (c.y < 0.0 ? radii.x : radii.w) : (c.y < 0.0 ? radii.y : radii.z);\n"
+            "    vec2 q = abs(c) - size * 0.5 + r;\n"
+            "    float dist = min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - r;\n"
+            "    gl_FragColor = vec4(upsample(gl_TexCoord[0].xy).rgb, clamp(0.5 - dist, 0.0, 1.0));\n"
+            "}\n").c_str());
+        return backdropShader_.valid() && kawaseDownShader_.valid() && kawaseUpShader_.valid();
+    }
+    
+    // Captures the framebuffer region (target pixels, y down) and runs the
+    // passes; false leaves nothing usable.
+    bool blurBackdrop(Backdrop& backdrop, int x, int y, int width, int height, int passes, float offset) {
+        auto& levels = backdrop.levels;
+        if ((int)levels.size() != passes + 1 || levels[0].width() != width || levels[0].height() != height) {
+            levels.clear();
+            int w = width, h = height;
+            for (int i = 0; i <= passes; ++i) {
+                levels.emplace_back(w, h);
+                if (!levels.back().valid()) {
+                    levels.clear();
+                    return false;
+                }
+                w = std::max(1, (w + 1) / 2);
+                h = std::max(1, (h + 1) / 2);
+            }
+        }
+        
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, levels[0].texture().id());
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, x, pixelHeight() - y - height, width, height);
+        
+        GLint previous = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+        glDisable(GL_SCISSOR_TEST);
+        glDisable(GL_BLEND);
+        
+        auto pass = [&](const ShaderProgram& shader, int from, int to) {
+            levels[to].bind();
+            glUniform2f(shader.uniform("halfPixel"), 0.5f / levels[to].width(), 0.5f / levels[to].height());
+            glBindTexture(GL_TEXTURE_2D, levels[from].texture().id());
+            glBegin(GL_QUADS);
+            glTexCoord2f(0, 0); glVertex2f(-1, -1);
+            glTexCoord2f(1, 0); glVertex2f(1, -1);
+            glTexCoord2f(1, 1); glVertex2f(1, 1);
+            glTexCoord2f(0, 1); glVertex2f(-1, 1);
+            glEnd();
+        };
+        
+        glUseProgram(kawaseDownShader_.id());
+        glUniform1i(kawaseDownShader_.uniform("source"), 0);
+        glUniform1f(kawaseDownShader_.uniform("offset"), offset);
+        for (int i = 1; i <= passes; ++i) pass(kawaseDownShader_, i - 1, i);
+        
+        glUseProgram(kawaseUpShader_.id());
+        glUniform1i(kawaseUpShader_.uniform("source"), 0);
+        glUniform1f(kawaseUpShader_.uniform("offset"), offset);
+        for (int i = passes - 1; i >= 1; --i) pass(kawaseUpShader_, i + 1, i);
+        
+        glUseProgram(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+        glViewport(0, 0, pixelWidth(), pixelHeight());
+        glEnable(GL_BLEND);
+        applyClip();
+        return true;
+    }
+    
+    void trimBackdrops() {
+        for (auto it = backdrops_.begin(); it != backdrops_.end();) {
+            if (it->second.lastUse + 1 < frame_) it = backdrops_.erase(it);
+            else ++it;
+        }
+    }
+    
+    // Fringes and flattening are sized in device pixels, so retessellate
+    // once the drawn scale drifts by more than a quarter.
+    static bool sameScale(float cached, float scale) {
+        return cached > 0 && scale > 0 && scale / cached < 1.25f && cached / scale < 1.25f;
+    }
+    
+    bool hasStencil() {
+        if (stencilBits_ < 0) glGetIntegerv(GL_STENCIL_BITS, &stencilBits_);
+        return stencilBits_ > 0;
+    }
+    
+    bool bindPathShader() {
+        flushIcons();
+        if (!pathShader_.valid()) {
+            pathShader_ = ShaderProgram(
+                "#version 120\n"
+                "varying float coverage;\n"
+                "void main() {\n"
+                "    gl_Position = ftransform();\n"
+                "    coverage = gl_MultiTexCoord0.x;\n"
+                "    gl_FrontColor = gl_Color;\n"
+                "}\n",
+                "#version 120\n"
+                "uniform float threshold;\n"
+                "varying float coverage;\n"
+                "void main() {\n"
+                "    if (coverage < threshold) discard;\n"
+                "    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * coverage);\n"
+                "}\n");
+            if (!pathShader_.valid()) return false;
+        }
+        glUseProgram(pathShader_.id());
+        glUniform1f(pathShader_.uniform("threshold"), 0.0f);
+        return true;
+    }
+    
+    void unbindPathShader() { glUseProgram(0); }
+    
+    void beginPathDraw(const VertexBuffer& buffer, const Transform2D& transform, const Color& color) {
+        float matrix[16];
+        transform.toMatrix(matrix);
+        glDisable(GL_TEXTURE_2D);
+        glColor4f(color.r, color.g, color.b, color.a);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glMultMatrixf(matrix);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.id());
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 3 * sizeof(float), nullptr);
+        glTexCoordPointer(1, GL_FLOAT, 3 * sizeof(float), reinterpret_cast<const void*>(2 * sizeof(float)));
+    }
+    
+    void endPathDraw() {
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glPopMatrix();
+        unbindPathShader();
+    }
+    
+    ShaderProgram colormapShader_;
+    ShaderProgram yuvShader_;
+    ShaderProgram lineShader_;
+    VertexBuffer lineCorners_, lineInstances_;
+    GLint lineSegmentAttr_ = -1, lineColorAttr_ = -1, lineWidthAttr_ = -1;
+    
+    // Each instance is a capsule; the fragment shader measures the distance
+    // to the segment for a one pixel anti-aliased edge.
+    bool bindLineShader() {
+        flushIcons();
+        if (!lineShader_.valid()) {
+            lineShader_ = ShaderProgram(
+                "#version 120\n"
+                "attribute vec4 segment;\n"
+                "attribute vec4 color;\n"
+                "attribute float halfWidth;\n"
+                "varying vec2 local;\n"
+                "varying float segmentLength;\n"
+                "varying float radius;\n"
+                "void main() {\n"
+                "    vec2 d = segment.zw - segment.xy;\n"
+                "    float len = length(d);\n"
+                "    vec2 dir = len > 0.0001 ? d / len : vec2(1.0, 0.0);\n"
+                "    float r = halfWidth + 1.0;\n"
+                "    local = vec2(mix(-r, len + r, gl_Vertex.x), gl_Vertex.y * r);\n"
+                "    segmentLength = len;\n"
+                "    radius = halfWidth;\n"
+                "    vec2 pos = segment.xy + dir * local.x + vec2(-dir.y, dir.x) * local.y;\n"
+                "    gl_Position = gl_ModelViewProjectionMatrix * vec4(pos, 0.0, 1.0);\n"
+                "    gl_FrontColor = color;\n"
+                "}\n",
+                "#version 120\n"
+                "varying vec2 local;\n"
+                "varying float segmentLength;\n"
+                "varying float radius;\n"
+                "void main() {\n"
+                "    float dx = max(max(-local.x, local.x - segmentLength), 0.0);\n"
+                "    float alpha = clamp(radius + 0.5 - length(vec2(dx, local.y)), 0.0, 1.0);\n"
+                "    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * alpha);\n"
+                "}\n");
+            if (!lineShader_.valid()) return false;
+            lineSegmentAttr_ = glGetAttribLocation(lineShader_.id(), "segment");
+            lineColorAttr_ = glGetAttribLocation(lineShader_.id(), "color");
+            lineWidthAttr_ = glGetAttribLocation(lineShader_.id(), "halfWidth");
+            const float corners[8] = {0, -1, 1, -1, 0, 1, 1, 1};
+            lineCorners_.upload(corners, sizeof(corners), GL_STATIC_DRAW);
+        }
+        if (lineSegmentAttr_ < 0 || lineColorAttr_ < 0 || lineWidthAttr_ < 0) return false;
+        glUseProgram(lineShader_.id());
+        return true;
+    }
+    
+    void trimPathCache() {
+        for (auto it = pathCache_.begin(); it != pathCache_.end();) {
+            if (it->second.lastUse + PATH_CACHE_FRAMES < frame_) it = pathCache_.erase(it);
+            else ++it;
+        }
+    }
+    
+    static constexpr int MAX_SVG_PIXELS = 4096;
+    
+    struct SvgRaster {
+        int width = 0, height = 0;
+        Texture texture;
+        std::future<std::vector<unsigned char>> pending;
+        std::shared_ptr<std::atomic<bool>> cancelled;  // skips the job if not started yet
+        uint64_t lastUse = 0;
+    };
+    struct SvgDocument {
+        std::shared_ptr<const SvgImage> image;   // null when parsing failed
+        std::vector<std::unique_ptr<SvgRaster>> rasters;
+    };
+    std::unordered_map<std::string, SvgDocument> svgDocuments_;
+    float contentScale_ = 1.0f;
+    size_t svgBudget_ = 32 * 1024 * 1024;
+    size_t svgBytes_ = 0;
+    size_t svgPending_ = 0;
+    
+    SvgDocument* svgDocument(const std::string& path) {
+        auto it = svgDocuments_.find(path);
+        if (it == svgDocuments_.end()) {
+            it = svgDocuments_.emplace(path, SvgDocument{SvgImage::load(path), {}}).first;
+        }
+        return &it->second;
+    }
+    
+    // Uploads a finished raster; a no-op while it is still running.
+    void collectSvgRaster(SvgRaster& raster) {
+        if (raster.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        std::vector<unsigned char> pixels = raster.pending.get();
+        svgPending_--;
+        raster.texture = Texture(raster.width, raster.height, pixels.data(), 4);
+        raster.lastUse = frame_;
+        svgBytes_ += pixels.size();
+        trimSvgCache();
+    }
+    
+    // Drops unfinished rasters of doc that weren't asked for this frame. A
+    // job already running finishes, but its result is discarded with the
+    // future.
+    void cancelStaleSvgRasters(SvgDocument& doc) {
+        auto& rasters = doc.rasters;
+        for (size_t i = 0; i < rasters.size();) {
+            SvgRaster& raster = *rasters[i];
+            if (raster.pending.valid() && raster.lastUse < frame_) {
+                *raster.cancelled = true;
+                svgPending_--;
+                rasters.erase(rasters.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+    }
+    
+    void collectSvgRasters() {
+        for (auto& entry : svgDocuments_) {
+            for (auto& raster : entry.second.rasters) {
+                if (raster->pending.valid()) collectSvgRaster(*raster);
+            }
+        }
+    }
+    
+    void trimSvgCache() {
+        while (svgBytes_ > svgBudget_) {
+            SvgDocument* victimDoc = nullptr;
+            size_t victim = 0;
+            for (auto& entry : svgDocuments_) {
+                auto& rasters = entry.second.rasters;
+                for (size_t i = 0; i < rasters.size(); ++i) {
+                    if (!rasters[i]->texture.valid() || rasters[i]->lastUse >= frame_) continue;
+                    if (!victimDoc || rasters[i]->lastUse < victimDoc->rasters[victim]->lastUse) {
+                        victimDoc = &entry.second;
+                        victim = i;
+                    }
+                }
+            }
+            if (!victimDoc) return;
+            SvgRaster& raster = *victimDoc->rasters[victim];
+            svgBytes_ -= (size_t)raster.width * raster.height * 4;
+            victimDoc->rasters.erase(victimDoc->rasters.begin() + victim);
+        }
+    }
+    
+    void flushIcons() {
+        if (iconQueue_.empty()) return;
+        if (!iconShader_.valid()) {
+            iconShader_ = ShaderProgram(
+                "#version 120\n"
+                "void main() {\n"
+                "    gl_Position = ftransform();\n"
+                "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+                "    gl_FrontColor = gl_Color;\n"
+                "}\n",
+                "#version 120\n"
+                "uniform sampler2D atlas;\n"
+                "uniform vec2 unitRange;\n"
+                "float median(vec3 v) { return max(min(v.r, v.g), min(max(v.r, v.g), v.b)); }\n"
+                "void main() {\n"
+                "    vec2 uv = gl_TexCoord[0].st;\n"
+                "    float distance = median(texture2D(atlas, uv).rgb) - 0.5;\n"
+                "    float screenPxRange = max(0.5 * dot(unitRange, vec2(1.0) / fwidth(uv)), 1.0);\n"
+                "    float alpha = clamp(distance * screenPxRange + 0.5, 0.0, 1.0);\n"
+                "    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * alpha);\n"
+                "}\n");
+            if (!iconShader_.valid()) {
+                iconQueue_.clear();
+                return;
+            }
+        }
+        
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, icons_.texture());
+        glUseProgram(iconShader_.id());
+        glUniform1i(iconShader_.uniform("atlas"), 0);
+        float unitRange = IconAtlas::DISTANCE_RANGE / IconAtlas::ATLAS_SIZE;
+        glUniform2f(iconShader_.uniform("unitRange"), unitRange, unitRange);
+        
+        glBegin(GL_QUADS);
+        for (const auto& icon : iconQueue_) {
+            const IconAtlas::Entry& e = icon.entry;
+            float dx = icon.rect.width * e.inset, dy = icon.rect.height * e.inset;
+            float x0 = icon.rect.x - dx, y0 = icon.rect.y - dy;
+            float x1 = icon.rect.x + icon.rect.width + dx, y1 = icon.rect.y + icon.rect.height + dy;
+            glColor4f(icon.color.r, icon.color.g, icon.color.b, icon.color.a);
+            glTexCoord2f(e.u0, e.v0); glVertex2f(x0, y0);
+            glTexCoord2f(e.u1, e.v0); glVertex2f(x1, y0);
+            glTexCoord2f(e.u1, e.v1); glVertex2f(x1, y1);
+            glTexCoord2f(e.u0, e.v1); glVertex2f(x0, y1);
+        }
+        glEnd();
+        
+        glUseProgram(0);
+        glDisable(GL_TEXTURE_2D);
+        iconQueue_.clear();
+    }
+    
+    void queueColorGlyphs(const GlyphRun& run, const Point& origin, float alpha, float maxWidth) {
+        if (run.colorGlyphs.empty()) return;
+        float x = std::round(origin.x - run.pen), y = std::round(origin.y);
+        float clipRight = maxWidth > 0 ? x + maxWidth : 1e30f;
+        for (const auto& g : run.colorGlyphs) {
+            colorQueue_.push_back({x + g.x, y + g.y, clipRight, alpha, g.codepoint});
+        }
+    }
+    
+    // Resolves queued color glyphs first (which may rasterize and upload),
+    // then draws them grouped by page.
+    void drawColorGlyphs(Font* font) {
+        if (colorQueue_.empty()) return;
+        ColorGlyphCache* cache = font->colorGlyphs();
+        if (!cache) {
+            colorQueue_.clear();
+            return;
+        }
+        
+        std::vector<std::pair<const ColorGlyphCache::Entry*, const QueuedColorGlyph*>> resolved;
+        resolved.reserve(colorQueue_.size());
+        for (const auto& q : colorQueue_) {
+            const ColorGlyphCache::Entry* entry = cache->get((int)q.codepoint, font->emSize());
+            if (entry && q.x + entry->x1 <= q.clipRight) resolved.push_back({entry, &q});
+        }
+        std::stable_sort(resolved.begin(), resolved.end(),
+                         [](const auto& a, const auto& b) { return a.first->page < b.first->page; });
+        
+        int page = -1;
+        for (const auto& [e, q] : resolved) {
+            if (e->page != page) {
+                if (page >= 0) glEnd();
+                page = e->page;
+                glBindTexture(GL_TEXTURE_2D, cache->pageTexture(page));
+                glBegin(GL_QUADS);
+            }
+            glColor4f(1, 1, 1, q->alpha);
+            glTexCoord2f(e->u0, e->v0); glVertex2f(q->x + e->x0, q->y + e->y0);
+            glTexCoord2f(e->u1, e->v0); glVertex2f(q->x + e->x1, q->y + e->y0);
+            glTexCoord2f(e->u1, e->v1); glVertex2f(q->x + e->x1, q->y + e->y1);
+            glTexCoord2f(e->u0, e->v1); glVertex2f(q->x + e->x0, q->y + e->y1);
+        }
+        if (page >= 0) glEnd();
+        colorQueue_.clear();
+    }
+    
+    void emitGlyphQuads(const GlyphRun& run, const Point& origin, float maxWidth) {
+        Point pos(std::round(origin.x - run.pen), std::round(origin.y));
+        size_t nextColor = 0;
+        for (size_t i = 0; i < run.quads.size(); ++i) {
+            const auto& q = run.quads[i];
+            if (maxWidth > 0 && q.x1 > maxWidth) break;
+            
+            while (nextColor < run.colors.size() && run.colors[nextColor].quad <= i) {
+                const Color& c = run.colors[nextColor++].color;
+                glColor4f(c.r, c.g, c.b, c.a);
+            }
+            
+            float x0 = pos.x + q.x0;
+            float y0 = pos.y + q.y0;
+            float x1 = pos.x + q.x1;
+            float y1 = pos.y + q.y1;
+            
+            glTexCoord2f(q.u0, q.v0); glVertex2f(x0, y0);
+            glTexCoord2f(q.u1, q.v0); glVertex2f(x1, y0);
+            glTexCoord2f(q.u1, q.v1); glVertex2f(x1, y1);
+            glTexCoord2f(q.u0, q.v1); glVertex2f(x0, y1);
+        }
+    }
+    
+    void applyClip() {
+        if (clipStack_.empty()) {
+            glDisable(GL_SCISSOR_TEST);
+            return;
+        }
+        const Rect& r = clipStack_.back();
+        glEnable(GL_SCISSOR_TEST);
+        glScissor((GLint)std::floor((r.x - originX_) * pixelScale_), 
+                  (GLint)std::floor((height_ - (r.y - originY_ + r.height)) * pixelScale_),
+                  (GLsizei)std::ceil(r.width * pixelScale_), 
+                  (GLsizei)std::ceil(r.height * pixelScale_));
+    }
     
     void drawCorner(float cx, float cy, float radius, float startAngle, float endAngle, 
                    const Color& color) {
@@ -655,7 +3384,11 @@ inline void Widget::render(Renderer& renderer) {
         Rect shadowRect = bounds_;
         shadowRect.x += style_.shadowOffset.x;
         shadowRect.y += style_.shadowOffset.y;
-        renderer.drawRoundedRect(shadowRect, style_.borderRadius, style_.shadowColor);
+        renderer.drawShadow(shadowRect, style_.borderRadius.topLeft, style_.shadowColor, style_.shadowBlur);
+    }
+    
+    if (style_.backdropBlur > 0) {
+        renderer.drawBackdropBlur(bounds_, style_.borderRadius, style_.backdropBlur);
     }
     
     // Draw background
@@ -0,0 +1,469 @@
+#pragma once
+
+#include "core.hpp"
+#include "widget.hpp"
+#include "renderer.hpp"
+#include "metrics.hpp"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace MetaUI {
+
+// ============================================================================
+// Input Recording
+// ============================================================================
+
+// One input event as the application received it. Pointer events carry the
+// window position they apply at, so a record replays without the events
+// before it.
+struct InputRecord {
+    enum class Type { Motion, Button, Scroll, Key, Resize };
+    
+    Type type = Type::Motion;
+    uint64_t time = 0;          // ns since the recording started
+    float x = 0, y = 0;         // pointer position; new size for Resize
+    float deltaX = 0, deltaY = 0;
+    uint32_t code = 0;          // MouseButton index or keycode
+    bool pressed = false;
+};
+
+// Delivers a record to a widget tree the way Application's Wayland
+// listeners do. Resize is left to the caller, which owns the size.
+inline void dispatchInput(Widget& root, const InputRecord& record) {
+    switch (record.type) {
+        case InputRecord::Type::Motion: {
+            MouseEvent event{};
+            event.position = Point(record.x, record.y);
+            root.handleMouseMove(event);
+            break;
+        }
+        case InputRecord::Type::Button: {
+            MouseEvent event{};
+            event.position = Point(record.x, record.y);
+            event.button = static_cast<MouseButton>(record.code);
+            event.pressed = record.pressed;
+            root.handleMouseButton(event);
+            break;
+        }
+        case InputRecord::Type::Scroll: {
+            ScrollEvent event{};
+            event.position = Point(record.x, record.y);
+            event.deltaX = record.deltaX;
+            event.deltaY = record.deltaY;
+            root.handleScroll(event);
+            break;
+        }
+        case InputRecord::Type::Key: {
+            KeyEvent event{};
+            event.keycode = record.code;
+            event.pressed = record.pressed;
+            root.handleKeyEvent(event);
+            break;
+        }
+        case InputRecord::Type::Resize:
+            break;
+    }
+}
+
+// An ordered event list, saved as text (one event per line) so recordings
+// can be attached to bug reports and diffed.
+class InputRecording {
+public:
+    void add(const InputRecord& record) { events_.push_back(record); }
+    void clear() { events_.clear(); }
+    
+    const std::vector<InputRecord>& events() const { return events_; }
+    size_t size() const { return events_.size(); }
+    bool empty() const { return events_.empty(); }
+    uint64_t duration() const { return events_.empty() ? 0 : events_.back().time; }
+    
+    bool save(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) return false;
+        
+        fprintf(file, "%s\n", HEADER);
+        for (const auto& e : events_) {
+            unsigned long long t = e.time;
+            switch (e.type) {
+                case InputRecord::Type::Motion:
+                    fprintf(file, "M %llu %.9g %.9g\n", t, e.x, e.y);
+                    break;
+                case InputRecord::Type::Button:
+                    fprintf(file, "B %llu %.9g %.9g %u %d\n", t, e.x, e.y, e.code, e.pressed ? 1 : 0);
+                    break;
+                case InputRecord::Type::Scroll:
+                    fprintf(file, "S %llu %.9g %.9g %.9g %.9g\n", t, e.x, e.y, e.deltaX, e.deltaY);
+                    break;
+                case InputRecord::Type::Key:
+                    fprintf(file, "K %llu %u %d\n", t, e.code, e.pressed ? 1 : 0);
+                    break;
+                case InputRecord::Type::Resize:
+                    fprintf(file, "R %llu %.9g %.9g\n", t, e.x, e.y);
+                    break;
+            }
+        }
+        return fclose(file) == 0;
+    }
+    
+    // Replaces the current events; on a malformed file the recording is
+    // left empty.
+    bool load(const std::string& path) {
+        events_.clear();
+        FILE* file = fopen(path.c_str(), "r");
+        if (!file) return false;
+        
+        char buffer[256];
+        bool valid = fgets(buffer, sizeof(buffer), file) &&
+                     std::strncmp(buffer, HEADER, std::strlen(HEADER)) == 0;
+        while (valid && fgets(buffer, sizeof(buffer), file)) {
+            InputRecord e;
+            unsigned long long t = 0;
+            int pressed = 0;
+            switch (buffer[0]) {
+                case 'M':
+                    e.type = InputRecord::Type::Motion;
+                    valid = sscanf(buffer + 1, "%llu %f %f", &t, &e.x, &e.y) == 3;
+                    break;
+                case 'B':
+                    e.type = InputRecord::Type::Button;
+                    valid = sscanf(buffer + 1, "%llu %f %f %u %d", &t, &e.x, &e.y, &e.code, &pressed) == 5;
+                    break;
+                case 'S':
+                    e.type = InputRecord::Type::Scroll;
+                    valid = sscanf(buffer + 1, "%llu %f %f %f %f", &t, &e.x, &e.y,
+                                   &e.deltaX, &e.deltaY) == 5;
+                    break;
+                case 'K':
+                    e.type = InputRecord::Type::Key;
+                    valid = sscanf(buffer + 1, "%llu %u %d", &t, &e.code, &pressed) == 3;
+                    break;
+                case 'R':
+                    e.type = InputRecord::Type::Resize;
+                    valid = sscanf(buffer + 1, "%llu %f %f", &t, &e.x, &e.y) == 3;
+                    break;
+                default:
+                    valid = false;
+            }
+            e.time = t;
+            e.pressed = pressed != 0;
+            if (valid) events_.push_back(e);
+        }
+        fclose(file);
+        if (!valid) events_.clear();
+        return valid;
+    }
+
+private:
+    static constexpr const char* HEADER = "METAUI-INPUT 1";
+    std::vector<InputRecord> events_;
+};
+
+// ============================================================================
+// Headless Application
+// ============================================================================
+
+struct FrameTiming {
+    double layoutMs = 0;
+    double renderMs = 0;
+};
+
+// Renders a widget tree into an offscreen pbuffer on a surfaceless EGL
+// display, for benchmarks and tests on machines without a compositor.
+// Widgets asking for separateSurface() get a pbuffer and renderer of their
+// own on the same context, as Application's subsurfaces do, and are drawn
+// only when they were just attached, received input or called
+// requestRedraw().
+class HeadlessApplication {
+public:
+    HeadlessApplication(int width, int height) : width_(width), height_(height) {
+        initEGL();
+        renderer_ = std::make_unique<Renderer>(width, height);
+    }
+    
+    ~HeadlessApplication() {
+        detachSurfaces();
+        renderer_.reset();
+        if (eglDisplay_ != EGL_NO_DISPLAY) {
+            eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (eglContext_ != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay_, eglContext_);
+            if (eglSurface_ != EGL_NO_SURFACE) eglDestroySurface(eglDisplay_, eglSurface_);
+            eglTerminate(eglDisplay_);
+        }
+    }
+    
+    HeadlessApplication(const HeadlessApplication&) = delete;
+    HeadlessApplication& operator=(const HeadlessApplication&) = delete;
+    
+    void setRoot(WidgetPtr root) { root_ = std::move(root); }
+    
+    // The pbuffer is sized once; larger sizes are clipped to it.
+    void resize(int width, int height) {
+        width_ = std::max(1, width);
+        height_ = std::max(1, height);
+        renderer_->setSize(width_, height_);
+    }
+    
+    void handleInput(const InputRecord& record) {
+        if (record.type == InputRecord::Type::Resize) resize((int)record.x, (int)record.y);
+        else if (root_) dispatchInput(*root_, record);
+        for (auto& surface : surfaces_) surface->dirty = true;
+    }
+    
+    // Lays out and renders one frame, waiting for the GPU so the render
+    // time covers the draw work and not just its submission.
+    FrameTiming renderFrame() {
+        using clock = std::chrono::steady_clock;
+        FrameTiming timing;
+        
+        auto start = clock::now();
+        if (root_) {
+            root_->measure(Size(width_, height_));
+            root_->layout(Rect(0, 0, width_, height_));
+        }
+        syncSurfaces();
+        auto laidOut = clock::now();
+        
+        renderer_->beginFrame();
+        if (root_) root_->render(*renderer_);
+        renderer_->endFrame();
+        for (auto& surface : surfaces_) {
+            if (surface->widget->takeRedrawRequest()) surface->dirty = true;
+            if (surface->dirty) renderSurface(*surface);
+        }
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+        glFinish();
+        auto rendered = clock::now();
+        
+        timing.layoutMs = std::chrono::duration<double, std::milli>(laidOut - start).count();
+        timing.renderMs = std::chrono::duration<double, std::milli>(rendered - laidOut).count();
+        return timing;
+    }
+    
+    Renderer& renderer() { return *renderer_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    
+    // Frames drawn into widget's own surface; 0 when it has none.
+    uint64_t surfaceFrames(const Widget& widget) const {
+        const Surface* surface = findSurface(widget);
+        return surface ? surface->frames : 0;
+    }
+    
+    // RGBA rows, bottom-up as glReadPixels returns them, of the window
+    // (nullptr) or of widget's own surface; empty when it has none.
+    std::vector<unsigned char> readPixels(const Widget* widget = nullptr) {
+        const Surface* surface = widget ? findSurface(*widget) : nullptr;
+        if (widget && !surface) return {};
+        EGLSurface target = surface ? surface->eglSurface : eglSurface_;
+        int w = surface ? surface->renderer->pixelWidth() : renderer_->pixelWidth();
+        int h = surface ? surface->renderer->pixelHeight() : renderer_->pixelHeight();
+        std::vector<unsigned char> pixels((size_t)w * h * 4);
+        eglMakeCurrent(eglDisplay_, target, target, eglContext_);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+        return pixels;
+    }
+
+private:
+    int width_, height_;
+    WidgetPtr root_;
+    std::unique_ptr<Renderer> renderer_;
+    
+    EGLDisplay eglDisplay_ = EGL_NO_DISPLAY;
+    EGLContext eglContext_ = EGL_NO_CONTEXT;
+    EGLSurface eglSurface_ = EGL_NO_SURFACE;
+    EGLConfig eglConfig_ = nullptr;
+    
+    struct Surface {
+        WidgetPtr widget;
+        Rect bounds;
+        float scale = 1.0f;
+        EGLSurface eglSurface = EGL_NO_SURFACE;
+        std::unique_ptr<Renderer> renderer;
+        bool dirty = true;
+        uint64_t frames = 0;
+    };
+    std::vector<std::unique_ptr<Surface>> surfaces_;
+    
+    const Surface* findSurface(const Widget& widget) const {
+        for (auto& surface : surfaces_) {
+            if (surface->widget.get() == &widget) return surface.get();
+        }
+        return nullptr;
+    }
+    
+    // Attaches again when the widgets asking for a surface, their bounds or
+    // their scale changed.
+    void syncSurfaces() {
+        std::vector<WidgetPtr> wanted;
+        if (root_) collectSeparateSurfaces(*root_, wanted);
+        bool same = wanted.size() == surfaces_.size();
+        for (size_t i = 0; same && i < wanted.size(); ++i) {
+            const Surface& surface = *surfaces_[i];
+            Rect bounds = wanted[i]->surfaceBounds();
+            same = surface.widget == wanted[i] &&
+                   surface.scale == std::clamp(wanted[i]->surfaceScale(), 0.1f, 1.0f) &&
+                   surface.bounds.x == bounds.x && surface.bounds.y == bounds.y &&
+                   surface.bounds.width == bounds.width && surface.bounds.height == bounds.height;
+        }
+        if (same) return;
+        
+        detachSurfaces();
+        for (auto& widget : wanted) {
+            auto surface = std::make_unique<Surface>();
+            surface->widget = widget;
+            surface->bounds = widget->surfaceBounds();
+            surface->scale = std::clamp(widget->surfaceScale(), 0.1f, 1.0f);
+            int w = (int)surface->bounds.width, h = (int)surface->bounds.height;
+            EGLint attribs[] = {
+                EGL_WIDTH, std::max(1, (int)std::lround(w * surface->scale)),
+                EGL_HEIGHT, std::max(1, (int)std::lround(h * surface->scale)),
+                EGL_NONE
+            };
+            surface->eglSurface = eglCreatePbufferSurface(eglDisplay_, eglConfig_, attribs);
+            if (surface->eglSurface == EGL_NO_SURFACE) continue;
+            
+            eglMakeCurrent(eglDisplay_, surface->eglSurface, surface->eglSurface, eglContext_);
+            surface->renderer = std::make_unique<Renderer>(w, h);
+            surface->renderer->setOrigin((int)surface->bounds.x, (int)surface->bounds.y);
+            surface->renderer->setPixelScale(surface->scale);
+            surface->renderer->setContentScale(surface->scale);
+            widget->setSurfaceAttached(true);
+            surfaces_.push_back(std::move(surface));
+        }
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+    }
+    
+    void renderSurface(Surface& surface) {
+        eglMakeCurrent(eglDisplay_, surface.eglSurface, surface.eglSurface, eglContext_);
+        surface.renderer->beginFrame();
+        if (surface.widget->isVisible()) surface.widget->render(*surface.renderer);
+        surface.renderer->endFrame();
+        surface.dirty = surface.renderer->hasPendingWork();
+        surface.frames++;
+    }
+    
+    void detachSurfaces() {
+        for (auto& surface : surfaces_) {
+            surface->widget->setSurfaceAttached(false);
+            eglMakeCurrent(eglDisplay_, surface->eglSurface, surface->eglSurface, eglContext_);
+            surface->renderer.reset();
+            eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+            eglDestroySurface(eglDisplay_, surface->eglSurface);
+        }
+        surfaces_.clear();
+    }
+    
+    void initEGL() {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+            eglDisplay_ = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (eglDisplay_ == EGL_NO_DISPLAY) eglDisplay_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (eglDisplay_ == EGL_NO_DISPLAY) throw std::runtime_error("Failed to get EGL display");
+        if (!eglInitialize(eglDisplay_, nullptr, nullptr)) throw std::runtime_error("Failed to initialize EGL");
+        
+        EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_STENCIL_SIZE, 8,   // path fills and strokes
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        
+        EGLConfig config;
+        EGLint numConfigs;
+        if (!eglChooseConfig(eglDisplay_, configAttribs, &config, 1, &numConfigs) || numConfigs == 0)
+            throw std::runtime_error("Failed to choose EGL config");
+        eglConfig_ = config;
+        
+        eglBindAPI(EGL_OPENGL_API);
+        
+        eglContext_ = eglCreateContext(eglDisplay_, config, EGL_NO_CONTEXT, nullptr);
+        if (eglContext_ == EGL_NO_CONTEXT) throw std::runtime_error("Failed to create EGL context");
+        
+        EGLint pbufferAttribs[] = { EGL_WIDTH, width_, EGL_HEIGHT, height_, EGL_NONE };
+        eglSurface_ = eglCreatePbufferSurface(eglDisplay_, config, pbufferAttribs);
+        if (eglSurface_ == EGL_NO_SURFACE) throw std::runtime_error("Failed to create EGL pbuffer");
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+    }
+};
+
+// ============================================================================
+// Input Replay
+// ============================================================================
+
+struct ReplayFrame {
+    uint64_t time = 0;          // recording time the frame was rendered at, ns
+    size_t events = 0;
+    FrameTiming timing;
+};
+
+struct ReplayResult {
+    std::vector<ReplayFrame> frames;
+    LatencyHistogram layout;
+    LatencyHistogram render;
+    LatencyHistogram total;
+    double wallMs = 0;
+};
+
+// Feeds a recording to a headless application. Events are grouped into
+// frames on a fixed grid of recording time, and a frame is rendered for
+// every slot that received input, so the frames and their contents are the
+// same whether the replay runs at the recorded pace or as fast as possible.
+class InputReplay {
+public:
+    enum class Speed { Original, Maximum };
+    
+    InputReplay& speed(Speed s) { speed_ = s; return *this; }
+    InputReplay& frameInterval(std::chrono::nanoseconds interval) {
+        interval_ = std::max<uint64_t>(1, interval.count());
+        return *this;
+    }
+    
+    ReplayResult run(HeadlessApplication& app, const InputRecording& recording) const {
+        using clock = std::chrono::steady_clock;
+        ReplayResult result;
+        auto start = clock::now();
+        
+        const auto& events = recording.events();
+        size_t next = 0;
+        while (next < events.size()) {
+            uint64_t slotEnd = (events[next].time / interval_ + 1) * interval_;
+            ReplayFrame frame;
+            frame.time = slotEnd;
+            for (; next < events.size() && events[next].time < slotEnd; ++next) {
+                app.handleInput(events[next]);
+                frame.events++;
+            }
+            if (speed_ == Speed::Original)
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(slotEnd));
+            
+            frame.timing = app.renderFrame();
+            result.layout.add(frame.timing.layoutMs);
+            result.render.add(frame.timing.renderMs);
+            result.total.add(frame.timing.layoutMs + frame.timing.renderMs);
+            result.frames.push_back(frame);
+        }
+        
+        result.wallMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        return result;
+    }
+
+private:
+    Speed speed_ = Speed::Maximum;
+    uint64_t interval_ = 16666667;  // 60 Hz
+};
+
+} // namespace MetaUI
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MetaUI {
+
+// ============================================================================
+// Resource Bundles
+// ============================================================================
+
+// A view of bytes inside a registered bundle. Bundles are never unloaded,
+// so the data stays valid for the life of the process.
+struct ResourceData {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    
+    explicit operator bool() const { return data != nullptr; }
+};
+
+// Process-wide registry of packed resource bundles, addressed as
+// "res://<name>" anywhere a font or image path is accepted. Bundles are
+// produced by tools/metaui-pack.py, either as a C++ source that embeds the
+// archive and registers it during static initialization, or as a .pak file
+// mounted at startup with mountFile() (one open and one mmap).
+//
+// Archive layout (little-endian):
+//   "MUIPAK01"  u32 count  u32 reserved
+//   count x { u32 nameOffset, u32 nameSize, u32 dataOffset, u32 dataSize }
+//   names, then data blobs aligned to 16 bytes
+// Offsets are from the start of the archive.
+class Resources {
+public:
+    static constexpr const char* SCHEME = "res://";
+    
+    static bool isResourcePath(const std::string& path) {
+        return path.compare(0, 6, SCHEME) == 0;
+    }
+    
+    // Registers an archive already in memory. data must outlive the process
+    // (static storage or a mapping). Later bundles override earlier names.
+    static bool addBundle(const unsigned char* data, size_t size) {
+        if (size < 16 || std::memcmp(data, "MUIPAK01", 8) != 0) return false;
+        uint32_t count = read32(data + 8);
+        if (count > (size - 16) / 16) return false;
+        
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (uint32_t i = 0; i < count; ++i) {
+            const unsigned char* entry = data + 16 + i * 16;
+            uint32_t nameOffset = read32(entry), nameSize = read32(entry + 4);
+            uint32_t dataOffset = read32(entry + 8), dataSize = read32(entry + 12);
+            if ((uint64_t)nameOffset + nameSize > size || (uint64_t)dataOffset + dataSize > size) {
+                return false;
+            }
+            std::string name(reinterpret_cast<const char*>(data + nameOffset), nameSize);
+            reg.entries[name] = ResourceData{data + dataOffset, dataSize};
+        }
+        return true;
+    }
+    
+    // Maps a .pak archive read-only and registers it.
+    static bool mountFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < 16) {
+            close(fd);
+            return false;
+        }
+        void* memory = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) return false;
+        
+        if (!addBundle(static_cast<const unsigned char*>(memory), (size_t)st.st_size)) {
+            munmap(memory, (size_t)st.st_size);
+            return false;
+        }
+        return true;
+    }
+    
+    // Accepts "res://name" or a bare name.
+    static ResourceData find(const std::string& path) {
+        std::string name = isResourcePath(path) ? path.substr(6) : path;
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto it = reg.entries.find(name);
+        return it != reg.entries.end() ? it->second : ResourceData{};
+    }
+    
+    static std::vector<std::string> names() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        std::vector<std::string> result;
+        for (const auto& entry : reg.entries) result.push_back(entry.first);
+        return result;
+    }
+
+private:
+    struct Registry {
+        std::mutex mutex;
+        std::unordered_map<std::string, ResourceData> entries;
+    };
+    
+    // Function-local so generated bundles can register from static
+    // initializers in any translation unit.
+    static Registry& registry() {
+        static Registry reg;
+        return reg;
+    }
+    
+    static uint32_t read32(const unsigned char* p) {
+        return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+};
+
+// Instantiated by generated bundle sources.
+struct ResourceBundleRegistration {
+    ResourceBundleRegistration(const unsigned char* data, size_t size) {
+        Resources::addBundle(data, size);
+    }
+};
+
+} // namespace MetaUI
@@ -0,0 +1,1257 @@
+#pragma once
+
+#include "msdf.hpp"
+#include "resources.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace MetaUI {
+
+// ============================================================================
+// SVG Images
+// ============================================================================
+
+// A parsed SVG document reduced to filled and stroked paths: path, rect,
+// circle, ellipse, line, polyline and polygon inside nested groups with
+// transforms, solid colors and linear/radial gradients, fill-rule, stroke
+// width and caps, and opacity (group opacity is folded into children).
+// Text, filters, masks, clip paths, patterns and <use> are ignored.
+//
+// Parsing happens once; rasterize() is const and thread safe, so one
+// document can be rendered at several sizes concurrently.
+class SvgImage {
+public:
+    static std::shared_ptr<const SvgImage> parse(std::string_view text) {
+        auto image = std::shared_ptr<SvgImage>(new SvgImage());
+        Parser parser(*image);
+        if (!parser.run(text)) return nullptr;
+        return image;
+    }
+    
+    // File path or "res://" resource.
+    static std::shared_ptr<const SvgImage> load(const std::string& path) {
+        if (Resources::isResourcePath(path)) {
+            ResourceData res = Resources::find(path);
+            if (!res) return nullptr;
+            return parse(std::string_view(reinterpret_cast<const char*>(res.data), res.size));
+        }
+        
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return nullptr;
+        std::string text;
+        char buffer[16384];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) text.append(buffer, n);
+        fclose(file);
+        return parse(text);
+    }
+    
+    static bool isSvgPath(const std::string& path) {
+        size_t n = path.size();
+        return n > 4 && path[n - 4] == '.' && std::tolower((unsigned char)path[n - 3]) == 's' &&
+               std::tolower((unsigned char)path[n - 2]) == 'v' &&
+               std::tolower((unsigned char)path[n - 1]) == 'g';
+    }
+    
+    // Intrinsic size in pixels (width/height attributes, else the viewBox).
+    float width() const { return width_; }
+    float height() const { return height_; }
+    
+    // Straight-alpha RGBA8, width * height * 4 bytes. The viewBox is fitted
+    // centered when preserveAspect is set, otherwise stretched to fill.
+    std::vector<unsigned char> rasterize(int width, int height, bool preserveAspect = true) const {
+        std::vector<float> canvas((size_t)width * height * 4, 0.0f);
+        float sx = width / viewW_, sy = height / viewH_;
+        if (preserveAspect) sx = sy = std::min(sx, sy);
+        Matrix view = {sx, 0, 0, sy, (width - viewW_ * sx) / 2 - viewX_ * sx, (height - viewH_ * sy) / 2 - viewY_ * sy};
+        
+        Coverage coverage(width, height);
+        std::vector<Vec> points;
+        for (const Shape& shape : shapes_) {
+            Matrix m = view * shape.transform;
+            float scale = std::sqrt(std::fabs(m.a * m.d - m.b * m.c));
+            
+            if (shape.fill.type != Paint::None) {
+                coverage.begin();
+                for (const auto& path : shape.paths) {
+                    flatten(path, m, scale, points);
+                    if (points.size() < 2) continue;
+                    for (size_t i = 0; i + 1 < points.size(); ++i) coverage.line(points[i], points[i + 1]);
+                    coverage.line(points.back(), points.front());
+                }
+                composite(canvas, width, coverage, shape.evenOdd, shape.fill, shape.fillOpacity * shape.opacity, shape, m);
+            }
+            
+            if (shape.stroke.type != Paint::None && shape.strokeWidth > 0) {
+                float halfWidth = shape.strokeWidth * scale / 2;
+                coverage.begin();
+                for (const auto& path : shape.paths) {
+                    flatten(path, m, scale, points);
+                    if (path.closed && points.size() > 1) points.push_back(points.front());
+                    strokePolyline(coverage, points, halfWidth, path.closed, shape.lineCap);
+                }
+                composite(canvas, width, coverage, false, shape.stroke, shape.strokeOpacity * shape.opacity, shape, m);
+            }
+        }
+        
+        std::vector<unsigned char> out(canvas.size());
+        for (size_t i = 0; i < canvas.size(); i += 4) {
+            float a = canvas[i + 3];
+            float inv = a > 0 ? 1.0f / a : 0.0f;
+            for (int c = 0; c < 3; ++c) out[i + c] = toByte(canvas[i + c] * inv);
+            out[i + 3] = toByte(a);
+        }
+        return out;
+    }
+    
+    // Filled outlines in viewBox units (y down), e.g. for
+    // IconAtlas::addShape(name, svg.outline(), svg.outlineSize()).
+    MsdfShape outline() const {
+        MsdfShape shape;
+        float size = outlineSize();
+        Matrix view = {1, 0, 0, 1, (size - viewW_) / 2 - viewX_, (size - viewH_) / 2 - viewY_};
+        for (const Shape& s : shapes_) {
+            if (s.fill.type == Paint::None) continue;
+            Matrix m = view * s.transform;
+            for (const auto& path : s.paths) {
+                if (path.points.size() < 4) continue;
+                Vec p = m.apply(path.points[0]);
+                shape.moveTo(p.x, p.y);
+                for (size_t i = 1; i + 2 < path.points.size(); i += 3) {
+                    Vec c1 = m.apply(path.points[i]), c2 = m.apply(path.points[i + 1]);
+                    Vec e = m.apply(path.points[i + 2]);
+                    shape.cubicTo(c1.x, c1.y, c2.x, c2.y, e.x, e.y);
+                }
+                shape.close();
+            }
+        }
+        return shape;
+    }
+    
+    float outlineSize() const { return std::max(viewW_, viewH_); }
+
+private:
+    struct Vec {
+        float x = 0, y = 0;
+    };
+    
+    struct Matrix {
+        float a = 1, b = 0, c = 0, d = 1, e = 0, f = 0;
+        
+        Vec apply(Vec p) const { return {a * p.x + c * p.y + e, b * p.x + d * p.y + f}; }
+        Matrix operator*(const Matrix& o) const {
+            return {a * o.a + c * o.b, b * o.a + d * o.b,
+                    a * o.c + c * o.d, b * o.c + d * o.d,
+                    a * o.e + c * o.f + e, b * o.e + d * o.f + f};
+        }
+        Matrix inverse() const {
+            float det = a * d - b * c;
+            if (det == 0) return {};
+            float i = 1 / det;
+            return {d * i, -b * i, -c * i, a * i, (c * f - d * e) * i, (b * e - a * f) * i};
+        }
+    };
+    
+    struct Gradient {
+        bool radial = false;
+        bool userSpace = false;
+        float x1 = 0, y1 = 0, x2 = 1, y2 = 0;   // linear
+        float cx = 0.5f, cy = 0.5f, r = 0.5f;   // radial
+        Matrix transform;
+        std::string href;
+        std::vector<std::pair<float, uint32_t>> stops;  // offset, RGBA
+        float lut[256][4];                      // premultiplied, filled on resolve
+    };
+    
+    struct Paint {
+        enum Type : uint8_t { None, Solid, Gradient } type = None;
+        uint32_t rgba = 0xFF;
+        std::string ref;                        // gradient id until resolved
+        const SvgImage::Gradient* gradient = nullptr;
+    };
+    
+    // Cubic Bezier path: start point, then three points per segment.
+    struct Path {
+        std::vector<Vec> points;
+        bool closed = false;
+    };
+    
+    enum class LineCap : uint8_t { Butt, Round, Square };
+    
+    struct Shape {
+        std::vector<Path> paths;
+        Matrix transform;
+        Paint fill, stroke;
+        float fillOpacity = 1, strokeOpacity = 1, opacity = 1;
+        float strokeWidth = 1;
+        bool evenOdd = false;
+        LineCap lineCap = LineCap::Butt;
+        float minX = 0, minY = 0, maxX = 0, maxY = 0;   // local bounds
+    };
+    
+    std::vector<Shape> shapes_;
+    std::unordered_map<std::string, std::unique_ptr<Gradient>> gradients_;
+    float width_ = 0, height_ = 0;
+    float viewX_ = 0, viewY_ = 0, viewW_ = 0, viewH_ = 0;
+    
+    SvgImage() = default;
+    
+    static unsigned char toByte(float v) {
+        return (unsigned char)std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f);
+    }
+    
+    // Locale-independent SVG number; advances i past separators and the number.
+    static bool readNumber(std::string_view s, size_t& i, float& out) {
+        while (i < s.size() && (std::isspace((unsigned char)s[i]) || s[i] == ',')) ++i;
+        size_t start = i;
+        double sign = 1, value = 0;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-')) sign = s[i++] == '-' ? -1 : 1;
+        bool digits = false;
+        while (i < s.size() && std::isdigit((unsigned char)s[i])) {
+            value = value * 10 + (s[i++] - '0');
+            digits = true;
+        }
+        if (i < s.size() && s[i] == '.') {
+            ++i;
+            double scale = 0.1;
+            while (i < s.size() && std::isdigit((unsigned char)s[i])) {
+                value += (s[i++] - '0') * scale;
+                scale *= 0.1;
+                digits = true;
+            }
+        }
+        if (!digits) {
+            i = start;
+            return false;
+        }
+        if (i + 1 < s.size() && (s[i] == 'e' || s[i] == 'E') &&
+            (std::isdigit((unsigned char)s[i + 1]) || s[i + 1] == '-' || s[i + 1] == '+')) {
+            ++i;
+            int expSign = 1, exponent = 0;
+            if (s[i] == '+' || s[i] == '-') expSign = s[i++] == '-' ? -1 : 1;
+            while (i < s.size() && std::isdigit((unsigned char)s[i])) {
+                exponent = std::min(exponent * 10 + (s[i++] - '0'), 1000);
+            }
+            value *= std::pow(10.0, expSign * exponent);
+        }
+        // Values that overflow a float would turn coordinates into NaN.
+        out = (float)(sign * value);
+        if (!std::isfinite(out)) {
+            i = start;
+            return false;
+        }
+        return true;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Rasterization
+    // ------------------------------------------------------------------------
+    
+    // Signed-area coverage accumulation (as in font-rs): each edge adds its
+    // exact area contribution to the cells it crosses and a running sum per
+    // row yields the winding-weighted coverage of every pixel.
+    class Coverage {
+    public:
+        Coverage(int width, int height)
+            : width_(width), height_(height), stride_(width + 2), cells_((size_t)stride_ * height, 0.0f) {}
+        
+        void begin() {
+            for (int y = minY_; y < maxY_; ++y) {
+                std::fill(&cells_[(size_t)y * stride_], &cells_[(size_t)y * stride_] + stride_, 0.0f);
+            }
+            minY_ = height_;
+            maxY_ = 0;
+        }
+        
+        void line(Vec p0, Vec p1) {
+            // Non-finite points (from overflowing transforms or widths)
+            // can't be placed in a row, so their edges are dropped.
+            if (!std::isfinite(p0.x) || !std::isfinite(p0.y) ||
+                !std::isfinite(p1.x) || !std::isfinite(p1.y)) return;
+            if (p0.y == p1.y) return;
+            float dir = 1;
+            if (p0.y > p1.y) {
+                std::swap(p0, p1);
+                dir = -1;
+            }
+            // Everything left of the canvas accumulates into column 0.
+            p0.x = std::clamp(p0.x, 0.0f, (float)width_);
+            p1.x = std::clamp(p1.x, 0.0f, (float)width_);
+            float dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+            if (!std::isfinite(dxdy)) return;
+            float x = p0.x;
+            int y0 = (int)std::clamp(p0.y, 0.0f, (float)height_);
+            if (p0.y < 0) x = std::clamp(x - p0.y * dxdy, 0.0f, (float)width_);
+            int y1 = (int)std::ceil(std::clamp(p1.y, 0.0f, (float)height_));
+            minY_ = std::min(minY_, y0);
+            maxY_ = std::max(maxY_, y1);
+            
+            for (int y = y0; y < y1; ++y) {
+                float* row = &cells_[(size_t)y * stride_];
+                float dy = std::min((float)(y + 1), p1.y) - std::max((float)y, p0.y);
+                float xnext = std::clamp(x + dxdy * dy, 0.0f, (float)width_);
+                float d = dy * dir;
+                float xa = std::min(x, xnext), xb = std::max(x, xnext);
+                float xaFloor = std::floor(xa);
+                int xai = (int)xaFloor;
+                float xbCeil = std::ceil(xb);
+                int xbi = (int)xbCeil;
+                if (xbi <= xai + 1) {
+                    float xmf = 0.5f * (x + xnext) - xaFloor;
+                    row[xai] += d - d * xmf;
+                    row[xai + 1] += d * xmf;
+                } else {
+                    float s = 1.0f / (xb - xa);
+                    float xaf = xa - xaFloor;
+                    float a0 = 0.5f * s * (1 - xaf) * (1 - xaf);
+                    float xbf = xb - xbCeil + 1;
+                    float am = 0.5f * s * xbf * xbf;
+                    row[xai] += d * a0;
+                    if (xbi == xai + 2) {
+                        row[xai + 1] += d * (1 - a0 - am);
+                    } else {
+                        float a1 = s * (1.5f - xaf);
+                        row[xai + 1] += d * (a1 - a0);
+                        for (int xi = xai + 2; xi < xbi - 1; ++xi) row[xi] += d * s;
+                        float a2 = a1 + (xbi - xai - 3) * s;
+                        row[xbi - 1] += d * (1 - a2 - am);
+                    }
+                    row[xbi] += d * am;
+                }
+                x = xnext;
+            }
+        }
+        
+        int minY() const { return minY_; }
+        int maxY() const { return maxY_; }
+        const float* row(int y) const { return &cells_[(size_t)y * stride_]; }
+    
+    private:
+        int width_, height_, stride_;
+        std::vector<float> cells_;
+        int minY_ = 0, maxY_ = 0;
+    };
+    
+    // Flattens to pixel space with segments of about 2px.
+    static void flatten(const Path& path, const Matrix& m, float scale, std::vector<Vec>& out) {
+        out.clear();
+        if (path.points.empty()) return;
+        out.push_back(m.apply(path.points[0]));
+        for (size_t i = 1; i + 2 < path.points.size(); i += 3) {
+            Vec p0 = path.points[i - 1], p1 = path.points[i], p2 = path.points[i + 1], p3 = path.points[i + 2];
+            float length = (std::hypot(p1.x - p0.x, p1.y - p0.y) + std::hypot(p2.x - p1.x, p2.y - p1.y) +
+                            std::hypot(p3.x - p2.x, p3.y - p2.y)) * scale;
+            bool straight = std::fabs((p3.x - p0.x) * (p1.y - p0.y) - (p3.y - p0.y) * (p1.x - p0.x)) < 1e-6f &&
+                            std::fabs((p3.x - p0.x) * (p2.y - p0.y) - (p3.y - p0.y) * (p2.x - p0.x)) < 1e-6f;
+            int steps = straight ? 1 : (int)std::clamp(std::ceil(length / 2), 1.0f, 128.0f);
+            for (int k = 1; k <= steps; ++k) {
+                float t = (float)k / steps, s = 1 - t;
+                Vec p{s * s * s * p0.x + 3 * s * s * t * p1.x + 3 * s * t * t * p2.x + t * t * t * p3.x,
+                      s * s * s * p0.y + 3 * s * s * t * p1.y + 3 * s * t * t * p2.y + t * t * t * p3.y};
+                out.push_back(m.apply(p));
+            }
+        }
+    }
+    
+    // Strokes as the union of one quad per segment and a disc per vertex
+    // (round joins; miter and bevel joins are drawn round too). All pieces
+    // share one orientation so overlaps add up and clamp under nonzero.
+    static void strokePolyline(Coverage& coverage, const std::vector<Vec>& points, float hw,
+                               bool closed, LineCap cap) {
+        if (points.empty() || !std::isfinite(hw)) return;
+        auto quad = [&](Vec a, Vec b, Vec c, Vec d) {
+            coverage.line(a, b);
+            coverage.line(b, c);
+            coverage.line(c, d);
+            coverage.line(d, a);
+        };
+        int discSteps = (int)std::clamp(std::ceil(hw * 2.5f), 8.0f, 48.0f);
+        auto disc = [&](Vec c) {
+            Vec prev{c.x + hw, c.y};
+            for (int i = 1; i <= discSteps; ++i) {
+                float angle = -2.0f * (float)M_PI * i / discSteps;
+                Vec next{c.x + hw * std::cos(angle), c.y + hw * std::sin(angle)};
+                coverage.line(prev, next);
+                prev = next;
+            }
+        };
+        
+        for (size_t i = 0; i + 1 < points.size(); ++i) {
+            Vec a = points[i], b = points[i + 1];
+            float dx = b.x - a.x, dy = b.y - a.y;
+            float len = std::hypot(dx, dy);
+            if (len == 0 || !std::isfinite(len)) continue;
+            Vec n{-dy / len * hw, dx / len * hw};
+            if (cap == LineCap::Square && !closed) {
+                Vec t{dx / len * hw, dy / len * hw};
+                if (i == 0) a = {a.x - t.x, a.y - t.y};
+                if (i + 2 == points.size()) b = {b.x + t.x, b.y + t.y};
+            }
+            quad({a.x + n.x, a.y + n.y}, {b.x + n.x, b.y + n.y}, {b.x - n.x, b.y - n.y}, {a.x - n.x, a.y - n.y});
+        }
+        for (size_t i = 0; i < points.size(); ++i) {
+            bool end = i == 0 || i + 1 == points.size();
+            if (!end || closed || cap == LineCap::Round) disc(points[i]);
+        }
+        if (points.size() == 1 && cap == LineCap::Round) disc(points[0]);
+    }
+    
+    void composite(std::vector<float>& canvas, int width, const Coverage& coverage, bool evenOdd,
+                   const Paint& paint, float opacity, const Shape& shape, const Matrix& m) const {
+        float solid[4];
+        Matrix toGradient;
+        if (paint.type == Paint::Solid) {
+            float a = (paint.rgba & 0xFF) / 255.0f * opacity;
+            solid[0] = (paint.rgba >> 24) / 255.0f * a;
+            solid[1] = ((paint.rgba >> 16) & 0xFF) / 255.0f * a;
+            solid[2] = ((paint.rgba >> 8) & 0xFF) / 255.0f * a;
+            solid[3] = a;
+        } else if (paint.gradient) {
+            Matrix units;
+            if (!paint.gradient->userSpace) {
+                units = {shape.maxX - shape.minX, 0, 0, shape.maxY - shape.minY, shape.minX, shape.minY};
+            }
+            toGradient = (m * units * paint.gradient->transform).inverse();
+        } else {
+            return;
+        }
+        
+        for (int y = coverage.minY(); y < coverage.maxY(); ++y) {
+            const float* cells = coverage.row(y);
+            float* out = &canvas[(size_t)y * width * 4];
+            float acc = 0;
+            for (int x = 0; x < width; ++x, out += 4) {
+                acc += cells[x];
+                float v = std::fabs(acc);
+                float cov;
+                if (evenOdd) {
+                    float t = std::fmod(v, 2.0f);
+                    cov = t > 1 ? 2 - t : t;
+                } else {
+                    cov = std::min(1.0f, v);
+                }
+                if (cov < 1.0f / 512) continue;
+                
+                const float* src = solid;
+                float sampled[4];
+                if (paint.type == Paint::Gradient) {
+                    const Gradient& g = *paint.gradient;
+                    Vec p = toGradient.apply({x + 0.5f, y + 0.5f});
+                    float t;
+                    if (g.radial) {
+                        t = std::hypot(p.x - g.cx, p.y - g.cy) / std::max(g.r, 1e-6f);
+                    } else {
+                        float dx = g.x2 - g.x1, dy = g.y2 - g.y1;
+                        float len2 = dx * dx + dy * dy;
+                        t = len2 > 0 ? ((p.x - g.x1) * dx + (p.y - g.y1) * dy) / len2 : 0;
+                    }
+                    t = t > 0 ? std::min(t, 1.0f) : 0.0f;  // NaN reads stop 0
+                    const float* c = g.lut[(int)(t * 255.0f + 0.5f)];
+                    for (int k = 0; k < 4; ++k) sampled[k] = c[k] * opacity;
+                    src = sampled;
+                }
+                float inv = 1 - src[3] * cov;
+                for (int k = 0; k < 4; ++k) out[k] = src[k] * cov + out[k] * inv;
+            }
+        }
+    }
+    
+    // ------------------------------------------------------------------------
+    // Parsing
+    // ------------------------------------------------------------------------
+    
+    class Parser {
+    public:
+        explicit Parser(SvgImage& image) : image_(image) {}
+        
+        bool run(std::string_view text) {
+            text_ = text;
+            states_.push_back(State());
+            while (pos_ < text_.size()) {
+                size_t lt = text_.find('<', pos_);
+                if (lt == std::string_view::npos) break;
+                pos_ = lt + 1;
+                if (startsWith("!--")) {
+                    skipPast("-->");
+                } else if (startsWith("![CDATA[")) {
+                    skipPast("]]>");
+                } else if (startsWith("?") || startsWith("!")) {
+                    skipPast(">");
+                } else if (startsWith("/")) {
+                    ++pos_;
+                    std::string_view name = readName();
+                    skipPast(">");
+                    endElement(name);
+                } else {
+                    if (!readElement()) return false;
+                }
+            }
+            if (!sawRoot_) return false;
+            finish();
+            return true;
+        }
+    
+    private:
+        struct State {
+            Matrix transform;
+            Paint fill{Paint::Solid, 0x000000FF, {}, nullptr};
+            Paint stroke;
+            float fillOpacity = 1, strokeOpacity = 1, opacity = 1;
+            float strokeWidth = 1;
+            bool evenOdd = false;
+            bool visible = true;
+            LineCap lineCap = LineCap::Butt;
+            uint32_t currentColor = 0x000000FF;
+        };
+        
+        SvgImage& image_;
+        std::string_view text_;
+        size_t pos_ = 0;
+        std::vector<State> states_;
+        std::vector<std::pair<std::string_view, std::string_view>> attrs_;
+        int skipDepth_ = 0;     // inside an ignored subtree
+        int defsDepth_ = 0;     // inside <defs>: gradients only
+        Gradient* gradient_ = nullptr;
+        bool sawRoot_ = false;
+        
+        bool startsWith(const char* s) const { return text_.substr(pos_, std::strlen(s)) == s; }
+        
+        void skipPast(const char* s) {
+            size_t at = text_.find(s, pos_);
+            pos_ = at == std::string_view::npos ? text_.size() : at + std::strlen(s);
+        }
+        
+        void skipSpace() {
+            while (pos_ < text_.size() && std::isspace((unsigned char)text_[pos_])) ++pos_;
+        }
+        
+        std::string_view readName() {
+            size_t start = pos_;
+            while (pos_ < text_.size() && !std::isspace((unsigned char)text_[pos_]) &&
+                   text_[pos_] != '>' && text_[pos_] != '/' && text_[pos_] != '=') {
+                ++pos_;
+            }
+            return text_.substr(start, pos_ - start);
+        }
+        
+        bool readElement() {
+            std::string_view name = readName();
+            attrs_.clear();
+            bool selfClosing = false;
+            for (;;) {
+                skipSpace();
+                if (pos_ >= text_.size()) return false;
+                if (text_[pos_] == '>') {
+                    ++pos_;
+                    break;
+                }
+                if (text_[pos_] == '/') {
+                    selfClosing = true;
+                    ++pos_;
+                    continue;
+                }
+                std::string_view key = readName();
+                skipSpace();
+                std::string_view value;
+                if (pos_ < text_.size() && text_[pos_] == '=') {
+                    ++pos_;
+                    skipSpace();
+                    if (pos_ >= text_.size()) return false;
+                    char quote = text_[pos_];
+                    if (quote != '"' && quote != '\'') return false;
+                    size_t end = text_.find(quote, pos_ + 1);
+                    if (end == std::string_view::npos) return false;
+                    value = text_.substr(pos_ + 1, end - pos_ - 1);
+                    pos_ = end + 1;
+                }
+                if (key.empty()) return false;
+                attrs_.emplace_back(key, value);
+            }
+            startElement(stripPrefix(name));
+            if (selfClosing) endElement(name);
+            return true;
+        }
+        
+        static std::string_view stripPrefix(std::string_view name) {
+            size_t colon = name.find(':');
+            return colon == std::string_view::npos ? name : name.substr(colon + 1);
+        }
+        
+        std::string_view attr(std::string_view key) const {
+            for (const auto& [k, v] : attrs_) if (k == key) return v;
+            return {};
+        }
+        
+        void startElement(std::string_view name) {
+            static const char* ignored[] = {
+                "clipPath", "mask", "symbol", "pattern", "text", "marker", "style",
+                "title", "desc", "metadata", "foreignObject", "filter", nullptr
+            };
+            if (skipDepth_ > 0) {
+                ++skipDepth_;
+                return;
+            }
+            for (int i = 0; ignored[i]; ++i) {
+                if (name == ignored[i]) {
+                    skipDepth_ = 1;
+                    return;
+                }
+            }
+            
+            states_.push_back(states_.back());
+            State& state = states_.back();
+            for (const auto& [k, v] : attrs_) applyAttribute(state, k, v);
+            
+            if (name == "svg") {
+                if (!sawRoot_) readRoot();
+                sawRoot_ = true;
+            } else if (name == "defs") {
+                ++defsDepth_;
+            } else if (name == "linearGradient" || name == "radialGradient") {
+                readGradient(name == "radialGradient");
+            } else if (name == "stop") {
+                readStop();
+            } else if (defsDepth_ == 0 && state.visible) {
+                readShape(name, state);
+            }
+        }
+        
+        void endElement(std::string_view name) {
+            if (skipDepth_ > 0) {
+                --skipDepth_;
+                return;
+            }
+            name = stripPrefix(name);
+            if (name == "defs") defsDepth_ = std::max(0, defsDepth_ - 1);
+            if (name == "linearGradient" || name == "radialGradient") gradient_ = nullptr;
+            if (states_.size() > 1) states_.pop_back();
+        }
+        
+        // --------------------------------------------------------------------
+        // Attributes and presentation properties
+        // --------------------------------------------------------------------
+        
+        void applyAttribute(State& state, std::string_view key, std::string_view value) {
+            if (key == "style") {
+                size_t start = 0;
+                while (start < value.size()) {
+                    size_t semi = value.find(';', start);
+                    if (semi == std::string_view::npos) semi = value.size();
+                    std::string_view decl = value.substr(start, semi - start);
+                    size_t colon = decl.find(':');
+                    if (colon != std::string_view::npos) {
+                        applyProperty(state, trim(decl.substr(0, colon)), trim(decl.substr(colon + 1)));
+                    }
+                    start = semi + 1;
+                }
+            } else if (key == "transform") {
+                state.transform = state.transform * parseTransform(value);
+            } else {
+                applyProperty(state, key, value);
+            }
+        }
+        
+        void applyProperty(State& state, std::string_view key, std::string_view value) {
+            if (key == "fill") {
+                state.fill = parsePaint(value, state);
+            } else if (key == "stroke") {
+                state.stroke = parsePaint(value, state);
+            } else if (key == "fill-opacity") {
+                state.fillOpacity = clampedNumber(value);
+            } else if (key == "stroke-opacity") {
+                state.strokeOpacity = clampedNumber(value);
+            } else if (key == "opacity") {
+                state.opacity *= clampedNumber(value);
+            } else if (key == "stroke-width") {
+                state.strokeWidth = parseNumber(value);
+            } else if (key == "fill-rule") {
+                state.evenOdd = value == "evenodd";
+            } else if (key == "stroke-linecap") {
+                state.lineCap = value == "round" ? LineCap::Round :
+                                value == "square" ? LineCap::Square : LineCap::Butt;
+            } else if (key == "color") {
+                parseColor(value, state.currentColor);
+            } else if ((key == "display" && value == "none") || (key == "visibility" && value == "hidden")) {
+                state.visible = false;
+            }
+        }
+        
+        static std::string_view trim(std::string_view s) {
+            while (!s.empty() && std::isspace((unsigned char)s.front())) s.remove_prefix(1);
+            while (!s.empty() && std::isspace((unsigned char)s.back())) s.remove_suffix(1);
+            return s;
+        }
+        
+        static float clampedNumber(std::string_view s) {
+            float v = parseNumber(s);
+            if (!s.empty() && s.back() == '%') v /= 100;
+            return std::clamp(v, 0.0f, 1.0f);
+        }
+        
+        Paint parsePaint(std::string_view value, const State& state) {
+            value = trim(value);
+            Paint paint;
+            if (value.empty() || value == "none" || value == "transparent") return paint;
+            if (value.substr(0, 4) == "url(") {
+                size_t hash = value.find('#'), close = value.find(')');
+                if (hash != std::string_view::npos && close != std::string_view::npos && hash < close) {
+                    paint.type = Paint::Gradient;
+                    paint.ref = std::string(value.substr(hash + 1, close - hash - 1));
+                }
+                return paint;
+            }
+            if (value == "currentColor") {
+                paint.type = Paint::Solid;
+                paint.rgba = state.currentColor;
+                return paint;
+            }
+            if (parseColor(value, paint.rgba)) paint.type = Paint::Solid;
+            return paint;
+        }
+        
+        static bool parseColor(std::string_view value, uint32_t& rgba) {
+            value = trim(value);
+            if (!value.empty() && value[0] == '#') {
+                unsigned v = 0;
+                size_t digits = value.size() - 1;
+                for (size_t i = 1; i < value.size(); ++i) {
+                    char c = (char)std::tolower((unsigned char)value[i]);
+                    if (!std::isxdigit((unsigned char)c)) return false;
+                    v = v * 16 + (unsigned)(c <= '9' ? c - '0' : c - 'a' + 10);
+                }
+                if (digits == 3) {
+                    unsigned r = (v >> 8) & 0xF, g = (v >> 4) & 0xF, b = v & 0xF;
+                    rgba = (r * 17u) << 24 | (g * 17u) << 16 | (b * 17u) << 8 | 0xFF;
+                } else if (digits == 6) {
+                    rgba = v << 8 | 0xFF;
+                } else {
+                    return false;
+                }
+                return true;
+            }
+            if (value.substr(0, 4) == "rgb(" || value.substr(0, 5) == "rgba(") {
+                size_t open = value.find('(');
+                std::string_view args = value.substr(open + 1);
+                float channel[4] = {0, 0, 0, 255};
+                for (int i = 0; i < 4 && !args.empty(); ++i) {
+                    size_t end = args.find_first_of(",)");
+                    std::string_view part = trim(args.substr(0, end));
+                    float v = parseNumber(part);
+                    if (i < 3) channel[i] = !part.empty() && part.back() == '%' ? v * 2.55f : v;
+                    else channel[i] = (!part.empty() && part.back() == '%' ? v / 100 : v) * 255;
+                    if (end == std::string_view::npos || args[end] == ')') break;
+                    args = args.substr(end + 1);
+                }
+                rgba = 0;
+                for (int i = 0; i < 4; ++i) {
+                    rgba = rgba << 8 | (uint32_t)std::clamp((int)std::lround(channel[i]), 0, 255);
+                }
+                return true;
+            }
+            static const std::pair<const char*, uint32_t> named[] = {
+                {"black", 0x000000FF}, {"white", 0xFFFFFFFF}, {"red", 0xFF0000FF},
+                {"green", 0x008000FF}, {"blue", 0x0000FFFF}, {"yellow", 0xFFFF00FF},
+                {"cyan", 0x00FFFFFF}, {"aqua", 0x00FFFFFF}, {"magenta", 0xFF00FFFF},
+                {"fuchsia", 0xFF00FFFF}, {"gray", 0x808080FF}, {"grey", 0x808080FF},
+                {"silver", 0xC0C0C0FF}, {"maroon", 0x800000FF}, {"olive", 0x808000FF},
+                {"lime", 0x00FF00FF}, {"teal", 0x008080FF}, {"navy", 0x000080FF},
+                {"purple", 0x800080FF}, {"orange", 0xFFA500FF},
+            };
+            for (const auto& [n, v] : named) {
+                if (value == n) {
+                    rgba = v;
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        // Locale-independent number at the start of s; units are ignored.
+        static float parseNumber(std::string_view s) {
+            size_t i = 0;
+            float v;
+            return readNumber(trim(s), i, v) ? v : 0.0f;
+        }
+        
+        static std::vector<float> readNumbers(std::string_view s) {
+            std::vector<float> values;
+            size_t i = 0;
+            float v;
+            while (readNumber(s, i, v)) values.push_back(v);
+            return values;
+        }
+        
+        static Matrix parseTransform(std::string_view s) {
+            Matrix result;
+            size_t i = 0;
+            while (i < s.size()) {
+                while (i < s.size() && (std::isspace((unsigned char)s[i]) || s[i] == ',')) ++i;
+                size_t open = s.find('(', i), close = s.find(')', i);
+                if (open == std::string_view::npos || close == std::string_view::npos || close < open) break;
+                std::string_view name = trim(s.substr(i, open - i));
+                std::vector<float> v = readNumbers(s.substr(open + 1, close - open - 1));
+                i = close + 1;
+                
+                Matrix m;
+                if (name == "matrix" && v.size() == 6) {
+                    m = {v[0], v[1], v[2], v[3], v[4], v[5]};
+                } else if (name == "translate" && !v.empty()) {
+                    m.e = v[0];
+                    m.f = v.size() > 1 ? v[1] : 0;
+                } else if (name == "scale" && !v.empty()) {
+                    m.a = v[0];
+                    m.d = v.size() > 1 ? v[1] : v[0];
+                } else if (name == "rotate" && !v.empty()) {
+                    float r = v[0] * (float)M_PI / 180;
+                    m = {std::cos(r), std::sin(r), -std::sin(r), std::cos(r), 0, 0};
+                    if (v.size() == 3) {
+                        m = Matrix{1, 0, 0, 1, v[1], v[2]} * m * Matrix{1, 0, 0, 1, -v[1], -v[2]};
+                    }
+                } else if (name == "skewX" && !v.empty()) {
+                    m.c = std::tan(v[0] * (float)M_PI / 180);
+                } else if (name == "skewY" && !v.empty()) {
+                    m.b = std::tan(v[0] * (float)M_PI / 180);
+                }
+                result = result * m;
+            }
+            return result;
+        }
+        
+        // --------------------------------------------------------------------
+        // Elements
+        // --------------------------------------------------------------------
+        
+        float number(std::string_view key, float fallback = 0) const {
+            std::string_view v = attr(key);
+            return v.empty() ? fallback : parseNumber(v);
+        }
+        
+        // Gradient coordinate: fractions and percentages both mean 0..1.
+        float fraction(std::string_view key, float fallback) const {
+            std::string_view v = trim(attr(key));
+            if (v.empty()) return fallback;
+            float n = parseNumber(v);
+            return v.back() == '%' ? n / 100 : n;
+        }
+        
+        void readRoot() {
+            std::vector<float> box = readNumbers(attr("viewBox"));
+            float w = number("width"), h = number("height");
+            if (attr("width").find('%') != std::string_view::npos) w = 0;
+            if (attr("height").find('%') != std::string_view::npos) h = 0;
+            if (box.size() == 4 && box[2] > 0 && box[3] > 0) {
+                image_.viewX_ = box[0];
+                image_.viewY_ = box[1];
+                image_.viewW_ = box[2];
+                image_.viewH_ = box[3];
+            } else {
+                image_.viewW_ = w > 0 ? w : 100;
+                image_.viewH_ = h > 0 ? h : 100;
+            }
+            image_.width_ = w > 0 ? w : image_.viewW_;
+            image_.height_ = h > 0 ? h : image_.viewH_;
+        }
+        
+        void readGradient(bool radial) {
+            std::string id(attr("id"));
+            if (id.empty()) return;
+            auto g = std::make_unique<Gradient>();
+            g->radial = radial;
+            g->userSpace = attr("gradientUnits") == "userSpaceOnUse";
+            g->transform = parseTransform(attr("gradientTransform"));
+            std::string_view href = attr("href").empty() ? attr("xlink:href") : attr("href");
+            if (!href.empty() && href[0] == '#') g->href = std::string(href.substr(1));
+            if (radial) {
+                g->cx = fraction("cx", 0.5f);
+                g->cy = fraction("cy", 0.5f);
+                g->r = fraction("r", 0.5f);
+            } else {
+                g->x1 = fraction("x1", 0);
+                g->y1 = fraction("y1", 0);
+                g->x2 = fraction("x2", 1);
+                g->y2 = fraction("y2", 0);
+            }
+            gradient_ = g.get();
+            image_.gradients_[id] = std::move(g);
+        }
+        
+        void readStop() {
+            if (!gradient_) return;
+            float offset = fraction("offset", 0);
+            uint32_t color = 0x000000FF;
+            float opacity = 1;
+            auto apply = [&](std::string_view k, std::string_view v) {
+                if (k == "stop-color") parseColor(v, color);
+                else if (k == "stop-opacity") opacity = clampedNumber(v);
+            };
+            for (const auto& [k, v] : attrs_) {
+                if (k == "style") {
+                    size_t start = 0;
+                    while (start < v.size()) {
+                        size_t semi = v.find(';', start);
+                        if (semi == std::string_view::npos) semi = v.size();
+                        std::string_view decl = v.substr(start, semi - start);
+                        size_t colon = decl.find(':');
+                        if (colon != std::string_view::npos) apply(trim(decl.substr(0, colon)), trim(decl.substr(colon + 1)));
+                        start = semi + 1;
+                    }
+                } else {
+                    apply(k, v);
+                }
+            }
+            uint32_t alpha = (uint32_t)std::lround((color & 0xFF) * opacity);
+            gradient_->stops.emplace_back(std::clamp(offset, 0.0f, 1.0f), (color & 0xFFFFFF00) | alpha);
+        }
+        
+        void readShape(std::string_view name, const State& state) {
+            PathBuilder path;
+            if (name == "path") {
+                path.parse(attr("d"));
+            } else if (name == "rect") {
+                float x = number("x"), y = number("y"), w = number("width"), h = number("height");
+                float rx = number("rx", -1), ry = number("ry", -1);
+                if (rx < 0) rx = ry;
+                if (ry < 0) ry = rx;
+                path.rect(x, y, w, h, std::clamp(rx, 0.0f, w / 2), std::clamp(ry, 0.0f, h / 2));
+            } else if (name == "circle") {
+                float r = number("r");
+                path.ellipse(number("cx"), number("cy"), r, r);
+            } else if (name == "ellipse") {
+                path.ellipse(number("cx"), number("cy"), number("rx"), number("ry"));
+            } else if (name == "line") {
+                path.moveTo(number("x1"), number("y1"));
+                path.lineTo(number("x2"), number("y2"));
+            } else if (name == "polyline" || name == "polygon") {
+                std::vector<float> v = readNumbers(attr("points"));
+                for (size_t i = 0; i + 1 < v.size(); i += 2) {
+                    if (i == 0) path.moveTo(v[0], v[1]);
+                    else path.lineTo(v[i], v[i + 1]);
+                }
+                if (name == "polygon") path.close();
+            } else {
+                return;
+            }
+            if (path.paths.empty()) return;
+            
+            Shape shape;
+            shape.paths = std::move(path.paths);
+            shape.transform = state.transform;
+            shape.fill = state.fill;
+            shape.stroke = state.stroke;
+            shape.fillOpacity = state.fillOpacity;
+            shape.strokeOpacity = state.strokeOpacity;
+            shape.opacity = state.opacity;
+            shape.strokeWidth = state.strokeWidth;
+            shape.evenOdd = state.evenOdd;
+            shape.lineCap = state.lineCap;
+            bool first = true;
+            for (const auto& p : shape.paths) {
+                for (const auto& v : p.points) {
+                    shape.minX = first ? v.x : std::min(shape.minX, v.x);
+                    shape.minY = first ? v.y : std::min(shape.minY, v.y);
+                    shape.maxX = first ? v.x : std::max(shape.maxX, v.x);
+                    shape.maxY = first ? v.y : std::max(shape.maxY, v.y);
+                    first = false;
+                }
+            }
+            image_.shapes_.push_back(std::move(shape));
+        }
+        
+        // Resolves gradient references (including href stop inheritance)
+        // and bakes each gradient's color ramp.
+        void finish() {
+            for (auto& [id, g] : image_.gradients_) {
+                const Gradient* source = g.get();
+                for (int depth = 0; source->stops.empty() && !source->href.empty() && depth < 8; ++depth) {
+                    auto it = image_.gradients_.find(source->href);
+                    if (it == image_.gradients_.end()) break;
+                    source = it->second.get();
+                }
+                bakeRamp(*g, source->stops);
+            }
+            for (Shape& shape : image_.shapes_) {
+                for (Paint* paint : {&shape.fill, &shape.stroke}) {
+                    if (paint->type != Paint::Gradient) continue;
+                    auto it = image_.gradients_.find(paint->ref);
+                    if (it == image_.gradients_.end()) {
+                        paint->type = Paint::None;
+                    } else {
+                        paint->gradient = it->second.get();
+                    }
+                }
+            }
+        }
+        
+        static void bakeRamp(Gradient& g, std::vector<std::pair<float, uint32_t>> stops) {
+            if (stops.empty()) stops.emplace_back(0.0f, 0x00000000);
+            for (size_t i = 1; i < stops.size(); ++i) {
+                stops[i].first = std::max(stops[i].first, stops[i - 1].first);
+            }
+            auto channel = [](uint32_t c, int k) { return ((c >> (24 - 8 * k)) & 0xFF) / 255.0f; };
+            size_t next = 0;
+            for (int i = 0; i < 256; ++i) {
+                float t = i / 255.0f;
+                while (next < stops.size() && stops[next].first < t) ++next;
+                uint32_t a, b;
+                float f = 0;
+                if (next == 0) {
+                    a = b = stops.front().second;
+                } else if (next == stops.size()) {
+                    a = b = stops.back().second;
+                } else {
+                    a = stops[next - 1].second;
+                    b = stops[next].second;
+                    float span = stops[next].first - stops[next - 1].first;
+                    f = span > 0 ? (t - stops[next - 1].first) / span : 1;
+                }
+                float alpha = channel(a, 3) + (channel(b, 3) - channel(a, 3)) * f;
+                for (int k = 0; k < 3; ++k) {
+                    g.lut[i][k] = (channel(a, k) + (channel(b, k) - channel(a, k)) * f) * alpha;
+                }
+                g.lut[i][3] = alpha;
+            }
+        }
+    };
+    
+    // ------------------------------------------------------------------------
+    // Path data
+    // ------------------------------------------------------------------------
+    
+    // Builds cubic-only paths from SVG path syntax and basic shapes; lines
+    // and quadratics are raised to cubics, arcs split into <= 90 degree
+    // cubic segments.
+    struct PathBuilder {
+        std::vector<Path> paths;
+        Vec pen, start;
+        
+        void moveTo(float x, float y) {
+            paths.emplace_back();
+            paths.back().points.push_back({x, y});
+            pen = start = {x, y};
+        }
+        
+        void lineTo(float x, float y) {
+            ensurePath();
+            cubicTo(pen.x + (x - pen.x) / 3, pen.y + (y - pen.y) / 3,
+                    pen.x + (x - pen.x) * 2 / 3, pen.y + (y - pen.y) * 2 / 3, x, y);
+        }
+        
+        void quadTo(float cx, float cy, float x, float y) {
+            cubicTo(pen.x + (cx - pen.x) * 2 / 3, pen.y + (cy - pen.y) * 2 / 3,
+                    x + (cx - x) * 2 / 3, y + (cy - y) * 2 / 3, x, y);
+        }
+        
+        void cubicTo(float c1x, float c1y, float c2x, float c2y, float x, float y) {
+            ensurePath();
+            auto& pts = paths.back().points;
+            pts.push_back({c1x, c1y});
+            pts.push_back({c2x, c2y});
+            pts.push_back({x, y});
+            pen = {x, y};
+        }
+        
+        void close() {
+            if (paths.empty()) return;
+            if (pen.x != start.x || pen.y != start.y) lineTo(start.x, start.y);
+            paths.back().closed = true;
+            pen = start;
+        }
+        
+        void rect(float x, float y, float w, float h, float rx, float ry) {
+            if (w <= 0 || h <= 0) return;
+            if (rx <= 0 || ry <= 0) {
+                moveTo(x, y);
+                lineTo(x + w, y);
+                lineTo(x + w, y + h);
+                lineTo(x, y + h);
+                close();
+                return;
+            }
+            const float k = 0.5522847f;
+            moveTo(x + rx, y);
+            lineTo(x + w - rx, y);
+            cubicTo(x + w - rx + rx * k, y, x + w, y + ry - ry * k, x + w, y + ry);
+            lineTo(x + w, y + h - ry);
+            cubicTo(x + w, y + h - ry + ry * k, x + w - rx + rx * k, y + h, x + w - rx, y + h);
+            lineTo(x + rx, y + h);
+            cubicTo(x + rx - rx * k, y + h, x, y + h - ry + ry * k, x, y + h - ry);
+            lineTo(x, y + ry);
+            cubicTo(x, y + ry - ry * k, x + rx - rx * k, y, x + rx, y);
+            close();
+        }
+        
+        void ellipse(float cx, float cy, float rx, float ry) {
+            if (rx <= 0 || ry <= 0) return;
+            const float k = 0.5522847f;
+            moveTo(cx + rx, cy);
+            cubicTo(cx + rx, cy + ry * k, cx + rx * k, cy + ry, cx, cy + ry);
+            cubicTo(cx - rx * k, cy + ry, cx - rx, cy + ry * k, cx - rx, cy);
+            cubicTo(cx - rx, cy - ry * k, cx - rx * k, cy - ry, cx, cy - ry);
+            cubicTo(cx + rx * k, cy - ry, cx + rx, cy - ry * k, cx + rx, cy);
+            close();
+        }
+        
+        void parse(std::string_view d) {
+            size_t i = 0;
+            char command = 0;
+            Vec lastControl;
+            char lastCommand = 0;
+            for (;;) {
+                while (i < d.size() && (std::isspace((unsigned char)d[i]) || d[i] == ',')) ++i;
+                if (i >= d.size()) break;
+                if (std::isalpha((unsigned char)d[i])) {
+                    command = d[i++];
+                    if (command == 'z' || command == 'Z') {
+                        close();
+                        lastCommand = command;
+                        continue;
+                    }
+                } else if (!command) {
+                    break;
+                }
+                
+                bool rel = std::islower((unsigned char)command);
+                float ox = rel ? pen.x : 0, oy = rel ? pen.y : 0;
+                float v[7];
+                auto read = [&](int n) {
+                    for (int k = 0; k < n; ++k) {
+                        if (!readNumber(d, i, v[k])) return false;
+                    }
+                    return true;
+                };
+                auto readFlag = [&](float& out) {
+                    while (i < d.size() && (std::isspace((unsigned char)d[i]) || d[i] == ',')) ++i;
+                    if (i >= d.size() || (d[i] != '0' && d[i] != '1')) return false;
+                    out = (float)(d[i++] - '0');
+                    return true;
+                };
+                
+                char upper = (char)std::toupper((unsigned char)command);
+                bool smoothCubic = lastCommand == 'C' || lastCommand == 'S';
+                bool smoothQuad = lastCommand == 'Q' || lastCommand == 'T';
+                Vec reflected{2 * pen.x - lastControl.x, 2 * pen.y - lastControl.y};
+                
+                switch (upper) {
+                case 'M':
+                    if (!read(2)) return;
+                    moveTo(ox + v[0], oy + v[1]);
+                    command = rel ? 'l' : 'L';  // further pairs are lines
+                    break;
+                case 'L':
+                    if (!read(2)) return;
+                    lineTo(ox + v[0], oy + v[1]);
+                    break;
+                case 'H':
+                    if (!read(1)) return;
+                    lineTo(ox + v[0], pen.y);
+                    break;
+                case 'V':
+                    if (!read(1)) return;
+                    lineTo(pen.x, oy + v[0]);
+                    break;
+                case 'C':
+                    if (!read(6)) return;
+                    cubicTo(ox + v[0], oy + v[1], ox + v[2], oy + v[3], ox + v[4], oy + v[5]);
+                    lastControl = {ox + v[2], oy + v[3]};
+                    break;
+                case 'S':
+                    if (!read(4)) return;
+                    if (!smoothCubic) reflected = pen;
+                    cubicTo(reflected.x, reflected.y, ox + v[0], oy + v[1], ox + v[2], oy + v[3]);
+                    lastControl = {ox + v[0], oy + v[1]};
+                    break;
+                case 'Q':
+                    if (!read(4)) return;
+                    quadTo(ox + v[0], oy + v[1], ox + v[2], oy + v[3]);
+                    lastControl = {ox + v[0], oy + v[1]};
+                    break;
+                case 'T':
+                    if (!read(2)) return;
+                    if (!smoothQuad) reflected = pen;
+                    quadTo(reflected.x, reflected.y, ox + v[0], oy + v[1]);
+                    lastControl = reflected;
+                    break;
+                case 'A':
+                    if (!read(3) || !readFlag(v[3]) || !readFlag(v[4])) return;
+                    if (!readNumber(d, i, v[5]) || !readNumber(d, i, v[6])) return;
+                    arcTo(v[0], v[1], v[2], v[3] != 0, v[4] != 0, ox + v[5], oy + v[6]);
+                    break;
+                default:
+                    return;
+                }
+                lastCommand = upper;
+            }
+        }
+        
+        void ensurePath() {
+            if (paths.empty()) moveTo(pen.x, pen.y);
+            else if (paths.back().closed) moveTo(start.x, start.y);
+        }
+        
+        // Endpoint to center parameterization (SVG 1.1 appendix F.6).
+        void arcTo(float rx, float ry, float angle, bool large, bool sweep, float x, float y) {
+            rx = std::fabs(rx);
+            ry = std::fabs(ry);
+            if (rx == 0 || ry == 0 || (x == pen.x && y == pen.y)) {
+                lineTo(x, y);
+                return;
+            }
+            float phi = angle * (float)M_PI / 180;
+            float cs = std::cos(phi), sn = std::sin(phi);
+            float dx = (pen.x - x) / 2, dy = (pen.y - y) / 2;
+            float x1 = cs * dx + sn * dy, y1 = -sn * dx + cs * dy;
+            float lambda = x1 * x1 / (rx * rx) + y1 * y1 / (ry * ry);
+            if (lambda > 1) {
+                rx *= std::sqrt(lambda);
+                ry *= std::sqrt(lambda);
+            }
+            float num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+            float den = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+            float coef = std::sqrt(std::max(0.0f, num / den)) * (large == sweep ? -1 : 1);
+            float cxp = coef * rx * y1 / ry, cyp = -coef * ry * x1 / rx;
+            float cx = cs * cxp - sn * cyp + (pen.x + x) / 2;
+            float cy = sn * cxp + cs * cyp + (pen.y + y) / 2;
+            
+            auto vecAngle = [](float ux, float uy, float vx, float vy) {
+                return std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+            };
+            float theta = vecAngle(1, 0, (x1 - cxp) / rx, (y1 - cyp) / ry);
+            float delta = vecAngle((x1 - cxp) / rx, (y1 - cyp) / ry, (-x1 - cxp) / rx, (-y1 - cyp) / ry);
+            if (!sweep && delta > 0) delta -= 2 * (float)M_PI;
+            if (sweep && delta < 0) delta += 2 * (float)M_PI;
+            
+            int segments = std::max(1, (int)std::ceil(std::fabs(delta) / ((float)M_PI / 2) - 1e-4f));
+            float step = delta / segments;
+            float k = 4.0f / 3.0f * std::tan(step / 4);
+            auto point = [&](float t, float& px, float& py, float& tx, float& ty) {
+                float ex = rx * std::cos(t), ey = ry * std::sin(t);
+                px = cx + cs * ex - sn * ey;
+                py = cy + sn * ex + cs * ey;
+                float dxt = -rx * std::sin(t), dyt = ry * std::cos(t);
+                tx = cs * dxt - sn * dyt;
+                ty = sn * dxt + cs * dyt;
+            };
+            for (int s = 0; s < segments; ++s) {
+                float t0 = theta + step * s, t1 = t0 + step;
+                float p0x, p0y, d0x, d0y, p1x, p1y, d1x, d1y;
+                point(t0, p0x, p0y, d0x, d0y);
+                point(t1, p1x, p1y, d1x, d1y);
+                if (s == segments - 1) {
+                    p1x = x;
+                    p1y = y;
+                }
+                cubicTo(p0x + k * d0x, p0y + k * d0y, p1x - k * d1x, p1y - k * d1y, p1x, p1y);
+            }
+        }
+    };
+};
+
+} // namespace MetaUI
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+namespace MetaUI {
+
+// ============================================================================
+// Thread Pool
+// ============================================================================
+
+// Fixed set of worker threads for CPU-bound background work (sorting,
+// filtering, rasterization). Tasks must not block on other tasks submitted
+// to the same pool.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { workerLoop(); });
+        }
+    }
+    
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // Process-wide pool shared by the library's widgets and models.
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+    
+    size_t size() const { return workers_.size(); }
+    
+    template<typename F>
+    auto submit(F&& fn) -> std::future<decltype(fn())> {
+        using Result = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back([task] { (*task)(); });
+        }
+        cv_.notify_one();
+        return future;
+    }
+    
+    // Splits [0, count) into contiguous chunks of at least minChunk items and
+    // runs fn(begin, end) on each, blocking until all chunks are done.
+    void parallelFor(size_t count, size_t minChunk,
+                     const std::function<void(size_t, size_t)>& fn) {
+        if (count == 0) return;
+        size_t chunks = std::min(size(), (count + minChunk - 1) / std::max<size_t>(1, minChunk));
+        if (chunks <= 1) {
+            fn(0, count);
+            return;
+        }
+        
+        size_t step = (count + chunks - 1) / chunks;
+        std::vector<std::future<void>> pending;
+        for (size_t begin = step; begin < count; begin += step) {
+            size_t end = std::min(count, begin + step);
+            pending.push_back(submit([&fn, begin, end] { fn(begin, end); }));
+        }
+        fn(0, std::min(count, step));
+        for (auto& f : pending) f.get();
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (stopping_ && tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+} // namespace MetaUI
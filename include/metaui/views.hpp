@@ -0,0 +1,1824 @@
+#pragma once
+
+#include "widget.hpp"
+#include "models.hpp"
+#include "renderer.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <string_view>
+#include <mutex>
+#include <deque>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace MetaUI {
+
+// ============================================================================
+// DataGrid Widget
+// ============================================================================
+
+// Virtualized table. Only cells inside the viewport are queried from the model
+// and laid out; their glyph runs are cached so scrolling and repainting cost
+// depends on the viewport size, not on the row or column count.
+class DataGrid : public Widget {
+public:
+    explicit DataGrid(std::shared_ptr<DataGridModel> model = nullptr)
+        : model_(std::move(model)) {
+        style_.background = Color(0.1f, 0.1f, 0.1f, 1.0f);
+        textStyle_.fontSize = 13;
+        textStyle_.color = Color(1, 1, 1, 1);
+        widthSpec_ = SizeSpec::fill();
+        heightSpec_ = SizeSpec::fill();
+        attachModel();
+    }
+    
+    ~DataGrid() override { detachModel(); }
+    
+    DataGrid(const DataGrid&) = delete;
+    DataGrid& operator=(const DataGrid&) = delete;
+    
+    DataGrid& model(std::shared_ptr<DataGridModel> m) {
+        detachModel();
+        model_ = std::move(m);
+        scrollOffset_ = Point();
+        invalidate();
+        attachModel();
+        requestRedraw();
+        return *this;
+    }
+    DataGrid& rowHeight(float h) { rowHeight_ = std::max(1.0f, h); requestRedraw(); return *this; }
+    DataGrid& headerHeight(float h) { headerHeight_ = std::max(0.0f, h); requestRedraw(); return *this; }
+    DataGrid& showHeader(bool s) { showHeader_ = s; requestRedraw(); return *this; }
+    DataGrid& frozenRows(size_t n) { frozenRows_ = n; requestRedraw(); return *this; }
+    DataGrid& defaultColumnWidth(float w) {
+        defaultColumnWidth_ = std::max(1.0f, w);
+        columnsDirty_ = true;
+        requestRedraw();
+        return *this;
+    }
+    DataGrid& columnWidth(size_t column, float w) {
+        columnWidths_[column] = std::max(1.0f, w);
+        columnsDirty_ = true;
+        requestRedraw();
+        return *this;
+    }
+    DataGrid& cellPadding(float p) { cellPadding_ = p; requestRedraw(); return *this; }
+    DataGrid& font(const std::string& family, float size = 13.0f) {
+        textStyle_.fontFamily = family;
+        textStyle_.fontSize = size;
+        requestRedraw();
+        return *this;
+    }
+    DataGrid& fontSize(float size) { textStyle_.fontSize = size; requestRedraw(); return *this; }
+    DataGrid& textColor(const Color& c) { textStyle_.color = c; requestRedraw(); return *this; }
+    DataGrid& headerColor(const Color& c) { headerColor_ = c; requestRedraw(); return *this; }
+    DataGrid& headerBackground(const Color& c) { headerBackground_ = c; requestRedraw(); return *this; }
+    DataGrid& alternateRowColor(const Color& c) { alternateRowColor_ = c; requestRedraw(); return *this; }
+    DataGrid& gridLineColor(const Color& c) { gridLineColor_ = c; requestRedraw(); return *this; }
+    
+    const std::shared_ptr<DataGridModel>& getModel() const { return model_; }
+    const Point& scrollOffset() const { return scrollOffset_; }
+    
+    void scrollTo(float x, float y) {
+        scrollOffset_ = Point(x, y);
+        clampScroll();
+    }
+    
+    void scrollToRow(size_t row) {
+        if (row < frozenRows_) return;
+        scrollTo(scrollOffset_.x, (row - frozenRows_) * rowHeight_);
+    }
+    
+    // Drops cached glyph runs after the model's contents changed.
+    void invalidate() {
+        cellRuns_.clear();
+        headerRuns_.clear();
+        columnsDirty_ = true;
+    }
+    
+    void invalidateRows(size_t first, size_t count) {
+        size_t columns = offsets_.empty() ? 0 : offsets_.size() - 1;
+        if (columns == 0) return;
+        for (auto it = cellRuns_.begin(); it != cellRuns_.end(); ) {
+            size_t row = it->first / columns;
+            if (row >= first && row - first < count) it = cellRuns_.erase(it);
+            else ++it;
+        }
+    }
+    
+    Size measureContent(Size available) override {
+        syncColumns();
+        float width = offsets_.empty() ? 0 : offsets_.back();
+        return Size(std::min(width, available.width), available.height);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        if (!model_) return;
+        
+        Font* font = renderer.loadFont(textStyle_);
+        if (!font || !font->valid()) return;
+        
+        syncColumns();
+        clampScroll();
+        
+        size_t rows = model_->rowCount();
+        size_t frozen = std::min(frozenRows_, rows);
+        
+        float headerH = showHeader_ ? headerHeight_ : 0;
+        Rect header(contentBounds_.x, contentBounds_.y, contentBounds_.width,
+                    std::min(headerH, contentBounds_.height));
+        Rect frozenArea(contentBounds_.x, header.y + header.height, contentBounds_.width,
+                        std::min(frozen * rowHeight_, contentBounds_.height - header.height));
+        Rect body(contentBounds_.x, frozenArea.y + frozenArea.height, contentBounds_.width,
+                  std::max(0.0f, contentBounds_.height - header.height - frozenArea.height));
+        
+        // Visible window
+        auto colBegin = std::upper_bound(offsets_.begin(), offsets_.end(), scrollOffset_.x);
+        size_t firstCol = colBegin == offsets_.begin() ? 0 : (colBegin - offsets_.begin()) - 1;
+        size_t lastCol = firstCol;
+        size_t columns = offsets_.size() - 1;
+        while (lastCol < columns && offsets_[lastCol] < scrollOffset_.x + contentBounds_.width) {
+            lastCol++;
+        }
+        
+        size_t firstRow = frozen + (size_t)(scrollOffset_.y / rowHeight_);
+        size_t lastRow = frozen + (size_t)std::ceil((scrollOffset_.y + body.height) / rowHeight_);
+        firstRow = std::min(firstRow, rows);
+        lastRow = std::min(lastRow, rows);
+        
+        // Lay out everything first: new glyphs must reach the atlas before
+        // a batch is opened.
+        if (showHeader_) {
+            if (headerRuns_.size() != columns) headerRuns_.assign(columns, GlyphRun());
+            for (size_t c = firstCol; c < lastCol; ++c) {
+                if (headerRuns_[c].font != font) {
+                    font->layoutRun(model_->headerText(c), headerRuns_[c]);
+                }
+            }
+        }
+        for (size_t r = 0; r < frozen; ++r) prepareRow(r, firstCol, lastCol, font);
+        for (size_t r = firstRow; r < lastRow; ++r) prepareRow(r, firstCol, lastCol, font);
+        
+        renderer.pushClip(contentBounds_);
+        
+        if (showHeader_ && header.height > 0) {
+            renderer.pushClip(header);
+            renderer.drawRect(header, headerBackground_);
+            drawColumnLines(renderer, header, firstCol, lastCol);
+            renderer.beginGlyphBatch(font);
+            for (size_t c = firstCol; c < lastCol; ++c) {
+                drawCell(renderer, headerRuns_[c], c, header.y, headerH, headerColor_, font);
+            }
+            renderer.endGlyphBatch();
+            renderer.popClip();
+        }
+        
+        if (frozen > 0) {
+            renderer.pushClip(frozenArea);
+            drawRows(renderer, frozenArea, 0, frozen, frozenArea.y, firstCol, lastCol, font);
+            renderer.popClip();
+        }
+        
+        if (body.height > 0) {
+            renderer.pushClip(body);
+            float y = body.y - std::fmod(scrollOffset_.y, rowHeight_);
+            drawRows(renderer, body, firstRow, lastRow, y, firstCol, lastCol, font);
+            renderer.popClip();
+        }
+        
+        renderer.popClip();
+        
+        trimCache(frozen, firstRow, lastRow, firstCol, lastCol);
+    }
+    
+    bool handleScroll(const ScrollEvent& event) override {
+        if (!contentBounds_.contains(event.position)) return false;
+        
+        scrollOffset_.x -= event.deltaX * 20;
+        scrollOffset_.y -= event.deltaY * 20;
+        clampScroll();
+        return true;
+    }
+
+private:
+    std::shared_ptr<DataGridModel> model_;
+    TextStyle textStyle_;
+    float rowHeight_ = 24;
+    float headerHeight_ = 28;
+    bool showHeader_ = true;
+    size_t frozenRows_ = 0;
+    float defaultColumnWidth_ = 120;
+    float cellPadding_ = 6;
+    Color headerColor_ = Color(1, 1, 1, 1);
+    Color headerBackground_ = Color(0.16f, 0.16f, 0.18f, 1.0f);
+    Color alternateRowColor_ = Color(1, 1, 1, 0.03f);
+    Color gridLineColor_ = Color(1, 1, 1, 0.08f);
+    Point scrollOffset_;
+    
+    std::unordered_map<size_t, float> columnWidths_;
+    std::vector<float> offsets_{0.0f};  // columnCount + 1 prefix sums
+    bool columnsDirty_ = true;
+    
+    std::vector<GlyphRun> headerRuns_;
+    std::unordered_map<uint64_t, GlyphRun> cellRuns_;
+    size_t listenerId_ = 0;
+    
+    void attachModel() {
+        if (!model_) return;
+        listenerId_ = model_->addListener([this](const std::vector<ModelChange>& changes) {
+            for (const auto& change : changes) applyChange(change);
+        });
+    }
+    
+    void detachModel() {
+        if (model_) model_->removeListener(listenerId_);
+    }
+    
+    void applyChange(const ModelChange& change) {
+        switch (change.kind) {
+            case ModelChange::Kind::Reset:
+                invalidate();
+                break;
+            case ModelChange::Kind::DataChanged:
+                invalidateRows(change.first, change.count);
+                break;
+            case ModelChange::Kind::RowsInserted:
+            case ModelChange::Kind::RowsRemoved:
+                shiftRows(change);
+                break;
+        }
+    }
+    
+    // Moves cached runs to their new row indices and keeps the first visible
+    // row anchored when rows change above it.
+    void shiftRows(const ModelChange& change) {
+        size_t columns = offsets_.size() - 1;
+        bool inserted = change.kind == ModelChange::Kind::RowsInserted;
+        
+        if (columns > 0 && !cellRuns_.empty()) {
+            std::unordered_map<uint64_t, GlyphRun> shifted;
+            shifted.reserve(cellRuns_.size());
+            for (auto& entry : cellRuns_) {
+                size_t row = entry.first / columns;
+                size_t col = entry.first % columns;
+                if (row >= change.first) {
+                    if (inserted) {
+                        row += change.count;
+                    } else if (row - change.first < change.count) {
+                        continue;
+                    } else {
+                        row -= change.count;
+                    }
+                }
+                shifted.emplace(cellKey(row, col), std::move(entry.second));
+            }
+            cellRuns_.swap(shifted);
+        }
+        
+        size_t firstVisible = frozenRows_ + (size_t)(scrollOffset_.y / rowHeight_);
+        if (change.first < firstVisible && change.first >= frozenRows_) {
+            size_t above = std::min(change.count, firstVisible - change.first);
+            float delta = (inserted ? change.count : above) * rowHeight_;
+            scrollOffset_.y = std::max(0.0f, scrollOffset_.y + (inserted ? delta : -delta));
+        }
+    }
+    
+    void syncColumns() {
+        size_t columns = model_ ? model_->columnCount() : 0;
+        if (!columnsDirty_ && offsets_.size() == columns + 1) return;
+        
+        if (offsets_.size() != columns + 1) {
+            cellRuns_.clear();
+            headerRuns_.clear();
+        }
+        
+        offsets_.assign(columns + 1, 0.0f);
+        for (size_t c = 0; c < columns; ++c) {
+            float w = defaultColumnWidth_;
+            auto it = columnWidths_.find(c);
+            if (it != columnWidths_.end()) {
+                w = it->second;
+            } else if (float preferred = model_->columnWidth(c); preferred > 0) {
+                w = preferred;
+            }
+            offsets_[c + 1] = offsets_[c] + w;
+        }
+        columnsDirty_ = false;
+    }
+    
+    void clampScroll() {
+        float contentW = offsets_.empty() ? 0 : offsets_.back();
+        size_t rows = model_ ? model_->rowCount() : 0;
+        size_t frozen = std::min(frozenRows_, rows);
+        float headerH = showHeader_ ? headerHeight_ : 0;
+        float bodyH = contentBounds_.height - headerH - frozen * rowHeight_;
+        float contentH = (rows - frozen) * rowHeight_;
+        
+        scrollOffset_.x = std::clamp(scrollOffset_.x, 0.0f,
+                                     std::max(0.0f, contentW - contentBounds_.width));
+        scrollOffset_.y = std::clamp(scrollOffset_.y, 0.0f, std::max(0.0f, contentH - bodyH));
+    }
+    
+    uint64_t cellKey(size_t row, size_t col) const {
+        return (uint64_t)row * (offsets_.size() - 1) + col;
+    }
+    
+    void prepareRow(size_t row, size_t firstCol, size_t lastCol, Font* font) {
+        for (size_t c = firstCol; c < lastCol; ++c) {
+            GlyphRun& run = cellRuns_[cellKey(row, c)];
+            if (run.font != font) font->layoutRun(model_->cellText(row, c), run);
+        }
+    }
+    
+    void drawCell(Renderer& renderer, const GlyphRun& run, size_t col, float y, float h,
+                  const Color& color, Font* font) {
+        float x = contentBounds_.x + offsets_[col] - scrollOffset_.x + cellPadding_;
+        float w = offsets_[col + 1] - offsets_[col] - cellPadding_ * 2;
+        float ty = y + (h - font->lineHeight()) / 2;
+        if (w > 0) renderer.batchGlyphRun(run, Point(x, ty), color, w);
+    }
+    
+    void drawColumnLines(Renderer& renderer, const Rect& area, size_t firstCol, size_t lastCol) {
+        if (gridLineColor_.a <= 0) return;
+        for (size_t c = firstCol; c < lastCol; ++c) {
+            float x = contentBounds_.x + offsets_[c + 1] - scrollOffset_.x - 1;
+            renderer.drawRect(Rect(x, area.y, 1, area.height), gridLineColor_);
+        }
+    }
+    
+    void drawRows(Renderer& renderer, const Rect& area, size_t first, size_t last, float y,
+                  size_t firstCol, size_t lastCol, Font* font) {
+        float rowY = y;
+        for (size_t r = first; r < last; ++r, rowY += rowHeight_) {
+            if (alternateRowColor_.a > 0 && (r & 1)) {
+                renderer.drawRect(Rect(area.x, rowY, area.width, rowHeight_), alternateRowColor_);
+            }
+            if (gridLineColor_.a > 0) {
+                renderer.drawRect(Rect(area.x, rowY + rowHeight_ - 1, area.width, 1), gridLineColor_);
+            }
+        }
+        drawColumnLines(renderer, area, firstCol, lastCol);
+        
+        renderer.beginGlyphBatch(font);
+        rowY = y;
+        for (size_t r = first; r < last; ++r, rowY += rowHeight_) {
+            for (size_t c = firstCol; c < lastCol; ++c) {
+                drawCell(renderer, cellRuns_[cellKey(r, c)], c, rowY, rowHeight_,
+                         textStyle_.color, font);
+            }
+        }
+        renderer.endGlyphBatch();
+    }
+    
+    // Keeps the run cache proportional to the viewport.
+    void trimCache(size_t frozen, size_t firstRow, size_t lastRow,
+                   size_t firstCol, size_t lastCol) {
+        size_t visible = (frozen + lastRow - firstRow) * (lastCol - firstCol);
+        if (cellRuns_.size() <= visible * 2 + 256) return;
+        
+        size_t columns = offsets_.size() - 1;
+        for (auto it = cellRuns_.begin(); it != cellRuns_.end(); ) {
+            size_t row = it->first / columns;
+            size_t col = it->first % columns;
+            bool keep = col >= firstCol && col < lastCol &&
+                        (row < frozen || (row >= firstRow && row < lastRow));
+            if (keep) ++it;
+            else it = cellRuns_.erase(it);
+        }
+    }
+};
+
+// ============================================================================
+// TreeView Widget
+// ============================================================================
+
+// Virtualized tree. Expanded state lives in a TreeRowIndex, so expanding a
+// node with thousands of descendants or jumping to any row costs O(log n),
+// and only rows inside the viewport are laid out and drawn.
+class TreeView : public Widget {
+public:
+    explicit TreeView(std::shared_ptr<TreeModel> model = nullptr) {
+        style_.background = Color(0.1f, 0.1f, 0.1f, 1.0f);
+        textStyle_.fontSize = 13;
+        textStyle_.color = Color(1, 1, 1, 1);
+        widthSpec_ = SizeSpec::fill();
+        heightSpec_ = SizeSpec::fill();
+        index_.reset(std::move(model));
+    }
+    
+    TreeView& model(std::shared_ptr<TreeModel> m) {
+        index_.reset(std::move(m));
+        reload();
+        requestRedraw();
+        return *this;
+    }
+    TreeView& rowHeight(float h) { rowHeight_ = std::max(1.0f, h); requestRedraw(); return *this; }
+    TreeView& indent(float i) { indent_ = i; requestRedraw(); return *this; }
+    TreeView& font(const std::string& family, float size = 13.0f) {
+        textStyle_.fontFamily = family;
+        textStyle_.fontSize = size;
+        requestRedraw();
+        return *this;
+    }
+    TreeView& fontSize(float size) { textStyle_.fontSize = size; requestRedraw(); return *this; }
+    TreeView& textColor(const Color& c) { textStyle_.color = c; requestRedraw(); return *this; }
+    TreeView& selectionColor(const Color& c) { selectionColor_ = c; requestRedraw(); return *this; }
+    TreeView& onSelect(std::function<void(TreeModel::NodeId)> handler) {
+        onSelectHandler_ = std::move(handler);
+        return *this;
+    }
+    TreeView& onToggle(std::function<void(TreeModel::NodeId, bool)> handler) {
+        onToggleHandler_ = std::move(handler);
+        return *this;
+    }
+    
+    size_t rowCount() const { return index_.rowCount(); }
+    const Point& scrollOffset() const { return scrollOffset_; }
+    
+    TreeModel::NodeId nodeAtRow(size_t row) const {
+        TreeRowIndex::Slot slot = index_.slotAt(row);
+        return slot == TreeRowIndex::NONE ? 0 : index_.node(slot).id;
+    }
+    
+    void expandRow(size_t row) { setExpanded(index_.slotAt(row), true); }
+    void collapseRow(size_t row) { setExpanded(index_.slotAt(row), false); }
+    void toggleRow(size_t row) {
+        TreeRowIndex::Slot slot = index_.slotAt(row);
+        if (slot != TreeRowIndex::NONE) setExpanded(slot, !index_.node(slot).expanded);
+    }
+    
+    void scrollTo(float y) {
+        scrollOffset_.y = y;
+        clampScroll();
+    }
+    
+    void scrollToRow(size_t row) { scrollTo(row * rowHeight_); }
+    
+    // Re-reads the model from scratch; expansion state is lost.
+    void reload() {
+        index_.reset(index_.model());
+        runs_.clear();
+        selected_ = TreeRowIndex::NONE;
+        scrollOffset_ = Point();
+    }
+    
+    Size measureContent(Size available) override {
+        return Size(available.width, available.height);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        if (!index_.model()) return;
+        
+        Font* font = renderer.loadFont(textStyle_);
+        if (!font || !font->valid()) return;
+        
+        clampScroll();
+        
+        size_t rows = index_.rowCount();
+        size_t firstRow = std::min(rows, (size_t)(scrollOffset_.y / rowHeight_));
+        size_t lastRow = std::min(rows, (size_t)std::ceil(
+            (scrollOffset_.y + contentBounds_.height) / rowHeight_));
+        
+        // Walk the visible window once: one O(log n) lookup for the first
+        // row, then in-order successors.
+        visible_.clear();
+        TreeRowIndex::Slot slot = index_.slotAt(firstRow);
+        for (size_t r = firstRow; r < lastRow && slot != TreeRowIndex::NONE; ++r) {
+            visible_.push_back(slot);
+            GlyphRun& run = runs_[slot];
+            if (run.font != font) font->layoutRun(index_.model()->text(index_.node(slot).id), run);
+            index_.hasChildren(slot);
+            slot = index_.next(slot);
+        }
+        if (expanderRuns_[0].font != font) {
+            font->layoutRun("\u25B8", expanderRuns_[0]);
+            font->layoutRun("\u25BE", expanderRuns_[1]);
+        }
+        
+        renderer.pushClip(contentBounds_);
+        
+        float top = contentBounds_.y - std::fmod(scrollOffset_.y, rowHeight_);
+        float textY = (rowHeight_ - font->lineHeight()) / 2;
+        for (size_t i = 0; i < visible_.size(); ++i) {
+            if (visible_[i] == selected_) {
+                renderer.drawRect(Rect(contentBounds_.x, top + i * rowHeight_,
+                                       contentBounds_.width, rowHeight_), selectionColor_);
+            }
+        }
+        
+        renderer.beginGlyphBatch(font);
+        for (size_t i = 0; i < visible_.size(); ++i) {
+            const auto& node = index_.node(visible_[i]);
+            float x = contentBounds_.x + (node.depth - 1) * indent_ - scrollOffset_.x;
+            float y = top + i * rowHeight_ + textY;
+            if (node.hasChildren > 0) {
+                renderer.batchGlyphRun(expanderRuns_[node.expanded ? 1 : 0], Point(x, y),
+                                       textStyle_.color.withAlpha(textStyle_.color.a * 0.6f));
+            }
+            renderer.batchGlyphRun(runs_[visible_[i]], Point(x + indent_, y), textStyle_.color);
+        }
+        renderer.endGlyphBatch();
+        
+        renderer.popClip();
+        
+        trimCache();
+    }
+    
+    bool handleMouseButton(const MouseEvent& event) override {
+        if (!event.pressed || event.button != MouseButton::Left) return false;
+        if (!contentBounds_.contains(event.position)) return false;
+        
+        size_t row = (size_t)((event.position.y - contentBounds_.y + scrollOffset_.y) / rowHeight_);
+        TreeRowIndex::Slot slot = index_.slotAt(row);
+        if (slot == TreeRowIndex::NONE) return false;
+        
+        const auto& node = index_.node(slot);
+        float expanderX = contentBounds_.x + (node.depth - 1) * indent_ - scrollOffset_.x;
+        if (event.position.x >= expanderX && event.position.x < expanderX + indent_ &&
+            index_.hasChildren(slot)) {
+            setExpanded(slot, !node.expanded);
+        } else {
+            selected_ = slot;
+            if (onSelectHandler_) onSelectHandler_(node.id);
+        }
+        return true;
+    }
+    
+    bool handleScroll(const ScrollEvent& event) override {
+        if (!contentBounds_.contains(event.position)) return false;
+        
+        scrollOffset_.x = std::max(0.0f, scrollOffset_.x - event.deltaX * 20);
+        scrollOffset_.y -= event.deltaY * 20;
+        clampScroll();
+        return true;
+    }
+
+private:
+    TreeRowIndex index_;
+    TextStyle textStyle_;
+    float rowHeight_ = 22;
+    float indent_ = 16;
+    Color selectionColor_ = Color::fromHex(0x3b82f655);
+    Point scrollOffset_;
+    TreeRowIndex::Slot selected_ = TreeRowIndex::NONE;
+    
+    std::unordered_map<TreeRowIndex::Slot, GlyphRun> runs_;
+    GlyphRun expanderRuns_[2];
+    std::vector<TreeRowIndex::Slot> visible_;
+    
+    std::function<void(TreeModel::NodeId)> onSelectHandler_;
+    std::function<void(TreeModel::NodeId, bool)> onToggleHandler_;
+    
+    void setExpanded(TreeRowIndex::Slot slot, bool expanded) {
+        if (slot == TreeRowIndex::NONE || index_.node(slot).expanded == expanded) return;
+        if (expanded) index_.expand(slot);
+        else index_.collapse(slot);
+        if (onToggleHandler_) onToggleHandler_(index_.node(slot).id, expanded);
+    }
+    
+    void clampScroll() {
+        float contentH = index_.rowCount() * rowHeight_;
+        scrollOffset_.y = std::clamp(scrollOffset_.y, 0.0f,
+                                     std::max(0.0f, contentH - contentBounds_.height));
+    }
+    
+    void trimCache() {
+        if (runs_.size() <= visible_.size() * 2 + 256) return;
+        std::unordered_map<TreeRowIndex::Slot, GlyphRun> kept;
+        for (auto slot : visible_) {
+            auto it = runs_.find(slot);
+            if (it != runs_.end()) kept.emplace(slot, std::move(it->second));
+        }
+        runs_.swap(kept);
+    }
+};
+
+// ============================================================================
+// Console Widget
+// ============================================================================
+
+// Scrollback view for logs and terminal output. Lines live in a bounded ring
+// buffer; appending parses ANSI SGR colors once and never touches existing
+// lines. Text uses a monospace fast path (every glyph advances by the same
+// cell width), and only lines inside the viewport are laid out and drawn.
+// append() may be called from any thread.
+class Console : public Widget {
+public:
+    explicit Console(size_t capacity = 10000) {
+        style_.background = Color(0.07f, 0.07f, 0.08f, 1.0f);
+        style_.padding = Padding(4);
+        textStyle_.fontSize = 13;
+        textStyle_.color = Color(0.85f, 0.85f, 0.85f, 1.0f);
+        widthSpec_ = SizeSpec::fill();
+        heightSpec_ = SizeSpec::fill();
+        lines_.resize(std::max<size_t>(1, capacity));
+    }
+    
+    Console& capacity(size_t lines) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lines_.assign(std::max<size_t>(1, lines), Line());
+        head_ = count_ = 0;
+        firstSeq_ = nextSeq_;
+        requestRedraw();
+        return *this;
+    }
+    Console& font(const std::string& family, float size = 13.0f) {
+        textStyle_.fontFamily = family;
+        textStyle_.fontSize = size;
+        requestRedraw();
+        return *this;
+    }
+    Console& fontSize(float size) { textStyle_.fontSize = size; requestRedraw(); return *this; }
+    Console& textColor(const Color& c) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        textStyle_.color = c;
+        layoutGeneration_++;
+        requestRedraw();
+        return *this;
+    }
+    Console& tabWidth(int columns) { tabWidth_ = std::max(1, columns); requestRedraw(); return *this; }
+    Console& followTail(bool f) { followTail_ = f; requestRedraw(); return *this; }
+    
+    // Appends one or more '\n'-separated lines.
+    Console& append(std::string_view text) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t start = 0;
+        for (size_t i = 0; i <= text.size(); ++i) {
+            if (i == text.size() || text[i] == '\n') {
+                if (i > start || i < text.size()) appendLine(text.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+        requestRedraw();
+        return *this;
+    }
+    
+    Console& clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = count_ = 0;
+        firstSeq_ = nextSeq_;
+        requestRedraw();
+        return *this;
+    }
+    
+    size_t lineCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+    
+    bool isFollowingTail() const { return followTail_; }
+    
+    Size measureContent(Size available) override {
+        return Size(available.width, available.height);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        
+        Font* font = renderer.loadFont(textStyle_);
+        if (!font || !font->valid()) return;
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        if (font != cachedFont_) cacheFontMetrics(font);
+        float lineH = (float)font->lineHeight();
+        size_t fullLines = (size_t)std::max(1.0f, std::floor(contentBounds_.height / lineH));
+        
+        uint64_t endSeq = firstSeq_ + count_;
+        if (followTail_) {
+            topSeq_ = endSeq > fullLines ? endSeq - fullLines : 0;
+        }
+        topSeq_ = std::clamp(topSeq_, firstSeq_, std::max(firstSeq_, endSeq > fullLines ? endSeq - fullLines : firstSeq_));
+        
+        uint64_t lastSeq = std::min<uint64_t>(endSeq, topSeq_ + fullLines + 1);
+        for (uint64_t seq = topSeq_; seq < lastSeq; ++seq) {
+            Line& line = lineAt(seq);
+            if (line.run.font != font || line.generation != layoutGeneration_) layoutLine(line, font);
+        }
+        
+        renderer.pushClip(contentBounds_);
+        renderer.beginGlyphBatch(font);
+        float y = contentBounds_.y;
+        for (uint64_t seq = topSeq_; seq < lastSeq; ++seq, y += lineH) {
+            renderer.batchGlyphRun(lineAt(seq).run, Point(contentBounds_.x, y), textStyle_.color);
+        }
+        renderer.endGlyphBatch();
+        renderer.popClip();
+    }
+    
+    bool handleScroll(const ScrollEvent& event) override {
+        if (!contentBounds_.contains(event.position)) return false;
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t lines = (int64_t)std::lround(-event.deltaY * 2);
+        if (lines == 0) return true;
+        
+        int64_t top = (int64_t)topSeq_ + lines;
+        topSeq_ = (uint64_t)std::max<int64_t>((int64_t)firstSeq_, top);
+        
+        // Scrolling back to the bottom resumes following new output.
+        uint64_t endSeq = firstSeq_ + count_;
+        size_t fullLines = cellHeight_ > 0
+            ? (size_t)std::max(1.0f, std::floor(contentBounds_.height / cellHeight_)) : 1;
+        followTail_ = topSeq_ + fullLines >= endSeq;
+        return true;
+    }
+
+private:
+    struct Span {
+        uint32_t column;
+        uint32_t rgba;  // 0 = default text color
+    };
+    
+    struct Line {
+        std::string text;  // escape sequences stripped
+        std::vector<Span> spans;
+        GlyphRun run;
+        uint64_t generation = 0;
+    };
+    
+    TextStyle textStyle_;
+    std::vector<Line> lines_;
+    size_t head_ = 0;   // slot of the oldest line
+    size_t count_ = 0;
+    uint64_t firstSeq_ = 0;
+    uint64_t nextSeq_ = 0;
+    uint64_t topSeq_ = 0;
+    bool followTail_ = true;
+    int tabWidth_ = 8;
+    uint64_t layoutGeneration_ = 0;
+    mutable std::mutex mutex_;
+    
+    Font* cachedFont_ = nullptr;
+    float cellWidth_ = 0;
+    float cellHeight_ = 0;
+    const Font::GlyphInfo* ascii_[128][Font::SUBPIXEL_BINS] = {};
+    
+    Line& lineAt(uint64_t seq) {
+        return lines_[(head_ + (seq - firstSeq_)) % lines_.size()];
+    }
+    
+    void appendLine(std::string_view raw) {
+        Line* line;
+        if (count_ < lines_.size()) {
+            line = &lines_[(head_ + count_) % lines_.size()];
+            count_++;
+        } else {
+            line = &lines_[head_];
+            head_ = (head_ + 1) % lines_.size();
+            firstSeq_++;
+        }
+        nextSeq_++;
+        
+        // Reuse the slot's buffers so steady-state appends don't allocate.
+        line->text.clear();
+        line->spans.clear();
+        line->run.font = nullptr;
+        parseAnsi(raw, *line);
+    }
+    
+    void parseAnsi(std::string_view raw, Line& line) {
+        uint32_t column = 0;
+        uint32_t current = 0;
+        bool bold = false;
+        int baseColor = -1;
+        
+        for (size_t i = 0; i < raw.size(); ) {
+            char c = raw[i];
+            if (c == '\x1b' && i + 1 < raw.size() && raw[i + 1] == '[') {
+                size_t end = i + 2;
+                while (end < raw.size() && (raw[end] < 0x40 || raw[end] > 0x7e)) end++;
+                if (end >= raw.size()) break;
+                if (raw[end] == 'm') {
+                    uint32_t color = applySgr(raw.substr(i + 2, end - i - 2), current, bold, baseColor);
+                    if (color != current) {
+                        current = color;
+                        if (!line.spans.empty() && line.spans.back().column == column) {
+                            line.spans.back().rgba = color;
+                        } else {
+                            line.spans.push_back(Span{column, color});
+                        }
+                    }
+                }
+                i = end + 1;
+                continue;
+            }
+            if (c == '\t') {
+                uint32_t spaces = tabWidth_ - column % tabWidth_;
+                line.text.append(spaces, ' ');
+                column += spaces;
+                i++;
+                continue;
+            }
+            if (c == '\r') {
+                i++;
+                continue;
+            }
+            line.text.push_back(c);
+            // Count columns per code point, not per UTF-8 byte.
+            if (((unsigned char)c & 0xC0) != 0x80) column++;
+            i++;
+        }
+    }
+    
+    static uint32_t applySgr(std::string_view params, uint32_t current, bool& bold, int& baseColor) {
+        int codes[16];
+        int n = 0;
+        int value = 0;
+        bool any = false;
+        for (size_t i = 0; i <= params.size() && n < 16; ++i) {
+            if (i == params.size() || params[i] == ';') {
+                codes[n++] = any ? value : 0;
+                value = 0;
+                any = false;
+            } else if (params[i] >= '0' && params[i] <= '9') {
+                value = value * 10 + (params[i] - '0');
+                any = true;
+            }
+        }
+        
+        for (int k = 0; k < n; ++k) {
+            int code = codes[k];
+            if (code == 0) {
+                bold = false;
+                baseColor = -1;
+                current = 0;
+            } else if (code == 1) {
+                bold = true;
+                if (baseColor >= 0 && baseColor < 8) current = paletteColor(baseColor + 8);
+            } else if (code == 22) {
+                bold = false;
+                if (baseColor >= 0 && baseColor < 8) current = paletteColor(baseColor);
+            } else if (code >= 30 && code <= 37) {
+                baseColor = code - 30;
+                current = paletteColor(bold ? baseColor + 8 : baseColor);
+            } else if (code >= 90 && code <= 97) {
+                baseColor = code - 90 + 8;
+                current = paletteColor(baseColor);
+            } else if (code == 39) {
+                baseColor = -1;
+                current = 0;
+            } else if (code == 38 && k + 2 < n && codes[k + 1] == 5) {
+                baseColor = -1;
+                current = paletteColor(codes[k + 2]);
+                k += 2;
+            } else if (code == 38 && k + 4 < n && codes[k + 1] == 2) {
+                baseColor = -1;
+                current = ((uint32_t)(codes[k + 2] & 0xFF) << 24) |
+                          ((uint32_t)(codes[k + 3] & 0xFF) << 16) |
+                          ((uint32_t)(codes[k + 4] & 0xFF) << 8) | 0xFF;
+                k += 4;
+            } else if ((code == 48 || code == 58) && k + 1 < n) {
+                // Background/underline colors are not drawn; skip their arguments.
+                k += codes[k + 1] == 5 ? 2 : codes[k + 1] == 2 ? 4 : 0;
+            }
+        }
+        return current;
+    }
+    
+    // xterm 256-color palette as 0xRRGGBBAA.
+    static uint32_t paletteColor(int index) {
+        static const uint32_t base[16] = {
+            0x000000ff, 0xcd3131ff, 0x0dbc79ff, 0xe5e510ff,
+            0x2472c8ff, 0xbc3fbcff, 0x11a8cdff, 0xe5e5e5ff,
+            0x666666ff, 0xf14c4cff, 0x23d18bff, 0xf5f543ff,
+            0x3b8eeaff, 0xd670d6ff, 0x29b8dbff, 0xffffffff
+        };
+        if (index < 0 || index > 255) return 0;
+        if (index < 16) return base[index];
+        if (index >= 232) {
+            uint32_t v = 8 + (index - 232) * 10;
+            return (v << 24) | (v << 16) | (v << 8) | 0xFF;
+        }
+        int cube = index - 16;
+        auto level = [](int v) -> uint32_t { return v == 0 ? 0 : 55 + v * 40; };
+        return (level(cube / 36) << 24) | (level((cube / 6) % 6) << 16) |
+               (level(cube % 6) << 8) | 0xFF;
+    }
+    
+    void cacheFontMetrics(Font* font) {
+        cachedFont_ = font;
+        for (auto& variants : ascii_) {
+            for (auto& glyph : variants) glyph = nullptr;
+        }
+        const Font::GlyphInfo* m = font->getGlyph('M');
+        cellWidth_ = m ? m->advance : font->size() * 0.6f;
+        cellHeight_ = (float)font->lineHeight();
+        layoutGeneration_++;
+    }
+    
+    // Monospace layout: glyph positions come straight from the column index,
+    // ASCII glyphs (per subpixel offset) from a flat table filled on first
+    // use, so there is no per-glyph measuring.
+    void layoutLine(Line& line, Font* font) {
+        GlyphRun& run = line.run;
+        run.quads.clear();
+        run.colors.clear();
+        run.colorGlyphs.clear();
+        run.font = font;
+        line.generation = layoutGeneration_;
+        
+        float baseline = (float)font->ascent();
+        size_t nextSpan = 0;
+        uint32_t column = 0;
+        const std::string& text = line.text;
+        
+        for (size_t i = 0; i < text.size(); ++column) {
+            while (nextSpan < line.spans.size() && line.spans[nextSpan].column <= column) {
+                uint32_t rgba = line.spans[nextSpan++].rgba;
+                run.colors.push_back({(uint32_t)run.quads.size(),
+                                      rgba ? Color::fromHex(rgba) : textStyle_.color});
+            }
+            
+            float x;
+            int bin;
+            Font::snapSubpixel(column * cellWidth_, x, bin);
+            
+            unsigned char c = (unsigned char)text[i];
+            const Font::GlyphInfo* glyph;
+            if (c < 128) {
+                if (c < 32) {
+                    i++;
+                    continue;
+                }
+                glyph = ascii_[c][bin];
+                if (!glyph) glyph = ascii_[c][bin] = font->getGlyph(c, bin);
+                i++;
+            } else {
+                int codepoint = Font::decodeUTF8(text, i);
+                glyph = font->getGlyph(codepoint, bin);
+                if (glyph && glyph->color) {
+                    run.colorGlyphs.push_back({x, baseline, (uint32_t)codepoint});
+                    continue;
+                }
+            }
+            if (!glyph || glyph->width == 0) continue;
+            
+            run.quads.push_back({
+                x + glyph->x0, baseline + glyph->y0, x + glyph->x1, baseline + glyph->y1,
+                glyph->u0, glyph->v0, glyph->u1, glyph->v1
+            });
+        }
+        run.width = column * cellWidth_;
+        run.height = cellHeight_;
+    }
+};
+
+
+// ============================================================================
+// LineChart Widget
+// ============================================================================
+
+// Minimum and maximum of values[0, count); count must be > 0.
+inline void minMax(const float* values, size_t count, float& lo, float& hi) {
+    size_t i = 0;
+    lo = hi = values[0];
+#if defined(__SSE2__)
+    if (count >= 8) {
+        __m128 vlo = _mm_loadu_ps(values), vhi = vlo;
+        for (i = 4; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps(values + i);
+            vlo = _mm_min_ps(vlo, v);
+            vhi = _mm_max_ps(vhi, v);
+        }
+        vlo = _mm_min_ps(vlo, _mm_shuffle_ps(vlo, vlo, _MM_SHUFFLE(1, 0, 3, 2)));
+        vlo = _mm_min_ps(vlo, _mm_shuffle_ps(vlo, vlo, _MM_SHUFFLE(2, 3, 0, 1)));
+        vhi = _mm_max_ps(vhi, _mm_shuffle_ps(vhi, vhi, _MM_SHUFFLE(1, 0, 3, 2)));
+        vhi = _mm_max_ps(vhi, _mm_shuffle_ps(vhi, vhi, _MM_SHUFFLE(2, 3, 0, 1)));
+        lo = _mm_cvtss_f32(vlo);
+        hi = _mm_cvtss_f32(vhi);
+    }
+#endif
+    for (; i < count; ++i) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+}
+
+// Largest triangle three buckets: calls emit(i) for threshold of the n
+// samples at(0) .. at(n - 1), in order, or for all of them if n <= threshold.
+// The first and last are always kept; in between, each bucket keeps the
+// sample that maximizes the triangle area with the previously kept one and
+// the next bucket's average. threshold must be >= 3.
+template<typename At, typename Emit>
+void lttb(uint64_t n, uint64_t threshold, At&& at, Emit&& emit) {
+    if (n <= threshold) {
+        for (uint64_t i = 0; i < n; ++i) emit(i);
+        return;
+    }
+    
+    double every = (double)(n - 2) / (threshold - 2);
+    uint64_t a = 0;
+    emit(0);
+    for (uint64_t bucket = 0; bucket < threshold - 2; ++bucket) {
+        uint64_t nextFrom = (uint64_t)((bucket + 1) * every) + 1;
+        uint64_t nextTo = std::min(n, (uint64_t)((bucket + 2) * every) + 1);
+        double avgX = 0, avgY = 0;
+        for (uint64_t i = nextFrom; i < nextTo; ++i) {
+            avgX += (double)i;
+            avgY += at(i);
+        }
+        uint64_t nextCount = std::max<uint64_t>(1, nextTo - nextFrom);
+        avgX /= nextCount;
+        avgY /= nextCount;
+        
+        uint64_t rangeFrom = (uint64_t)(bucket * every) + 1;
+        uint64_t rangeTo = (uint64_t)((bucket + 1) * every) + 1;
+        double ax = (double)a, ay = at(a);
+        double best = -1;
+        uint64_t chosen = rangeFrom;
+        for (uint64_t i = rangeFrom; i < rangeTo; ++i) {
+            double area = std::fabs((ax - avgX) * (at(i) - ay) - (ax - (double)i) * (avgY - ay));
+            if (area > best) {
+                best = area;
+                chosen = i;
+            }
+        }
+        emit(chosen);
+        a = chosen;
+    }
+    emit(n - 1);
+}
+
+// Scrolling plot of high-rate sample streams (one value per tick, newest at
+// the right edge). Each series keeps its samples in a ring buffer plus
+// per-pixel-column buckets (first, last, min, max) aligned to absolute
+// sample numbers, so an append only updates the newest bucket and a frame
+// draws about two segments per column however many samples are visible.
+// Min/max bucketing keeps every spike; Lttb (largest triangle three
+// buckets) gives a smoother shape but rescans the visible samples whenever
+// data arrives. All series are drawn with one instanced draw.
+// append() may be called from any thread.
+class LineChart : public Widget {
+public:
+    enum class Decimation { MinMax, Lttb };
+    
+    explicit LineChart(size_t capacity = 1 << 20) : capacity_(std::max<size_t>(1, capacity)) {
+        style_.background = Color(0.07f, 0.07f, 0.08f, 1.0f);
+        widthSpec_ = SizeSpec::fill();
+        heightSpec_ = SizeSpec::fill();
+    }
+    
+    // Returns the series index for append().
+    size_t addSeries(const Color& color, float width = 1.5f) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        series_.emplace_back();
+        Series& s = series_.back();
+        s.color = color;
+        s.width = width;
+        s.samples.resize(capacity_);
+        generation_++;
+        return series_.size() - 1;
+    }
+    
+    // Samples shown across the width; 0 shows the whole ring buffer.
+    LineChart& visibleSamples(size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        visible_ = count;
+        bucketSize_ = 0;  // rebucket on next render
+        requestRedraw();
+        return *this;
+    }
+    LineChart& yRange(float min, float max) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        yMin_ = min;
+        yMax_ = max;
+        autoRange_ = false;
+        generation_++;
+        requestRedraw();
+        return *this;
+    }
+    LineChart& autoRange() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        autoRange_ = true;
+        generation_++;
+        requestRedraw();
+        return *this;
+    }
+    LineChart& decimation(Decimation d) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decimation_ = d;
+        generation_++;
+        requestRedraw();
+        return *this;
+    }
+    
+    LineChart& append(size_t series, float value) { return append(series, &value, 1); }
+    
+    LineChart& append(size_t series, const float* values, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (series >= series_.size() || count == 0) return *this;
+        Series& s = series_[series];
+        
+        // Only the newest capacity_ values can survive.
+        if (count > capacity_) {
+            s.total += count - capacity_;
+            values += count - capacity_;
+            count = capacity_;
+        }
+        size_t slot = (size_t)(s.total % capacity_);
+        size_t first = std::min(count, capacity_ - slot);
+        std::copy(values, values + first, s.samples.begin() + slot);
+        std::copy(values + first, values + count, s.samples.begin());
+        
+        if (bucketSize_ > 0) {
+            uint64_t n = s.total;
+            size_t i = 0;
+            while (i < count) {
+                uint64_t index = (n + i) / bucketSize_;
+                size_t run = (size_t)std::min<uint64_t>(count - i, (index + 1) * bucketSize_ - (n + i));
+                float lo, hi;
+                minMax(values + i, run, lo, hi);
+                if (s.buckets.empty() || s.buckets.back().index != index) {
+                    s.buckets.push_back(Bucket{index, values[i], values[i + run - 1], lo, hi});
+                } else {
+                    Bucket& b = s.buckets.back();
+                    b.last = values[i + run - 1];
+                    b.min = std::min(b.min, lo);
+                    b.max = std::max(b.max, hi);
+                }
+                i += run;
+            }
+        }
+        s.total += count;
+        if (bucketSize_ > 0) {
+            uint64_t start = windowStart(s.total);
+            while (!s.buckets.empty() && (s.buckets.front().index + 1) * bucketSize_ <= start) {
+                s.buckets.pop_front();
+            }
+        }
+        generation_++;
+        requestRedraw();
+        return *this;
+    }
+    
+    LineChart& clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Series& s : series_) {
+            s.total = 0;
+            s.buckets.clear();
+        }
+        generation_++;
+        requestRedraw();
+        return *this;
+    }
+    
+    uint64_t sampleCount(size_t series) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return series < series_.size() ? series_[series].total : 0;
+    }
+    
+    Size measureContent(Size available) override {
+        return Size(available.width, available.height);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        if (contentBounds_.width < 1 || contentBounds_.height < 1) return;
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        int columns = std::max(1, (int)contentBounds_.width);
+        uint64_t visible = visibleCount();
+        uint64_t bucketSize = std::max<uint64_t>(1, (visible + columns - 1) / columns);
+        if (bucketSize != bucketSize_) {
+            bucketSize_ = bucketSize;
+            for (Series& s : series_) rebucket(s);
+            generation_++;
+        }
+        
+        const Rect& r = contentBounds_;
+        if (generation_ != builtGeneration_ || r.x != builtBounds_.x || r.y != builtBounds_.y ||
+            r.width != builtBounds_.width || r.height != builtBounds_.height) {
+            buildSegments();
+            builtGeneration_ = generation_;
+            builtBounds_ = contentBounds_;
+        }
+        
+        renderer.pushClip(contentBounds_);
+        renderer.drawLineSegments(segments_.data(), segments_.size());
+        renderer.popClip();
+    }
+
+private:
+    struct Bucket {
+        uint64_t index;             // absolute sample number / bucket size
+        float first, last, min, max;
+    };
+    
+    struct Series {
+        Color color;
+        float width = 1.5f;
+        std::vector<float> samples; // ring: sample n lives at n % capacity
+        uint64_t total = 0;         // samples ever appended
+        std::deque<Bucket> buckets;
+    };
+    
+    size_t capacity_;
+    size_t visible_ = 0;
+    std::vector<Series> series_;
+    uint64_t bucketSize_ = 0;
+    Decimation decimation_ = Decimation::MinMax;
+    bool autoRange_ = true;
+    float yMin_ = 0, yMax_ = 1;
+    
+    uint64_t generation_ = 0;
+    uint64_t builtGeneration_ = ~0ull;
+    Rect builtBounds_;
+    std::vector<LineSegment> segments_;
+    mutable std::mutex mutex_;
+    
+    uint64_t visibleCount() const { return visible_ > 0 ? std::min(visible_, capacity_) : capacity_; }
+    
+    uint64_t windowStart(uint64_t total) const {
+        uint64_t visible = visibleCount();
+        return total > visible ? total - visible : 0;
+    }
+    
+    uint64_t newestTotal() const {
+        uint64_t total = 0;
+        for (const Series& s : series_) total = std::max(total, s.total);
+        return total;
+    }
+    
+    // Calls fn(pointer, count) for the stored samples in [from, to).
+    template<typename F>
+    void forSpans(const Series& s, uint64_t from, uint64_t to, F&& fn) const {
+        while (from < to) {
+            size_t slot = (size_t)(from % capacity_);
+            size_t run = (size_t)std::min<uint64_t>(to - from, capacity_ - slot);
+            fn(s.samples.data() + slot, run);
+            from += run;
+        }
+    }
+    
+    void rebucket(Series& s) {
+        s.buckets.clear();
+        uint64_t start = std::max(windowStart(s.total), s.total > capacity_ ? s.total - capacity_ : 0);
+        for (uint64_t index = start / bucketSize_; index * bucketSize_ < s.total; ++index) {
+            uint64_t from = std::max(start, index * bucketSize_);
+            uint64_t to = std::min(s.total, (index + 1) * bucketSize_);
+            Bucket b{index, s.samples[from % capacity_], s.samples[(to - 1) % capacity_], INFINITY, -INFINITY};
+            forSpans(s, from, to, [&](const float* values, size_t count) {
+                float lo, hi;
+                minMax(values, count, lo, hi);
+                b.min = std::min(b.min, lo);
+                b.max = std::max(b.max, hi);
+            });
+            s.buckets.push_back(b);
+        }
+    }
+    
+    void buildSegments() {
+        segments_.clear();
+        uint64_t newest = newestTotal();
+        uint64_t start = windowStart(newest);
+        double visible = (double)visibleCount();
+        const Rect& r = contentBounds_;
+        
+        float lo = yMin_, hi = yMax_;
+        if (autoRange_) {
+            lo = INFINITY;
+            hi = -INFINITY;
+            for (const Series& s : series_) {
+                for (const Bucket& b : s.buckets) {
+                    if ((b.index + 1) * bucketSize_ <= start) continue;
+                    lo = std::min(lo, b.min);
+                    hi = std::max(hi, b.max);
+                }
+            }
+            if (!(lo <= hi)) {
+                lo = 0;
+                hi = 1;
+            }
+            float pad = (hi - lo) * 0.05f;
+            if (pad == 0) pad = std::max(std::fabs(hi) * 0.05f, 0.5f);
+            lo -= pad;
+            hi += pad;
+        }
+        float yScale = hi > lo ? r.height / (hi - lo) : 0;
+        auto mapY = [&](float v) { return r.y + r.height - (v - lo) * yScale; };
+        auto mapX = [&](double sample) { return r.x + (float)((sample - (double)start) / visible * r.width); };
+        
+        for (const Series& s : series_) {
+            if (decimation_ == Decimation::Lttb) {
+                appendLttb(s, start, mapX, mapY);
+                continue;
+            }
+            bool havePrev = false;
+            float prevX = 0, prevY = 0;
+            for (const Bucket& b : s.buckets) {
+                float x = mapX((double)b.index * bucketSize_ + bucketSize_ * 0.5);
+                if (havePrev) segments_.push_back({prevX, prevY, x, mapY(b.first), s.color, s.width});
+                if (b.max > b.min || !havePrev) {
+                    segments_.push_back({x, mapY(b.min), x, mapY(b.max), s.color, s.width});
+                }
+                prevX = x;
+                prevY = mapY(b.last);
+                havePrev = true;
+            }
+        }
+    }
+    
+    // Keeps about two points per pixel column.
+    template<typename MapX, typename MapY>
+    void appendLttb(const Series& s, uint64_t windowFrom, MapX mapX, MapY mapY) {
+        uint64_t from = std::max(windowFrom, s.total > capacity_ ? s.total - capacity_ : 0);
+        uint64_t n = s.total > from ? s.total - from : 0;
+        if (n == 0) return;
+        auto at = [&](uint64_t i) { return s.samples[(from + i) % capacity_]; };
+        uint64_t threshold = std::max<uint64_t>(3, (uint64_t)contentBounds_.width * 2);
+        
+        float px = 0, py = 0;
+        bool have = false;
+        lttb(n, threshold, at, [&](uint64_t i) {
+            float x = mapX((double)(from + i)), y = mapY(at(i));
+            if (have) segments_.push_back({px, py, x, y, s.color, s.width});
+            px = x;
+            py = y;
+            have = true;
+        });
+    }
+};
+
+
+// ============================================================================
+// Heatmap Widget
+// ============================================================================
+
+// Dense matrix view. Values live in a float texture colored through a
+// colormap lookup texture in the shader, so a 2000x2000 matrix is one quad.
+// Writes mark a dirty row range that is re-uploaded with glTexSubImage2D on
+// the next frame; changing the value range or colormap re-uploads nothing.
+// Zoom (wheel) and pan (drag) only change texture coordinates. resize(),
+// set*() and colormap() may be called from any thread.
+class Heatmap : public Widget {
+public:
+    enum class Colormap { Viridis, Magma, Gray };
+    
+    Heatmap(int columns = 0, int rows = 0) {
+        widthSpec_ = SizeSpec::fill();
+        heightSpec_ = SizeSpec::fill();
+        resize(columns, rows);
+        colormap(Colormap::Viridis);
+    }
+    
+    // Clears to NaN (transparent).
+    Heatmap& resize(int columns, int rows) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        columns_ = std::max(0, columns);
+        rows_ = std::max(0, rows);
+        values_.assign((size_t)columns_ * rows_, NAN);
+        reallocate_ = true;
+        requestRedraw();
+        return *this;
+    }
+    
+    // count rows of columns() values each, starting at firstRow.
+    Heatmap& setRows(int firstRow, int count, const float* values) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        copyRows(firstRow, count, values);
+        return *this;
+    }
+    Heatmap& setRow(int row, const float* values) { return setRows(row, 1, values); }
+    
+    // rows() * columns() values, the size as of this call.
+    Heatmap& setAll(const float* values) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        copyRows(0, rows_, values);
+        return *this;
+    }
+    
+    Heatmap& set(int column, int row, float value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (column < 0 || column >= columns_ || row < 0 || row >= rows_) return *this;
+        values_[(size_t)row * columns_ + column] = value;
+        markDirty(row, row + 1);
+        return *this;
+    }
+    
+    Heatmap& range(float min, float max) { min_ = min; max_ = max; requestRedraw(); return *this; }
+    Heatmap& smooth(bool s) { smooth_ = s; filterChanged_ = true; requestRedraw(); return *this; }
+    
+    Heatmap& colormap(Colormap map) {
+        static const uint32_t viridis[] = {0x440154, 0x472d7b, 0x3b528b, 0x2c728e, 0x21918c,
+                                           0x28ae80, 0x5ec962, 0xaddc30, 0xfde725};
+        static const uint32_t magma[] = {0x000004, 0x1c1044, 0x4f127b, 0x812581, 0xb5367a,
+                                         0xe55064, 0xfb8761, 0xfec287, 0xfcfdbf};
+        std::vector<Color> stops;
+        if (map == Colormap::Gray) {
+            stops = {Color(0, 0, 0, 1), Color(1, 1, 1, 1)};
+        } else {
+            for (uint32_t rgb : map == Colormap::Viridis ? viridis : magma) stops.push_back(Color::fromHex(rgb << 8 | 0xFF));
+        }
+        return colormap(stops);
+    }
+    
+    // Evenly spaced color stops, interpolated into a 256-entry table.
+    Heatmap& colormap(const std::vector<Color>& stops) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lut_.assign(LUT_SIZE * 4, 0);
+        if (stops.empty()) return *this;
+        for (int i = 0; i < LUT_SIZE; ++i) {
+            float t = (float)i / (LUT_SIZE - 1) * (stops.size() - 1);
+            size_t k = std::min((size_t)t, stops.size() - 1);
+            size_t next = std::min(k + 1, stops.size() - 1);
+            float f = t - k;
+            const Color& a = stops[k];
+            const Color& b = stops[next];
+            float rgba[4] = {a.r + (b.r - a.r) * f, a.g + (b.g - a.g) * f, a.b + (b.b - a.b) * f, a.a + (b.a - a.a) * f};
+            for (int c = 0; c < 4; ++c) lut_[i * 4 + c] = (unsigned char)std::lround(std::clamp(rgba[c], 0.0f, 1.0f) * 255);
+        }
+        lutDirty_ = true;
+        requestRedraw();
+        return *this;
+    }
+    
+    // Visible part of the matrix in normalized coordinates (0..1).
+    Heatmap& view(const Rect& uv) { view_ = uv; clampView(); requestRedraw(); return *this; }
+    Heatmap& resetView() { view_ = Rect(0, 0, 1, 1); requestRedraw(); return *this; }
+    const Rect& currentView() const { return view_; }
+    
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+    
+    Size measureContent(Size available) override {
+        return Size(available.width, available.height);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (columns_ == 0 || rows_ == 0) return;
+            if (reallocate_) {
+                valuesTexture_ = Texture::floatTexture(columns_, rows_);
+                dirtyFrom_ = 0;
+                dirtyTo_ = rows_;
+                reallocate_ = false;
+                filterChanged_ = true;
+            }
+            if (dirtyFrom_ < dirtyTo_) {
+                valuesTexture_.update(0, dirtyFrom_, columns_, dirtyTo_ - dirtyFrom_, GL_RED, GL_FLOAT,
+                                       values_.data() + (size_t)dirtyFrom_ * columns_);
+                dirtyFrom_ = dirtyTo_ = 0;
+            }
+            if (lutDirty_) {
+                lutTexture_ = Texture(LUT_SIZE, 1, lut_.data(), 4);
+                lutDirty_ = false;
+            }
+        }
+        if (filterChanged_) {
+            valuesTexture_.setFilter(smooth_ ? GL_LINEAR : GL_NEAREST);
+            filterChanged_ = false;
+        }
+        
+        renderer.drawColormapped(valuesTexture_, lutTexture_, contentBounds_, view_, min_, max_);
+    }
+    
+    bool handleScroll(const ScrollEvent& event) override {
+        if (!contentBounds_.contains(event.position) || contentBounds_.width <= 0) return false;
+        
+        // Zoom about the point under the cursor.
+        float fx = (event.position.x - contentBounds_.x) / contentBounds_.width;
+        float fy = (event.position.y - contentBounds_.y) / contentBounds_.height;
+        float u = view_.x + fx * view_.width, v = view_.y + fy * view_.height;
+        float factor = std::pow(1.1f, event.deltaY / 10.0f);
+        view_.width = std::clamp(view_.width * factor, minViewSize(columns_), 1.0f);
+        view_.height = std::clamp(view_.height * factor, minViewSize(rows_), 1.0f);
+        view_.x = u - fx * view_.width;
+        view_.y = v - fy * view_.height;
+        clampView();
+        return true;
+    }
+    
+    bool handleMouseButton(const MouseEvent& event) override {
+        if (event.button != MouseButton::Left) return Widget::handleMouseButton(event);
+        if (event.pressed && contentBounds_.contains(event.position)) {
+            dragging_ = true;
+            dragLast_ = event.position;
+            return true;
+        }
+        if (!event.pressed && dragging_) {
+            dragging_ = false;
+            return true;
+        }
+        return Widget::handleMouseButton(event);
+    }
+    
+    bool handleMouseMove(const MouseEvent& event) override {
+        Widget::handleMouseMove(event);
+        if (!dragging_ || contentBounds_.width <= 0 || contentBounds_.height <= 0) return false;
+        view_.x -= (event.position.x - dragLast_.x) / contentBounds_.width * view_.width;
+        view_.y -= (event.position.y - dragLast_.y) / contentBounds_.height * view_.height;
+        dragLast_ = event.position;
+        clampView();
+        return true;
+    }
+
+private:
+    static constexpr int LUT_SIZE = 256;
+    
+    int columns_ = 0, rows_ = 0;
+    std::vector<float> values_;
+    int dirtyFrom_ = 0, dirtyTo_ = 0;     // rows awaiting upload
+    bool reallocate_ = false;
+    std::vector<unsigned char> lut_;
+    bool lutDirty_ = false;
+    mutable std::mutex mutex_;
+    
+    Texture valuesTexture_;
+    Texture lutTexture_;
+    float min_ = 0, max_ = 1;
+    bool smooth_ = false;
+    bool filterChanged_ = true;
+    Rect view_ = Rect(0, 0, 1, 1);
+    bool dragging_ = false;
+    Point dragLast_;
+    
+    // Caller holds mutex_.
+    void copyRows(int firstRow, int count, const float* values) {
+        firstRow = std::max(0, firstRow);
+        count = std::min(count, rows_ - firstRow);
+        if (count <= 0) return;
+        std::copy(values, values + (size_t)count * columns_, values_.begin() + (size_t)firstRow * columns_);
+        markDirty(firstRow, firstRow + count);
+    }
+    
+    void markDirty(int from, int to) {
+        if (dirtyFrom_ >= dirtyTo_) {
+            dirtyFrom_ = from;
+            dirtyTo_ = to;
+        } else {
+            dirtyFrom_ = std::min(dirtyFrom_, from);
+            dirtyTo_ = std::max(dirtyTo_, to);
+        }
+        requestRedraw();
+    }
+    
+    // Zoom stops at about four cells across.
+    static float minViewSize(int cells) { return cells > 4 ? 4.0f / cells : 1.0f; }
+    
+    void clampView() {
+        view_.width = std::clamp(view_.width, 1e-6f, 1.0f);
+        view_.height = std::clamp(view_.height, 1e-6f, 1.0f);
+        view_.x = std::clamp(view_.x, 0.0f, 1.0f - view_.width);
+        view_.y = std::clamp(view_.y, 0.0f, 1.0f - view_.height);
+    }
+};
+
+
+// ============================================================================
+// VideoFrame Widget
+// ============================================================================
+
+// 8-bit YUV 4:2:0 frame, tightly packed. NV12 keeps interleaved chroma in u
+// and leaves v empty.
+struct YuvImage {
+    enum class Format { I420, NV12 };
+    
+    Format format = Format::I420;
+    int width = 0, height = 0;
+    std::vector<uint8_t> y, u, v;
+    
+    int chromaWidth() const { return (width + 1) / 2; }
+    int chromaHeight() const { return (height + 1) / 2; }
+    
+    void allocate(Format f, int w, int h) {
+        format = f;
+        width = w;
+        height = h;
+        y.resize((size_t)w * h);
+        size_t chroma = (size_t)chromaWidth() * chromaHeight();
+        u.resize(f == Format::NV12 ? chroma * 2 : chroma);
+        v.resize(f == Format::NV12 ? 0 : chroma);
+    }
+};
+
+// Displays frames from a producer thread (camera, decoder). submit*()
+// copies the planes into a back buffer and swaps it into a one-frame
+// mailbox; a frame still waiting there when the next one arrives is
+// dropped, so a slow consumer always shows the newest frame and never
+// queues. Planes are uploaded into a ring of textures (so the upload never
+// targets the texture the GPU may still be reading) and converted to RGB
+// in the fragment shader.
+class VideoFrame : public Widget {
+public:
+    VideoFrame() {
+        widthSpec_ = SizeSpec::fill();
+        heightSpec_ = SizeSpec::fill();
+    }
+    
+    VideoFrame& matrix(YuvMatrix m) { matrix_ = m; requestRedraw(); return *this; }
+    VideoFrame& fullRange(bool f) { fullRange_ = f; requestRedraw(); return *this; }
+    VideoFrame& preserveAspect(bool p) { preserveAspect_ = p; requestRedraw(); return *this; }
+    
+    // Strides are in bytes. May be called from any thread.
+    void submitI420(int width, int height, const uint8_t* y, int yStride,
+                    const uint8_t* u, int uStride, const uint8_t* v, int vStride) {
+        std::lock_guard<std::mutex> producer(producerMutex_);
+        back_.allocate(YuvImage::Format::I420, width, height);
+        copyPlane(back_.y.data(), width, y, yStride, width, height);
+        copyPlane(back_.u.data(), back_.chromaWidth(), u, uStride, back_.chromaWidth(), back_.chromaHeight());
+        copyPlane(back_.v.data(), back_.chromaWidth(), v, vStride, back_.chromaWidth(), back_.chromaHeight());
+        publish();
+    }
+    
+    void submitNV12(int width, int height, const uint8_t* y, int yStride, const uint8_t* uv, int uvStride) {
+        std::lock_guard<std::mutex> producer(producerMutex_);
+        back_.allocate(YuvImage::Format::NV12, width, height);
+        copyPlane(back_.y.data(), width, y, yStride, width, height);
+        copyPlane(back_.u.data(), back_.chromaWidth() * 2, uv, uvStride, back_.chromaWidth() * 2, back_.chromaHeight());
+        publish();
+    }
+    
+    void submit(const YuvImage& image) {
+        if (image.format == YuvImage::Format::NV12) {
+            submitNV12(image.width, image.height, image.y.data(), image.width, image.u.data(), image.chromaWidth() * 2);
+        } else {
+            submitI420(image.width, image.height, image.y.data(), image.width,
+                       image.u.data(), image.chromaWidth(), image.v.data(), image.chromaWidth());
+        }
+    }
+    
+    uint64_t framesSubmitted() const { std::lock_guard<std::mutex> lock(mutex_); return submitted_; }
+    uint64_t framesDropped() const { std::lock_guard<std::mutex> lock(mutex_); return dropped_; }
+    uint64_t framesShown() const { return shown_; }
+    
+    Size measureContent(Size /*available*/) override {
+        if (current_ >= 0) return Size((float)slots_[current_].width, (float)slots_[current_].height);
+        return Size(320, 180);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        
+        bool fresh = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (hasPending_) {
+                std::swap(pending_, front_);
+                hasPending_ = false;
+                fresh = true;
+            }
+        }
+        if (fresh) upload(front_);
+        if (current_ < 0) return;
+        
+        const Slot& slot = slots_[current_];
+        Rect target = contentBounds_;
+        if (preserveAspect_ && slot.width > 0 && slot.height > 0) {
+            float scale = std::min(target.width / slot.width, target.height / slot.height);
+            target.width = slot.width * scale;
+            target.height = slot.height * scale;
+            target.x += (contentBounds_.width - target.width) / 2;
+            target.y += (contentBounds_.height - target.height) / 2;
+        }
+        renderer.drawYuv(slot.y, slot.u, slot.format == YuvImage::Format::I420 ? &slot.v : nullptr,
+                         target, matrix_, fullRange_);
+    }
+
+private:
+    static constexpr int RING_SIZE = 3;
+    
+    struct Slot {
+        Texture y, u, v;
+        int width = 0, height = 0;
+        YuvImage::Format format = YuvImage::Format::I420;
+    };
+    
+    YuvImage back_;                 // producer-owned, guarded by producerMutex_
+    YuvImage pending_;              // mailbox, guarded by mutex_
+    YuvImage front_;                // render thread only
+    bool hasPending_ = false;
+    uint64_t submitted_ = 0, dropped_ = 0, shown_ = 0;
+    std::mutex producerMutex_;
+    mutable std::mutex mutex_;
+    
+    Slot slots_[RING_SIZE];
+    int current_ = -1;
+    YuvMatrix matrix_ = YuvMatrix::Bt601;
+    bool fullRange_ = false;
+    bool preserveAspect_ = true;
+    
+    static void copyPlane(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int rowBytes, int rows) {
+        if (srcStride == rowBytes && dstStride == rowBytes) {
+            std::memcpy(dst, src, (size_t)rowBytes * rows);
+            return;
+        }
+        for (int row = 0; row < rows; ++row) {
+            std::memcpy(dst + (size_t)row * dstStride, src + (size_t)row * srcStride, rowBytes);
+        }
+    }
+    
+    void publish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(back_, pending_);
+            if (hasPending_) dropped_++;
+            hasPending_ = true;
+            submitted_++;
+        }
+        requestRedraw();
+    }
+    
+    void upload(const YuvImage& image) {
+        int next = (current_ + 1) % RING_SIZE;
+        Slot& slot = slots_[next];
+        bool nv12 = image.format == YuvImage::Format::NV12;
+        int cw = image.chromaWidth(), ch = image.chromaHeight();
+        if (slot.width != image.width || slot.height != image.height || slot.format != image.format ||
+            !slot.y.valid()) {
+            slot.y = Texture(image.width, image.height, image.y.data(), 1);
+            slot.u = Texture(cw, ch, image.u.data(), nv12 ? 2 : 1);
+            slot.v = nv12 ? Texture() : Texture(cw, ch, image.v.data(), 1);
+            slot.width = image.width;
+            slot.height = image.height;
+            slot.format = image.format;
+        } else {
+            slot.y.update(0, 0, image.width, image.height, GL_ALPHA, GL_UNSIGNED_BYTE, image.y.data());
+            slot.u.update(0, 0, cw, ch, nv12 ? GL_LUMINANCE_ALPHA : GL_ALPHA, GL_UNSIGNED_BYTE, image.u.data());
+            if (!nv12) slot.v.update(0, 0, cw, ch, GL_ALPHA, GL_UNSIGNED_BYTE, image.v.data());
+        }
+        current_ = next;
+        shown_++;
+    }
+};
+
+// Synthetic producer for exercising VideoFrame without a camera: 75% color
+// bars, a square moving 4 pixels per frame and the frame number as a row of
+// 16 black/white blocks along the bottom edge (least significant bit on the
+// left), in BT.601 limited range.
+class SyntheticVideoSource {
+public:
+    SyntheticVideoSource(int width, int height, YuvImage::Format format = YuvImage::Format::I420) {
+        image_.allocate(format, std::max(2, width), std::max(2, height));
+    }
+    
+    const YuvImage& frame(uint64_t index) {
+        static const float bars[7][3] = {
+            {0.75f, 0.75f, 0.75f}, {0.75f, 0.75f, 0}, {0, 0.75f, 0.75f}, {0, 0.75f, 0},
+            {0.75f, 0, 0.75f}, {0.75f, 0, 0}, {0, 0, 0.75f}
+        };
+        int w = image_.width, h = image_.height;
+        int box = std::max(2, h / 6);
+        int boxX = (int)((index * 4) % (uint64_t)std::max(1, w - box));
+        int boxY = h / 2 - box / 2;
+        int stripY = h - std::max(2, h / 16);
+        int block = std::max(1, w / 16);
+        
+        auto colorAt = [&](int x, int y, float rgb[3]) {
+            if (y >= stripY) {
+                int bit = x / block;
+                float c = bit < 16 && ((index >> bit) & 1) ? 1.0f : 0.0f;
+                rgb[0] = rgb[1] = rgb[2] = c;
+            } else if (x >= boxX && x < boxX + box && y >= boxY && y < boxY + box) {
+                rgb[0] = rgb[1] = rgb[2] = 1.0f;
+            } else {
+                const float* bar = bars[std::min(6, x * 7 / w)];
+                rgb[0] = bar[0];
+                rgb[1] = bar[1];
+                rgb[2] = bar[2];
+            }
+        };
+        
+        float rgb[3];
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                colorAt(x, y, rgb);
+                image_.y[(size_t)y * w + x] = toByte(16 + 65.481f * rgb[0] + 128.553f * rgb[1] + 24.966f * rgb[2]);
+            }
+        }
+        int cw = image_.chromaWidth();
+        for (int y = 0; y < image_.chromaHeight(); ++y) {
+            for (int x = 0; x < cw; ++x) {
+                colorAt(std::min(x * 2, w - 1), std::min(y * 2, h - 1), rgb);
+                uint8_t u = toByte(128 - 37.797f * rgb[0] - 74.203f * rgb[1] + 112.0f * rgb[2]);
+                uint8_t v = toByte(128 + 112.0f * rgb[0] - 93.786f * rgb[1] - 18.214f * rgb[2]);
+                if (image_.format == YuvImage::Format::NV12) {
+                    image_.u[((size_t)y * cw + x) * 2] = u;
+                    image_.u[((size_t)y * cw + x) * 2 + 1] = v;
+                } else {
+                    image_.u[(size_t)y * cw + x] = u;
+                    image_.v[(size_t)y * cw + x] = v;
+                }
+            }
+        }
+        return image_;
+    }
+    
+    void submitTo(VideoFrame& target, uint64_t index) { target.submit(frame(index)); }
+
+private:
+    YuvImage image_;
+    
+    static uint8_t toByte(float v) { return (uint8_t)std::clamp((int)std::lround(v), 0, 255); }
+};
+
+} // namespace MetaUI
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "core.hpp"
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <functional>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace MetaUI {
 
@@ -12,6 +15,57 @@ class Widget;
 
 using WidgetPtr = std::shared_ptr<Widget>;
 
+// ============================================================================
+// Redraw Requests
+// ============================================================================
+
+// Wakes the Application's event loop from any thread: an eventfd it polls
+// next to the display connection. Widgets fed by producer threads (charts,
+// video) signal through Widget::requestRedraw(); window() records that the
+// window itself, rather than a widget's own subsurface, needs drawing.
+class RedrawSignal {
+public:
+    static RedrawSignal& shared() {
+        static RedrawSignal signal;
+        return signal;
+    }
+    
+    RedrawSignal(const RedrawSignal&) = delete;
+    RedrawSignal& operator=(const RedrawSignal&) = delete;
+    
+    int fd() const { return fd_; }
+    
+    void notify() {
+        uint64_t one = 1;
+        ssize_t written = write(fd_, &one, sizeof(one));
+        (void)written;
+    }
+    
+    // Only the first request before the loop takes it writes the eventfd,
+    // so producers calling this per sample stay off the syscall path.
+    void window() {
+        if (!window_.exchange(true, std::memory_order_acq_rel)) notify();
+    }
+    
+    // Loop side, once fd() is readable: clears the wakeup and returns
+    // whether the window was asked for since the last call. The eventfd is
+    // drained before the flags are cleared, so a request racing with this
+    // either is returned here or wakes the loop again.
+    bool take() {
+        uint64_t count;
+        ssize_t got = read(fd_, &count, sizeof(count));
+        (void)got;
+        return window_.exchange(false, std::memory_order_acq_rel);
+    }
+
+private:
+    int fd_;
+    std::atomic<bool> window_{false};
+    
+    RedrawSignal() : fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+    ~RedrawSignal() { if (fd_ >= 0) close(fd_); }
+};
+
 // ============================================================================
 // Widget Base Class
 // ============================================================================
@@ -22,25 +76,27 @@ public:
     virtual ~Widget() = default;
     
     // Layout
-    Widget& width(SizeSpec spec) { widthSpec_ = spec; return *this; }
-    Widget& height(SizeSpec spec) { heightSpec_ = spec; return *this; }
-    Widget& size(SizeSpec w, SizeSpec h) { widthSpec_ = w; heightSpec_ = h; return *this; }
+    Widget& width(SizeSpec spec) { widthSpec_ = spec; requestRedraw(); return *this; }
+    Widget& height(SizeSpec spec) { heightSpec_ = spec; requestRedraw(); return *this; }
+    Widget& size(SizeSpec w, SizeSpec h) { widthSpec_ = w; heightSpec_ = h; requestRedraw(); return *this; }
     
     // Styling
-    Widget& padding(const Padding& p) { style_.padding = p; return *this; }
-    Widget& padding(float all) { style_.padding = Padding(all); return *this; }
-    Widget& margin(const Padding& m) { style_.margin = m; return *this; }
-    Widget& margin(float all) { style_.margin = Padding(all); return *this; }
+    Widget& padding(const Padding& p) { style_.padding = p; requestRedraw(); return *this; }
+    Widget& padding(float all) { style_.padding = Padding(all); requestRedraw(); return *this; }
+    Widget& margin(const Padding& m) { style_.margin = m; requestRedraw(); return *this; }
+    Widget& margin(float all) { style_.margin = Padding(all); requestRedraw(); return *this; }
     
-    Widget& background(const Color& c) { style_.background = c; return *this; }
+    Widget& background(const Color& c) { style_.background = c; requestRedraw(); return *this; }
     Widget& border(const Color& c, float width = 1.0f) { 
         style_.borderColor = c; 
         style_.borderWidth = width; 
+        requestRedraw();
         return *this; 
     }
-    Widget& borderRadius(float r) { style_.borderRadius = BorderRadius(r); return *this; }
+    Widget& borderRadius(float r) { style_.borderRadius = BorderRadius(r); requestRedraw(); return *this; }
     Widget& borderRadius(float tl, float tr, float br, float bl) {
         style_.borderRadius = BorderRadius(tl, tr, br, bl);
+        requestRedraw();
         return *this;
     }
     
@@ -49,6 +105,7 @@ public:
         style_.shadowColor = c;
         style_.shadowOffset = offset;
         style_.shadowBlur = blur;
+        requestRedraw();
         return *this;
     }
     
@@ -57,9 +114,14 @@ public:
         style_.gradientStart = start;
         style_.gradientEnd = end;
         style_.gradientAngle = angle;
+        requestRedraw();
         return *this;
     }
     
+    // Frosted glass: blurs whatever is drawn behind the widget. Pair with a
+    // translucent background() for the tint.
+    Widget& backdropBlur(float radius) { style_.backdropBlur = radius; requestRedraw(); return *this; }
+    
     // Event handlers
     Widget& onClick(std::function<void()> handler) {
         onClickHandler_ = std::move(handler);
@@ -77,13 +139,55 @@ public:
     }
     
     // Visibility
-    Widget& visible(bool v) { visible_ = v; return *this; }
-    Widget& enabled(bool e) { enabled_ = e; return *this; }
+    Widget& visible(bool v) { visible_ = v; requestRedraw(); return *this; }
+    Widget& enabled(bool e) { enabled_ = e; requestRedraw(); return *this; }
     
     // Getters
     const Rect& bounds() const { return bounds_; }
     const BoxStyle& style() const { return style_; }
     bool isVisible() const { return visible_; }
+    
+    // Asks the Application for a Wayland subsurface of its own, so content
+    // that changes every frame (charts, video) commits without redrawing
+    // the rest of the window. Ignored when the compositor lacks
+    // wl_subcompositor. A scale below 1 renders the surface at that
+    // fraction of its size for the compositor to stretch (wp_viewporter).
+    Widget& separateSurface(bool s = true, float scale = 1.0f) {
+        separateSurface_ = s;
+        surfaceScale_ = scale;
+        RedrawSignal::shared().window();   // the window re-attaches
+        return *this;
+    }
+    bool wantsSeparateSurface() const { return separateSurface_; }
+    float surfaceScale() const { return surfaceScale_; }
+    
+    // Set by the Application while the widget renders into its own
+    // surface; containers skip it when drawing the window.
+    void setSurfaceAttached(bool attached) {
+        redrawRequested_.store(false, std::memory_order_relaxed);
+        surfaceAttached_.store(attached, std::memory_order_release);
+    }
+    bool hasSeparateSurface() const { return surfaceAttached_.load(std::memory_order_acquire); }
+    
+    // Draws the widget's surface (its subsurface, else the window) again
+    // without waiting for input. May be called from any thread.
+    void requestRedraw() {
+        if (hasSeparateSurface()) {
+            if (!redrawRequested_.exchange(true, std::memory_order_acq_rel)) RedrawSignal::shared().notify();
+        } else {
+            RedrawSignal::shared().window();
+        }
+    }
+    
+    // Clears and returns a pending requestRedraw() of an attached widget.
+    bool takeRedrawRequest() { return redrawRequested_.exchange(false, std::memory_order_acq_rel); }
+    
+    // Whole-pixel area its own surface covers, in window coordinates.
+    Rect surfaceBounds() const {
+        return Rect(std::floor(bounds_.x), std::floor(bounds_.y),
+                    (float)std::max(1, (int)std::ceil(bounds_.width)),
+                    (float)std::max(1, (int)std::ceil(bounds_.height)));
+    }
     bool isEnabled() const { return enabled_; }
     bool isHovered() const { return hovered_; }
     bool isFocused() const { return focused_; }
@@ -191,6 +295,10 @@ protected:
     bool enabled_ = true;
     bool hovered_ = false;
     bool focused_ = false;
+    bool separateSurface_ = false;
+    std::atomic<bool> surfaceAttached_{false};
+    std::atomic<bool> redrawRequested_{false};
+    float surfaceScale_ = 1.0f;
     
     std::function<void()> onClickHandler_;
     std::function<void(bool)> onHoverHandler_;
@@ -205,11 +313,13 @@ class Container : public Widget {
 public:
     Container& addChild(WidgetPtr child) {
         children_.push_back(std::move(child));
+        requestRedraw();
         return *this;
     }
     
     Container& clearChildren() {
         children_.clear();
+        requestRedraw();
         return *this;
     }
     
@@ -218,7 +328,7 @@ public:
     void render(Renderer& renderer) override {
         Widget::render(renderer);
         for (auto& child : children_) {
-            if (child->isVisible()) child->render(renderer);
+            if (child->isVisible() && !child->hasSeparateSurface()) child->render(renderer);
         }
     }
     
@@ -242,4 +352,14 @@ protected:
     std::vector<WidgetPtr> children_;
 };
 
+// Widgets under widget that asked for separateSurface(), in tree order.
+inline void collectSeparateSurfaces(const Widget& widget, std::vector<WidgetPtr>& out) {
+    auto* container = dynamic_cast<const Container*>(&widget);
+    if (!container) return;
+    for (const auto& child : container->children()) {
+        if (child->wantsSeparateSurface()) out.push_back(child);
+        collectSeparateSurfaces(*child, out);
+    }
+}
+
 } // namespace MetaUI
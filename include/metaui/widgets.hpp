@@ -5,6 +5,12 @@
 #include "renderer.hpp"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
 
 namespace MetaUI {
 
@@ -16,21 +22,23 @@ class Text : public Widget {
 public:
     explicit Text(const std::string& text = "") : text_(text) {}
     
-    Text& text(const std::string& t) { text_ = t; return *this; }
+    Text& text(const std::string& t) { text_ = t; requestRedraw(); return *this; }
     Text& font(const std::string& family, float size = 14.0f) {
         textStyle_.fontFamily = family;
         textStyle_.fontSize = size;
+        requestRedraw();
         return *this;
     }
-    Text& fontSize(float size) { textStyle_.fontSize = size; return *this; }
-    Text& color(const Color& c) { textStyle_.color = c; return *this; }
-    Text& bold(bool b = true) { textStyle_.bold = b; return *this; }
-    Text& italic(bool i = true) { textStyle_.italic = i; return *this; }
-    Text& align(TextStyle::Align a) { textStyle_.align = a; return *this; }
-    Text& valign(TextStyle::VAlign a) { textStyle_.valign = a; return *this; }
-    Text& lineHeight(float h) { textStyle_.lineHeight = h; return *this; }
-    Text& wrap(bool w) { wrap_ = w; return *this; }
-    Text& maxWidth(float w) { maxWidth_ = w; return *this; }
+    Text& fontSize(float size) { textStyle_.fontSize = size; requestRedraw(); return *this; }
+    Text& color(const Color& c) { textStyle_.color = c; requestRedraw(); return *this; }
+    Text& bold(bool b = true) { textStyle_.bold = b; requestRedraw(); return *this; }
+    Text& italic(bool i = true) { textStyle_.italic = i; requestRedraw(); return *this; }
+    Text& align(TextStyle::Align a) { textStyle_.align = a; requestRedraw(); return *this; }
+    Text& valign(TextStyle::VAlign a) { textStyle_.valign = a; requestRedraw(); return *this; }
+    Text& lineHeight(float h) { textStyle_.lineHeight = h; requestRedraw(); return *this; }
+    Text& truncate(TextStyle::Truncate t) { textStyle_.truncate = t; requestRedraw(); return *this; }
+    Text& wrap(bool w) { wrap_ = w; requestRedraw(); return *this; }
+    Text& maxWidth(float w) { maxWidth_ = w; requestRedraw(); return *this; }
     
     const std::string& getText() const { return text_; }
     const TextStyle& textStyle() const { return textStyle_; }
@@ -46,10 +54,17 @@ public:
         
         if (text_.empty()) return;
         
-        Font* font = renderer.loadFont(textStyle_.fontFamily, textStyle_.fontSize);
+        Font* font = renderer.loadFont(textStyle_);
         if (!font) return;
         
-        Size textSize = font->measureText(text_);
+        const GlyphRun* elided = nullptr;
+        Size textSize;
+        if (textStyle_.truncate != TextStyle::Truncate::None) {
+            elided = &elided_.layout(font, text_, contentBounds_.width, textStyle_.truncate);
+            textSize = Size(elided->width, elided->height);
+        } else {
+            textSize = font->measureText(text_);
+        }
         
         // Calculate position based on alignment
         Point textPos = contentBounds_.topLeft();
@@ -76,7 +91,16 @@ public:
                 break;
         }
         
-        renderer.drawText(text_, textPos, font, textStyle_.color, textStyle_);
+        if (elided) {
+            // The width doesn't depend on the pen. Measuring kept the pen of
+            // the last frame, so this lays out again only when the aligned
+            // position's fraction moved.
+            elided = &elided_.layout(font, text_, contentBounds_.width, textStyle_.truncate,
+                                     textPos.x);
+            renderer.drawGlyphRun(*elided, textPos, textStyle_.color);
+        } else {
+            renderer.drawText(text_, textPos, font, textStyle_.color, textStyle_);
+        }
     }
     
 private:
@@ -84,6 +108,369 @@ private:
     TextStyle textStyle_;
     bool wrap_ = false;
     float maxWidth_ = 0;
+    ElidedText elided_;
+};
+
+// ============================================================================
+// Rich Text Widget
+// ============================================================================
+
+struct TextSpan {
+    std::string text;
+    TextStyle style;
+};
+
+// One paragraph of mixed styles. Spans are decoded into glyphs once, lines
+// are broken once per width, and the positioned quads are kept in one run
+// per font, so a frame costs one batched draw per distinct font no matter
+// how many spans there are.
+class RichText : public Widget {
+public:
+    RichText() = default;
+    
+    // Appends a span. The overloads without a full style start from the
+    // base style set with font()/fontSize()/color().
+    RichText& span(const std::string& text, const TextStyle& style) {
+        spans_.push_back({text, style});
+        shaped_ = false;
+        requestRedraw();
+        return *this;
+    }
+    RichText& span(const std::string& text) { return span(text, baseStyle_); }
+    RichText& span(const std::string& text, const Color& color) {
+        TextStyle style = baseStyle_;
+        style.color = color;
+        return span(text, style);
+    }
+    RichText& spans(std::vector<TextSpan> s) {
+        spans_ = std::move(s);
+        shaped_ = false;
+        requestRedraw();
+        return *this;
+    }
+    RichText& clearSpans() {
+        spans_.clear();
+        shaped_ = false;
+        requestRedraw();
+        return *this;
+    }
+    
+    RichText& font(const std::string& family, float size = 14.0f) {
+        baseStyle_.fontFamily = family;
+        baseStyle_.fontSize = size;
+        requestRedraw();
+        return *this;
+    }
+    RichText& fontSize(float size) { baseStyle_.fontSize = size; requestRedraw(); return *this; }
+    RichText& color(const Color& c) { baseStyle_.color = c; requestRedraw(); return *this; }
+    RichText& align(TextStyle::Align a) { align_ = a; layoutWidth_ = -1; requestRedraw(); return *this; }
+    RichText& lineSpacing(float s) { lineSpacing_ = s; layoutWidth_ = -1; requestRedraw(); return *this; }
+    RichText& wrap(bool w) { wrap_ = w; layoutWidth_ = -1; requestRedraw(); return *this; }
+    
+    const std::vector<TextSpan>& getSpans() const { return spans_; }
+    
+    // Measuring has no renderer to shape with, so it reuses the layout from
+    // the last frame at the same width and estimates otherwise.
+    Size measureContent(Size available) override {
+        float width = available.width - style_.padding.horizontal();
+        if (shaped_ && layoutWidth_ == (wrap_ ? width : 0)) {
+            return Size(layoutSize_.width, layoutSize_.height);
+        }
+        
+        float lineWidth = 0, maxWidth = 0, height = 0, lineHeight = 0;
+        for (const auto& span : spans_) {
+            float advance = span.style.fontSize * 0.6f;
+            float spanLine = span.style.fontSize * span.style.lineHeight;
+            for (char c : span.text) {
+                if (((unsigned char)c & 0xC0) == 0x80) continue;
+                lineHeight = std::max(lineHeight, spanLine);
+                if (c == '\n' || (wrap_ && width > 0 && lineWidth + advance > width)) {
+                    maxWidth = std::max(maxWidth, lineWidth);
+                    height += lineHeight;
+                    lineWidth = 0;
+                    if (c == '\n') continue;
+                }
+                lineWidth += advance;
+            }
+        }
+        maxWidth = std::max(maxWidth, lineWidth);
+        return Size(maxWidth, height + lineHeight);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        if (spans_.empty()) return;
+        
+        if (!shaped_ || shapedFor_ != &renderer) shape(renderer);
+        float width = wrap_ ? contentBounds_.width : 0;
+        if (layoutWidth_ != width) breakLines(width);
+        
+        Point origin = contentBounds_.topLeft();
+        for (size_t f = 0; f < fonts_.size(); ++f) {
+            if (runs_[f].empty() && runs_[f].colorGlyphs.empty()) continue;
+            renderer.beginGlyphBatch(fonts_[f]);
+            renderer.batchGlyphRun(runs_[f], origin, baseStyle_.color);
+            renderer.endGlyphBatch();
+        }
+    }
+    
+private:
+    enum class ClusterKind : uint8_t { Glyph, Space, Newline };
+    
+    struct Cluster {
+        int codepoint;
+        float advance;
+        uint16_t font;
+        uint16_t span;
+        ClusterKind kind;
+    };
+    
+    std::vector<TextSpan> spans_;
+    TextStyle baseStyle_;
+    TextStyle::Align align_ = TextStyle::Align::Left;
+    float lineSpacing_ = 1.0f;
+    bool wrap_ = true;
+    
+    // Shaping: code points and advances per span, independent of width.
+    bool shaped_ = false;
+    Renderer* shapedFor_ = nullptr;
+    std::vector<Font*> fonts_;
+    std::vector<Cluster> clusters_;
+    
+    // Line layout for layoutWidth_ (0 = unbounded); one run per font.
+    float layoutWidth_ = -1;
+    Size layoutSize_;
+    std::vector<GlyphRun> runs_;
+    
+    void shape(Renderer& renderer) {
+        fonts_.clear();
+        clusters_.clear();
+        
+        for (size_t s = 0; s < spans_.size(); ++s) {
+            const TextSpan& span = spans_[s];
+            Font* font = renderer.loadFont(span.style);
+            if (!font || !font->valid()) continue;
+            
+            auto it = std::find(fonts_.begin(), fonts_.end(), font);
+            uint16_t fontIndex = (uint16_t)(it - fonts_.begin());
+            if (it == fonts_.end()) fonts_.push_back(font);
+            
+            const std::string& text = span.text;
+            for (size_t i = 0; i < text.size(); ) {
+                Cluster c{0, 0, fontIndex, (uint16_t)s, ClusterKind::Glyph};
+                if (text[i] == '\n') {
+                    c.kind = ClusterKind::Newline;
+                    i++;
+                } else {
+                    c.codepoint = Font::decodeUTF8(text, i);
+                    const Font::GlyphInfo* glyph = font->getGlyph(c.codepoint);
+                    if (!glyph) continue;
+                    c.advance = glyph->advance;
+                    if (c.codepoint == ' ' || c.codepoint == '\t') c.kind = ClusterKind::Space;
+                }
+                clusters_.push_back(c);
+            }
+        }
+        
+        runs_.resize(fonts_.size());
+        shaped_ = true;
+        shapedFor_ = &renderer;
+        layoutWidth_ = -1;
+    }
+    
+    // Greedy line breaking at spaces; a word longer than the line is split
+    // between glyphs.
+    void breakLines(float maxWidth) {
+        for (auto& run : runs_) {
+            run.quads.clear();
+            run.colors.clear();
+            run.colorGlyphs.clear();
+        }
+        for (size_t f = 0; f < fonts_.size(); ++f) runs_[f].font = fonts_[f];
+        
+        layoutWidth_ = maxWidth;
+        layoutSize_ = Size(0, 0);
+        
+        float y = 0;
+        size_t lineStart = 0;
+        while (lineStart < clusters_.size()) {
+            size_t lineEnd = lineStart;   // exclusive, before trailing break
+            size_t next = clusters_.size();
+            size_t lastSpace = SIZE_MAX;
+            float x = 0;
+            
+            for (size_t i = lineStart; i < clusters_.size(); ++i) {
+                const Cluster& c = clusters_[i];
+                if (c.kind == ClusterKind::Newline) {
+                    lineEnd = i;
+                    next = i + 1;
+                    break;
+                }
+                if (c.kind == ClusterKind::Space) lastSpace = i;
+                if (maxWidth > 0 && c.kind == ClusterKind::Glyph &&
+                    x + c.advance > maxWidth && i > lineStart) {
+                    if (lastSpace != SIZE_MAX && lastSpace > lineStart) {
+                        lineEnd = lastSpace;
+                        next = lastSpace + 1;
+                    } else {
+                        lineEnd = i;
+                        next = i;
+                    }
+                    break;
+                }
+                x += c.advance;
+                lineEnd = i + 1;
+            }
+            
+            y = emitLine(lineStart, lineEnd, next, y, maxWidth);
+            lineStart = next;
+        }
+        
+        // A trailing newline still opens an empty last line.
+        if (!clusters_.empty() && clusters_.back().kind == ClusterKind::Newline) {
+            y += fonts_[clusters_.back().font]->lineHeight() * lineSpacing_;
+        }
+        layoutSize_.height = y;
+    }
+    
+    float emitLine(size_t begin, size_t end, size_t next, float y, float maxWidth) {
+        // Metrics cover the break cluster too, so empty lines keep their height.
+        float ascent = 0, height = 0;
+        size_t metricsEnd = std::max(end, std::min(next, clusters_.size()));
+        for (size_t i = begin; i < metricsEnd; ++i) {
+            Font* font = fonts_[clusters_[i].font];
+            ascent = std::max(ascent, (float)font->ascent());
+            height = std::max(height, (float)font->lineHeight());
+        }
+        
+        float width = 0;
+        size_t visibleEnd = end;
+        while (visibleEnd > begin && clusters_[visibleEnd - 1].kind == ClusterKind::Space) visibleEnd--;
+        for (size_t i = begin; i < visibleEnd; ++i) width += clusters_[i].advance;
+        layoutSize_.width = std::max(layoutSize_.width, width);
+        
+        float x = 0;
+        if (maxWidth > 0 && align_ == TextStyle::Align::Center) x = (maxWidth - width) / 2;
+        if (maxWidth > 0 && align_ == TextStyle::Align::Right) x = maxWidth - width;
+        float baseline = std::round(y + ascent);
+        
+        for (size_t i = begin; i < visibleEnd; ++i) {
+            const Cluster& c = clusters_[i];
+            float originX;
+            const Font::GlyphInfo* g = fonts_[c.font]->getGlyphAt(c.codepoint, x, originX);
+            if (g && g->color) {
+                runs_[c.font].colorGlyphs.push_back({originX, baseline, (uint32_t)c.codepoint});
+            } else if (g && g->width > 0) {
+                GlyphRun& run = runs_[c.font];
+                const Color& color = spans_[c.span].style.color;
+                if (run.colors.empty() || !sameColor(run.colors.back().color, color)) {
+                    run.colors.push_back({(uint32_t)run.quads.size(), color});
+                }
+                run.quads.push_back({
+                    originX + g->x0, baseline + g->y0, originX + g->x1, baseline + g->y1,
+                    g->u0, g->v0, g->u1, g->v1
+                });
+            }
+            x += c.advance;
+        }
+        
+        return y + height * lineSpacing_;
+    }
+    
+    static bool sameColor(const Color& a, const Color& b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+};
+
+// ============================================================================
+// Numeric Label Widget
+// ============================================================================
+
+// Label for values that change every frame (counters, clocks, FPS readouts).
+// Values are formatted into a fixed buffer and only the characters that
+// changed get new quads, so an update neither allocates nor re-lays out.
+class NumericLabel : public Widget {
+public:
+    NumericLabel() = default;
+    
+    template<typename T>
+    NumericLabel& value(T v) {
+        static_assert(std::is_arithmetic_v<T>, "NumericLabel::value needs a number");
+        int n;
+        if constexpr (std::is_integral_v<T>) {
+            n = std::snprintf(buffer_, sizeof(buffer_), "%s%lld%s",
+                              prefix_.c_str(), (long long)v, suffix_.c_str());
+        } else {
+            n = std::snprintf(buffer_, sizeof(buffer_), "%s%.*f%s",
+                              prefix_.c_str(), decimals_, (double)v, suffix_.c_str());
+        }
+        length_ = (size_t)std::clamp(n, 0, (int)sizeof(buffer_) - 1);
+        requestRedraw();
+        return *this;
+    }
+    
+    // Preformatted text such as "12:04:59"; truncated to NumericRun::MAX_CHARS.
+    NumericLabel& text(std::string_view t) {
+        length_ = std::min(t.size(), NumericRun::MAX_CHARS);
+        std::memcpy(buffer_, t.data(), length_);
+        buffer_[length_] = '\0';
+        requestRedraw();
+        return *this;
+    }
+    
+    // Formatting options apply from the next value().
+    NumericLabel& decimals(int d) { decimals_ = std::max(0, d); return *this; }
+    NumericLabel& prefix(const std::string& p) { prefix_ = p; return *this; }
+    NumericLabel& suffix(const std::string& s) { suffix_ = s; return *this; }
+    
+    NumericLabel& font(const std::string& family, float size = 14.0f) {
+        textStyle_.fontFamily = family;
+        textStyle_.fontSize = size;
+        font_ = nullptr;
+        requestRedraw();
+        return *this;
+    }
+    NumericLabel& fontSize(float size) { textStyle_.fontSize = size; font_ = nullptr; requestRedraw(); return *this; }
+    NumericLabel& color(const Color& c) { textStyle_.color = c; requestRedraw(); return *this; }
+    NumericLabel& align(TextStyle::Align a) { textStyle_.align = a; requestRedraw(); return *this; }
+    
+    const char* getText() const { return buffer_; }
+    
+    Size measureContent(Size available) override {
+        return Size(std::max<size_t>(length_, 1) * textStyle_.fontSize * 0.6f,
+                    textStyle_.fontSize * textStyle_.lineHeight);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        
+        // Fonts are looked up once, not per frame: loadFont builds a key string.
+        if (!font_ || fontFor_ != &renderer) {
+            font_ = renderer.loadFont(textStyle_);
+            fontFor_ = &renderer;
+        }
+        run_.setFont(font_);
+        run_.setText(buffer_, length_);
+        
+        Point pos = contentBounds_.topLeft();
+        if (textStyle_.align == TextStyle::Align::Center) {
+            pos.x += (contentBounds_.width - run_.width()) / 2;
+        } else if (textStyle_.align == TextStyle::Align::Right) {
+            pos.x += contentBounds_.width - run_.width();
+        }
+        renderer.drawGlyphRun(run_.run(), pos, textStyle_.color);
+    }
+    
+private:
+    TextStyle textStyle_;
+    char buffer_[NumericRun::MAX_CHARS + 1] = {};
+    size_t length_ = 0;
+    int decimals_ = 0;
+    std::string prefix_;
+    std::string suffix_;
+    NumericRun run_;
+    Font* font_ = nullptr;
+    Renderer* fontFor_ = nullptr;
 };
 
 // ============================================================================
@@ -97,12 +484,25 @@ public:
     Image& path(const std::string& p) { 
         imagePath_ = p; 
         texture_ = nullptr;  // Force reload
+        svgSize_ = Size();
+        requestRedraw();
         return *this; 
     }
-    Image& fit(bool f) { fit_ = f; return *this; }
-    Image& preserveAspect(bool p) { preserveAspect_ = p; return *this; }
-    Image& opacity(float o) { opacity_ = std::clamp(o, 0.0f, 1.0f); return *this; }
-    Image& tint(const Color& c) { tint_ = c; hasTint_ = true; return *this; }
+    Image& fit(bool f) { fit_ = f; requestRedraw(); return *this; }
+    Image& preserveAspect(bool p) { preserveAspect_ = p; requestRedraw(); return *this; }
+    Image& opacity(float o) { opacity_ = std::clamp(o, 0.0f, 1.0f); requestRedraw(); return *this; }
+    Image& tint(const Color& c) { tint_ = c; hasTint_ = true; requestRedraw(); return *this; }
+    
+    // Stretches the image over the content box keeping borders of the
+    // given insets (image pixels, drawn at scale times that), for skinned
+    // buttons and frames.
+    Image& ninePatch(const Padding& insets, float scale = 1.0f) {
+        ninePatch_ = true;
+        ninePatchInsets_ = insets;
+        ninePatchScale_ = scale;
+        requestRedraw();
+        return *this;
+    }
     
     const std::string& imagePath() const { return imagePath_; }
     bool shouldFit() const { return fit_; }
@@ -115,6 +515,7 @@ public:
         }
         
         // Otherwise use image size or default
+        if (svgSize_.width > 0) return svgSize_;
         if (texture_ && texture_->valid()) {
             return Size(texture_->width(), texture_->height());
         }
@@ -130,13 +531,22 @@ public:
             return;
         }
         
+        if (SvgImage::isSvgPath(imagePath_)) {
+            renderSvg(renderer);
+            return;
+        }
+        
         // Load texture if needed
         if (!texture_) {
             texture_ = renderer.loadImage(imagePath_);
         }
         
         if (texture_ && texture_->valid()) {
-            if (preserveAspect_) {
+            if (ninePatch_) {
+                Color color = hasTint_ ? tint_ : Color(1, 1, 1, 1);
+                color.a *= opacity_;
+                renderer.drawNinePatch(*texture_, contentBounds_, ninePatchInsets_, color, ninePatchScale_);
+            } else if (preserveAspect_) {
                 renderer.drawImageScaled(*texture_, contentBounds_, true, opacity_);
             } else {
                 renderer.drawImage(*texture_, contentBounds_, opacity_);
@@ -148,13 +558,38 @@ public:
     }
     
 private:
+    // Rasterized at the drawn size every frame; the renderer caches per size.
+    void renderSvg(Renderer& renderer) {
+        svgSize_ = renderer.svgSize(imagePath_);
+        if (svgSize_.width <= 0 || svgSize_.height <= 0) {
+            renderer.drawRect(contentBounds_, Color(0.5f, 0.2f, 0.2f, 0.5f));
+            return;
+        }
+        
+        Rect target = contentBounds_;
+        if (preserveAspect_) {
+            float scale = std::min(target.width / svgSize_.width, target.height / svgSize_.height);
+            target.width = svgSize_.width * scale;
+            target.height = svgSize_.height * scale;
+            target.x += (contentBounds_.width - target.width) / 2;
+            target.y += (contentBounds_.height - target.height) / 2;
+        }
+        if (Texture* texture = renderer.loadSvg(imagePath_, target.width, target.height)) {
+            renderer.drawImage(*texture, target, opacity_);
+        }
+    }
+    
     std::string imagePath_;
     Texture* texture_ = nullptr;
+    Size svgSize_;
     bool fit_ = true;
     bool preserveAspect_ = true;
     float opacity_ = 1.0f;
     Color tint_;
     bool hasTint_ = false;
+    bool ninePatch_ = false;
+    Padding ninePatchInsets_;
+    float ninePatchScale_ = 1.0f;
 };
 
 // ============================================================================
@@ -169,20 +604,25 @@ public:
         heightSpec_ = SizeSpec::fixed(size);
     }
     
-    Icon& name(const std::string& n) { name_ = n; return *this; }
+    Icon& name(const std::string& n) { name_ = n; requestRedraw(); return *this; }
     Icon& size(float s) { 
         size_ = s; 
         widthSpec_ = SizeSpec::fixed(s);
         heightSpec_ = SizeSpec::fixed(s);
+        requestRedraw();
         return *this; 
     }
-    Icon& color(const Color& c) { color_ = c; return *this; }
+    Icon& color(const Color& c) { color_ = c; requestRedraw(); return *this; }
     
     void render(Renderer& renderer) override {
         Widget::render(renderer);
         
-        // For now, draw a simple shape as placeholder
-        // In production, would load from icon font or sprite sheet
+        float side = std::min(contentBounds_.width, contentBounds_.height);
+        Rect box(contentBounds_.x + (contentBounds_.width - side) / 2,
+                 contentBounds_.y + (contentBounds_.height - side) / 2, side, side);
+        if (renderer.drawIcon(name_, box, color_)) return;
+        
+        // Unknown icon (or no icon font installed): placeholder dot.
         float cx = contentBounds_.x + contentBounds_.width / 2;
         float cy = contentBounds_.y + contentBounds_.height / 2;
         float r = std::min(contentBounds_.width, contentBounds_.height) / 2 - 2;
@@ -200,6 +640,74 @@ private:
     Color color_ = Color(1, 1, 1, 1);
 };
 
+// ============================================================================
+// Canvas Widget
+// ============================================================================
+
+// Drawing state handed to a Canvas draw callback. Coordinates start at the
+// canvas's top-left corner; save()/restore() bracket transform changes.
+class CanvasContext {
+public:
+    CanvasContext(Renderer& renderer, const Transform2D& origin)
+        : renderer_(renderer), transform_(origin) {}
+    
+    void save() { stack_.push_back(transform_); }
+    void restore() {
+        if (stack_.empty()) return;
+        transform_ = stack_.back();
+        stack_.pop_back();
+    }
+    
+    CanvasContext& translate(float x, float y) { transform_ = transform_ * Transform2D::translation(x, y); return *this; }
+    CanvasContext& rotate(float radians) { transform_ = transform_ * Transform2D::rotation(radians); return *this; }
+    CanvasContext& scale(float sx, float sy) { transform_ = transform_ * Transform2D::scaling(sx, sy); return *this; }
+    CanvasContext& transform(const Transform2D& t) { transform_ = transform_ * t; return *this; }
+    
+    void fill(const VectorPath& path, const Color& color, FillRule rule = FillRule::NonZero) {
+        renderer_.fillPath(path, transform_, color, rule);
+    }
+    void stroke(const VectorPath& path, const Color& color, const StrokeStyle& style = StrokeStyle()) {
+        renderer_.strokePath(path, transform_, color, style);
+    }
+    
+    const Transform2D& currentTransform() const { return transform_; }
+    Renderer& renderer() { return renderer_; }
+    
+private:
+    Renderer& renderer_;
+    Transform2D transform_;
+    std::vector<Transform2D> stack_;
+};
+
+// Custom vector drawing. Build VectorPaths once (e.g. captured by the
+// callback) and move them with the context transform: the renderer keeps
+// their tessellation on the GPU until a path changes.
+class Canvas : public Widget {
+public:
+    using DrawHandler = std::function<void(CanvasContext&, const Size&)>;
+    
+    explicit Canvas(DrawHandler handler = nullptr) : onDraw_(std::move(handler)) {}
+    
+    Canvas& onDraw(DrawHandler handler) { onDraw_ = std::move(handler); return *this; }
+    
+    Size measureContent(Size /*available*/) override {
+        return Size(100, 100);
+    }
+    
+    void render(Renderer& renderer) override {
+        Widget::render(renderer);
+        if (!onDraw_) return;
+        
+        renderer.pushClip(contentBounds_);
+        CanvasContext context(renderer, Transform2D::translation(contentBounds_.x, contentBounds_.y));
+        onDraw_(context, Size(contentBounds_.width, contentBounds_.height));
+        renderer.popClip();
+    }
+    
+private:
+    DrawHandler onDraw_;
+};
+
 // ============================================================================
 // Button Widget
 // ============================================================================
@@ -216,12 +724,12 @@ public:
         textStyle_.align = TextStyle::Align::Center;
     }
     
-    Button& label(const std::string& l) { label_ = l; return *this; }
-    Button& textColor(const Color& c) { textStyle_.color = c; return *this; }
-    Button& fontSize(float s) { textStyle_.fontSize = s; return *this; }
-    Button& hoverStyle(const Color& bg) { hoverBg_ = bg; return *this; }
-    Button& activeStyle(const Color& bg) { activeBg_ = bg; return *this; }
-    Button& icon(const std::string& iconPath) { iconPath_ = iconPath; return *this; }
+    Button& label(const std::string& l) { label_ = l; requestRedraw(); return *this; }
+    Button& textColor(const Color& c) { textStyle_.color = c; requestRedraw(); return *this; }
+    Button& fontSize(float s) { textStyle_.fontSize = s; requestRedraw(); return *this; }
+    Button& hoverStyle(const Color& bg) { hoverBg_ = bg; requestRedraw(); return *this; }
+    Button& activeStyle(const Color& bg) { activeBg_ = bg; requestRedraw(); return *this; }
+    Button& icon(const std::string& iconPath) { iconPath_ = iconPath; requestRedraw(); return *this; }
     
     const std::string& getLabel() const { return label_; }
     
@@ -244,7 +752,7 @@ public:
         
         Widget::render(renderer);
         
-        Font* font = renderer.loadFont(textStyle_.fontFamily, textStyle_.fontSize);
+        Font* font = renderer.loadFont(textStyle_);
         if (font) {
             Size textSize = font->measureText(label_);
             Point textPos(
@@ -294,8 +802,8 @@ public:
         textStyle_.color = Color(1, 1, 1, 1);
     }
     
-    TextInput& placeholder(const std::string& p) { placeholder_ = p; return *this; }
-    TextInput& value(const std::string& v) { text_ = v; cursorPos_ = v.length(); return *this; }
+    TextInput& placeholder(const std::string& p) { placeholder_ = p; requestRedraw(); return *this; }
+    TextInput& value(const std::string& v) { text_ = v; cursorPos_ = v.length(); requestRedraw(); return *this; }
     TextInput& onChange(std::function<void(const std::string&)> handler) {
         onChangeHandler_ = std::move(handler);
         return *this;
@@ -323,7 +831,7 @@ public:
         
         Widget::render(renderer);
         
-        Font* font = renderer.loadFont(textStyle_.fontFamily, textStyle_.fontSize);
+        Font* font = renderer.loadFont(textStyle_);
         if (!font) return;
         
         std::string displayText = text_.empty() ? placeholder_ : text_;
@@ -405,15 +913,15 @@ public:
         style_.borderRadius = BorderRadius(3);
     }
     
-    Slider& range(float min, float max) { min_ = min; max_ = max; return *this; }
-    Slider& value(float v) { value_ = std::clamp(v, min_, max_); return *this; }
+    Slider& range(float min, float max) { min_ = min; max_ = max; requestRedraw(); return *this; }
+    Slider& value(float v) { value_ = std::clamp(v, min_, max_); requestRedraw(); return *this; }
     Slider& onChange(std::function<void(float)> handler) {
         onChangeHandler_ = std::move(handler);
         return *this;
     }
-    Slider& trackColor(const Color& c) { style_.background = c; return *this; }
-    Slider& thumbColor(const Color& c) { thumbColor_ = c; return *this; }
-    Slider& fillColor(const Color& c) { fillColor_ = c; return *this; }
+    Slider& trackColor(const Color& c) { style_.background = c; requestRedraw(); return *this; }
+    Slider& thumbColor(const Color& c) { thumbColor_ = c; requestRedraw(); return *this; }
+    Slider& fillColor(const Color& c) { fillColor_ = c; requestRedraw(); return *this; }
     
     float getValue() const { return value_; }
     
@@ -483,12 +991,12 @@ public:
         style_.borderRadius = BorderRadius(3);
     }
     
-    Checkbox& checked(bool c) { checked_ = c; return *this; }
+    Checkbox& checked(bool c) { checked_ = c; requestRedraw(); return *this; }
     Checkbox& onToggle(std::function<void(bool)> handler) {
         onToggleHandler_ = std::move(handler);
         return *this;
     }
-    Checkbox& checkColor(const Color& c) { checkColor_ = c; return *this; }
+    Checkbox& checkColor(const Color& c) { checkColor_ = c; requestRedraw(); return *this; }
     
     bool isChecked() const { return checked_; }
     
@@ -550,9 +1058,9 @@ public:
         style_.borderRadius = BorderRadius(3);
     }
     
-    ProgressBar& progress(float p) { progress_ = std::clamp(p, 0.0f, 1.0f); return *this; }
-    ProgressBar& fillColor(const Color& c) { fillColor_ = c; return *this; }
-    ProgressBar& showText(bool s) { showText_ = s; return *this; }
+    ProgressBar& progress(float p) { progress_ = std::clamp(p, 0.0f, 1.0f); requestRedraw(); return *this; }
+    ProgressBar& fillColor(const Color& c) { fillColor_ = c; requestRedraw(); return *this; }
+    ProgressBar& showText(bool s) { showText_ = s; requestRedraw(); return *this; }
     
     float getProgress() const { return progress_; }
     
@@ -568,16 +1076,20 @@ public:
         renderer.drawRoundedRect(fillRect, style_.borderRadius, fillColor_);
         
         if (showText_ && contentBounds_.height >= 14) {
-            std::string text = std::to_string((int)(progress_ * 100)) + "%";
-            Font* font = renderer.loadFont("", 10);
-            if (font) {
-                Size textSize = font->measureText(text);
-                Point textPos(
-                    contentBounds_.x + (contentBounds_.width - textSize.width) / 2,
-                    contentBounds_.y + (contentBounds_.height - textSize.height) / 2
-                );
-                renderer.drawText(text, textPos, font, Color(1, 1, 1, 1), TextStyle());
+            if (!font_ || fontFor_ != &renderer) {
+                font_ = renderer.loadFont("", 10);
+                fontFor_ = &renderer;
             }
+            char text[8];
+            int n = std::snprintf(text, sizeof(text), "%d%%", (int)(progress_ * 100));
+            percent_.setFont(font_);
+            percent_.setText(text, (size_t)n);
+            
+            Point textPos(
+                contentBounds_.x + (contentBounds_.width - percent_.width()) / 2,
+                contentBounds_.y + (contentBounds_.height - percent_.height()) / 2
+            );
+            renderer.drawGlyphRun(percent_.run(), textPos, Color(1, 1, 1, 1));
         }
     }
     
@@ -585,6 +1097,9 @@ private:
     float progress_;
     Color fillColor_ = Color::fromHex(0x3b82f6ff);
     bool showText_ = false;
+    NumericRun percent_;
+    Font* font_ = nullptr;
+    Renderer* fontFor_ = nullptr;
 };
 
 // ============================================================================
@@ -625,13 +1140,14 @@ public:
         style_.background = Color(0.3f, 0.3f, 0.3f, 1.0f);
     }
     
-    Divider& color(const Color& c) { style_.background = c; return *this; }
+    Divider& color(const Color& c) { style_.background = c; requestRedraw(); return *this; }
     Divider& thickness(float t) {
         if (direction_ == Direction::Horizontal) {
             heightSpec_ = SizeSpec::fixed(t);
         } else {
             widthSpec_ = SizeSpec::fixed(t);
         }
+        requestRedraw();
         return *this;
     }
     
@@ -650,10 +1166,11 @@ public:
         textStyle_.color = Color(1, 1, 1, 1);
     }
     
-    Label& text(const std::string& t) { text_ = t; return *this; }
-    Label& fontSize(float s) { textStyle_.fontSize = s; return *this; }
-    Label& color(const Color& c) { textStyle_.color = c; return *this; }
-    Label& bold(bool b) { textStyle_.bold = b; return *this; }
+    Label& text(const std::string& t) { text_ = t; requestRedraw(); return *this; }
+    Label& fontSize(float s) { textStyle_.fontSize = s; requestRedraw(); return *this; }
+    Label& color(const Color& c) { textStyle_.color = c; requestRedraw(); return *this; }
+    Label& bold(bool b) { textStyle_.bold = b; requestRedraw(); return *this; }
+    Label& truncate(TextStyle::Truncate t) { textStyle_.truncate = t; requestRedraw(); return *this; }
     
     Size measureContent(Size available) override {
         return Size(text_.length() * textStyle_.fontSize * 0.6f, 
@@ -663,8 +1180,14 @@ public:
     void render(Renderer& renderer) override {
         Widget::render(renderer);
         
-        Font* font = renderer.loadFont(textStyle_.fontFamily, textStyle_.fontSize);
-        if (font) {
+        Font* font = renderer.loadFont(textStyle_);
+        if (!font) return;
+        
+        if (textStyle_.truncate != TextStyle::Truncate::None) {
+            const GlyphRun& run = elided_.layout(font, text_, contentBounds_.width, textStyle_.truncate,
+                                                 contentBounds_.x);
+            renderer.drawGlyphRun(run, contentBounds_.topLeft(), textStyle_.color);
+        } else {
             renderer.drawText(text_, contentBounds_.topLeft(), font, 
                             textStyle_.color, textStyle_);
         }
@@ -673,6 +1196,7 @@ public:
 private:
     std::string text_;
     TextStyle textStyle_;
+    ElidedText elided_;
 };
 
 } // namespace MetaUI
@@ -0,0 +1,231 @@
+// ColorGlyphSource on CBDT/CBLC and sbix fonts built here: cmap lookup,
+// strike selection, metrics, 'dupe' glyphs and the alpha-weighted
+// downscale, plus truncated files, which must fail without reading past the
+// end. No GL context is needed.
+#include "metaui/renderer.hpp"
+#include <cstdio>
+#include <map>
+#include <unistd.h>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+struct Bytes {
+    std::vector<unsigned char> data;
+    
+    Bytes& u8(uint32_t v) { data.push_back((unsigned char)v); return *this; }
+    Bytes& u16(uint32_t v) { return u8(v >> 8).u8(v); }
+    Bytes& u32(uint32_t v) { return u16(v >> 16).u16(v); }
+    Bytes& tag(const char* t) { return u8(t[0]).u8(t[1]).u8(t[2]).u8(t[3]); }
+    Bytes& zeros(size_t n) { data.insert(data.end(), n, 0); return *this; }
+    Bytes& append(const Bytes& b) { data.insert(data.end(), b.data.begin(), b.data.end()); return *this; }
+    size_t size() const { return data.size(); }
+};
+
+uint32_t crc32(const unsigned char* p, size_t n) {
+    uint32_t crc = ~0u;
+    for (size_t i = 0; i < n; ++i) {
+        crc ^= p[i];
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// RGBA PNG with the image data in stored (uncompressed) deflate blocks.
+Bytes png(int w, int h, uint32_t (*pixel)(int x, int y)) {
+    Bytes raw;
+    for (int y = 0; y < h; ++y) {
+        raw.u8(0);
+        for (int x = 0; x < w; ++x) raw.u32(pixel(x, y));
+    }
+    Bytes z;
+    z.u8(0x78).u8(0x01);
+    for (size_t at = 0; at < raw.size(); at += 65535) {
+        size_t n = std::min<size_t>(65535, raw.size() - at);
+        z.u8(at + n == raw.size() ? 1 : 0).u8(n & 0xFF).u8(n >> 8).u8(~n & 0xFF).u8((~n >> 8) & 0xFF);
+        z.data.insert(z.data.end(), raw.data.begin() + at, raw.data.begin() + at + n);
+    }
+    uint32_t a = 1, b = 0;
+    for (unsigned char c : raw.data) { a = (a + c) % 65521; b = (b + a) % 65521; }
+    z.u32(b << 16 | a);
+    
+    Bytes out;
+    out.u32(0x89504E47).u32(0x0D0A1A0A);
+    auto chunk = [&](const char* type, const Bytes& body) {
+        Bytes typed;
+        typed.tag(type).append(body);
+        out.u32((uint32_t)body.size()).append(typed).u32(crc32(typed.data.data(), typed.size()));
+    };
+    chunk("IHDR", Bytes().u32(w).u32(h).u8(8).u8(6).u8(0).u8(0).u8(0));
+    chunk("IDAT", z);
+    chunk("IEND", Bytes());
+    return out;
+}
+
+// Opaque red left of x = 7, transparent green right of it.
+uint32_t halfRed(int x, int) { return x < 7 ? 0xFF0000FF : 0x00FF0000; }
+uint32_t blue(int, int) { return 0x0000FFFF; }
+
+const int SMILE = 0x1F600, GRIN = 0x1F601;
+
+Bytes cmap() {
+    Bytes groups;
+    groups.u32(SMILE).u32(SMILE).u32(1).u32(GRIN).u32(GRIN).u32(2);
+    Bytes table;
+    table.u16(0).u16(1).u16(3).u16(10).u32(12);
+    table.u16(12).u16(0).u32(16 + (uint32_t)groups.size()).u32(0).u32(2).append(groups);
+    return table;
+}
+
+Bytes font(const std::map<std::string, Bytes>& tables) {
+    Bytes dir, body;
+    size_t offset = 12 + 16 * tables.size();
+    for (const auto& [tag, data] : tables) {
+        dir.tag(tag.c_str()).u32(0).u32((uint32_t)(offset + body.size())).u32((uint32_t)data.size());
+        body.append(data).zeros((4 - data.size() % 4) % 4);
+    }
+    Bytes out;
+    out.u32(0x00010000).u16((uint32_t)tables.size()).u16(0).u16(0).u16(0);
+    return out.append(dir).append(body);
+}
+
+// One 16 ppem strike, index format 1, image format 17 (small metrics).
+Bytes cbdtFont() {
+    Bytes images[] = {png(16, 16, halfRed), png(16, 16, blue)};
+    Bytes cbdt, offsets;
+    cbdt.u32(0x00030000);
+    for (const Bytes& image : images) {
+        offsets.u32((uint32_t)cbdt.size());
+        cbdt.u8(16).u8(16).u8(1).u8(13).u8(18).u32((uint32_t)image.size()).append(image);
+    }
+    offsets.u32((uint32_t)cbdt.size());
+    
+    Bytes subtable;
+    subtable.u16(1).u16(17).u32(0).append(offsets);
+    Bytes array;
+    array.u16(1).u16(2).u32(8).append(subtable);
+    Bytes cblc;
+    cblc.u32(0x00030000).u32(1);
+    cblc.u32(8 + 48).u32((uint32_t)array.size()).u32(1).u32(0).zeros(24);
+    cblc.u16(1).u16(2).u8(16).u8(16).u8(32).u8(1).append(array);
+    return font({{"cmap", cmap()}, {"CBDT", cbdt}, {"CBLC", cblc}});
+}
+
+// Strikes at 16 (red) and 32 ppem (blue); glyph 2 is a 'dupe' of glyph 1.
+Bytes sbixFont() {
+    auto strike = [](int ppem, const Bytes& image) {
+        Bytes glyph1;
+        glyph1.u16(2).u16((uint32_t)-3 & 0xFFFF).tag("png ").append(image);
+        Bytes glyph2;
+        glyph2.u16(0).u16(0).tag("dupe").u16(1);
+        uint32_t start = 4 + 4 * 4;
+        Bytes out;
+        out.u16(ppem).u16(72).u32(start).u32(start).u32(start + (uint32_t)glyph1.size())
+           .u32(start + (uint32_t)(glyph1.size() + glyph2.size()));
+        return out.append(glyph1).append(glyph2);
+    };
+    Bytes small = strike(16, png(16, 16, halfRed));
+    Bytes large = strike(32, png(32, 32, blue));
+    Bytes sbix;
+    sbix.u16(1).u16(1).u32(2).u32(16).u32(16 + (uint32_t)small.size()).append(small).append(large);
+    
+    Bytes head, hhea, hmtx, maxp;
+    head.zeros(18).u16(2048).zeros(34);
+    hhea.zeros(34).u16(3);
+    hmtx.u16(0).u16(0).u16(2560).u16(0).u16(2560).u16(0);
+    maxp.u32(0x5000).u16(3);
+    return font({{"cmap", cmap()}, {"head", head}, {"hhea", hhea},
+                 {"hmtx", hmtx}, {"maxp", maxp}, {"sbix", sbix}});
+}
+
+std::string writeTemp(const Bytes& bytes, size_t length) {
+    char path[] = "/tmp/metaui-color-glyphs-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return "";
+    bool ok = write(fd, bytes.data.data(), length) == (ssize_t)length;
+    close(fd);
+    return ok ? path : "";
+}
+
+const unsigned char* pixel(const ColorGlyphSource::Bitmap& b, int x, int y) {
+    return &b.rgba[((size_t)y * b.width + x) * 4];
+}
+
+void testCbdt(const ColorGlyphSource& source) {
+    EXPECT(source.valid());
+    EXPECT(source.hasGlyph(SMILE) && source.hasGlyph(GRIN));
+    EXPECT(!source.hasGlyph('A'));
+    EXPECT(source.advance(SMILE) == 18.0f / 16);
+    
+    ColorGlyphSource::Bitmap b;
+    EXPECT(source.decode(SMILE, 16, b));
+    EXPECT(b.width == 16 && b.height == 16);
+    EXPECT(b.bearingX == 1 && b.bearingY == 13);
+    EXPECT(pixel(b, 0, 0)[0] == 255 && pixel(b, 0, 0)[3] == 255);
+    EXPECT(pixel(b, 15, 0)[3] == 0);
+    
+    // Half size: the boundary pixel averages one red and one clear column,
+    // and the clear green doesn't bleed into it.
+    EXPECT(source.decode(SMILE, 8, b));
+    EXPECT(b.width == 8 && b.height == 8);
+    EXPECT(b.bearingX == 0.5f && b.bearingY == 6.5f);
+    const unsigned char* edge = pixel(b, 3, 4);
+    EXPECT(edge[0] == 255 && edge[1] == 0 && edge[3] == 128);
+    EXPECT(pixel(b, 4, 4)[3] == 0);
+    
+    EXPECT(source.decode(GRIN, 16, b));
+    EXPECT(pixel(b, 8, 8)[2] == 255 && pixel(b, 8, 8)[0] == 0);
+    EXPECT(!source.decode('A', 16, b));
+}
+
+void testSbix(const ColorGlyphSource& source) {
+    EXPECT(source.valid());
+    EXPECT(source.advance(SMILE) == 2560.0f / 2048);
+    
+    // The smallest strike at least as large, else the largest.
+    ColorGlyphSource::Bitmap b;
+    EXPECT(source.decode(SMILE, 16, b));
+    EXPECT(b.width == 16 && pixel(b, 0, 0)[0] == 255);
+    EXPECT(b.bearingX == 2 && b.bearingY == 13);
+    EXPECT(source.decode(SMILE, 20, b));
+    EXPECT(b.width == 20 && pixel(b, 0, 0)[2] == 255);
+    EXPECT(source.decode(SMILE, 64, b));
+    EXPECT(b.width == 64 && pixel(b, 63, 63)[2] == 255);
+    
+    EXPECT(source.decode(GRIN, 32, b));
+    EXPECT(b.width == 32 && pixel(b, 0, 0)[2] == 255);
+}
+
+} // namespace
+
+int main() {
+    Bytes fonts[] = {cbdtFont(), sbixFont()};
+    for (int f = 0; f < 2; ++f) {
+        std::string path = writeTemp(fonts[f], fonts[f].size());
+        EXPECT(!path.empty());
+        ColorGlyphSource source(path);
+        if (f == 0) testCbdt(source);
+        else testSbix(source);
+        unlink(path.c_str());
+        
+        for (size_t length = 0; length < fonts[f].size(); length += 5) {
+            path = writeTemp(fonts[f], length);
+            ColorGlyphSource truncated(path);
+            ColorGlyphSource::Bitmap b;
+            truncated.hasGlyph(SMILE);
+            truncated.advance(GRIN);
+            truncated.decode(SMILE, 16, b);
+            truncated.decode(GRIN, 40, b);
+            unlink(path.c_str());
+        }
+    }
+    
+    EXPECT(!ColorGlyphSource("/nonexistent/emoji.ttf").valid());
+    return failures == 0 ? 0 : 1;
+}
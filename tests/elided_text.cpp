@@ -0,0 +1,126 @@
+// ElidedText cut points against a brute-force search over whole code points,
+// and reuse of the laid-out run across frames and measuring calls.
+#include "metaui/replay.hpp"
+#include <cstdio>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+using Truncate = TextStyle::Truncate;
+
+std::vector<size_t> codePoints(const std::string& text) {
+    std::vector<size_t> offsets{0};
+    for (size_t i = 0; i < text.size(); ) {
+        Font::decodeUTF8(text, i);
+        offsets.push_back(i);
+    }
+    return offsets;
+}
+
+// Widest elision whose width fits; for Middle, the prefix gets half the
+// budget first and the suffix whatever is left.
+std::string bruteForce(Font& font, const std::string& text, float maxWidth, Truncate mode) {
+    if (font.measureText(text).width <= maxWidth) return text;
+    std::string ellipsis = font.hasGlyph(0x2026) ? "…" : "...";
+    float available = std::max(0.0f, maxWidth - font.measureText(ellipsis).width);
+    auto offsets = codePoints(text);
+    size_t n = offsets.size() - 1;
+    auto width = [&](size_t from, size_t to) {
+        return font.measureText(text.substr(offsets[from], offsets[to] - offsets[from])).width;
+    };
+    auto longestPrefix = [&](float budget) {
+        size_t k = 0;
+        while (k < n && width(0, k + 1) <= budget) k++;
+        return k;
+    };
+    auto shortestSuffix = [&](size_t from, float budget) {
+        size_t j = n;
+        while (j > from && width(j - 1, n) <= budget) j--;
+        return j;
+    };
+    
+    switch (mode) {
+        case Truncate::End:
+            return text.substr(0, offsets[longestPrefix(available)]) + ellipsis;
+        case Truncate::Start:
+            return ellipsis + text.substr(offsets[shortestSuffix(0, available)]);
+        default: {
+            size_t k = longestPrefix(available / 2);
+            size_t j = shortestSuffix(k, available - width(0, k));
+            return text.substr(0, offsets[k]) + ellipsis + text.substr(offsets[j]);
+        }
+    }
+}
+
+void testCutPoints(Font& font) {
+    const std::string texts[] = {
+        "/home/user/projects/metaui/include/metaui/renderer.hpp",
+        "Grüße aus Köln — naïve café déjà vu",
+        "WWWWWWWWiiiiiiiiWWWWWWWW",
+    };
+    for (const auto& text : texts) {
+        float full = font.measureText(text).width;
+        for (Truncate mode : {Truncate::End, Truncate::Start, Truncate::Middle}) {
+            for (float width = 0; width <= full + 20; width += 7.5f) {
+                ElidedText elided;
+                const GlyphRun& run = elided.layout(&font, text, width, mode, 0);
+                GlyphRun expected;
+                font.layoutRun(bruteForce(font, text, width, mode), expected);
+                EXPECT(std::fabs(run.width - expected.width) < 0.01f);
+                EXPECT(run.quads.size() == expected.quads.size());
+            }
+        }
+    }
+    
+    ElidedText elided;
+    EXPECT(elided.layout(&font, "short", 1000, Truncate::End, 0).width ==
+           font.measureText("short").width);
+}
+
+void testReuse(Font& font) {
+    ElidedText elided;
+    std::string text = "a label long enough to need an ellipsis at this width";
+    const GlyphRun& run = elided.layout(&font, text, 120, Truncate::Middle, 10.25f);
+    EXPECT(run.pen == 0.25f);
+    auto quads = run.quads;
+    
+    // Measuring without a position keeps the pen the run was drawn at.
+    elided.layout(&font, text, 120, Truncate::Middle);
+    EXPECT(run.pen == 0.25f);
+    EXPECT(run.quads.size() == quads.size() && run.quads.front().x0 == quads.front().x0);
+    
+    // Only the fraction of x matters.
+    elided.layout(&font, text, 120, Truncate::Middle, 37.25f);
+    EXPECT(run.pen == 0.25f);
+    elided.layout(&font, text, 120, Truncate::Middle, 37.5f);
+    EXPECT(run.pen == 0.5f);
+    EXPECT(run.width <= 120);
+    
+    elided.layout(&font, "changed", 120, Truncate::Middle, 0);
+    EXPECT(run.width == font.measureText("changed").width);
+}
+
+} // namespace
+
+int main() {
+    std::unique_ptr<HeadlessApplication> app;
+    try {
+        app = std::make_unique<HeadlessApplication>(64, 64);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "skipped: %s\n", e.what());
+        return 77;
+    }
+    
+    Font font("sans", 16);
+    EXPECT(font.valid());
+    if (!font.valid()) return 1;
+    testCutPoints(font);
+    testReuse(font);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+// FontDatabase directory scan: family/style and generic-name resolution over
+// a private copy of the DejaVu fonts, and reuse of the on-disk index for
+// directories whose mtime is unchanged. Built without fontconfig, which
+// would otherwise take precedence over the scan.
+#include "metaui/fontdb.hpp"
+#include <cstdio>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+bool copyFile(const std::string& from, const std::string& to) {
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary);
+    out << in.rdbuf();
+    return in && out;
+}
+
+std::string fileName(const FontFace* face) {
+    return face ? face->path.substr(face->path.rfind('/') + 1) : "(none)";
+}
+
+const char* SOURCES[] = {"/usr/share/fonts/truetype/dejavu", "/usr/share/fonts/TTF",
+                         "/usr/share/fonts/dejavu", "/usr/share/fonts/dejavu-sans-fonts"};
+
+std::string findDejaVu() {
+    for (const char* dir : SOURCES) {
+        if (access((std::string(dir) + "/DejaVuSans-Bold.ttf").c_str(), R_OK) == 0 &&
+            access((std::string(dir) + "/DejaVuSerif.ttf").c_str(), R_OK) == 0 &&
+            access((std::string(dir) + "/DejaVuSansMono.ttf").c_str(), R_OK) == 0) {
+            return dir;
+        }
+    }
+    return "";
+}
+
+void removeTree(const std::string& path) {
+    if (DIR* d = opendir(path.c_str())) {
+        while (dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name != "." && name != "..") removeTree(path + "/" + name);
+        }
+        closedir(d);
+        rmdir(path.c_str());
+    } else {
+        unlink(path.c_str());
+    }
+}
+
+} // namespace
+
+int main() {
+    std::string source = findDejaVu();
+    if (source.empty()) {
+        std::fprintf(stderr, "skipped: DejaVu fonts not installed\n");
+        return 77;
+    }
+    
+    char temp[] = "/tmp/metaui-fontdb-XXXXXX";
+    if (!mkdtemp(temp)) return 1;
+    std::string root = temp;
+    std::string sans = root + "/sans", other = root + "/other/nested";
+    mkdir(sans.c_str(), 0755);
+    mkdir((root + "/other").c_str(), 0755);
+    mkdir(other.c_str(), 0755);
+    for (const char* name : {"DejaVuSans.ttf", "DejaVuSans-Bold.ttf"}) {
+        EXPECT(copyFile(source + "/" + name, sans + "/" + name));
+    }
+    for (const char* name : {"DejaVuSerif.ttf", "DejaVuSansMono.ttf"}) {
+        EXPECT(copyFile(source + "/" + name, other + "/" + name));
+    }
+    std::string index = root + "/cache/fonts.idx";
+    
+    {
+        FontDatabase db({sans, root + "/other"}, index);
+        EXPECT(db.faces().size() == 4);
+        EXPECT(fileName(db.find("DejaVu Sans")) == "DejaVuSans.ttf");
+        EXPECT(fileName(db.find("dejavu SANS", true)) == "DejaVuSans-Bold.ttf");
+        // No italic face: the upright one with the closest weight stands in.
+        EXPECT(fileName(db.find("DejaVu Sans", false, true)) == "DejaVuSans.ttf");
+        EXPECT(fileName(db.find("DejaVu Sans", true, true)) == "DejaVuSans-Bold.ttf");
+        EXPECT(fileName(db.find("DejaVu Serif", true)) == "DejaVuSerif.ttf");
+        
+        EXPECT(fileName(db.resolve("serif")) == "DejaVuSerif.ttf");
+        EXPECT(fileName(db.resolve("monospace")) == "DejaVuSansMono.ttf");
+        EXPECT(fileName(db.resolve("mono")) == "DejaVuSansMono.ttf");
+        EXPECT(fileName(db.resolve("sans", true)) == "DejaVuSans-Bold.ttf");
+        EXPECT(fileName(db.resolve("")) == "DejaVuSans.ttf");
+        EXPECT(fileName(db.resolve("No Such Family")) == "DejaVuSans.ttf");
+        EXPECT(db.find("No Such Family") == nullptr);
+        
+        const FontFace* face = db.find("DejaVu Sans");
+        EXPECT(face && face->weight == 400 && !face->italic && face->coversRange(0));
+        EXPECT(db.find("DejaVu Sans", true)->weight == 700);
+        
+        auto data = db.fileData(face->path);
+        EXPECT(data && data->size() > 12);
+        EXPECT(db.fileData(face->path) == data);
+        EXPECT(db.fileData(root + "/missing.ttf") == nullptr);
+    }
+    EXPECT(access(index.c_str(), R_OK) == 0);
+    
+    // Rewriting a file doesn't touch its directory's mtime, so the indexed
+    // entry is trusted...
+    EXPECT(copyFile(source + "/DejaVuSans.ttf", other + "/DejaVuSerif.ttf"));
+    {
+        FontDatabase db({sans, root + "/other"}, index);
+        EXPECT(fileName(db.find("DejaVu Serif")) == "DejaVuSerif.ttf");
+    }
+    // ...until a file is added or removed there. Mtimes are compared in
+    // whole seconds, so step it past the one the index recorded.
+    unlink((other + "/DejaVuSansMono.ttf").c_str());
+    struct stat st;
+    stat(other.c_str(), &st);
+    struct timespec times[2] = {{st.st_mtime + 2, 0}, {st.st_mtime + 2, 0}};
+    utimensat(AT_FDCWD, other.c_str(), times, 0);
+    {
+        FontDatabase db({sans, root + "/other"}, index);
+        EXPECT(db.find("DejaVu Serif") == nullptr);
+        EXPECT(db.find("DejaVu Sans Mono") == nullptr);
+        EXPECT(db.faces().size() == 3);
+        EXPECT(fileName(db.resolve("monospace")) == "DejaVuSans.ttf");
+    }
+    
+    // File names: anything with a slash, or an existing file here.
+    EXPECT(FontDatabase::isFilePath("fonts/Custom.ttf"));
+    EXPECT(!FontDatabase::isFilePath("DejaVu Sans"));
+    EXPECT(!FontDatabase::isFilePath(""));
+    if (chdir(sans.c_str()) == 0) {
+        EXPECT(FontDatabase::isFilePath("DejaVuSans.ttf"));
+        EXPECT(!FontDatabase::isFilePath("DejaVuSerif.ttf"));
+    }
+    
+    removeTree(root);
+    return failures == 0 ? 0 : 1;
+}
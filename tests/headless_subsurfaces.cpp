@@ -0,0 +1,78 @@
+// Separate-surface widgets on HeadlessApplication: the window's GL state
+// must not leak into a subsurface renderer (or back), and a subsurface is
+// drawn again only when it asked for it.
+#include "metaui/replay.hpp"
+#include <cstdio>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+class Root : public Container {
+public:
+    void layoutChildren() override {
+        for (auto& child : children_) child->layout(Rect(100, 80, 64, 48));
+    }
+};
+
+class Counted : public Widget {
+public:
+    int renders = 0;
+    void render(Renderer& renderer) override { ++renders; Widget::render(renderer); }
+};
+
+bool filled(const std::vector<unsigned char>& pixels, unsigned char r, unsigned char g, unsigned char b) {
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        if (pixels[i] != r || pixels[i + 1] != g || pixels[i + 2] != b) return false;
+    }
+    return !pixels.empty();
+}
+
+} // namespace
+
+int main() {
+    std::unique_ptr<HeadlessApplication> app;
+    try {
+        app = std::make_unique<HeadlessApplication>(320, 240);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "skipped: %s\n", e.what());
+        return 77;
+    }
+    
+    auto root = std::make_shared<Root>();
+    root->background(Color(1, 0, 0, 1));
+    auto child = std::make_shared<Counted>();
+    child->background(Color(0, 0, 1, 1));
+    child->separateSurface();
+    root->addChild(child);
+    app->setRoot(root);
+    
+    for (int i = 0; i < 3; ++i) app->renderFrame();
+    EXPECT(filled(app->readPixels(), 255, 0, 0));
+    auto pixels = app->readPixels(child.get());
+    EXPECT(pixels.size() == 64u * 48 * 4);
+    EXPECT(filled(pixels, 0, 0, 255));
+    EXPECT(app->surfaceFrames(*child) == 1);
+    EXPECT(child->renders == 1);
+    
+    child->requestRedraw();
+    app->renderFrame();
+    app->renderFrame();
+    EXPECT(app->surfaceFrames(*child) == 2);
+    EXPECT(filled(app->readPixels(), 255, 0, 0));
+    
+    // Back into the window once it no longer asks for a surface.
+    child->separateSurface(false);
+    app->renderFrame();
+    EXPECT(app->surfaceFrames(*child) == 0);
+    pixels = app->readPixels();
+    size_t inside = ((size_t)(240 - 100) * 320 + 120) * 4;
+    EXPECT(pixels[inside] == 0 && pixels[inside + 2] == 255);
+    
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+// LineChart decimation: the min/max kernel its buckets are built from,
+// including the unaligned SIMD tails, and the LTTB selection. Appends only
+// touch the ring buffer, so no GL context is needed.
+#include "metaui/views.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+void testMinMax() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> value(-1000, 1000);
+    std::vector<float> values(80);
+    for (float& v : values) v = value(rng);
+    
+    // Every length around the vector width, from every alignment.
+    for (size_t offset = 0; offset < 4; ++offset) {
+        for (size_t count = 1; offset + count <= values.size(); ++count) {
+            const float* p = values.data() + offset;
+            float lo, hi;
+            minMax(p, count, lo, hi);
+            auto [expectLo, expectHi] = std::minmax_element(p, p + count);
+            EXPECT(lo == *expectLo && hi == *expectHi);
+        }
+    }
+    
+    // Extremes in the scalar tail and in each vector lane.
+    for (size_t at = 0; at < 11; ++at) {
+        std::vector<float> flat(11, 1.0f);
+        flat[at] = -5;
+        flat[(at + 3) % 11] = 9;
+        float lo, hi;
+        minMax(flat.data(), flat.size(), lo, hi);
+        EXPECT(lo == -5 && hi == 9);
+    }
+}
+
+std::vector<uint64_t> select(const std::vector<float>& values, uint64_t threshold) {
+    std::vector<uint64_t> kept;
+    lttb(values.size(), threshold, [&](uint64_t i) { return values[i]; },
+         [&](uint64_t i) { kept.push_back(i); });
+    return kept;
+}
+
+void testLttb() {
+    std::vector<float> values(1000);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = std::sin(i * 0.05f);
+    
+    // Short series are passed through.
+    std::vector<float> few(values.begin(), values.begin() + 10);
+    std::vector<uint64_t> all = select(few, 10);
+    EXPECT(all.size() == 10);
+    for (uint64_t i = 0; i < all.size(); ++i) EXPECT(all[i] == i);
+    EXPECT(select({}, 3).empty());
+    
+    // Exactly threshold points, in order, one per bucket, ends kept.
+    for (uint64_t threshold : {3u, 4u, 17u, 100u, 999u}) {
+        std::vector<uint64_t> kept = select(values, threshold);
+        EXPECT(kept.size() == threshold);
+        if (kept.size() != threshold) continue;
+        EXPECT(kept.front() == 0 && kept.back() == values.size() - 1);
+        double every = (double)(values.size() - 2) / (threshold - 2);
+        for (uint64_t b = 0; b + 2 < threshold; ++b) {
+            EXPECT(kept[b + 1] >= (uint64_t)(b * every) + 1);
+            EXPECT(kept[b + 1] < (uint64_t)((b + 1) * every) + 1);
+        }
+    }
+    
+    // A single-sample spike on a flat line survives 50x decimation, in
+    // either direction.
+    for (float spike : {40.0f, -40.0f}) {
+        std::vector<float> flat(5000, 3.0f);
+        flat[2345] = spike;
+        std::vector<uint64_t> kept = select(flat, 100);
+        EXPECT(std::find(kept.begin(), kept.end(), 2345u) != kept.end());
+    }
+    
+    // A straight line has no preferred point; each bucket keeps its first.
+    std::vector<float> ramp(102);
+    for (size_t i = 0; i < ramp.size(); ++i) ramp[i] = (float)i;
+    std::vector<uint64_t> kept = select(ramp, 12);
+    for (uint64_t b = 0; b < 10; ++b) EXPECT(kept[b + 1] == b * 10 + 1);
+}
+
+void testAppend() {
+    LineChart chart(16);
+    size_t a = chart.addSeries(Color(1, 0, 0, 1));
+    size_t b = chart.addSeries(Color(0, 1, 0, 1));
+    EXPECT(a == 0 && b == 1);
+    
+    std::vector<float> values(40, 1.0f);
+    chart.append(a, values.data(), 5);
+    chart.append(a, values.data(), values.size());  // more than the ring holds
+    chart.append(b, 2.0f);
+    chart.append(7, 2.0f);                          // no such series
+    EXPECT(chart.sampleCount(a) == 45);
+    EXPECT(chart.sampleCount(b) == 1);
+    EXPECT(chart.sampleCount(7) == 0);
+    
+    chart.clear();
+    EXPECT(chart.sampleCount(a) == 0 && chart.sampleCount(b) == 0);
+}
+
+} // namespace
+
+int main() {
+    testMinMax();
+    testLttb();
+    testAppend();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Application against MockCompositor: the first frame is committed, a
+// click repaints the window, a configure resizes it, closed ends run(),
+// and quit() from another thread wakes a run() blocked on the display.
+#include "metaui.hpp"
+#include "metaui/mockcompositor.hpp"
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+using namespace MetaUI;
+
+namespace {
+
+std::atomic<int> failures{0};
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+const Color red(1, 0, 0, 1), green(0, 1, 0, 1);
+
+// Turns green when clicked.
+class Target : public Widget {
+public:
+    bool handleMouseButton(const MouseEvent& event) override {
+        if (!event.pressed || !bounds().contains(event.position)) return false;
+        background(green);
+        return true;
+    }
+};
+
+// Center pixel of an ARGB8888/XRGB8888 frame, as little-endian bytes B, G, R.
+bool centerIs(const MockFrame& frame, const Color& color) {
+    if (frame.pixels.empty()) return false;
+    const uint8_t* p = frame.pixels.data() + ((size_t)(frame.height / 2) * frame.width + frame.width / 2) * 4;
+    auto near = [](uint8_t byte, float value) { return std::abs(byte - value * 255.0f) <= 2.0f; };
+    return near(p[2], color.r) && near(p[1], color.g) && near(p[0], color.b);
+}
+
+// Waits for a committed frame that matches, dropping the ones before it.
+bool waitForFrame(MockCompositor& compositor, const std::function<bool(const MockFrame&)>& match) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        size_t next = compositor.frameCount() + 1;
+        for (const MockFrame& frame : compositor.takeFrames()) {
+            if (match(frame)) return true;
+        }
+        compositor.waitForFrames(next, std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    MockCompositor compositor;
+    compositor.collectPixels(true);
+    std::unique_ptr<Application> app;
+    try {
+        app = std::make_unique<Application>("mock", 160, 120);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "skipped: %s\n", e.what());
+        return 77;
+    }
+    
+    auto target = std::make_shared<Target>();
+    target->background(red);
+    target->size(SizeSpec::fill(), SizeSpec::fill());
+    app->setRoot(target);
+    
+    std::atomic<bool> returned{false};
+    std::thread driver([&] {
+        EXPECT(waitForFrame(compositor, [](const MockFrame& frame) {
+            return frame.width == 160 && frame.height == 120 && centerIs(frame, red);
+        }));
+        
+        compositor.pointerMotion(80, 60);
+        compositor.pointerButton(BTN_LEFT, true);
+        compositor.pointerButton(BTN_LEFT, false);
+        EXPECT(waitForFrame(compositor, [](const MockFrame& frame) { return centerIs(frame, green); }));
+        
+        compositor.configureSurface(200, 100);
+        EXPECT(waitForFrame(compositor, [](const MockFrame& frame) {
+            return frame.width == 200 && frame.height == 100 && centerIs(frame, green);
+        }));
+        
+        compositor.closeSurface();
+        for (int i = 0; i < 500 && !returned; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT(returned);
+        if (!returned) app->quit();
+    });
+    app->run();
+    returned = true;
+    driver.join();
+    
+    // Nothing else will arrive on the display; only quit() can end this run.
+    returned = false;
+    std::thread quitter([&] {
+        for (int i = 0; i < 500 && !returned; ++i) {
+            app->quit();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    auto start = std::chrono::steady_clock::now();
+    app->run();
+    returned = true;
+    quitter.join();
+    EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    
+    app.reset();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+// MsdfGenerator against analytic distances: a square, whose channel median
+// must keep the sharp corners, a circle from cubics, a reversed contour and a
+// hole. No GL context is needed.
+#include "metaui/msdf.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+const int SIZE = 40;
+const float RANGE = 6;
+
+struct Field {
+    std::vector<unsigned char> rgb = std::vector<unsigned char>(SIZE * SIZE * 3);
+    
+    int median(int x, int y) const {
+        const unsigned char* p = &rgb[(y * SIZE + x) * 3];
+        return std::max(std::min(p[0], p[1]), std::min(std::max(p[0], p[1]), p[2]));
+    }
+};
+
+Field generate(const MsdfShape& shape) {
+    Field field;
+    MsdfGenerator::generate(shape, field.rgb.data(), SIZE, SIZE, SIZE * 3, 1, 0, 0, RANGE);
+    return field;
+}
+
+int encode(float distance) {
+    return (int)std::lround(std::clamp(0.5f + distance / RANGE, 0.0f, 1.0f) * 255);
+}
+
+void square(MsdfShape& shape, float x0, float y0, float x1, float y1, bool reversed = false) {
+    shape.moveTo(x0, y0);
+    if (reversed) {
+        shape.lineTo(x0, y1);
+        shape.lineTo(x1, y1);
+        shape.lineTo(x1, y0);
+    } else {
+        shape.lineTo(x1, y0);
+        shape.lineTo(x1, y1);
+        shape.lineTo(x0, y1);
+    }
+    shape.close();
+}
+
+// Signed distance of the square's half-plane intersection: the field a
+// median of three channels reproduces, corners included, within the range.
+float squareDistance(float x, float y, float x0, float y0, float x1, float y1) {
+    return std::min(std::min(x - x0, x1 - x), std::min(y - y0, y1 - y));
+}
+
+void testSquare() {
+    for (bool reversed : {false, true}) {
+        MsdfShape shape;
+        square(shape, 10, 10, 30, 30, reversed);
+        Field field = generate(shape);
+        int worst = 0;
+        for (int y = 0; y < SIZE; ++y) {
+            for (int x = 0; x < SIZE; ++x) {
+                float d = squareDistance(x + 0.5f, y + 0.5f, 10, 10, 30, 30);
+                EXPECT((field.median(x, y) >= 128) == (d > 0));
+                float dx = std::max({10 - (x + 0.5f), (x + 0.5f) - 30, 0.0f});
+                float dy = std::max({10 - (y + 0.5f), (y + 0.5f) - 30, 0.0f});
+                // Beyond half the range only the clamped true distance is stored.
+                float trueDistance = d > 0 ? d : std::hypot(dx, dy);
+                int expected = trueDistance >= RANGE / 2 ? encode(d > 0 ? d : -trueDistance) : encode(d);
+                worst = std::max(worst, std::abs(field.median(x, y) - expected));
+            }
+        }
+        EXPECT(worst <= 1);
+    }
+}
+
+void testCircle() {
+    // Four cubic quarter arcs around (20, 20), radius 12.
+    const float k = 0.5522847f * 12;
+    MsdfShape shape;
+    shape.moveTo(32, 20);
+    shape.cubicTo(32, 20 + k, 20 + k, 32, 20, 32);
+    shape.cubicTo(20 - k, 32, 8, 20 + k, 8, 20);
+    shape.cubicTo(8, 20 - k, 20 - k, 8, 20, 8);
+    shape.cubicTo(20 + k, 8, 32, 20 - k, 32, 20);
+    Field field = generate(shape);
+    
+    int worst = 0;
+    for (int y = 0; y < SIZE; ++y) {
+        for (int x = 0; x < SIZE; ++x) {
+            float d = 12 - std::hypot(x + 0.5f - 20, y + 0.5f - 20);
+            worst = std::max(worst, std::abs(field.median(x, y) - encode(d)));
+        }
+    }
+    // The cubic arcs and their flattening are within a few hundredths of a pixel.
+    EXPECT(worst <= 3);
+}
+
+void testHole() {
+    MsdfShape shape;
+    square(shape, 4, 4, 36, 36);
+    square(shape, 14, 14, 26, 26, true);
+    Field field = generate(shape);
+    EXPECT(field.median(20, 20) == 0);
+    EXPECT(field.median(8, 20) == 255);
+    EXPECT(field.median(1, 1) == 0);
+    EXPECT(field.median(13, 20) > 128 && field.median(14, 20) < 128);
+}
+
+} // namespace
+
+int main() {
+    testSquare();
+    testCircle();
+    testHole();
+    
+    MsdfShape empty;
+    EXPECT(empty.empty());
+    Field field = generate(empty);
+    EXPECT(field.median(20, 20) == 0);
+    return failures == 0 ? 0 : 1;
+}
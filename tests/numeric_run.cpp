@@ -0,0 +1,77 @@
+// NumericRun: an update rewrites only the characters that changed, digits
+// keep a fixed whole-pixel pitch, and unchanged text is reported as such.
+#include "metaui/replay.hpp"
+#include <cstdio>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+bool sameQuad(const GlyphRun::Quad& a, const GlyphRun::Quad& b) {
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+} // namespace
+
+int main() {
+    std::unique_ptr<HeadlessApplication> app;
+    try {
+        app = std::make_unique<HeadlessApplication>(64, 64);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "skipped: %s\n", e.what());
+        return 77;
+    }
+    
+    Font font("sans", 18.5f);
+    NumericRun run;
+    EXPECT(!run.setText("1"));  // no font yet
+    run.setFont(&font);
+    EXPECT(run.font() == &font);
+    EXPECT(run.height() == (float)font.lineHeight());
+    
+    EXPECT(run.setText("1234.56 ms"));
+    EXPECT(!run.setText("1234.56 ms"));
+    EXPECT(run.run().quads.size() == 10);
+    auto before = run.run().quads;
+    float width = run.width();
+    EXPECT(width == std::round(width));
+    
+    // One digit changes: only its quad differs and nothing moves.
+    EXPECT(run.setText("1234.57 ms"));
+    const auto& quads = run.run().quads;
+    for (size_t i = 0; i < quads.size(); ++i) {
+        EXPECT(sameQuad(quads[i], before[i]) == (i != 6));
+    }
+    EXPECT(run.width() == width);
+    
+    // Every digit has the same pitch, so any number of equal length is
+    // equally wide.
+    run.setText("1111111");
+    float ones = run.width();
+    run.setText("8888888");
+    EXPECT(run.width() == ones);
+    run.setText("0");
+    EXPECT(ones == 7 * run.width());
+    
+    // Shorter text drops the tail; longer text is clamped.
+    run.setText("12");
+    EXPECT(run.run().quads.size() == 2);
+    std::string longText(NumericRun::MAX_CHARS + 8, '9');
+    run.setText(longText.c_str());
+    EXPECT(run.run().quads.size() == NumericRun::MAX_CHARS);
+    
+    // Glyph quads sit on whole-pixel pens: the glyph's own offsets from a
+    // whole-pixel origin, as pre-baked at bin 0.
+    run.setText("7");
+    const Font::GlyphInfo* seven = font.getGlyph('7');
+    float x = run.run().quads[0].x0 - seven->x0;
+    EXPECT(x == std::floor(x));
+    EXPECT(run.run().quads[0].u0 == seven->u0);
+    
+    return failures == 0 ? 0 : 1;
+}
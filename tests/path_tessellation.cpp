@@ -0,0 +1,169 @@
+// PathTessellation: vertex counts of fills and strokes for simple shapes,
+// fan areas, curve flattening against the tolerance, and the coverage a
+// stroke integrates to. No GL context is needed.
+#include "metaui/path.hpp"
+#include <cstdio>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+bool near(float a, float b, float tolerance) { return std::fabs(a - b) <= tolerance; }
+
+// Signed area of the triangles in [first, first + count), optionally
+// weighted by their mean coverage.
+float area(const PathTessellation& t, size_t first, size_t count, bool weighted = false) {
+    float sum = 0;
+    for (size_t v = first; v + 3 <= first + count; v += 3) {
+        const float* a = &t.vertices[v * 3];
+        const float* b = a + 3;
+        const float* c = b + 3;
+        float signedArea = ((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) / 2;
+        sum += weighted ? std::fabs(signedArea) * (a[2] + b[2] + c[2]) / 3 : signedArea;
+    }
+    return sum;
+}
+
+void testFill() {
+    VectorPath rect;
+    rect.rect(10, 20, 30, 40);
+    PathTessellation t = PathTessellation::fill(rect, 1);
+    EXPECT(t.fanCount == 6);             // two fan triangles
+    EXPECT(t.fringeCount == 4 * 2 * 6);  // a quad each side of every edge
+    EXPECT(t.coverCount == 6);
+    EXPECT(t.vertexCount() == t.fanCount + t.fringeCount + t.coverCount);
+    EXPECT(near(std::fabs(area(t, 0, t.fanCount)), 30 * 40, 0.01f));
+    
+    // The cover quad is the bounds grown by a pixel.
+    const float* cover = &t.vertices[(t.fanCount + t.fringeCount) * 3];
+    EXPECT(cover[0] == 9 && cover[1] == 19 && cover[2] == 1);
+    EXPECT(near(std::fabs(area(t, t.fanCount + t.fringeCount, 6)), 32 * 42, 0.01f));
+    
+    // Fringe coverage is 0.5 on the outline and 0 half a pixel off it.
+    for (size_t v = t.fanCount; v < t.fanCount + t.fringeCount; ++v) {
+        float c = t.vertices[v * 3 + 2];
+        EXPECT(c == 0.5f || c == 0);
+    }
+    
+    // At a larger scale the fringe shrinks with the pixel.
+    PathTessellation scaled = PathTessellation::fill(rect, 4);
+    EXPECT(scaled.vertexCount() == t.vertexCount());
+    EXPECT(std::fabs(area(scaled, scaled.fanCount, scaled.fringeCount, true)) <
+           std::fabs(area(t, t.fanCount, t.fringeCount, true)) / 3);
+    
+    VectorPath two;
+    two.rect(0, 0, 10, 10).rect(20, 0, 10, 10);
+    EXPECT(PathTessellation::fill(two, 1).fanCount == 12);
+    
+    VectorPath line;
+    line.moveTo(0, 0).lineTo(10, 10);
+    PathTessellation empty = PathTessellation::fill(line, 1);
+    EXPECT(empty.vertexCount() == 0 && empty.coverCount == 0);
+    EXPECT(PathTessellation::fill(VectorPath(), 1).vertexCount() == 0);
+}
+
+void testCurves() {
+    const float r = 50;
+    VectorPath circle;
+    circle.circle(0, 0, r);
+    size_t previous = 0;
+    for (float scale : {0.5f, 1.0f, 4.0f}) {
+        float tolerance = 0.25f / scale;
+        auto lines = circle.flatten(tolerance);
+        EXPECT(lines.size() == 1 && lines[0].closed);
+        if (lines.size() != 1) return;
+        const auto& points = lines[0].points;
+        for (size_t i = 0; i < points.size(); ++i) {
+            const Point& a = points[i];
+            const Point& b = points[(i + 1) % points.size()];
+            EXPECT(near(std::hypot(a.x, a.y), r, r * 3e-4f));   // cubic arc error
+            // Chord midpoints stay within the tolerance of the arc.
+            EXPECT(r - std::hypot((a.x + b.x) / 2, (a.y + b.y) / 2) <= tolerance);
+        }
+        EXPECT(points.size() > previous);
+        previous = points.size();
+        
+        PathTessellation t = PathTessellation::fill(circle, scale);
+        EXPECT(t.fanCount == (points.size() - 2) * 3);
+        EXPECT(near(std::fabs(area(t, 0, t.fanCount)), (float)M_PI * r * r, 2 * (float)M_PI * r * tolerance));
+    }
+}
+
+void testStroke() {
+    VectorPath line;
+    line.moveTo(0, 0).lineTo(100, 0);
+    
+    // One segment: the solid core plus a fringe quad on each side, whose
+    // coverage integrates to exactly length * width.
+    StrokeStyle style;
+    style.width = 4;
+    PathTessellation butt = PathTessellation::stroke(line, style, 1);
+    EXPECT(butt.vertexCount() == 18);
+    EXPECT(near(area(butt, 0, butt.vertexCount(), true), 100 * 4, 0.01f));
+    
+    float minX = INFINITY, maxX = -INFINITY;
+    style.cap = LineCap::Square;
+    PathTessellation square = PathTessellation::stroke(line, style, 1);
+    EXPECT(square.vertexCount() == 18);
+    for (size_t v = 0; v < square.vertexCount(); ++v) {
+        minX = std::min(minX, square.vertices[v * 3]);
+        maxX = std::max(maxX, square.vertices[v * 3]);
+    }
+    EXPECT(minX == -2 && maxX == 102);
+    
+    // Round caps add a disc at each end: a core fan triangle and a fringe
+    // quad per step, with more steps for wider strokes.
+    style.cap = LineCap::Round;
+    size_t round = PathTessellation::stroke(line, style, 1).vertexCount() - 18;
+    EXPECT(round > 0 && round % (2 * 9) == 0);
+    style.width = 40;
+    EXPECT(PathTessellation::stroke(line, style, 1).vertexCount() - 18 > round);
+    
+    // Closed: four segments and a round join at every corner.
+    VectorPath rect;
+    rect.rect(0, 0, 50, 50);
+    style.width = 4;
+    style.cap = LineCap::Butt;
+    PathTessellation closed = PathTessellation::stroke(rect, style, 1);
+    EXPECT(closed.vertexCount() == 4 * 18 + 4 * round / 2);
+    
+    // Hairlines keep a one pixel footprint at reduced coverage, no core.
+    style.width = 0.5f;
+    PathTessellation hairline = PathTessellation::stroke(line, style, 1);
+    EXPECT(hairline.vertexCount() == 12);
+    float maxCoverage = 0;
+    for (size_t v = 0; v < hairline.vertexCount(); ++v) {
+        maxCoverage = std::max(maxCoverage, hairline.vertices[v * 3 + 2]);
+    }
+    EXPECT(maxCoverage == 0.5f);
+    EXPECT(near(area(hairline, 0, hairline.vertexCount(), true), 100 * 0.5f, 0.01f));
+    
+    VectorPath dot;
+    dot.moveTo(5, 5);
+    style.cap = LineCap::Round;
+    EXPECT(PathTessellation::stroke(dot, style, 1).vertexCount() > 0);
+    style.cap = LineCap::Butt;
+    EXPECT(PathTessellation::stroke(dot, style, 1).vertexCount() == 0);
+}
+
+} // namespace
+
+int main() {
+    testFill();
+    testCurves();
+    testStroke();
+    
+    // Edits bump the version; copies get their own id.
+    VectorPath path;
+    uint64_t version = path.version();
+    path.rect(0, 0, 1, 1);
+    EXPECT(path.version() > version);
+    VectorPath copy(path);
+    EXPECT(copy.id() != path.id() && !copy.empty());
+    return failures == 0 ? 0 : 1;
+}
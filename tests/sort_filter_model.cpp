@@ -0,0 +1,83 @@
+// SortFilterModel: each filter's change batch, replayed onto a copy of the
+// previous rows, must reproduce the new rows without a reset.
+#include "metaui/models.hpp"
+#include <cstdio>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+class Table : public DataGridModel {
+public:
+    std::vector<std::string> names;
+    size_t rowCount() const override { return names.size(); }
+    size_t columnCount() const override { return 1; }
+    std::string cellText(size_t row, size_t) const override { return names[row]; }
+};
+
+std::vector<std::string> visible(const SortFilterModel& model) {
+    std::vector<std::string> rows;
+    for (size_t r = 0; r < model.rowCount(); ++r) rows.push_back(model.cellText(r, 0));
+    return rows;
+}
+
+void testSortFilterModel() {
+    auto table = std::make_shared<Table>();
+    const char* words[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta"};
+    for (int i = 0; i < 2000; ++i) {
+        table->names.push_back(std::string(words[i % 8]) + std::to_string(i * 7919 % 2000));
+    }
+    ThreadPool pool(4);
+    SortFilterModel model(table, pool);
+    model.sort(0);
+    
+    std::vector<std::string> shadow = visible(model);
+    for (size_t i = 1; i < shadow.size(); ++i) EXPECT(shadow[i - 1] <= shadow[i]);
+    
+    bool reset = false;
+    model.addListener([&](const std::vector<ModelChange>& changes) {
+        for (const auto& c : changes) {
+            switch (c.kind) {
+            case ModelChange::Kind::Reset:
+                reset = true;
+                break;
+            case ModelChange::Kind::RowsInserted:
+                shadow.insert(shadow.begin() + c.first, c.count, std::string());
+                for (size_t k = 0; k < c.count; ++k) {
+                    shadow[c.first + k] = model.cellText(c.first + k, 0);
+                }
+                break;
+            case ModelChange::Kind::RowsRemoved:
+                shadow.erase(shadow.begin() + c.first, shadow.begin() + c.first + c.count);
+                break;
+            case ModelChange::Kind::DataChanged:
+                break;
+            }
+        }
+    });
+    
+    for (const char* query : {"ta", "ETA", "eta1", "ta", "a1", "", "zeta19", "gamma"}) {
+        model.filter(query);
+        EXPECT(!reset);
+        EXPECT(shadow == visible(model));
+        for (const auto& row : shadow) {
+            EXPECT(containsIgnoreCase(row, toLowerAscii(query)));
+        }
+    }
+    model.filter("");
+    EXPECT(model.rowCount() == table->names.size());
+}
+
+} // namespace
+
+int main() {
+    testSortFilterModel();
+    EXPECT(containsIgnoreCase("a fairly long haystack with NEEDLE at the end", "needle"));
+    EXPECT(!containsIgnoreCase("a fairly long haystack without it", "needle"));
+    return failures == 0 ? 0 : 1;
+}
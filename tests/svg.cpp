@@ -0,0 +1,164 @@
+// SvgImage: parsing of sizes, colors, transforms and path data, and the
+// rasterizer's coverage against known areas. Truncated documents must be
+// rejected or drawn without reading past the end. No GL context is needed.
+#include "metaui/svg.hpp"
+#include <cstdio>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+struct Raster {
+    std::vector<unsigned char> rgba;
+    int width;
+    
+    const unsigned char* at(int x, int y) const { return &rgba[((size_t)y * width + x) * 4]; }
+    int alpha(int x, int y) const { return at(x, y)[3]; }
+    
+    float area() const {
+        float sum = 0;
+        for (size_t i = 3; i < rgba.size(); i += 4) sum += rgba[i] / 255.0f;
+        return sum;
+    }
+};
+
+Raster draw(const std::string& body, int width = 20, int height = 20, bool preserveAspect = true,
+            const char* size = "width=\"20\" height=\"20\" viewBox=\"0 0 20 20\"") {
+    std::string text = std::string("<svg xmlns=\"http://www.w3.org/2000/svg\" ") + size + ">" + body + "</svg>";
+    auto image = SvgImage::parse(text);
+    EXPECT(image != nullptr);
+    if (!image) return {std::vector<unsigned char>((size_t)width * height * 4), width};
+    return {image->rasterize(width, height, preserveAspect), width};
+}
+
+bool near(float a, float b, float tolerance) { return std::fabs(a - b) <= tolerance; }
+
+void testParse() {
+    EXPECT(SvgImage::parse("") == nullptr);
+    EXPECT(SvgImage::parse("not an svg") == nullptr);
+    EXPECT(SvgImage::parse("<html></html>") == nullptr);
+    
+    auto sized = SvgImage::parse("<svg width=\"48\" height=\"32\" viewBox=\"0 0 12 8\"/>");
+    EXPECT(sized && sized->width() == 48 && sized->height() == 32);
+    auto boxed = SvgImage::parse("<?xml version=\"1.0\"?><!-- icon --><svg viewBox=\"0 0 24 16\"></svg>");
+    EXPECT(boxed && boxed->width() == 24 && boxed->height() == 16);
+    
+    EXPECT(SvgImage::isSvgPath("icons/close.SVG"));
+    EXPECT(!SvgImage::isSvgPath("icons/close.png"));
+}
+
+void testFills() {
+    Raster r = draw("<rect x=\"5\" y=\"5\" width=\"10\" height=\"10\" fill=\"red\"/>");
+    EXPECT(r.at(10, 10)[0] == 255 && r.at(10, 10)[1] == 0 && r.alpha(10, 10) == 255);
+    EXPECT(r.alpha(2, 2) == 0 && r.alpha(16, 10) == 0);
+    EXPECT(near(r.area(), 100, 0.5f));
+    
+    // Half-covered pixels get half the alpha.
+    r = draw("<rect x=\"4.5\" y=\"4\" width=\"10\" height=\"10\" fill=\"#00f\"/>");
+    EXPECT(near(r.alpha(4, 8), 128, 1) && r.at(4, 8)[2] == 255);
+    
+    // Curves are flattened into ~2px chords, which shave off about 1%.
+    const float pi = 3.14159265f;
+    r = draw("<circle cx=\"10\" cy=\"10\" r=\"8\" fill=\"rgb(0, 128, 0)\"/>");
+    EXPECT(near(r.area(), pi * 64, pi * 64 * 0.015f));
+    EXPECT(r.at(10, 10)[1] == 128);
+    
+    r = draw("<ellipse cx=\"10\" cy=\"10\" rx=\"8\" ry=\"4\" fill=\"black\"/>");
+    EXPECT(near(r.area(), pi * 32, pi * 32 * 0.015f));
+    
+    // Relative path commands tracing the same square as the first rect.
+    r = draw("<path d=\"m5 5h10v10H5z\" fill=\"red\"/>");
+    EXPECT(near(r.area(), 100, 0.5f));
+    r = draw("<polygon points=\"5,5 15,5 15,15 5,15\" fill=\"red\"/>");
+    EXPECT(near(r.area(), 100, 0.5f));
+    
+    // A square inside a square, same direction: a hole only with evenodd.
+    const char* nested = "M2 2H18V18H2Z M6 6H14V14H6Z";
+    r = draw(std::string("<path d=\"") + nested + "\" fill-rule=\"evenodd\"/>");
+    EXPECT(r.alpha(10, 10) == 0 && r.alpha(3, 10) == 255);
+    EXPECT(near(r.area(), 256 - 64, 0.5f));
+    r = draw(std::string("<path d=\"") + nested + "\"/>");
+    EXPECT(r.alpha(10, 10) == 255);
+    
+    r = draw("<rect width=\"20\" height=\"20\" fill=\"none\"/>");
+    EXPECT(r.area() == 0);
+}
+
+void testStrokes() {
+    Raster r = draw("<line x1=\"2\" y1=\"10\" x2=\"18\" y2=\"10\" stroke=\"blue\" stroke-width=\"2\"/>");
+    EXPECT(near(r.area(), 32, 0.5f));
+    EXPECT(r.alpha(10, 9) == 255 && r.alpha(10, 10) == 255 && r.alpha(10, 11) == 0);
+    EXPECT(r.alpha(1, 9) == 0);
+    
+    r = draw("<line x1=\"4\" y1=\"10\" x2=\"16\" y2=\"10\" stroke=\"blue\" stroke-width=\"2\" "
+             "stroke-linecap=\"square\"/>");
+    EXPECT(near(r.area(), 28, 0.5f));
+    
+    // Joins are round: the 14px outer square minus the 10px inner one,
+    // less the four corners outside a unit disc.
+    r = draw("<rect x=\"4\" y=\"4\" width=\"12\" height=\"12\" fill=\"none\" stroke=\"red\" "
+             "stroke-width=\"2\"/>");
+    EXPECT(near(r.area(), 196 - 100 - (4 - 3.14159265f), 0.25f));
+    EXPECT(r.alpha(10, 10) == 0 && r.alpha(3, 10) == 255 && r.alpha(2, 10) == 0);
+}
+
+void testStyle() {
+    Raster r = draw("<g transform=\"translate(10 0) scale(0.5)\">"
+                    "<rect width=\"20\" height=\"20\" fill=\"red\"/></g>");
+    EXPECT(r.alpha(15, 5) == 255 && r.alpha(5, 5) == 0 && r.alpha(15, 15) == 0);
+    EXPECT(near(r.area(), 100, 0.5f));
+    
+    r = draw("<g opacity=\"0.5\"><rect width=\"20\" height=\"20\" style=\"fill: lime\"/></g>");
+    EXPECT(near(r.alpha(10, 10), 128, 1) && r.at(10, 10)[1] == 255);
+    
+    r = draw("<defs><linearGradient id=\"g\"><stop offset=\"0\" stop-color=\"#f00\"/>"
+             "<stop offset=\"1\" stop-color=\"#00f\"/></linearGradient></defs>"
+             "<rect width=\"20\" height=\"20\" fill=\"url(#g)\"/>");
+    EXPECT(r.at(0, 10)[0] > 230 && r.at(0, 10)[2] < 25);
+    EXPECT(r.at(19, 10)[2] > 230 && r.at(19, 10)[0] < 25);
+    EXPECT(near(r.at(10, 10)[0], r.at(10, 10)[2], 30));
+    
+    // A square viewBox in a wide raster is centered unless stretched.
+    const char* box = "viewBox=\"0 0 10 10\"";
+    r = draw("<rect width=\"10\" height=\"10\"/>", 40, 20, true, box);
+    EXPECT(r.alpha(5, 10) == 0 && r.alpha(20, 10) == 255 && near(r.area(), 400, 0.5f));
+    r = draw("<rect width=\"10\" height=\"10\"/>", 40, 20, false, box);
+    EXPECT(r.alpha(5, 10) == 255 && near(r.area(), 800, 0.5f));
+}
+
+void testTruncated() {
+    std::string text =
+        "<svg viewBox=\"0 0 20 20\"><defs><radialGradient id=\"r\" cx=\"0.5\" cy=\"0.5\" r=\"0.5\">"
+        "<stop offset=\"0\" stop-color=\"white\"/><stop offset=\"1\" stop-color=\"navy\"/>"
+        "</radialGradient></defs><g transform=\"rotate(30 10 10)\">"
+        "<path d=\"M2 2C8 0 12 0 18 2S20 12 18 18Q10 20 2 18T2 2A4 6 15 0 1 10 10z\" "
+        "fill=\"url(#r)\" stroke=\"#123456\" stroke-width=\"1.5\"/>"
+        "<polyline points=\"1 1 5 19 9 1 13 19\" fill=\"none\" stroke=\"teal\"/></g></svg>";
+    auto full = SvgImage::parse(text);
+    EXPECT(full != nullptr);
+    if (full) EXPECT(full->rasterize(16, 16).size() == 16u * 16 * 4);
+    for (size_t length = 0; length < text.size(); ++length) {
+        std::string prefix = text.substr(0, length);
+        if (auto image = SvgImage::parse(prefix)) image->rasterize(8, 8);
+    }
+}
+
+} // namespace
+
+int main() {
+    testParse();
+    testFills();
+    testStrokes();
+    testStyle();
+    testTruncated();
+    
+    auto icon = SvgImage::parse("<svg viewBox=\"0 0 24 24\"><path d=\"M4 4h16v16H4z\"/>"
+                                "<path d=\"M0 0h1\" fill=\"none\" stroke=\"red\"/></svg>");
+    EXPECT(icon && icon->outline().contours.size() == 1 && icon->outlineSize() == 24);
+    return failures == 0 ? 0 : 1;
+}
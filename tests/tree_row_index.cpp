@@ -0,0 +1,68 @@
+// TreeRowIndex against a naive flattening of the expanded rows under random
+// expand/collapse.
+#include "metaui/models.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace MetaUI;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+// Node n has n % 4 + 1 children, ids n * 4 + 1 onwards; ids above 400 are leaves.
+class Tree : public TreeModel {
+public:
+    size_t childCount(NodeId node) const override { return node > 400 ? 0 : node % 4 + 1; }
+    NodeId child(NodeId node, size_t index) const override { return node * 4 + 1 + index; }
+    std::string text(NodeId node) const override { return std::to_string(node); }
+};
+
+void flatten(const TreeRowIndex& index, TreeRowIndex::Slot slot, std::vector<TreeRowIndex::Slot>& rows) {
+    const auto& n = index.node(slot);
+    if (!n.expanded) return;
+    for (auto child : n.children) {
+        rows.push_back(child);
+        flatten(index, child, rows);
+    }
+}
+
+void testTreeRowIndex() {
+    TreeRowIndex index;
+    index.reset(std::make_shared<Tree>());
+    EXPECT(index.rowCount() == 1);
+    
+    std::mt19937 rng(7);
+    for (int step = 0; step < 300; ++step) {
+        std::vector<TreeRowIndex::Slot> rows;
+        flatten(index, index.rootSlot(), rows);
+        EXPECT(index.rowCount() == rows.size());
+        if (index.rowCount() != rows.size()) return;
+        
+        for (size_t r = 0; r < rows.size(); ++r) {
+            EXPECT(index.slotAt(r) == rows[r]);
+            EXPECT(index.rowOf(rows[r]) == (int64_t)r);
+            EXPECT(index.next(rows[r]) == (r + 1 < rows.size() ? rows[r + 1] : TreeRowIndex::NONE));
+        }
+        EXPECT(index.slotAt(rows.size()) == TreeRowIndex::NONE);
+        
+        index.toggle(rows[rng() % rows.size()]);
+    }
+    
+    // Rows under a collapsed ancestor have no row.
+    auto first = index.slotAt(0);
+    index.expand(first);
+    auto inner = index.node(first).children[0];
+    index.collapse(first);
+    EXPECT(index.rowOf(inner) == -1);
+}
+
+} // namespace
+
+int main() {
+    testTreeRowIndex();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Pack assets into a MetaUI resource bundle (see include/metaui/resources.hpp).
+
+    metaui-pack.py -o assets.cpp [--root DIR] [--subset-from FILE]... FILE...
+    metaui-pack.py -o assets.pak ...
+
+A .cpp/.cc output embeds the archive and registers it at static
+initialization; any other extension writes the raw archive for
+Resources::mountFile(). Entries are named by their path relative to --root
+(default: the current directory), or explicitly with NAME=PATH.
+
+With --subset-from, .ttf/.otf fonts are reduced to printable ASCII plus
+every character found in the given files (sources, translations, ...)
+using fontTools' pyftsubset. Without fontTools the fonts are embedded whole
+and a warning is printed.
+"""
+
+import argparse
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+MAGIC = b"MUIPAK01"
+ALIGN = 16
+
+
+def collect_codepoints(paths):
+    codepoints = set(range(0x20, 0x7F))
+    for path in paths:
+        with open(path, encoding="utf-8", errors="ignore") as f:
+            codepoints.update(ord(c) for c in f.read() if ord(c) >= 0x20)
+    return codepoints
+
+
+def find_subsetter():
+    tool = shutil.which("pyftsubset")
+    if tool:
+        return [tool]
+    try:
+        import fontTools.subset  # noqa: F401
+        return [sys.executable, "-m", "fontTools.subset"]
+    except ImportError:
+        return None
+
+
+def subset_font(path, codepoints, subsetter):
+    unicodes = ",".join("U+%04X" % cp for cp in sorted(codepoints))
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "subset" + os.path.splitext(path)[1])
+        subprocess.run(subsetter + [path, "--unicodes=" + unicodes,
+                                    "--layout-features=*", "--output-file=" + out],
+                       check=True)
+        with open(out, "rb") as f:
+            return f.read()
+
+
+def build_archive(entries):
+    header_size = 16 + 16 * len(entries)
+    names = b"".join(name.encode() for name, _ in entries)
+    offset = header_size + len(names)
+
+    table, blobs, name_offset = [], [], header_size
+    for name, data in entries:
+        pad = -offset % ALIGN
+        blobs.append(b"\0" * pad + data)
+        offset += pad
+        table.append(struct.pack("<IIII", name_offset, len(name.encode()), offset, len(data)))
+        name_offset += len(name.encode())
+        offset += len(data)
+
+    return MAGIC + struct.pack("<II", len(entries), 0) + b"".join(table) + names + b"".join(blobs)
+
+
+def write_cpp(path, archive):
+    symbol = "metaui_bundle_" + "".join(c if c.isalnum() else "_"
+                                        for c in os.path.splitext(os.path.basename(path))[0])
+    with open(path, "w") as f:
+        f.write("// Generated by metaui-pack.py; do not edit.\n")
+        f.write("#include <metaui/resources.hpp>\n\n")
+        f.write("alignas(16) static const unsigned char %s[%d] = {\n" % (symbol, len(archive)))
+        for i in range(0, len(archive), 24):
+            f.write("    " + ",".join(str(b) for b in archive[i:i + 24]) + ",\n")
+        f.write("};\n\n")
+        f.write("static const MetaUI::ResourceBundleRegistration %s_registration(%s, sizeof(%s));\n"
+                % (symbol, symbol, symbol))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack assets into a MetaUI resource bundle.")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--root", default=".")
+    parser.add_argument("--subset-from", action="append", default=[], metavar="FILE",
+                        help="subset fonts to the characters in FILE (repeatable)")
+    parser.add_argument("files", nargs="+")
+    args = parser.parse_args()
+
+    codepoints = collect_codepoints(args.subset_from) if args.subset_from else None
+    subsetter = find_subsetter() if codepoints else None
+    if codepoints and not subsetter:
+        print("metaui-pack: fontTools not found, embedding fonts unsubsetted", file=sys.stderr)
+
+    entries = []
+    for spec in args.files:
+        name, _, path = spec.partition("=") if "=" in spec else ("", "", spec)
+        name = name or os.path.relpath(path, args.root).replace(os.sep, "/")
+        if subsetter and os.path.splitext(path)[1].lower() in (".ttf", ".otf"):
+            data = subset_font(path, codepoints, subsetter)
+        else:
+            with open(path, "rb") as f:
+                data = f.read()
+        entries.append((name, data))
+
+    archive = build_archive(entries)
+    if os.path.splitext(args.output)[1] in (".cpp", ".cc"):
+        write_cpp(args.output, archive)
+    else:
+        with open(args.output, "wb") as f:
+            f.write(archive)
+
+
+if __name__ == "__main__":
+    main()